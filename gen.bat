@@ -1,6 +1,10 @@
 @echo off
-REM English generate
+REM English generate, d3tool (src/DecodeTool) writes the same legacy database translategen does in a fraction of the time
 echo Generating English localization...
-call translategen en/en_source.txt
+if exist d3tool.exe (
+	d3tool compile en/en_source.txt en/en_source.db --legacy
+) else (
+	call translategen en/en_source.txt
+)
 echo Finished generating...
 pause
\ No newline at end of file
@@ -0,0 +1,135 @@
+// Standard includes
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+// Our includes
+#include "commands.h"
+#include "toolutils.h"
+#include "translationdb.h"
+
+// Runs every key through the lookup, returning the average nanoseconds per lookup
+template<typename LookupFunc>
+static double MeasureLookups(const std::vector<std::string>& Keys, LookupFunc Lookup, uint32_t& Found)
+{
+	static const uint32_t Rounds = 50;
+
+	Found = 0;
+	if (Keys.empty())
+		return 0.0;
+
+	ToolUtils::Stopwatch Timer;
+	for (uint32_t Round = 0; Round < Rounds; Round++)
+	{
+		for (auto& Key : Keys)
+		{
+			if (Lookup(Key.c_str()) != nullptr)
+				Found++;
+		}
+	}
+
+	Found /= Rounds;
+	return Timer.ElapsedNanoseconds() / ((double)Keys.size() * Rounds);
+}
+
+int BenchCommand(int argc, char** argv)
+{
+	if (argc < 1)
+	{
+		printf("usage: d3tool bench <database.db> [--engine map|db] [--source en_source.txt] [--missing en_missing.txt]\n");
+		return 1;
+	}
+
+	std::string DatabasePath = argv[0];
+	std::string Engine = "db";
+	std::string SourcePath = "en/en_source.txt";
+	std::string MissingPath = "en/en_missing.txt";
+
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (std::strcmp(argv[i], "--engine") == 0)
+			Engine = argv[i + 1];
+		else if (std::strcmp(argv[i], "--source") == 0)
+			SourcePath = argv[i + 1];
+		else if (std::strcmp(argv[i], "--missing") == 0)
+			MissingPath = argv[i + 1];
+	}
+
+	auto HitKeys = ToolUtils::ReadSourceKeys(SourcePath);
+	auto MissKeys = ToolUtils::ReadMissingKeys(MissingPath);
+	auto BaselineResident = ToolUtils::GetPeakResidentBytes();
+
+	double LoadTime = 0.0, HitTime = 0.0, MissTime = 0.0;
+	uint64_t LoadAllocations = 0;
+	uint32_t Entries = 0, Hits = 0, Misses = 0;
+
+	if (Engine == "map")
+	{
+		std::unordered_map<std::string, std::string> Map;
+
+		auto Allocations = ToolUtils::GetAllocationCount();
+		ToolUtils::Stopwatch Timer;
+		if (!ToolUtils::LoadLegacyMap(DatabasePath, Map))
+		{
+			printf("Failed to load: %s\n", DatabasePath.c_str());
+			return 1;
+		}
+		LoadTime = Timer.ElapsedMilliseconds();
+		LoadAllocations = ToolUtils::GetAllocationCount() - Allocations;
+		Entries = (uint32_t)Map.size();
+
+		// Matches the original hook, find then operator[]
+		auto Lookup = [&Map](const char* Key) -> const char*
+		{
+			if (Map.find(Key) != Map.end())
+				return Map[Key].c_str();
+			return nullptr;
+		};
+
+		HitTime = MeasureLookups(HitKeys, Lookup, Hits);
+		MissTime = MeasureLookups(MissKeys, Lookup, Misses);
+	}
+	else if (Engine == "db")
+	{
+		TranslationDB Database;
+
+		auto Allocations = ToolUtils::GetAllocationCount();
+		ToolUtils::Stopwatch Timer;
+		if (!Database.Load(DatabasePath))
+		{
+			printf("Failed to load: %s\n", DatabasePath.c_str());
+			return 1;
+		}
+		LoadTime = Timer.ElapsedMilliseconds();
+		LoadAllocations = ToolUtils::GetAllocationCount() - Allocations;
+		Entries = Database.GetEntryCount();
+
+		auto Lookup = [&Database](const char* Key) -> const char*
+		{
+			return Database.Find(Key);
+		};
+
+		HitTime = MeasureLookups(HitKeys, Lookup, Hits);
+		MissTime = MeasureLookups(MissKeys, Lookup, Misses);
+
+		printf("mapped:         %s\n", Database.IsMapped() ? "yes" : "no");
+	}
+	else
+	{
+		printf("Unknown engine: %s\n", Engine.c_str());
+		return 1;
+	}
+
+	auto PeakResident = ToolUtils::GetPeakResidentBytes();
+
+	printf("engine:         %s\n", Engine.c_str());
+	printf("entries:        %u\n", Entries);
+	printf("load:           %.3f ms, %llu allocations\n", LoadTime, (unsigned long long)LoadAllocations);
+	printf("hit lookup:     %.1f ns (%u/%u found)\n", HitTime, Hits, (uint32_t)HitKeys.size());
+	printf("miss lookup:    %.1f ns (%u/%u found)\n", MissTime, Misses, (uint32_t)MissKeys.size());
+	printf("peak rss:       %.2f MB (+%.2f MB)\n", PeakResident / 1048576.0, (PeakResident - BaselineResident) / 1048576.0);
+
+	return 0;
+}
\ No newline at end of file
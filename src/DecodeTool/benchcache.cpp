@@ -0,0 +1,219 @@
+// Standard includes
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Our includes
+#include "commands.h"
+#include "toolutils.h"
+#include "translate.h"
+#include "translationstore.h"
+#include "stringcache.h"
+
+// A single call in the replayed stream, dynamic calls copy their text into a reused buffer first
+struct CacheStreamCall
+{
+	const char* Reference;
+	const char* DynamicText;
+};
+
+// Builds a stream of frames, most calls reference a fixed pool of literals with a zipf skew,
+// the rest format keys into a few rotating buffers, so the same pointer keeps changing text
+static std::vector<CacheStreamCall> BuildStream(const std::vector<std::string>& Literals, const std::vector<std::string>& Dynamic, std::vector<std::vector<char>>& Buffers, uint32_t Frames, uint32_t CallsPerFrame, uint32_t Seed)
+{
+	std::mt19937 Random(Seed);
+
+	std::vector<double> Cumulative(Literals.size());
+	double Total = 0;
+	for (size_t i = 0; i < Literals.size(); i++)
+	{
+		Total += 1.0 / (double)(i + 1);
+		Cumulative[i] = Total;
+	}
+
+	std::uniform_real_distribution<double> Uniform(0, Total);
+	std::uniform_int_distribution<uint32_t> Percent(0, 99);
+	std::uniform_int_distribution<size_t> DynamicPick(0, Dynamic.size() - 1);
+	std::uniform_int_distribution<size_t> BufferPick(0, Buffers.size() - 1);
+
+	std::vector<CacheStreamCall> Stream;
+	Stream.reserve((size_t)Frames * CallsPerFrame);
+
+	for (uint32_t Frame = 0; Frame < Frames; Frame++)
+	{
+		for (uint32_t Call = 0; Call < CallsPerFrame; Call++)
+		{
+			CacheStreamCall Entry;
+
+			if (Percent(Random) < 5)
+			{
+				Entry.Reference = Buffers[BufferPick(Random)].data();
+				Entry.DynamicText = Dynamic[DynamicPick(Random)].c_str();
+			}
+			else
+			{
+				auto Index = std::lower_bound(Cumulative.begin(), Cumulative.end(), Uniform(Random)) - Cumulative.begin();
+				Entry.Reference = Literals[std::min<size_t>(Index, Literals.size() - 1)].c_str();
+				Entry.DynamicText = nullptr;
+			}
+
+			Stream.push_back(Entry);
+		}
+	}
+
+	return Stream;
+}
+
+// Copies the text of a dynamic call into its buffer, like the engine formatting a reference
+static const char* PrepareCall(const CacheStreamCall& Call)
+{
+	if (Call.DynamicText != nullptr)
+		std::strcpy((char*)Call.Reference, Call.DynamicText);
+
+	return Call.Reference;
+}
+
+int BenchCacheCommand(int argc, char** argv)
+{
+	if (argc < 1)
+	{
+		printf("usage: d3tool bench-cache <database.db> [--source en_source.txt] [--missing en_missing.txt] [--literals 400] [--frames 2000] [--threads 4]\n");
+		return 1;
+	}
+
+	std::string DatabasePath = argv[0];
+	std::string SourcePath = "en/en_source.txt";
+	std::string MissingPath = "en/en_missing.txt";
+	uint32_t LiteralCount = 400;
+	uint32_t Frames = 2000;
+	uint32_t Threads = 4;
+
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (std::strcmp(argv[i], "--source") == 0)
+			SourcePath = argv[i + 1];
+		else if (std::strcmp(argv[i], "--missing") == 0)
+			MissingPath = argv[i + 1];
+		else if (std::strcmp(argv[i], "--literals") == 0)
+			LiteralCount = (uint32_t)std::max(1, std::atoi(argv[i + 1]));
+		else if (std::strcmp(argv[i], "--frames") == 0)
+			Frames = (uint32_t)std::max(1, std::atoi(argv[i + 1]));
+		else if (std::strcmp(argv[i], "--threads") == 0)
+			Threads = (uint32_t)std::max(1, std::atoi(argv[i + 1]));
+	}
+
+	std::unique_ptr<TranslationDB> Database(new TranslationDB());
+	if (!Database->Load(DatabasePath))
+	{
+		printf("Failed to load: %s\n", DatabasePath.c_str());
+		return 1;
+	}
+
+	auto SourceKeys = ToolUtils::ReadSourceKeys(SourcePath);
+	auto MissingKeys = ToolUtils::ReadMissingKeys(MissingPath);
+	if (SourceKeys.empty())
+	{
+		printf("No keys in: %s\n", SourcePath.c_str());
+		return 1;
+	}
+
+	// The literal pool, mostly translated references with some the database doesn't know, half of them @ prefixed
+	std::mt19937 Random(1234);
+	std::vector<std::string> Literals;
+	for (uint32_t i = 0; i < LiteralCount; i++)
+	{
+		auto Missing = !MissingKeys.empty() && (i % 10) == 9;
+		auto Key = Missing ? MissingKeys[Random() % MissingKeys.size()] : SourceKeys[Random() % SourceKeys.size()];
+		Literals.push_back(((i & 1) != 0) ? "@" + Key : Key);
+	}
+
+	std::vector<std::string> Dynamic;
+	size_t LongestDynamic = 0;
+	for (uint32_t i = 0; i < 256; i++)
+	{
+		Dynamic.push_back(SourceKeys[Random() % SourceKeys.size()]);
+		LongestDynamic = std::max(LongestDynamic, Dynamic.back().size());
+	}
+
+	static const uint32_t CallsPerFrame = 2000;
+	std::vector<std::vector<char>> Buffers(8, std::vector<char>(LongestDynamic + 1, 0));
+	auto Stream = BuildStream(Literals, Dynamic, Buffers, Frames, CallsPerFrame, 42);
+
+	TranslationStore Store;
+	auto Plain = Database.get();
+
+	std::unique_ptr<TranslationStack> Stack(new TranslationStack());
+	Stack->AddLayer(std::move(Database), DatabasePath);
+	Stack->BuildIndex();
+	Store.Publish(std::move(Stack));
+
+	StringReferenceCache Cache;
+
+	printf("database:       %s\n", DatabasePath.c_str());
+	printf("stream:         %u frames x %u calls, %u literals, 5%% dynamic\n", Frames, CallsPerFrame, LiteralCount);
+
+	// Uncached lookups, also recording the expected results
+	std::vector<const char*> Expected(Stream.size());
+	ToolUtils::Stopwatch Timer;
+
+	for (size_t i = 0; i < Stream.size(); i++)
+		Expected[i] = TranslateStringReference(*Plain, PrepareCall(Stream[i]));
+
+	auto PlainNs = Timer.ElapsedNanoseconds() / (double)Stream.size();
+
+	// Cached lookups through the store, like the hook
+	uint32_t Mismatches = 0;
+	Timer.Restart();
+
+	for (size_t i = 0; i < Stream.size(); i++)
+	{
+		if (TranslateStringReference(Cache, Store, PrepareCall(Stream[i])) != Expected[i])
+			Mismatches++;
+	}
+
+	auto CachedNs = Timer.ElapsedNanoseconds() / (double)Stream.size();
+	auto Hits = Cache.GetHits();
+	auto Misses = Cache.GetMisses();
+
+	printf("uncached:       %.1f ns/call\n", PlainNs);
+	printf("cached:         %.1f ns/call\n", CachedNs);
+	printf("hit rate:       %.2f%% (%u hits, %u misses)\n", (100.0 * Hits) / (double)std::max<uint64_t>(1, (uint64_t)Hits + Misses), Hits, Misses);
+
+	// Every thread replays its own literal stream against the shared cache, dynamic calls are skipped since the buffers are shared
+	std::atomic<uint32_t> ThreadMismatches(0);
+	std::vector<std::thread> Workers;
+	Cache.ResetCounters();
+	Timer.Restart();
+
+	for (uint32_t t = 0; t < Threads; t++)
+	{
+		Workers.push_back(std::thread([&, t]()
+		{
+			uint32_t Local = 0;
+			for (size_t i = t; i < Stream.size(); i++)
+			{
+				if (Stream[i].DynamicText != nullptr)
+					continue;
+				if (TranslateStringReference(Cache, Store, Stream[i].Reference) != TranslateStringReference(*Plain, Stream[i].Reference))
+					Local++;
+			}
+
+			ThreadMismatches.fetch_add(Local);
+		}));
+	}
+
+	for (auto& Worker : Workers)
+		Worker.join();
+
+	printf("threads:        %u readers, %.2f ms, %u mismatches\n", Threads, Timer.ElapsedMilliseconds(), ThreadMismatches.load());
+	printf("mismatches:     %u\n", Mismatches);
+
+	return (Mismatches == 0 && ThreadMismatches.load() == 0) ? 0 : 1;
+}
\ No newline at end of file
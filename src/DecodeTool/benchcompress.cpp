@@ -0,0 +1,226 @@
+// Standard includes
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Our includes
+#include "commands.h"
+#include "toolutils.h"
+#include "translationdb.h"
+#include "symboltable.h"
+
+static const uint32_t Rounds = 20;
+// Keeps the decode loop from being optimized away
+static volatile size_t DecodeSink = 0;
+
+// Gets the size of a section of an image, zero if it doesn't have one
+static uint32_t GetSectionSize(const std::vector<uint8_t>& Image, uint32_t Id)
+{
+	auto DbHeader = (const TranslationDBHeader*)Image.data();
+	auto Sections = (const TranslationDBSection*)(Image.data() + sizeof(TranslationDBHeader));
+
+	for (uint32_t i = 0; i < DbHeader->SectionCount; i++)
+	{
+		if (Sections[i].Id == Id)
+			return Sections[i].Size;
+	}
+
+	return 0;
+}
+
+// Times one pass of value lookups over every key, in nanoseconds per key
+static double MeasureLookups(const TranslationDB& Database, const std::vector<std::string>& Keys, uint32_t& Found)
+{
+	Found = 0;
+
+	ToolUtils::Stopwatch Timer;
+	for (auto& Key : Keys)
+	{
+		if (Database.Find(Key.c_str(), Key.size()) != nullptr)
+			Found++;
+	}
+
+	return Timer.ElapsedNanoseconds() / (double)Keys.size();
+}
+
+int BenchCompressCommand(int argc, char** argv)
+{
+	if (argc < 1)
+	{
+		printf("usage: d3tool bench-compress <database.db> [--source en_source.txt]\n");
+		return 1;
+	}
+
+	std::string DatabasePath = argv[0];
+	std::string SourcePath = "en/en_source.txt";
+
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (std::strcmp(argv[i], "--source") == 0)
+			SourcePath = argv[i + 1];
+	}
+
+	TranslationDB Source;
+	if (!Source.Load(DatabasePath))
+	{
+		printf("Failed to load: %s\n", DatabasePath.c_str());
+		return 1;
+	}
+
+	// Every pair of the database, values decoded if it's compressed already
+	auto& SourceView = Source.GetView();
+	std::vector<std::string_view> Values;
+	TranslationDBBuilder Builder;
+
+	for (uint32_t i = 0; i < SourceView.EntryCount; i++)
+	{
+		auto& Entry = SourceView.Entries[i];
+		auto Value = Source.GetValue(&Entry);
+
+		Values.emplace_back(Value);
+		Builder.Add(Source.GetKey(&Entry), Entry.KeyLength, Value, (uint32_t)Values.back().size());
+	}
+
+	// Train and encode on their own
+	ToolUtils::Stopwatch Timer;
+	SymbolTable Table;
+	Table.Train(Values);
+	auto TrainTime = Timer.ElapsedMilliseconds();
+
+	size_t RawBytes = 0, LongestValue = 0;
+	std::vector<std::vector<uint8_t>> Encoded(Values.size());
+
+	Timer.Restart();
+	for (size_t i = 0; i < Values.size(); i++)
+		Table.Encode(Values[i].data(), Values[i].size(), Encoded[i]);
+	auto EncodeTime = Timer.ElapsedMilliseconds();
+
+	size_t EncodedBytes = 0;
+	for (size_t i = 0; i < Values.size(); i++)
+	{
+		RawBytes += Values[i].size();
+		EncodedBytes += Encoded[i].size();
+		LongestValue = std::max(LongestValue, Values[i].size());
+	}
+
+	// Every value must decode back to itself
+	std::vector<char> Buffer(LongestValue + SYMBOLTABLE_MAX_LENGTH + 1);
+	uint32_t Mismatches = 0;
+
+	for (size_t i = 0; i < Values.size(); i++)
+	{
+		auto Length = SymbolTable::Decode(Table.GetData(), Encoded[i].data(), Encoded[i].size(), Buffer.data());
+		if (Length != Values[i].size() || Length != SymbolTable::GetDecodedLength(Table.GetData(), Encoded[i].data(), Encoded[i].size()) || std::memcmp(Buffer.data(), Values[i].data(), Length) != 0)
+			Mismatches++;
+	}
+
+	size_t Decoded = 0;
+	Timer.Restart();
+	for (uint32_t Round = 0; Round < Rounds; Round++)
+	{
+		for (auto& Value : Encoded)
+			Decoded += SymbolTable::Decode(Table.GetData(), Value.data(), Value.size(), Buffer.data());
+	}
+	auto DecodeNs = Timer.ElapsedNanoseconds();
+	DecodeSink = Decoded;
+
+	// Whole images, plain and compressed
+	std::vector<uint8_t> PlainImage, CompressedImage;
+	std::string Error;
+
+	if (!Builder.Build(PlainImage, &Error))
+	{
+		printf("Failed to build database: %s\n", Error.c_str());
+		return 1;
+	}
+
+	Builder.SetValueCompression(true);
+
+	Timer.Restart();
+	if (!Builder.Build(CompressedImage, &Error))
+	{
+		printf("Failed to build database: %s\n", Error.c_str());
+		return 1;
+	}
+	auto CompressedBuildTime = Timer.ElapsedMilliseconds();
+
+	auto PlainStrings = GetSectionSize(PlainImage, TRANSLATIONDB_SECTION_STRINGS);
+	auto PlainWide = GetSectionSize(PlainImage, TRANSLATIONDB_SECTION_WIDEENTRIES) + GetSectionSize(PlainImage, TRANSLATIONDB_SECTION_WIDESTRINGS);
+	auto CompressedStrings = GetSectionSize(CompressedImage, TRANSLATIONDB_SECTION_STRINGS);
+	auto PlainSize = PlainImage.size(), CompressedSize = CompressedImage.size();
+
+	TranslationDB Plain, Compressed;
+	if (!Plain.LoadImage(PlainImage) || !Compressed.LoadImage(CompressedImage) || !Compressed.IsCompressed())
+	{
+		printf("Failed to load the built images\n");
+		return 1;
+	}
+
+	// Both databases must return the same values, in both encodings, and the same pointer every time
+	auto& View = Compressed.GetView();
+	for (uint32_t i = 0; i < View.EntryCount; i++)
+	{
+		auto& Entry = View.Entries[i];
+		auto Expected = Plain.FindEntry(Compressed.GetKey(&Entry), Entry.KeyLength);
+		auto Value = Compressed.GetValue(&Entry);
+
+		if (Expected == nullptr || std::strcmp(Plain.GetValue(Expected), Value) != 0 || Compressed.GetValue(&Entry) != Value)
+		{
+			Mismatches++;
+			continue;
+		}
+
+		uint32_t ExpectedLength = 0, WideLength = 0;
+		auto ExpectedWide = Plain.GetWideValue(Expected, ExpectedLength);
+		auto Wide = Compressed.GetWideValue(&Entry, WideLength);
+
+		if ((ExpectedWide == nullptr) != (Wide == nullptr) || (Wide != nullptr && (WideLength != ExpectedLength || std::memcmp(Wide, ExpectedWide, (WideLength + 1) * sizeof(uint16_t)) != 0)))
+			Mismatches++;
+	}
+
+	// Lookups on a fresh database, the first pass decodes every value it hits
+	TranslationDB Fresh;
+	std::vector<uint8_t> FreshImage(CompressedImage.size());
+	if (!Builder.Build(FreshImage, &Error) || !Fresh.LoadImage(FreshImage))
+	{
+		printf("Failed to load the built images\n");
+		return 1;
+	}
+
+	auto Keys = ToolUtils::ReadSourceKeys(SourcePath);
+	if (Keys.empty())
+	{
+		printf("No keys in: %s\n", SourcePath.c_str());
+		return 1;
+	}
+
+	uint32_t PlainFound = 0, FirstFound = 0, CachedFound = 0, Found = 0;
+	auto FirstNs = MeasureLookups(Fresh, Keys, FirstFound);
+
+	double PlainNs = 0, CachedNs = 0;
+	for (uint32_t Round = 0; Round < Rounds; Round++)
+	{
+		PlainNs += MeasureLookups(Plain, Keys, PlainFound);
+		CachedNs += MeasureLookups(Fresh, Keys, CachedFound);
+	}
+	MeasureLookups(Compressed, Keys, Found);
+
+	auto TableBytes = (uint32_t)sizeof(SymbolTableData);
+	uint32_t SymbolCount = 0;
+	for (auto Length : Table.GetData().Lengths)
+		SymbolCount += (Length > 0) ? 1 : 0;
+
+	printf("values:         %u (%.2f MB)\n", (uint32_t)Values.size(), RawBytes / (1024.0 * 1024.0));
+	printf("symbol table:   %u symbols, %u bytes, trained in %.2f ms\n", SymbolCount, TableBytes, TrainTime);
+	printf("encoded:        %.2f MB, ratio %.2fx, %.1f MB/s\n", EncodedBytes / (1024.0 * 1024.0), (double)RawBytes / EncodedBytes, (RawBytes / (1024.0 * 1024.0)) / (EncodeTime / 1000.0));
+	printf("decode:         %.0f MB/s, %.1f ns per value\n", ((double)RawBytes * Rounds / (1024.0 * 1024.0)) / (DecodeNs / 1e9), DecodeNs / ((double)Values.size() * Rounds));
+	printf("strings:        %u bytes plain (+%u wide), %u bytes compressed\n", PlainStrings, PlainWide, CompressedStrings);
+	printf("image:          %u bytes plain, %u bytes compressed (%.1f%%), built in %.2f ms\n", (uint32_t)PlainSize, (uint32_t)CompressedSize, (100.0 * CompressedSize) / PlainSize, CompressedBuildTime);
+	printf("lookup:         %.1f ns plain, %.1f ns first hit, %.1f ns cached (%u keys, %u found)\n", PlainNs / Rounds, FirstNs, CachedNs / Rounds, (uint32_t)Keys.size(), FirstFound);
+	printf("decoded arena:  %.2f MB after every key\n", Fresh.GetView().Decoded->GetDecodedBytes() / (1024.0 * 1024.0));
+	printf("mismatches:     %u\n", Mismatches);
+
+	return (Mismatches == 0 && PlainFound == FirstFound && FirstFound == CachedFound && Found == PlainFound) ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,179 @@
+// Standard includes
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Our includes
+#include "commands.h"
+#include "toolutils.h"
+#include "translationdb.h"
+#include "translationlookup.h"
+#include "unicode.h"
+
+// Lookup timings for one hash policy
+struct HashBenchResult
+{
+	double BuildTime;
+	double HashTime;
+	double HitTime;
+	double MissTime;
+	double ReferenceTime;
+	double WideTime;
+	uint32_t Hits;
+	uint32_t Misses;
+	uint32_t ReferenceHits;
+	uint32_t WideHits;
+	uint64_t Allocations;
+};
+
+static const uint32_t Rounds = 20;
+// Keeps the hash loop from being optimized away
+static volatile uint64_t HashSink = 0;
+
+// Times a lookup over every key, in nanoseconds per key
+template<typename Keys, typename Func>
+static double MeasureKeys(const Keys& KeyList, Func Lookup, uint32_t& Found)
+{
+	Found = 0;
+
+	ToolUtils::Stopwatch Timer;
+	for (uint32_t Round = 0; Round < Rounds; Round++)
+	{
+		for (auto& Key : KeyList)
+		{
+			if (Lookup(Key) != nullptr)
+				Found++;
+		}
+	}
+
+	Found /= Rounds;
+	return Timer.ElapsedNanoseconds() / ((double)KeyList.size() * Rounds);
+}
+
+template<typename Hasher>
+static bool BenchPolicy(const TranslationDBBuilder& Builder, const std::vector<std::string>& HitKeys, const std::vector<std::string>& MissKeys, HashBenchResult& Result)
+{
+	std::vector<uint8_t> Image;
+	std::string Error;
+
+	ToolUtils::Stopwatch Timer;
+	if (!Builder.BuildWith<Hasher>(Image, &Error))
+	{
+		printf("Failed to build database: %s\n", Error.c_str());
+		return false;
+	}
+	Result.BuildTime = Timer.ElapsedMilliseconds();
+
+	TranslationDB Database;
+	if (!Database.LoadImage(Image))
+		return false;
+
+	TranslationLookup<Hasher> Lookup(Database.GetView());
+	if (!Lookup.IsCompatible())
+		return false;
+
+	// Every key in the shapes the hooks see them, prepared up front
+	std::vector<std::string_view> Views(HitKeys.begin(), HitKeys.end());
+	std::vector<std::string_view> MissViews(MissKeys.begin(), MissKeys.end());
+	std::vector<std::string> References;
+	std::vector<std::vector<uint16_t>> WideKeys;
+
+	for (auto& Key : HitKeys)
+	{
+		References.push_back("@" + Key);
+
+		std::vector<uint16_t> Wide(Key.size() + 1, 0);
+		size_t WideLength = 0;
+		Unicode::Utf8ToUtf16(Key.c_str(), Key.size(), Wide.data(), WideLength);
+		Wide.resize(WideLength);
+		WideKeys.push_back(Wide);
+	}
+
+	// The hash alone
+	uint64_t Sink = 0;
+	Timer.Restart();
+	for (uint32_t Round = 0; Round < Rounds; Round++)
+	{
+		for (auto& Key : Views)
+			Sink ^= Hasher::Hash(Key.data(), Key.size());
+	}
+	Result.HashTime = Timer.ElapsedNanoseconds() / ((double)Views.size() * Rounds);
+	HashSink = Sink;
+
+	auto Allocations = ToolUtils::GetAllocationCount();
+
+	Result.HitTime = MeasureKeys(Views, [&Lookup](std::string_view Key) { return Lookup.FindEntry(Key); }, Result.Hits);
+	Result.MissTime = MeasureKeys(MissViews, [&Lookup](std::string_view Key) { return Lookup.FindEntry(Key); }, Result.Misses);
+	Result.ReferenceTime = MeasureKeys(References, [&Lookup](const std::string& Key) { return Lookup.FindReference(Key.c_str()); }, Result.ReferenceHits);
+	Result.WideTime = MeasureKeys(WideKeys, [&Lookup](const std::vector<uint16_t>& Key) { return Lookup.FindEntry(Key.data(), Key.size()); }, Result.WideHits);
+
+	Result.Allocations = ToolUtils::GetAllocationCount() - Allocations;
+	return true;
+}
+
+static void PrintResult(const char* Name, const HashBenchResult& Result, size_t HitCount, size_t MissCount)
+{
+	printf("%s\n", Name);
+	printf("  build:        %.2f ms\n", Result.BuildTime);
+	printf("  hash only:    %.1f ns\n", Result.HashTime);
+	printf("  hit lookup:   %.1f ns (%u/%u found)\n", Result.HitTime, Result.Hits, (uint32_t)HitCount);
+	printf("  miss lookup:  %.1f ns (%u/%u found)\n", Result.MissTime, Result.Misses, (uint32_t)MissCount);
+	printf("  @reference:   %.1f ns (%u/%u found)\n", Result.ReferenceTime, Result.ReferenceHits, (uint32_t)HitCount);
+	printf("  utf16 key:    %.1f ns (%u/%u found)\n", Result.WideTime, Result.WideHits, (uint32_t)HitCount);
+	printf("  allocations:  %llu\n", (unsigned long long)Result.Allocations);
+}
+
+int BenchHashCommand(int argc, char** argv)
+{
+	if (argc < 1)
+	{
+		printf("usage: d3tool bench-hash <database.db> [--source en_source.txt] [--missing en_missing.txt]\n");
+		return 1;
+	}
+
+	std::string DatabasePath = argv[0];
+	std::string SourcePath = "en/en_source.txt";
+	std::string MissingPath = "en/en_missing.txt";
+
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (std::strcmp(argv[i], "--source") == 0)
+			SourcePath = argv[i + 1];
+		else if (std::strcmp(argv[i], "--missing") == 0)
+			MissingPath = argv[i + 1];
+	}
+
+	TranslationDB Source;
+	if (!Source.Load(DatabasePath))
+	{
+		printf("Failed to load: %s\n", DatabasePath.c_str());
+		return 1;
+	}
+
+	// Rebuild the same pairs with every policy
+	auto& View = Source.GetView();
+	TranslationDBBuilder Builder;
+
+	// Values go through the database, which decodes them if it's compressed
+	for (uint32_t i = 0; i < View.EntryCount; i++)
+	{
+		auto& Entry = View.Entries[i];
+		auto Value = Source.GetValue(&Entry);
+		Builder.Add(Source.GetKey(&Entry), Entry.KeyLength, Value, (uint32_t)std::strlen(Value));
+	}
+
+	auto HitKeys = ToolUtils::ReadSourceKeys(SourcePath);
+	auto MissKeys = ToolUtils::ReadMissingKeys(MissingPath);
+
+	HashBenchResult Fnv1a, WordMix;
+	if (!BenchPolicy<Hashing::Fnv1a>(Builder, HitKeys, MissKeys, Fnv1a) || !BenchPolicy<Hashing::WordMix>(Builder, HitKeys, MissKeys, WordMix))
+		return 1;
+
+	printf("entries:        %u\n", View.EntryCount);
+	PrintResult("fnv1a", Fnv1a, HitKeys.size(), MissKeys.size());
+	PrintResult("wordmix", WordMix, HitKeys.size(), MissKeys.size());
+
+	return (Fnv1a.Hits == WordMix.Hits && Fnv1a.Misses == WordMix.Misses && Fnv1a.ReferenceHits == Fnv1a.Hits && WordMix.WideHits == WordMix.Hits) ? 0 : 1;
+}
\ No newline at end of file
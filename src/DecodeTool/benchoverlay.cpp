@@ -0,0 +1,221 @@
+// Standard includes
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Our includes
+#include "commands.h"
+#include "toolutils.h"
+#include "translationdb.h"
+#include "translationstack.h"
+#include "unicode.h"
+
+static const uint32_t Rounds = 20;
+
+// Times a lookup over every key, in nanoseconds per key
+template<typename Func>
+static double MeasureKeys(const std::vector<std::string>& Keys, Func Lookup, uint32_t& Found)
+{
+	Found = 0;
+
+	ToolUtils::Stopwatch Timer;
+	for (uint32_t Round = 0; Round < Rounds; Round++)
+	{
+		for (auto& Key : Keys)
+		{
+			if (Lookup(Key) != nullptr)
+				Found++;
+		}
+	}
+
+	Found /= Rounds;
+	return Timer.ElapsedNanoseconds() / ((double)Keys.size() * Rounds);
+}
+
+// Builds a layer from owned strings
+static std::unique_ptr<TranslationDB> BuildLayer(const std::vector<std::pair<std::string, std::string>>& Pairs)
+{
+	TranslationDBBuilder Builder;
+	for (auto& Pair : Pairs)
+		Builder.Add(Pair.first.c_str(), (uint32_t)Pair.first.size(), Pair.second.c_str(), (uint32_t)Pair.second.size());
+
+	std::vector<uint8_t> Image;
+	std::unique_ptr<TranslationDB> Layer(new TranslationDB());
+
+	if (!Builder.Build(Image) || !Layer->LoadImage(Image))
+		return nullptr;
+
+	return Layer;
+}
+
+int BenchOverlayCommand(int argc, char** argv)
+{
+	if (argc < 1)
+	{
+		printf("usage: d3tool bench-overlay <database.db> [--overlays 2] [--keys 500] [--missing en_missing.txt]\n");
+		return 1;
+	}
+
+	std::string DatabasePath = argv[0];
+	std::string MissingPath = "en/en_missing.txt";
+	uint32_t OverlayCount = 2, OverlayKeys = 500;
+
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (std::strcmp(argv[i], "--overlays") == 0)
+			OverlayCount = (uint32_t)std::max(1, std::atoi(argv[i + 1]));
+		else if (std::strcmp(argv[i], "--keys") == 0)
+			OverlayKeys = (uint32_t)std::max(1, std::atoi(argv[i + 1]));
+		else if (std::strcmp(argv[i], "--missing") == 0)
+			MissingPath = argv[i + 1];
+	}
+
+	std::unique_ptr<TranslationDB> Base(new TranslationDB());
+	if (!Base->Load(DatabasePath))
+	{
+		printf("Failed to load: %s\n", DatabasePath.c_str());
+		return 1;
+	}
+
+	// The merged view every stack lookup must agree with, built the slow way
+	std::unordered_map<std::string, std::string> Merged;
+	std::vector<std::string> BaseKeys;
+	auto& BaseView = Base->GetView();
+
+	for (uint32_t i = 0; i < BaseView.EntryCount; i++)
+	{
+		BaseKeys.push_back(Base->GetKey(&BaseView.Entries[i]));
+		Merged[BaseKeys.back()] = Base->GetValue(&BaseView.Entries[i]);
+	}
+
+	// Every overlay overrides base keys, keys of the overlay below it and adds a few of its own
+	std::mt19937 Random(7);
+	std::vector<std::vector<std::pair<std::string, std::string>>> Overlays(OverlayCount);
+	std::vector<std::string> OverlayOnly;
+
+	for (uint32_t Layer = 0; Layer < OverlayCount; Layer++)
+	{
+		auto Tag = "[L" + std::to_string(Layer + 1) + "] ";
+		auto& Pairs = Overlays[Layer];
+
+		for (uint32_t i = 0; i < OverlayKeys; i++)
+		{
+			std::string Key;
+
+			if (Layer > 0 && (i % 4) == 0)
+				Key = Overlays[Layer - 1][Random() % Overlays[Layer - 1].size()].first;
+			else if ((i % 4) == 1)
+				Key = "OVERLAY_" + std::to_string(Layer + 1) + "_KEY_" + std::to_string(i);
+			else
+				Key = BaseKeys[Random() % BaseKeys.size()];
+
+			if (Merged.find(Key) == Merged.end())
+				OverlayOnly.push_back(Key);
+
+			Pairs.push_back(std::make_pair(Key, Tag + Key));
+			Merged[Key] = Tag + Key;
+		}
+	}
+
+	auto MissingKeys = ToolUtils::ReadMissingKeys(MissingPath);
+	std::vector<std::string> AbsentKeys;
+	for (auto& Key : MissingKeys)
+	{
+		if (Merged.find(Key) == Merged.end())
+			AbsentKeys.push_back(Key);
+	}
+
+	// The same base alone, and under every overlay
+	std::unique_ptr<TranslationDB> SingleBase(new TranslationDB());
+	SingleBase->Load(DatabasePath);
+
+	TranslationStack Single, Stack;
+	Single.AddLayer(std::move(SingleBase), DatabasePath);
+	Single.BuildIndex();
+
+	auto BaseSize = Base->GetImageSize();
+	Stack.AddLayer(std::move(Base), DatabasePath);
+
+	size_t OverlayBytes = 0;
+	for (uint32_t Layer = 0; Layer < OverlayCount; Layer++)
+	{
+		auto Database = BuildLayer(Overlays[Layer]);
+		if (Database == nullptr)
+		{
+			printf("Failed to build overlay %u\n", Layer + 1);
+			return 1;
+		}
+
+		OverlayBytes += Database->GetImageSize();
+		Stack.AddLayer(std::move(Database), "overlay " + std::to_string(Layer + 1));
+	}
+
+	ToolUtils::Stopwatch Timer;
+	if (!Stack.BuildIndex())
+	{
+		printf("Failed to build the owner index\n");
+		return 1;
+	}
+	auto IndexTime = Timer.ElapsedMilliseconds();
+
+	// Every key must resolve like the merged map, in every key shape the hooks use
+	uint32_t Mismatches = 0;
+	std::vector<std::string> AllKeys;
+	for (auto& Pair : Merged)
+		AllKeys.push_back(Pair.first);
+
+	for (auto& Key : AllKeys)
+	{
+		auto& Expected = Merged[Key];
+		auto Value = Stack.Find(Key.c_str(), Key.size());
+		auto Reference = Stack.FindReference(("@" + Key).c_str());
+
+		std::vector<uint16_t> WideKey(Key.size() + 1);
+		size_t WideKeyLength = 0;
+		Unicode::Utf8ToUtf16(Key.c_str(), Key.size(), WideKey.data(), WideKeyLength);
+
+		const TranslationDBEntry* Entry = nullptr;
+		auto Layer = Stack.FindEntry(WideKey.data(), WideKeyLength, Entry);
+
+		if (Value == nullptr || Expected != Value || Reference != Value || Layer == nullptr || Layer->GetValue(Entry) != Value)
+			Mismatches++;
+	}
+
+	for (auto& Key : AbsentKeys)
+	{
+		if (Stack.Find(Key.c_str(), Key.size()) != nullptr)
+			Mismatches++;
+	}
+
+	if (Stack.GetEntryCount() != Merged.size())
+		Mismatches++;
+
+	std::vector<std::string> OverriddenKeys;
+	for (uint32_t Layer = 0; Layer < OverlayCount; Layer++)
+	{
+		for (auto& Pair : Overlays[Layer])
+			OverriddenKeys.push_back(Pair.first);
+	}
+
+	uint32_t SingleHits = 0, StackHits = 0, OverlayHits = 0, SingleMisses = 0, StackMisses = 0;
+	auto SingleHitNs = MeasureKeys(BaseKeys, [&Single](const std::string& Key) { return Single.Find(Key.c_str(), Key.size()); }, SingleHits);
+	auto StackHitNs = MeasureKeys(BaseKeys, [&Stack](const std::string& Key) { return Stack.Find(Key.c_str(), Key.size()); }, StackHits);
+	auto OverlayHitNs = MeasureKeys(OverriddenKeys, [&Stack](const std::string& Key) { return Stack.Find(Key.c_str(), Key.size()); }, OverlayHits);
+	auto SingleMissNs = MeasureKeys(AbsentKeys, [&Single](const std::string& Key) { return Single.Find(Key.c_str(), Key.size()); }, SingleMisses);
+	auto StackMissNs = MeasureKeys(AbsentKeys, [&Stack](const std::string& Key) { return Stack.Find(Key.c_str(), Key.size()); }, StackMisses);
+
+	printf("base:           %u entries, %u bytes\n", Stack.GetLayer(0).GetEntryCount(), BaseSize);
+	printf("overlays:       %u x %u keys, %u bytes\n", OverlayCount, OverlayKeys, (uint32_t)OverlayBytes);
+	printf("owner index:    %u keys, %u bytes, built in %.2f ms\n", Stack.GetOverlayKeyCount(), (uint32_t)Stack.GetIndexSize(), IndexTime);
+	printf("entries:        %u distinct (%u only in overlays)\n", Stack.GetEntryCount(), (uint32_t)OverlayOnly.size());
+	printf("base hit:       %.1f ns single, %.1f ns stacked\n", SingleHitNs, StackHitNs);
+	printf("overlay hit:    %.1f ns stacked\n", OverlayHitNs);
+	printf("miss:           %.1f ns single, %.1f ns stacked\n", SingleMissNs, StackMissNs);
+	printf("mismatches:     %u\n", Mismatches);
+
+	return (Mismatches == 0 && StackMisses == 0 && SingleHits == StackHits) ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,854 @@
+// Platform includes
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#include <immintrin.h>
+#define LEGACY_SSE42 1
+#else
+#define LEGACY_SSE42 0
+#endif
+
+// Standard includes
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+// Our includes
+#include "commands.h"
+#include "toolutils.h"
+#include "cpufeatures.h"
+#include "patternscan.h"
+#include "parallel.h"
+#include "sitecache.h"
+
+// The signatures DecodeApplyPatches looks for
+static const struct
+{
+	const char* Name;
+	const char* Pattern;
+} Signatures[] =
+{
+	{ "SEHTranslate", "55 8B EC 83 E4 ? A1 ? ? ? ? 56 57 85 C0" },
+	{ "ScaleformTranslate", "8B 50 ?? 33 F6 56 6A ?? FF D2 3B C6 74" },
+	{ "DBFindXAssetHeader", "55 8B EC 83 E4 ? 83 EC ? 53 56 57 C7 44 24 ? ? ? ? ? 80 3D ? ? ? ? ?" },
+	{ "SEGetString", "55 8B EC 83 EC ? 53 56 BE ? ? ? ? 2B CE" },
+	{ "ScaleformSetInfo", "55 8B EC 8B 45 ? 56 8B F1 85 C0 74 ? 53" },
+};
+
+// Extra bytes after the image, the legacy scan reads past the end of the range
+static const size_t ImagePadding = 64;
+
+// The scan phook.h had, parsing and searching exactly as it did
+class LegacyPatternScan
+{
+private:
+	std::string PatternData;
+	std::string PatternMask;
+
+#if LEGACY_SSE42
+	// The SSE4.2 loop, one unaligned compare at every offset
+#ifndef _MSC_VER
+	__attribute__((target("sse4.2")))
+#endif
+	intptr_t ScanSse42(uintptr_t Source, uintptr_t SourceSize)
+	{
+		alignas(16) char DesiredMask[16] = { 0 };
+
+		for (size_t i = 0; i < this->PatternMask.size(); i++)
+			DesiredMask[i / 8] |= ((this->PatternMask[i] == '?') ? 0 : 1) << (i % 8);
+
+		__m128i Mask = _mm_load_si128((const __m128i*)DesiredMask);
+		__m128i Comparand = _mm_loadu_si128((const __m128i*)this->PatternData.c_str());
+
+		for (uint64_t i = Source; i <= (Source + SourceSize); i++)
+		{
+			__m128i Value = _mm_loadu_si128((const __m128i*)i);
+			__m128i Result = _mm_cmpestrm(Value, 16, Comparand, (int)this->PatternData.size(), _SIDD_CMP_EQUAL_EACH);
+
+			__m128i Matches = _mm_and_si128(Mask, Result);
+			__m128i Equivalence = _mm_xor_si128(Mask, Matches);
+
+			if (_mm_test_all_zeros(Equivalence, Equivalence))
+				return (intptr_t)(i - Source);
+		}
+
+		return -1;
+	}
+#endif
+
+public:
+	LegacyPatternScan(const char* Pattern)
+	{
+		uint8_t TempDigit = 0;
+		bool TempFlag = false;
+		bool LastWasUnknown = false;
+
+		// The length was measured every iteration
+		for (size_t i = 0; i < strlen(Pattern); i++)
+		{
+			auto& ch = Pattern[i];
+
+			if (ch == ' ')
+			{
+				LastWasUnknown = false;
+				continue;
+			}
+			else if (ch == '?')
+			{
+				if (LastWasUnknown)
+				{
+					LastWasUnknown = false;
+				}
+				else
+				{
+					PatternData += '\x00';
+					PatternMask += '?';
+					LastWasUnknown = true;
+				}
+			}
+			else if ((ch >= '0' && ch <= '9') || (ch >= 'A' && ch <= 'F') || (ch >= 'a' && ch <= 'f'))
+			{
+				char StrBuffer[] = { ch, 0 };
+				int thisDigit = strtol(StrBuffer, nullptr, 16);
+
+				if (!TempFlag)
+				{
+					TempDigit = (thisDigit << 4);
+					TempFlag = true;
+				}
+				else
+				{
+					TempDigit |= thisDigit;
+					TempFlag = false;
+
+					PatternData += TempDigit;
+					PatternMask += 'x';
+				}
+
+				LastWasUnknown = false;
+			}
+		}
+	}
+
+	// Gets the parsed bytes, and whether each is fixed
+	void GetSignature(std::vector<uint8_t>& Bytes, std::vector<bool>& Fixed) const
+	{
+		Bytes.assign(this->PatternData.begin(), this->PatternData.end());
+		Fixed.clear();
+		for (auto Mask : this->PatternMask)
+			Fixed.push_back(Mask != '?');
+	}
+
+	intptr_t Scan(uintptr_t Source, uintptr_t SourceSize)
+	{
+		bool UseSSE = false;
+
+		// Checked on every scan, only for patterns of 16 bytes or less
+#if LEGACY_SSE42
+		if (this->PatternMask.size() <= 16)
+		{
+#ifdef _MSC_VER
+			int cpuid[4]; __cpuid(cpuid, 0);
+			if (cpuid[0] >= 1)
+			{
+				__cpuidex(cpuid, 1, 0);
+				UseSSE = ((cpuid[2] & (1 << 20)) > 0);
+			}
+#else
+			unsigned int cpuid[4] = { 0 };
+			if (__get_cpuid_max(0, nullptr) >= 1)
+			{
+				__cpuid_count(1, 0, cpuid[0], cpuid[1], cpuid[2], cpuid[3]);
+				UseSSE = ((cpuid[2] & (1 << 20)) > 0);
+			}
+#endif
+		}
+
+		if (UseSSE)
+			return this->ScanSse42(Source, SourceSize);
+#endif
+
+		const char* PatternData = this->PatternData.c_str();
+		char* DataPtr = (char*)Source;
+
+		for (uint64_t i = 0; i < SourceSize; i++)
+		{
+			bool IsMatch = true;
+			for (size_t c = 0; c < this->PatternData.size(); c++)
+			{
+				if (this->PatternMask[c] == '?')
+					continue;
+
+				if (PatternData[c] != DataPtr[i + c])
+				{
+					IsMatch = false;
+					break;
+				}
+			}
+
+			if (IsMatch)
+				return (intptr_t)(i);
+		}
+
+		return -1;
+	}
+};
+
+// Synthesizes a code image, bytes as common as they are in x86 code with function prologues every few hundred bytes.
+// Every signature is placed once near the end, with near misses (one fixed byte off) spread through the whole image
+static void BuildImage(size_t Size, uint32_t Seed, std::vector<uint8_t>& Image, std::vector<size_t>& Expected, uint32_t& NearMisses)
+{
+	std::mt19937 Random(Seed);
+
+	// Bytes by rank, drawn with a weight falling off as the rank gets rarer
+	std::vector<uint8_t> Distribution;
+	for (uint32_t Value = 0; Value < 256; Value++)
+	{
+		auto Common = 256 - (uint32_t)PatternScan::GetByteRank((uint8_t)Value);
+		auto Weight = std::max<uint32_t>(1, (Common * Common * Common) / 65536);
+
+		Distribution.insert(Distribution.end(), Weight, (uint8_t)Value);
+	}
+
+	Image.assign(Size + ImagePadding, 0);
+	std::uniform_int_distribution<uint32_t> Pick(0, (uint32_t)Distribution.size() - 1);
+
+	for (size_t i = 0; i < Size; i++)
+		Image[i] = Distribution[Pick(Random)];
+
+	static const uint8_t Prologue[] = { 0x55, 0x8B, 0xEC, 0x83, 0xE4, 0xF8, 0x83, 0xEC };
+	for (size_t Offset = 0; Offset + 64 < Size; Offset += 64 + (Random() % 448))
+		std::memcpy(&Image[Offset], Prologue, sizeof(Prologue));
+
+	NearMisses = 0;
+	Expected.clear();
+
+	auto Tail = Size - std::min<size_t>(Size / 2, 1024 * 1024);
+
+	for (auto& Signature : Signatures)
+	{
+		std::vector<uint8_t> Bytes;
+		std::vector<bool> Fixed;
+		LegacyPatternScan(Signature.Pattern).GetSignature(Bytes, Fixed);
+
+		// Wildcards take random bytes
+		auto Place = [&](size_t Offset, int32_t Broken)
+		{
+			for (size_t i = 0; i < Bytes.size(); i++)
+				Image[Offset + i] = Fixed[i] ? Bytes[i] : (uint8_t)Random();
+
+			if (Broken >= 0)
+				Image[Offset + Broken] ^= 0x01;
+		};
+
+		// The anchors are kept, so every near miss is a candidate that fails verification
+		PatternScan Scanner(Signature.Pattern);
+		for (uint32_t a = 0; a < 2; a++)
+			Fixed[Scanner.GetAnchor(a)] = false;
+
+		for (size_t Offset = Random() % 65536; Offset + 1024 < Tail; Offset += 32768 + (Random() % 65536))
+		{
+			int32_t Broken = (int32_t)(Random() % Bytes.size());
+			while (!Fixed[Broken])
+				Broken = (Broken + 1) % (int32_t)Bytes.size();
+
+			Place(Offset, Broken);
+			for (uint32_t a = 0; a < 2; a++)
+				Image[Offset + Scanner.GetAnchor(a)] = Bytes[Scanner.GetAnchor(a)];
+
+			NearMisses++;
+		}
+
+		auto Offset = Tail + (Random() % (Size - Tail - 64));
+		Place(Offset, -1);
+		for (uint32_t a = 0; a < 2; a++)
+			Image[Offset + Scanner.GetAnchor(a)] = Bytes[Scanner.GetAnchor(a)];
+		Expected.push_back(Offset);
+	}
+}
+
+// A random signature for a range, half of them copied out of it. Bytes are -1 for wildcards
+static std::string RandomSignature(std::mt19937& Random, const std::vector<uint8_t>& Range, std::vector<int32_t>& Signature)
+{
+	Signature.resize(1 + (Random() % 40));
+	auto Origin = (!Range.empty() && (Random() & 1) != 0) ? (size_t)(Random() % Range.size()) : Range.size();
+
+	std::string Pattern;
+	for (size_t i = 0; i < Signature.size(); i++)
+	{
+		char Text[4];
+
+		if ((Random() % 4) == 0 && i != 0)
+		{
+			Signature[i] = -1;
+			Pattern += "? ";
+			continue;
+		}
+
+		Signature[i] = (Origin + i < Range.size()) ? Range[Origin + i] : (int32_t)(0x50 + (Random() % 4));
+		snprintf(Text, sizeof(Text), "%02X ", Signature[i]);
+		Pattern += Text;
+	}
+
+	return Pattern;
+}
+
+// Whether or not a signature from RandomSignature matches at an address, a byte at a time
+static bool SignatureMatches(const uint8_t* Data, const std::vector<int32_t>& Signature)
+{
+	for (size_t i = 0; i < Signature.size(); i++)
+	{
+		if (Signature[i] >= 0 && Signature[i] != Data[i])
+			return false;
+	}
+
+	return true;
+}
+
+// Scans random ranges for random sets of signatures at every level, exactly sized so a read past the range is caught
+// under a sanitizer. Returns the amount of scans that disagreed with a byte at a time search
+static uint32_t CheckRandomScans(uint32_t Cases, uint32_t Seed)
+{
+	std::mt19937 Random(Seed);
+	uint32_t Failures = 0;
+
+	for (uint32_t Case = 0; Case < Cases; Case++)
+	{
+		// Few distinct bytes, so partial matches are common
+		std::vector<uint8_t> Range(Random() % 400);
+		for (auto& Byte : Range)
+			Byte = (uint8_t)(0x50 + (Random() % 4));
+
+		MultiPatternScan Set;
+		std::vector<std::string> Patterns;
+		std::vector<PatternMatch> ExpectedAll;
+		std::vector<intptr_t> ExpectedFirst;
+
+		auto Count = 1 + (Random() % 12);
+		for (uint32_t Id = 0; Id < Count; Id++)
+		{
+			std::vector<int32_t> Signature;
+			Patterns.push_back(RandomSignature(Random, Range, Signature));
+			Set.Add(Patterns.back().c_str());
+			ExpectedFirst.push_back(-1);
+
+			for (size_t Start = 0; Start + Signature.size() <= Range.size(); Start++)
+			{
+				if (!SignatureMatches(Range.data() + Start, Signature))
+					continue;
+
+				ExpectedAll.push_back({ Id, (uintptr_t)Start });
+				if (ExpectedFirst[Id] < 0)
+					ExpectedFirst[Id] = (intptr_t)Start;
+			}
+		}
+
+		std::sort(ExpectedAll.begin(), ExpectedAll.end(), [](const PatternMatch& Left, const PatternMatch& Right)
+		{
+			return (Left.Offset != Right.Offset) ? (Left.Offset < Right.Offset) : (Left.Id < Right.Id);
+		});
+
+		// An empty vector has no storage to point at
+		std::unique_ptr<uint8_t[]> Exact(new uint8_t[Range.size() + 1]);
+		if (!Range.empty())
+			std::memcpy(Exact.get(), Range.data(), Range.size());
+
+		auto Source = (uintptr_t)Exact.get();
+
+		for (uint32_t Level = CPU_LEVEL_SCALAR; Level <= (uint32_t)CpuFeatures::GetSupportedLevel(); Level++)
+		{
+			CpuFeatures::SetLevelLimit((CpuLevel)Level);
+
+			for (uint32_t Id = 0; Id < Count; Id++)
+			{
+				if (PatternScan(Patterns[Id].c_str()).Scan(Source, Range.size()) != ExpectedFirst[Id])
+					Failures++;
+			}
+
+			std::vector<intptr_t> First;
+			Set.ScanFirst(Source, Range.size(), First);
+			if (First != ExpectedFirst)
+				Failures++;
+
+			std::vector<PatternMatch> All;
+			Set.ScanAll(Source, Range.size(), All);
+
+			auto Same = (All.size() == ExpectedAll.size());
+			for (size_t i = 0; Same && i < All.size(); i++)
+				Same = (All[i].Id == ExpectedAll[i].Id && All[i].Offset == ExpectedAll[i].Offset);
+
+			if (!Same)
+				Failures++;
+		}
+	}
+
+	CpuFeatures::SetLevelLimit(CPU_LEVEL_AVX2);
+	return Failures;
+}
+
+// Runs a scan once per round, returns the milliseconds of the fastest
+// Places random signatures over and beside the chunk boundaries of a few chunks, then checks the chunked scans on
+// 1 to MaxThreads workers against a byte at a time search. Returns the amount of scans that disagreed
+static uint32_t CheckChunkBoundaries(uint32_t MaxThreads, uint32_t Seed)
+{
+	std::mt19937 Random(Seed);
+	uint32_t Failures = 0;
+
+	auto ChunkSize = PatternScan::GetChunkSize();
+	std::vector<uint8_t> Range(ChunkSize * 3 + 100);
+	for (auto& Byte : Range)
+		Byte = (uint8_t)Random();
+
+	MultiPatternScan Set;
+	std::vector<std::string> Patterns;
+	std::vector<std::vector<int32_t>> Signatures;
+	std::vector<uint8_t> Empty;
+
+	for (uint32_t Id = 0; Id < 16; Id++)
+	{
+		Signatures.emplace_back();
+		Patterns.push_back(RandomSignature(Random, Empty, Signatures.back()));
+		Set.Add(Patterns.back().c_str());
+
+		// Across each boundary, its last start, its first start and the end of the range
+		auto& Signature = Signatures.back();
+		std::vector<size_t> Places;
+
+		for (size_t Boundary = ChunkSize; Boundary < Range.size(); Boundary += ChunkSize)
+		{
+			Places.push_back(Boundary - std::min(Boundary, (Signature.size() / 2) + (Random() % 4)));
+			Places.push_back(Boundary - 1);
+			Places.push_back(Boundary);
+		}
+		Places.push_back(Range.size() - Signature.size());
+
+		for (auto Place : Places)
+		{
+			for (size_t i = 0; i < Signature.size(); i++)
+			{
+				if (Signature[i] >= 0)
+					Range[Place + i] = (uint8_t)Signature[i];
+			}
+		}
+	}
+
+	// Placed after each other, so a later one can overwrite an earlier one, the search decides what's there
+	std::vector<std::vector<uintptr_t>> Expected(Signatures.size());
+	std::vector<PatternMatch> ExpectedAll;
+	std::vector<intptr_t> ExpectedFirst(Signatures.size(), -1);
+
+	for (size_t Start = 0; Start < Range.size(); Start++)
+	{
+		for (uint32_t Id = 0; Id < (uint32_t)Signatures.size(); Id++)
+		{
+			if (Start + Signatures[Id].size() > Range.size() || !SignatureMatches(Range.data() + Start, Signatures[Id]))
+				continue;
+
+			Expected[Id].push_back(Start);
+			ExpectedAll.push_back({ Id, (uintptr_t)Start });
+			if (ExpectedFirst[Id] < 0)
+				ExpectedFirst[Id] = (intptr_t)Start;
+		}
+	}
+
+	auto Source = (uintptr_t)Range.data();
+
+	for (uint32_t Threads = 1; Threads <= MaxThreads; Threads++)
+	{
+		for (uint32_t Id = 0; Id < (uint32_t)Signatures.size(); Id++)
+		{
+			PatternScan Scanner(Patterns[Id].c_str());
+
+			if (Scanner.ScanParallel(Source, Range.size(), Threads) != ExpectedFirst[Id])
+				Failures++;
+
+			std::vector<uintptr_t> All;
+			Scanner.ScanAll(Source, Range.size(), All, Threads);
+			if (All != Expected[Id])
+				Failures++;
+		}
+
+		std::vector<intptr_t> First;
+		Set.ScanFirst(Source, Range.size(), First, Threads);
+		if (First != ExpectedFirst)
+			Failures++;
+
+		std::vector<PatternMatch> All;
+		Set.ScanAll(Source, Range.size(), All, Threads);
+
+		auto Same = (All.size() == ExpectedAll.size());
+		for (size_t i = 0; Same && i < All.size(); i++)
+			Same = (All[i].Id == ExpectedAll[i].Id && All[i].Offset == ExpectedAll[i].Offset);
+
+		if (!Same)
+			Failures++;
+	}
+
+	return Failures;
+}
+
+template<typename Scan>
+static double MeasureScan(uint32_t Rounds, intptr_t& Result, Scan&& Function)
+{
+	double Best = 0.0;
+
+	for (uint32_t Round = 0; Round < Rounds; Round++)
+	{
+		ToolUtils::Stopwatch Timer;
+		Result = Function();
+
+		auto Time = Timer.ElapsedMilliseconds();
+		if (Round == 0 || Time < Best)
+			Best = Time;
+	}
+
+	return Best;
+}
+
+// Reads a little endian value at any alignment
+static uint32_t ReadValue32(const uint8_t* Data)
+{
+	uint32_t Value;
+	std::memcpy(&Value, Data, sizeof(Value));
+	return Value;
+}
+
+// Writes PE headers over the start of a synthetic image, enough for SiteCache to identify it
+static void WriteImageHeaders(std::vector<uint8_t>& Image, uint32_t TimeDateStamp, uint32_t ImageBase)
+{
+	auto Write = [&](size_t Offset, uint32_t Value) { std::memcpy(Image.data() + Offset, &Value, sizeof(Value)); };
+
+	std::memset(Image.data(), 0, 0x400);
+	Image[0] = 'M';
+	Image[1] = 'Z';
+	Write(0x3C, 0x80);
+	std::memcpy(Image.data() + 0x80, "PE\0\0", 4);
+	Write(0x88, TimeDateStamp);
+
+	// A 32bit optional header, its image base, image size and headers size
+	Image[0x98] = 0x0B;
+	Image[0x99] = 0x01;
+	Write(0x98 + 28, ImageBase);
+	Write(0x98 + 56, (uint32_t)Image.size());
+	Write(0x98 + 60, 0x400);
+}
+
+// What DecodeApplyPatches does at startup: the cached sites when they still match, along with a value derived from
+// the second signature's site, otherwise a scan that rewrites the cache once every signature is found
+static bool ResolveSites(const std::string& Path, const std::vector<uint8_t>& Image, size_t Size, const MultiPatternScan& Set, std::vector<intptr_t>& Offsets)
+{
+	SiteCache Cache(Path, Image.data(), Size, Set);
+
+	std::vector<uint32_t> Sites, Extras;
+	auto Cached = Cache.Load(Set, Image.data(), Size, Sites, Extras) && Extras.size() == 1 && Sites[1] + 0x28 <= Size && ReadValue32(Image.data() + Sites[1] + 0x24) == Extras[0];
+
+	Offsets.assign(Sites.begin(), Sites.end());
+	if (Cached)
+		return true;
+
+	Set.ScanFirst((uintptr_t)Image.data(), Size, Offsets);
+	if (std::find(Offsets.begin(), Offsets.end(), -1) == Offsets.end() && (size_t)Offsets[1] + 0x28 <= Size)
+	{
+		Sites.assign(Offsets.begin(), Offsets.end());
+		Extras.assign(1, ReadValue32(Image.data() + Offsets[1] + 0x24));
+		Cache.Save(Sites, Extras);
+	}
+
+	return false;
+}
+
+// Runs the cache through a patched game, a moved function, a damaged file and changed signatures, returns the amount
+// of launches that didn't resolve what a scan finds or used the cache when they shouldn't have
+static uint32_t CheckSiteCache(std::vector<uint8_t> Image, size_t Size, const MultiPatternScan& Set, uint32_t Rounds, double& LoadTime, double& ScanTime)
+{
+	auto Path = std::string("bench_pattern.sites");
+	std::remove(Path.c_str());
+
+	WriteImageHeaders(Image, 0x5F3C1A00, 0x400000);
+
+	std::vector<intptr_t> Expected;
+	Set.ScanFirst((uintptr_t)Image.data(), Size, Expected);
+
+	uint32_t Failures = 0;
+	auto Launch = [&](bool ShouldBeCached)
+	{
+		std::vector<intptr_t> Offsets;
+		std::vector<intptr_t> Reference;
+		Set.ScanFirst((uintptr_t)Image.data(), Size, Reference);
+
+		if (ResolveSites(Path, Image, Size, Set, Offsets) != ShouldBeCached || Offsets != Reference)
+			Failures++;
+	};
+
+	// The first launch scans, the next ones use the cache
+	Launch(false);
+	Launch(true);
+
+	intptr_t Result = 0;
+	LoadTime = MeasureScan(Rounds, Result, [&]() { std::vector<intptr_t> Offsets; return (intptr_t)ResolveSites(Path, Image, Size, Set, Offsets); });
+	ScanTime = MeasureScan(Rounds, Result, [&]() { std::vector<intptr_t> Offsets; Set.ScanFirst((uintptr_t)Image.data(), Size, Offsets); return Offsets[0]; });
+
+	// Relocating the image rewrites its base in the headers, it's still the same executable
+	WriteImageHeaders(Image, 0x5F3C1A00, 0x10000000);
+	Launch(true);
+
+	// A patch changes the timestamp, the sites are scanned for and cached again
+	WriteImageHeaders(Image, 0x5F3C1B00, 0x400000);
+	Launch(false);
+	Launch(true);
+
+	// The same headers over different code, the site of the first signature no longer matches
+	auto Moved = (size_t)Expected[0] + PatternScan(Signatures[0].Pattern).GetAnchor(0);
+	auto Original = Image[Moved];
+	Image[Moved] ^= 0xFF;
+	Launch(false);
+	Image[Moved] = Original;
+	Launch(true);
+
+	// A damaged file is scanned over and replaced
+	std::vector<uint8_t> File;
+	ToolUtils::ReadFile(Path, File);
+	File.back() ^= 0x01;
+	ToolUtils::WriteFile(Path, File.data(), File.size());
+	Launch(false);
+	Launch(true);
+
+	// Another set of signatures doesn't use sites found for this one
+	MultiPatternScan Fewer;
+	for (size_t s = 1; s < sizeof(Signatures) / sizeof(Signatures[0]); s++)
+		Fewer.Add(Signatures[s].Pattern);
+
+	std::vector<intptr_t> Offsets;
+	if (ResolveSites(Path, Image, Size, Fewer, Offsets))
+		Failures++;
+
+	std::remove(Path.c_str());
+	return Failures;
+}
+
+int BenchPatternCommand(int argc, char** argv)
+{
+	uint32_t SizeMegabytes = 30;
+	uint32_t Rounds = 5;
+	uint32_t Seed = 1;
+	uint32_t MaxThreads = Parallel::GetWorkerCount();
+	std::string ImagePath;
+
+	for (int i = 0; i + 1 < argc; i += 2)
+	{
+		if (std::strcmp(argv[i], "--size") == 0)
+			SizeMegabytes = (uint32_t)std::max(1, std::atoi(argv[i + 1]));
+		else if (std::strcmp(argv[i], "--rounds") == 0)
+			Rounds = (uint32_t)std::max(1, std::atoi(argv[i + 1]));
+		else if (std::strcmp(argv[i], "--seed") == 0)
+			Seed = (uint32_t)std::atoi(argv[i + 1]);
+		else if (std::strcmp(argv[i], "--image") == 0)
+			ImagePath = argv[i + 1];
+		else if (std::strcmp(argv[i], "--threads") == 0)
+			MaxThreads = (uint32_t)std::max(1, std::atoi(argv[i + 1]));
+	}
+
+	std::vector<uint8_t> Image;
+	std::vector<size_t> Expected;
+	uint32_t NearMisses = 0;
+	size_t Size = 0;
+
+	if (!ImagePath.empty())
+	{
+		// A real binary, nothing is placed so only agreement is checked
+		if (!ToolUtils::ReadFile(ImagePath, Image) || Image.empty())
+		{
+			printf("Failed to read: %s\n", ImagePath.c_str());
+			return 1;
+		}
+
+		Size = Image.size();
+		Image.resize(Size + ImagePadding, 0);
+		printf("image:    %s, %.1f MB\n", ImagePath.c_str(), Size / (1024.0 * 1024.0));
+	}
+	else
+	{
+		Size = (size_t)SizeMegabytes * 1024 * 1024;
+		BuildImage(Size, Seed, Image, Expected, NearMisses);
+		printf("image:    %.1f MB of synthetic x86 code, each signature once in the last MB, %u near misses\n", Size / (1024.0 * 1024.0), NearMisses);
+	}
+
+	auto Source = (uintptr_t)Image.data();
+	auto Supported = CpuFeatures::GetSupportedLevel();
+
+	printf("%-20s %6s %7s", "signature", "bytes", "anchors");
+	printf(" %12s", "legacy");
+	for (uint32_t Level = CPU_LEVEL_SCALAR; Level <= (uint32_t)Supported; Level++)
+		printf(" %12s", CpuFeatures::GetLevelName((CpuLevel)Level));
+	printf("\n");
+
+	std::vector<double> Totals(2 + (size_t)Supported, 0.0);
+	bool Valid = true;
+
+	for (size_t s = 0; s < sizeof(Signatures) / sizeof(Signatures[0]); s++)
+	{
+		auto& Signature = Signatures[s];
+		PatternScan Scanner(Signature.Pattern);
+
+		char Anchors[16];
+		snprintf(Anchors, sizeof(Anchors), "+%u,+%u", Scanner.GetAnchor(0), Scanner.GetAnchor(1));
+		printf("%-20s %6u %7s", Signature.Name, (uint32_t)Scanner.GetLength(), Anchors);
+
+		// The legacy scan parsed the signature for every call, as FindPattern still does
+		intptr_t LegacyResult = -1;
+		auto LegacyTime = MeasureScan(Rounds, LegacyResult, [&]() { return LegacyPatternScan(Signature.Pattern).Scan(Source, Size); });
+		Totals[0] += LegacyTime;
+		printf(" %9.2f ms", LegacyTime);
+
+		if (!Expected.empty() && LegacyResult != (intptr_t)Expected[s])
+		{
+			printf("\n%s: legacy found %lld, placed at %llu\n", Signature.Name, (long long)LegacyResult, (unsigned long long)Expected[s]);
+			Valid = false;
+		}
+
+		for (uint32_t Level = CPU_LEVEL_SCALAR; Level <= (uint32_t)Supported; Level++)
+		{
+			CpuFeatures::SetLevelLimit((CpuLevel)Level);
+
+			intptr_t Result = -1;
+			auto Time = MeasureScan(Rounds, Result, [&]() { return PatternScan(Signature.Pattern).Scan(Source, Size); });
+			Totals[1 + Level] += Time;
+			printf(" %9.2f ms", Time);
+
+			if (Result != LegacyResult)
+			{
+				printf("\n%s: %s found %lld, legacy %lld\n", Signature.Name, CpuFeatures::GetLevelName((CpuLevel)Level), (long long)Result, (long long)LegacyResult);
+				Valid = false;
+			}
+		}
+
+		CpuFeatures::SetLevelLimit(CPU_LEVEL_AVX2);
+		printf("\n");
+	}
+
+	printf("%-20s %6s %7s", "all five", "", "");
+	for (auto Total : Totals)
+		printf(" %9.2f ms", Total);
+	printf("\n");
+
+	printf("%-20s %6s %7s", "throughput", "", "");
+	for (auto Total : Totals)
+		printf(" %7.2f GB/s", (Size * 5.0 / (1024.0 * 1024.0 * 1024.0)) / (Total / 1000.0));
+	printf("\n");
+
+	// All five in one pass, against the five separate scans above
+	MultiPatternScan Set;
+	for (auto& Signature : Signatures)
+		Set.Add(Signature.Pattern);
+
+	printf("%-20s %6s %7s %12s", "one pass first", "", "", "");
+	for (uint32_t Level = CPU_LEVEL_SCALAR; Level <= (uint32_t)Supported; Level++)
+	{
+		CpuFeatures::SetLevelLimit((CpuLevel)Level);
+
+		std::vector<intptr_t> First;
+		intptr_t Found = 0;
+		auto Time = MeasureScan(Rounds, Found, [&]() { Set.ScanFirst(Source, Size, First); return (intptr_t)First.size(); });
+		printf(" %9.2f ms", Time);
+
+		for (size_t s = 0; s < First.size(); s++)
+		{
+			auto Legacy = LegacyPatternScan(Signatures[s].Pattern).Scan(Source, Size);
+			if (First[s] != Legacy)
+			{
+				printf("\n%s: one pass %s found %lld, legacy %lld\n", Signatures[s].Name, CpuFeatures::GetLevelName((CpuLevel)Level), (long long)First[s], (long long)Legacy);
+				Valid = false;
+			}
+		}
+	}
+	printf("\n");
+
+	printf("%-20s %6s %7s %12s", "one pass all", "", "", "");
+	for (uint32_t Level = CPU_LEVEL_SCALAR; Level <= (uint32_t)Supported; Level++)
+	{
+		CpuFeatures::SetLevelLimit((CpuLevel)Level);
+
+		std::vector<PatternMatch> All;
+		intptr_t Found = 0;
+		auto Time = MeasureScan(Rounds, Found, [&]() { Set.ScanAll(Source, Size, All); return (intptr_t)All.size(); });
+		printf(" %9.2f ms", Time);
+	}
+	printf("\n");
+
+	CpuFeatures::SetLevelLimit(CPU_LEVEL_AVX2);
+
+	// The chunked scans on 1 to MaxThreads workers, each checked against one worker
+	printf("\n%-20s %12s %12s %12s %12s %8s\n", "threads", "five first", "five all", "pass first", "pass all", "speedup");
+
+	std::vector<intptr_t> SerialFirst;
+	std::vector<std::vector<uintptr_t>> SerialAll;
+	std::vector<PatternMatch> SerialPassAll;
+	double SerialTime = 0.0;
+
+	for (uint32_t Threads = 1; Threads <= MaxThreads; Threads++)
+	{
+		double FirstTime = 0.0, AllTime = 0.0;
+		std::vector<intptr_t> First;
+		std::vector<std::vector<uintptr_t>> All(sizeof(Signatures) / sizeof(Signatures[0]));
+
+		for (size_t s = 0; s < All.size(); s++)
+		{
+			PatternScan Scanner(Signatures[s].Pattern);
+			intptr_t Result = -1;
+
+			FirstTime += MeasureScan(Rounds, Result, [&]() { return Scanner.ScanParallel(Source, Size, Threads); });
+			First.push_back(Result);
+
+			AllTime += MeasureScan(Rounds, Result, [&]() { Scanner.ScanAll(Source, Size, All[s], Threads); return (intptr_t)All[s].size(); });
+		}
+
+		std::vector<intptr_t> PassFirst;
+		std::vector<PatternMatch> PassAll;
+		intptr_t Found = 0;
+
+		auto PassFirstTime = MeasureScan(Rounds, Found, [&]() { Set.ScanFirst(Source, Size, PassFirst, Threads); return (intptr_t)PassFirst.size(); });
+		auto PassAllTime = MeasureScan(Rounds, Found, [&]() { Set.ScanAll(Source, Size, PassAll, Threads); return (intptr_t)PassAll.size(); });
+
+		if (Threads == 1)
+		{
+			SerialFirst = First;
+			SerialAll = All;
+			SerialPassAll = PassAll;
+			SerialTime = PassFirstTime;
+		}
+
+		printf("%-20u %9.2f ms %9.2f ms %9.2f ms %9.2f ms %7.2fx\n", Threads, FirstTime, AllTime, PassFirstTime, PassAllTime, SerialTime / PassFirstTime);
+
+		auto Same = (First == SerialFirst && All == SerialAll && PassFirst == SerialFirst && PassAll.size() == SerialPassAll.size());
+		for (size_t i = 0; Same && i < PassAll.size(); i++)
+			Same = (PassAll[i].Id == SerialPassAll[i].Id && PassAll[i].Offset == SerialPassAll[i].Offset);
+
+		if (!Same)
+		{
+			printf("%u threads: the chunked scans disagree with one worker\n", Threads);
+			Valid = false;
+		}
+	}
+
+	auto BoundaryFailures = CheckChunkBoundaries(std::max<uint32_t>(MaxThreads, 4), Seed);
+	printf("\nchunks:   16 signatures over and beside %u KB chunk boundaries, %u scans disagree with a byte at a time search\n", (uint32_t)(PatternScan::GetChunkSize() / 1024), BoundaryFailures);
+
+	double LoadTime = 0.0, ScanTime = 0.0;
+	auto CacheFailures = CheckSiteCache(Image, Size, Set, Rounds, LoadTime, ScanTime);
+	printf("cache:    cached sites loaded and checked in %.3f ms against a %.2f ms scan, %u of 10 launches went wrong\n", LoadTime, ScanTime, CacheFailures);
+
+	auto Failures = CheckRandomScans(20000, Seed);
+	printf("random:   20000 sets of 1 to 12 signatures over short ranges, %u scans disagree with a byte at a time search\n", Failures);
+
+	Valid = Valid && Failures == 0 && BoundaryFailures == 0 && CacheFailures == 0;
+	printf("result:   %s\n", Valid ? "every level finds what the legacy scan finds" : "FAILED");
+	return Valid ? 0 : 1;
+}
\ No newline at end of file
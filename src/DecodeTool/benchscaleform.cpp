@@ -0,0 +1,197 @@
+// Standard includes
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <codecvt>
+#include <locale>
+#include <unordered_map>
+
+// Our includes
+#include "commands.h"
+#include "toolutils.h"
+#include "translate.h"
+#include "unicode.h"
+
+// Stand-in for the engine's translate info, the key is the first field like the real one
+struct MockTranslateInfo
+{
+	const uint16_t* Key;
+	const uint16_t* Result;
+	uint32_t ResultLength;
+};
+
+// Stand-in for TranslateInfoSetResult, a length of -1 makes the engine measure the string
+static int MockSetResult(MockTranslateInfo* TranslateInfo, const uint16_t* ResultText, int ResultTextLength)
+{
+	if (ResultTextLength < 0)
+	{
+		ResultTextLength = 0;
+		while (ResultText[ResultTextLength] != 0)
+			ResultTextLength++;
+	}
+
+	TranslateInfo->Result = ResultText;
+	TranslateInfo->ResultLength = (uint32_t)ResultTextLength;
+	return 1;
+}
+
+// Stand-in for TranslateInfoTranslate, the engine's own lookup
+static int MockTranslate(MockTranslateInfo* TranslateInfo)
+{
+	TranslateInfo->Result = nullptr;
+	TranslateInfo->ResultLength = 0;
+	return 0;
+}
+
+typedef std::wstring_convert<std::codecvt_utf8_utf16<char16_t>, char16_t> LegacyConverter;
+
+// The original hook, converting the key to utf8 and the value back for every call
+static int LegacyHook(std::unordered_map<std::string, std::string>& Database, MockTranslateInfo* TranslateInfo)
+{
+	// The result has to outlive the call, like the engine copying it
+	static std::u16string ResultLoad;
+
+	auto WideKeyStr = std::u16string((const char16_t*)TranslateInfo->Key);
+	auto KeyStr = LegacyConverter().to_bytes(WideKeyStr);
+	auto KeyFind = std::string(KeyStr);
+
+	if (KeyStr.size() > 2 && KeyStr[0] == '@')
+		KeyFind = KeyStr.substr(1);
+
+	if (Database.find(KeyFind) != Database.end())
+	{
+		try
+		{
+			ResultLoad = LegacyConverter().from_bytes(Database[KeyFind]);
+			return MockSetResult(TranslateInfo, (const uint16_t*)ResultLoad.c_str(), -1);
+		}
+		catch (...)
+		{
+			return MockTranslate(TranslateInfo);
+		}
+	}
+
+	return MockTranslate(TranslateInfo);
+}
+
+// The current hook, driven through the shared lookup logic
+static int FastHook(const TranslationDB& Database, MockTranslateInfo* TranslateInfo)
+{
+	uint32_t ResultLength = 0;
+	auto Translated = TranslateScaleformKey(Database, TranslateInfo->Key, ResultLength);
+
+	if (Translated != nullptr)
+		return MockSetResult(TranslateInfo, Translated, (int)ResultLength);
+
+	return MockTranslate(TranslateInfo);
+}
+
+static std::vector<uint16_t> ToUtf16(const std::string& Value)
+{
+	std::vector<uint16_t> Result(Value.size() + 1, 0);
+	size_t Length = 0;
+
+	if (!Unicode::Utf8ToUtf16(Value.c_str(), Value.size(), Result.data(), Length))
+		Length = 0;
+
+	Result.resize(Length + 1);
+	Result[Length] = 0;
+	return Result;
+}
+
+int BenchScaleformCommand(int argc, char** argv)
+{
+	if (argc < 1)
+	{
+		printf("usage: d3tool bench-scaleform <database.db> [--source en_source.txt] [--missing en_missing.txt]\n");
+		return 1;
+	}
+
+	std::string DatabasePath = argv[0];
+	std::string SourcePath = "en/en_source.txt";
+	std::string MissingPath = "en/en_missing.txt";
+
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (std::strcmp(argv[i], "--source") == 0)
+			SourcePath = argv[i + 1];
+		else if (std::strcmp(argv[i], "--missing") == 0)
+			MissingPath = argv[i + 1];
+	}
+
+	TranslationDB Database;
+	if (!Database.Load(DatabasePath))
+	{
+		printf("Failed to load: %s\n", DatabasePath.c_str());
+		return 1;
+	}
+
+	// The legacy map is filled from the same database so both hooks see identical data
+	std::unordered_map<std::string, std::string> LegacyDatabase;
+	std::vector<std::vector<uint16_t>> Keys;
+
+	for (auto& Key : ToolUtils::ReadSourceKeys(SourcePath))
+	{
+		auto Value = Database.Find(Key.c_str());
+		if (Value != nullptr)
+			LegacyDatabase[Key] = Value;
+
+		Keys.push_back(ToUtf16("@" + Key));
+	}
+
+	for (auto& Key : ToolUtils::ReadMissingKeys(MissingPath))
+		Keys.push_back(ToUtf16(Key));
+
+	static const uint32_t Rounds = 20;
+	MockTranslateInfo TranslateInfo;
+
+	uint32_t LegacyHits = 0, FastHits = 0, Mismatches = 0;
+
+	// Both hooks must produce the same results
+	for (auto& Key : Keys)
+	{
+		TranslateInfo.Key = Key.data();
+		LegacyHits += LegacyHook(LegacyDatabase, &TranslateInfo);
+		auto LegacyResult = std::u16string((const char16_t*)(TranslateInfo.Result ? TranslateInfo.Result : (const uint16_t*)u""), TranslateInfo.ResultLength);
+
+		FastHits += FastHook(Database, &TranslateInfo);
+		auto FastResult = std::u16string((const char16_t*)(TranslateInfo.Result ? TranslateInfo.Result : (const uint16_t*)u""), TranslateInfo.ResultLength);
+
+		if (LegacyResult != FastResult)
+			Mismatches++;
+	}
+
+	auto Allocations = ToolUtils::GetAllocationCount();
+	ToolUtils::Stopwatch Timer;
+	for (uint32_t Round = 0; Round < Rounds; Round++)
+	{
+		for (auto& Key : Keys)
+		{
+			TranslateInfo.Key = Key.data();
+			LegacyHook(LegacyDatabase, &TranslateInfo);
+		}
+	}
+	auto LegacyTime = Timer.ElapsedNanoseconds() / ((double)Keys.size() * Rounds);
+	auto LegacyAllocations = ToolUtils::GetAllocationCount() - Allocations;
+
+	Allocations = ToolUtils::GetAllocationCount();
+	Timer.Restart();
+	for (uint32_t Round = 0; Round < Rounds; Round++)
+	{
+		for (auto& Key : Keys)
+		{
+			TranslateInfo.Key = Key.data();
+			FastHook(Database, &TranslateInfo);
+		}
+	}
+	auto FastTime = Timer.ElapsedNanoseconds() / ((double)Keys.size() * Rounds);
+	auto FastAllocations = ToolUtils::GetAllocationCount() - Allocations;
+
+	printf("keys:           %u (%u hits)\n", (uint32_t)Keys.size(), FastHits);
+	printf("mismatches:     %u (legacy hits %u)\n", Mismatches, LegacyHits);
+	printf("legacy hook:    %.1f ns/call, %.2f allocations/call\n", LegacyTime, (double)LegacyAllocations / ((double)Keys.size() * Rounds));
+	printf("utf16 hook:     %.1f ns/call, %.2f allocations/call\n", FastTime, (double)FastAllocations / ((double)Keys.size() * Rounds));
+
+	return (Mismatches == 0) ? 0 : 1;
+}
\ No newline at end of file
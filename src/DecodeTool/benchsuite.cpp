@@ -0,0 +1,670 @@
+// Standard includes
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Our includes
+#include "commands.h"
+#include "toolutils.h"
+#include "translate.h"
+#include "translationdb.h"
+#include "translationstack.h"
+#include "translationstore.h"
+#include "stringcache.h"
+
+//
+// The lookup benchmark suite, every engine against the same key streams derived from the shipped corpora:
+//   hit       every key the source defines, once each, shuffled
+//   miss      every key the game logged as missing or has in its localize dump that the source doesn't define
+//   localize  every key of the game's own localize dump, in file order
+//   zipf      a zipf(1) skewed stream over the localize keys
+//   frame     a screen of keys redrawn every frame, a few of them changing each frame
+// Results are written as JSON, one object per engine and workload, so runs can be diffed.
+//
+
+// Version of the JSON layout, bumped when fields change meaning
+static const uint32_t SuiteFormatVersion = 1;
+// Lookups timed one by one for the latency percentiles of a workload
+static const size_t LatencySamples = 200000;
+// Lookups every thread count runs in total, at least one whole pass over the stream per thread
+static const size_t ThroughputLookups = 2000000;
+// Loads timed per engine, the median is reported
+static const uint32_t LoadRepeats = 5;
+
+// A key stream, pointers into key storage that outlives the suite so pointer keyed caches see stable literals
+struct SuiteWorkload
+{
+	const char* Name;
+	std::vector<const char*> Keys;
+	size_t DistinctKeys;
+};
+
+// Latency and throughput of one engine on one workload
+struct SuiteResult
+{
+	const char* Workload;
+	size_t Hits;
+	double Mean;
+	double Percentiles[5];
+	double Maximum;
+	std::vector<std::pair<uint32_t, double>> Throughput;
+};
+
+// Reported latency percentiles
+static const double Percentiles[5] = { 50.0, 90.0, 99.0, 99.9, 99.99 };
+static const char* PercentileNames[5] = { "p50", "p90", "p99", "p999", "p9999" };
+
+// Writes indented JSON into a string, the suite only needs objects, arrays, strings and numbers
+class JsonWriter
+{
+private:
+	std::string Text;
+	std::vector<bool> First;
+	bool AfterKey;
+
+	// Starts a value, separating it from the previous one
+	void Separate()
+	{
+		if (this->AfterKey)
+		{
+			this->AfterKey = false;
+			return;
+		}
+
+		if (!this->First.empty())
+		{
+			if (!this->First.back())
+				this->Text += ",";
+
+			this->First.back() = false;
+			this->Text += "\n";
+			this->Text.append(this->First.size(), '\t');
+		}
+	}
+
+	void Open(char Bracket)
+	{
+		this->Separate();
+		this->Text += Bracket;
+		this->First.push_back(true);
+	}
+
+	void Close(char Bracket)
+	{
+		auto Empty = this->First.back();
+		this->First.pop_back();
+
+		if (!Empty)
+		{
+			this->Text += "\n";
+			this->Text.append(this->First.size(), '\t');
+		}
+
+		this->Text += Bracket;
+	}
+
+	void Quote(const char* Value)
+	{
+		this->Text += '"';
+
+		for (auto Cursor = Value; *Cursor != 0; Cursor++)
+		{
+			if (*Cursor == '"' || *Cursor == '\\')
+				this->Text += '\\';
+
+			if ((uint8_t)*Cursor >= 0x20)
+				this->Text += *Cursor;
+		}
+
+		this->Text += '"';
+	}
+
+public:
+	JsonWriter() : AfterKey(false) { }
+
+	void BeginObject() { this->Open('{'); }
+	void EndObject() { this->Close('}'); }
+	void BeginArray() { this->Open('['); }
+	void EndArray() { this->Close(']'); }
+
+	void Key(const char* Name)
+	{
+		this->Separate();
+		this->Quote(Name);
+		this->Text += ": ";
+		this->AfterKey = true;
+	}
+
+	void String(const char* Value)
+	{
+		this->Separate();
+		this->Quote(Value);
+	}
+
+	void Number(double Value)
+	{
+		char Buffer[64];
+		snprintf(Buffer, sizeof(Buffer), "%.6g", Value);
+
+		this->Separate();
+		this->Text += Buffer;
+	}
+
+	void Integer(uint64_t Value)
+	{
+		this->Separate();
+		this->Text += std::to_string(Value);
+	}
+
+	void Field(const char* Name, const char* Value) { this->Key(Name); this->String(Value); }
+	void Field(const char* Name, double Value) { this->Key(Name); this->Number(Value); }
+	void FieldInteger(const char* Name, uint64_t Value) { this->Key(Name); this->Integer(Value); }
+
+	const std::string& GetText() const { return this->Text; }
+};
+
+// The original hook, a v1 file loaded into an unordered_map and probed twice per hit
+class MapEngine
+{
+private:
+	std::unordered_map<std::string, std::string> Map;
+
+public:
+	static const char* GetName() { return "map"; }
+
+	bool Load(const std::string& Path)
+	{
+		// The original loader reads anything as v1, a v2 file would load garbage
+		std::vector<uint8_t> Magic;
+		if (!ToolUtils::ReadFile(Path, Magic) || (Magic.size() >= sizeof(uint32_t) && *(const uint32_t*)Magic.data() == TRANSLATIONDB_MAGIC))
+			return false;
+
+		return ToolUtils::LoadLegacyMap(Path, this->Map);
+	}
+
+	uint32_t GetEntryCount() const { return (uint32_t)this->Map.size(); }
+
+	const char* Find(const char* Key)
+	{
+		if (this->Map.find(Key) != this->Map.end())
+			return this->Map[Key].c_str();
+
+		return nullptr;
+	}
+};
+
+// The database, queried like the StringEd hook without the pointer cache
+class DatabaseEngine
+{
+private:
+	TranslationDB Database;
+
+public:
+	static const char* GetName() { return "db"; }
+
+	bool Load(const std::string& Path) { return this->Database.Load(Path); }
+	uint32_t GetEntryCount() const { return this->Database.GetEntryCount(); }
+	const char* Find(const char* Key) { return TranslateStringReference(this->Database, Key); }
+};
+
+// The full StringEd hook path, the published stack behind the pointer cache
+class StoreEngine
+{
+private:
+	TranslationStore Store;
+	StringReferenceCache Cache;
+
+public:
+	static const char* GetName() { return "store"; }
+
+	bool Load(const std::string& Path)
+	{
+		std::unique_ptr<TranslationStack> Stack(new TranslationStack());
+		if (!Stack->Load(Path))
+			return false;
+
+		this->Store.Publish(std::move(Stack));
+		return true;
+	}
+
+	uint32_t GetEntryCount() const { return this->Store.Acquire()->GetEntryCount(); }
+	const char* Find(const char* Key) { return TranslateStringReference(this->Cache, this->Store, Key); }
+};
+
+// Gets the value at a percentile of sorted samples
+static double GetPercentile(const std::vector<double>& Sorted, double Percentile)
+{
+	if (Sorted.empty())
+		return 0.0;
+
+	auto Index = (size_t)((Percentile / 100.0) * (double)(Sorted.size() - 1) + 0.5);
+	return Sorted[std::min(Index, Sorted.size() - 1)];
+}
+
+// Measures the cost of reading the clock twice, subtracted from every timed lookup
+static double GetTimerOverhead()
+{
+	std::vector<double> Samples(10000);
+
+	for (auto& Sample : Samples)
+	{
+		auto Start = std::chrono::steady_clock::now();
+		auto End = std::chrono::steady_clock::now();
+		Sample = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(End - Start).count();
+	}
+
+	std::sort(Samples.begin(), Samples.end());
+	return GetPercentile(Samples, 50.0);
+}
+
+// Times lookups one by one after a warm up pass, then the throughput of every thread count over whole passes
+template<typename Engine>
+static SuiteResult MeasureWorkload(Engine& Lookup, const SuiteWorkload& Workload, const std::vector<uint32_t>& ThreadCounts, double TimerOverhead)
+{
+	SuiteResult Result;
+	Result.Workload = Workload.Name;
+	Result.Hits = 0;
+
+	auto& Keys = Workload.Keys;
+	auto Samples = std::min(Keys.size(), LatencySamples);
+
+	for (size_t i = 0; i < Samples; i++)
+		Lookup.Find(Keys[i]);
+
+	std::vector<double> Latencies(Samples);
+	double Total = 0.0;
+
+	for (size_t i = 0; i < Samples; i++)
+	{
+		auto Start = std::chrono::steady_clock::now();
+		auto Value = Lookup.Find(Keys[i]);
+		auto End = std::chrono::steady_clock::now();
+
+		Result.Hits += (Value != nullptr) ? 1 : 0;
+
+		Latencies[i] = std::max(0.0, (double)std::chrono::duration_cast<std::chrono::nanoseconds>(End - Start).count() - TimerOverhead);
+		Total += Latencies[i];
+	}
+
+	std::sort(Latencies.begin(), Latencies.end());
+
+	Result.Mean = Samples ? Total / (double)Samples : 0.0;
+	Result.Maximum = Latencies.empty() ? 0.0 : Latencies.back();
+
+	for (size_t i = 0; i < 5; i++)
+		Result.Percentiles[i] = GetPercentile(Latencies, Percentiles[i]);
+
+	// Every thread replays the whole stream from its own offset, so threads don't walk in lockstep, the work is split between them
+	for (auto Threads : ThreadCounts)
+	{
+		auto Passes = std::max<size_t>(1, ThroughputLookups / std::max<size_t>(1, Keys.size() * Threads));
+		std::atomic<uint32_t> Ready(0);
+		std::atomic<bool> Start(false);
+		std::atomic<size_t> Found(0);
+		std::vector<std::thread> Workers;
+
+		for (uint32_t t = 0; t < Threads; t++)
+		{
+			Workers.push_back(std::thread([&, t]()
+			{
+				auto Offset = (Keys.size() * t) / Threads;
+				size_t Local = 0;
+
+				Ready.fetch_add(1);
+				while (!Start.load(std::memory_order_acquire))
+					std::this_thread::yield();
+
+				for (size_t Pass = 0; Pass < Passes; Pass++)
+				{
+					for (size_t i = 0; i < Keys.size(); i++)
+						Local += (Lookup.Find(Keys[(Offset + i) % Keys.size()]) != nullptr) ? 1 : 0;
+				}
+
+				Found.fetch_add(Local);
+			}));
+		}
+
+		while (Ready.load() != Threads)
+			std::this_thread::yield();
+
+		ToolUtils::Stopwatch Timer;
+		Start.store(true, std::memory_order_release);
+
+		for (auto& Worker : Workers)
+			Worker.join();
+
+		auto Seconds = Timer.ElapsedNanoseconds() / 1000000000.0;
+		Result.Throughput.push_back(std::make_pair(Threads, ((double)Keys.size() * Passes * Threads) / std::max(Seconds, 1e-9)));
+	}
+
+	return Result;
+}
+
+// Loads an engine, timing repeated loads, then runs every workload against it and writes its results
+template<typename Engine>
+static bool RunEngine(const std::string& DatabasePath, const std::vector<SuiteWorkload>& Workloads, const std::vector<uint32_t>& ThreadCounts, double TimerOverhead, JsonWriter& Json)
+{
+	auto ResidentBefore = ToolUtils::GetResidentBytes();
+	auto Allocations = ToolUtils::GetAllocationCount();
+	ToolUtils::Stopwatch Timer;
+
+	std::unique_ptr<Engine> Lookup(new Engine());
+	if (!Lookup->Load(DatabasePath))
+	{
+		printf("%-8s skipped, can't load %s\n", Engine::GetName(), DatabasePath.c_str());
+
+		Json.BeginObject();
+		Json.Field("name", Engine::GetName());
+		Json.Field("skipped", "can't load the database");
+		Json.EndObject();
+		return false;
+	}
+
+	std::vector<double> LoadTimes(1, Timer.ElapsedMilliseconds());
+	auto LoadAllocations = ToolUtils::GetAllocationCount() - Allocations;
+	auto ResidentLoaded = ToolUtils::GetResidentBytes();
+
+	for (uint32_t i = 1; i < LoadRepeats; i++)
+	{
+		Timer.Restart();
+		std::unique_ptr<Engine> Repeat(new Engine());
+		Repeat->Load(DatabasePath);
+		LoadTimes.push_back(Timer.ElapsedMilliseconds());
+	}
+
+	std::sort(LoadTimes.begin(), LoadTimes.end());
+
+	std::vector<SuiteResult> Results;
+	for (auto& Workload : Workloads)
+		Results.push_back(MeasureWorkload(*Lookup, Workload, ThreadCounts, TimerOverhead));
+
+	// Mapped databases only become resident as they're touched
+	auto ResidentUsed = ToolUtils::GetResidentBytes();
+
+	printf("%-8s %u entries, load %.2f ms, %llu allocations, resident +%.2f MB loaded, +%.2f MB used\n", Engine::GetName(), Lookup->GetEntryCount(), GetPercentile(LoadTimes, 50.0),
+		(unsigned long long)LoadAllocations, ((double)ResidentLoaded - (double)ResidentBefore) / 1048576.0, ((double)ResidentUsed - (double)ResidentBefore) / 1048576.0);
+
+	Json.BeginObject();
+	Json.Field("name", Engine::GetName());
+	Json.FieldInteger("entries", Lookup->GetEntryCount());
+	Json.Key("load");
+	Json.BeginObject();
+	Json.Field("median_ms", GetPercentile(LoadTimes, 50.0));
+	Json.Field("min_ms", LoadTimes.front());
+	Json.Field("max_ms", LoadTimes.back());
+	Json.FieldInteger("allocations", LoadAllocations);
+	Json.EndObject();
+	Json.Key("resident");
+	Json.BeginObject();
+	Json.Field("loaded_bytes", (double)ResidentLoaded - (double)ResidentBefore);
+	Json.Field("used_bytes", (double)ResidentUsed - (double)ResidentBefore);
+	Json.EndObject();
+	Json.Key("workloads");
+	Json.BeginArray();
+
+	for (size_t w = 0; w < Results.size(); w++)
+	{
+		auto& Result = Results[w];
+		auto Sampled = std::min(Workloads[w].Keys.size(), LatencySamples);
+
+		printf("  %-9s hit %6.2f%%  mean %7.1f ns  p50 %7.1f  p99 %7.1f  p9999 %8.1f  max %9.1f ns ", Result.Workload, Sampled ? (100.0 * Result.Hits) / Sampled : 0.0, Result.Mean,
+			Result.Percentiles[0], Result.Percentiles[2], Result.Percentiles[4], Result.Maximum);
+
+		for (auto& Point : Result.Throughput)
+			printf(" %ut %.1fM/s", Point.first, Point.second / 1000000.0);
+
+		printf("\n");
+
+		Json.BeginObject();
+		Json.Field("name", Result.Workload);
+		Json.Field("hit_rate", Sampled ? (double)Result.Hits / (double)Sampled : 0.0);
+		Json.Key("latency_ns");
+		Json.BeginObject();
+		Json.FieldInteger("samples", Sampled);
+		Json.Field("mean", Result.Mean);
+
+		for (size_t i = 0; i < 5; i++)
+			Json.Field(PercentileNames[i], Result.Percentiles[i]);
+
+		Json.Field("max", Result.Maximum);
+		Json.EndObject();
+		Json.Key("throughput");
+		Json.BeginArray();
+
+		for (auto& Point : Result.Throughput)
+		{
+			Json.BeginObject();
+			Json.FieldInteger("threads", Point.first);
+			Json.Field("lookups_per_second", Point.second);
+			Json.EndObject();
+		}
+
+		Json.EndArray();
+		Json.EndObject();
+	}
+
+	Json.EndArray();
+	Json.EndObject();
+	return true;
+}
+
+// Draws a zipf(1) skewed stream of pointers to keys, the most popular keys are spread over the key list by the shuffle
+static std::vector<const char*> BuildZipfStream(const std::vector<std::string>& Keys, size_t Length, std::mt19937& Random)
+{
+	std::vector<const char*> Ranked;
+	for (auto& Key : Keys)
+		Ranked.push_back(Key.c_str());
+
+	std::shuffle(Ranked.begin(), Ranked.end(), Random);
+
+	std::vector<double> Cumulative(Ranked.size());
+	double Total = 0;
+	for (size_t i = 0; i < Ranked.size(); i++)
+	{
+		Total += 1.0 / (double)(i + 1);
+		Cumulative[i] = Total;
+	}
+
+	std::uniform_real_distribution<double> Uniform(0, Total);
+	std::vector<const char*> Stream(Length);
+
+	for (auto& Key : Stream)
+	{
+		auto Index = std::lower_bound(Cumulative.begin(), Cumulative.end(), Uniform(Random)) - Cumulative.begin();
+		Key = Ranked[std::min<size_t>(Index, Ranked.size() - 1)];
+	}
+
+	return Stream;
+}
+
+// A screen of zipf drawn keys requested every frame in the same order, replacing a few each frame like menus changing
+static std::vector<const char*> BuildFrameStream(const std::vector<std::string>& Keys, uint32_t ScreenKeys, uint32_t Frames, uint32_t ChangedPerFrame, std::mt19937& Random)
+{
+	auto Pool = BuildZipfStream(Keys, (size_t)ScreenKeys + (size_t)Frames * ChangedPerFrame, Random);
+	std::vector<const char*> Screen(Pool.begin(), Pool.begin() + ScreenKeys);
+	std::uniform_int_distribution<uint32_t> Slot(0, ScreenKeys - 1);
+
+	std::vector<const char*> Stream;
+	Stream.reserve((size_t)ScreenKeys * Frames);
+	auto Next = Pool.begin() + ScreenKeys;
+
+	for (uint32_t Frame = 0; Frame < Frames; Frame++)
+	{
+		for (uint32_t i = 0; i < ChangedPerFrame; i++)
+			Screen[Slot(Random)] = *Next++;
+
+		Stream.insert(Stream.end(), Screen.begin(), Screen.end());
+	}
+
+	return Stream;
+}
+
+// Parses a comma separated list of thread counts
+static std::vector<uint32_t> ParseThreadCounts(const char* Text)
+{
+	std::vector<uint32_t> Result;
+
+	for (auto Cursor = Text; *Cursor != 0;)
+	{
+		auto Count = std::atoi(Cursor);
+		if (Count > 0)
+			Result.push_back((uint32_t)Count);
+
+		auto Comma = std::strchr(Cursor, ',');
+		if (Comma == nullptr)
+			break;
+
+		Cursor = Comma + 1;
+	}
+
+	return Result;
+}
+
+int BenchSuiteCommand(int argc, char** argv)
+{
+	if (argc < 1)
+	{
+		printf("usage: d3tool bench-suite <database.db> [--source en_source.txt] [--missing en_missing.txt] [--localize game_localize.txt] [--engines map,db,store] [--threads 1,2,4,8] [--output bench.json]\n");
+		return 1;
+	}
+
+	std::string DatabasePath = argv[0];
+	std::string SourcePath = "en/en_source.txt";
+	std::string MissingPath = "en/en_missing.txt";
+	std::string LocalizePath = "game_localize.txt";
+	std::string EngineList = "map,db,store";
+	std::string OutputPath = "bench.json";
+	std::vector<uint32_t> ThreadCounts = { 1, 2, 4, 8 };
+
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (std::strcmp(argv[i], "--source") == 0)
+			SourcePath = argv[i + 1];
+		else if (std::strcmp(argv[i], "--missing") == 0)
+			MissingPath = argv[i + 1];
+		else if (std::strcmp(argv[i], "--localize") == 0)
+			LocalizePath = argv[i + 1];
+		else if (std::strcmp(argv[i], "--engines") == 0)
+			EngineList = argv[i + 1];
+		else if (std::strcmp(argv[i], "--threads") == 0)
+			ThreadCounts = ParseThreadCounts(argv[i + 1]);
+		else if (std::strcmp(argv[i], "--output") == 0)
+			OutputPath = argv[i + 1];
+	}
+
+	// Key storage, every stream points into these
+	auto SourceKeys = ToolUtils::ReadSourceKeys(SourcePath);
+	auto MissingKeys = ToolUtils::ReadMissingKeys(MissingPath);
+	auto LocalizeKeys = ToolUtils::ReadLocalizeKeys(LocalizePath);
+
+	if (SourceKeys.empty() || MissingKeys.empty() || LocalizeKeys.empty() || ThreadCounts.empty())
+	{
+		printf("Need keys from %s, %s and %s, and at least one thread count\n", SourcePath.c_str(), MissingPath.c_str(), LocalizePath.c_str());
+		return 1;
+	}
+
+	// Fixed seeds, so every run measures the same streams
+	std::mt19937 Random(20140101);
+	std::vector<SuiteWorkload> Workloads;
+
+	auto AddWorkload = [&Workloads](const char* Name, std::vector<const char*> Keys)
+	{
+		std::unordered_set<std::string> Distinct(Keys.begin(), Keys.end());
+		Workloads.push_back(SuiteWorkload { Name, std::move(Keys), Distinct.size() });
+	};
+
+	// Every defined key once, the first definition stands in for its duplicates
+	std::unordered_set<std::string> Defined;
+	std::vector<const char*> Stream;
+
+	for (auto& Key : SourceKeys)
+	{
+		if (Defined.insert(Key).second)
+			Stream.push_back(Key.c_str());
+	}
+
+	std::shuffle(Stream.begin(), Stream.end(), Random);
+	AddWorkload("hit", Stream);
+
+	// Logged and localize keys the source doesn't define, the missing log also has keys translated since it was written
+	std::unordered_set<std::string> Undefined;
+
+	Stream.clear();
+	for (auto Keys : { &MissingKeys, &LocalizeKeys })
+	{
+		for (auto& Key : *Keys)
+		{
+			if (Defined.count(Key) == 0 && Undefined.insert(Key).second)
+				Stream.push_back(Key.c_str());
+		}
+	}
+
+	AddWorkload("miss", Stream);
+
+	Stream.clear();
+	for (auto& Key : LocalizeKeys)
+		Stream.push_back(Key.c_str());
+
+	AddWorkload("localize", Stream);
+	AddWorkload("zipf", BuildZipfStream(LocalizeKeys, 1000000, Random));
+	AddWorkload("frame", BuildFrameStream(LocalizeKeys, 400, 2000, 8, Random));
+
+	auto TimerOverhead = GetTimerOverhead();
+
+	JsonWriter Json;
+	Json.BeginObject();
+	Json.FieldInteger("format", SuiteFormatVersion);
+	Json.Field("database", DatabasePath.c_str());
+	Json.FieldInteger("hardware_threads", std::thread::hardware_concurrency());
+	Json.Field("timer_overhead_ns", TimerOverhead);
+	Json.Key("workloads");
+	Json.BeginArray();
+
+	printf("database: %s, timer overhead %.1f ns subtracted from every timed lookup\n", DatabasePath.c_str(), TimerOverhead);
+
+	for (auto& Workload : Workloads)
+	{
+		printf("workload: %-9s %8u lookups, %6u distinct keys\n", Workload.Name, (uint32_t)Workload.Keys.size(), (uint32_t)Workload.DistinctKeys);
+
+		Json.BeginObject();
+		Json.Field("name", Workload.Name);
+		Json.FieldInteger("lookups", Workload.Keys.size());
+		Json.FieldInteger("distinct_keys", Workload.DistinctKeys);
+		Json.EndObject();
+	}
+
+	Json.EndArray();
+	Json.Key("engines");
+	Json.BeginArray();
+
+	// New engines go here, and in the default list
+	auto Engines = "," + EngineList + ",";
+	if (Engines.find(",map,") != std::string::npos)
+		RunEngine<MapEngine>(DatabasePath, Workloads, ThreadCounts, TimerOverhead, Json);
+	if (Engines.find(",db,") != std::string::npos)
+		RunEngine<DatabaseEngine>(DatabasePath, Workloads, ThreadCounts, TimerOverhead, Json);
+	if (Engines.find(",store,") != std::string::npos)
+		RunEngine<StoreEngine>(DatabasePath, Workloads, ThreadCounts, TimerOverhead, Json);
+
+	Json.EndArray();
+	Json.EndObject();
+
+	auto& Text = Json.GetText();
+	if (!ToolUtils::WriteFile(OutputPath, Text.data(), Text.size()))
+	{
+		printf("Failed to write: %s\n", OutputPath.c_str());
+		return 1;
+	}
+
+	printf("results:  %s\n", OutputPath.c_str());
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,228 @@
+// Standard includes
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Our includes
+#include "commands.h"
+#include "toolutils.h"
+#include "translationdb.h"
+#include "translate.h"
+#include "placeholders.h"
+
+static const uint32_t Rounds = 200;
+// Keeps the format loops from being optimized away
+static volatile size_t FormatSink = 0;
+
+// Formats a value the way it's done without templates, scanning for placeholders into a temporary string
+static std::string ScanFormat(const std::string& Value, const std::vector<std::string>& Arguments)
+{
+	std::string Result;
+
+	for (size_t i = 0; i < Value.size();)
+	{
+		auto Found = Value.find("&&", i);
+		if (Found == std::string::npos)
+		{
+			Result.append(Value, i, std::string::npos);
+			break;
+		}
+
+		auto Slot = Placeholders::GetSlot(Value.data() + Found, Value.size() - Found);
+		if (Slot != 0 && Slot <= Arguments.size())
+		{
+			Result.append(Value, i, Found - i);
+			Result += Arguments[Slot - 1];
+			i = Found + PLACEHOLDERS_LENGTH;
+		}
+		else
+		{
+			Result.append(Value, i, Found + 1 - i);
+			i = Found + 1;
+		}
+	}
+
+	return Result;
+}
+
+// Prints a slot mask as a list of placeholders
+static std::string DescribeSlots(uint32_t SlotMask)
+{
+	std::string Result;
+
+	for (uint32_t Slot = 1; Slot <= PLACEHOLDERS_MAX_SLOT; Slot++)
+	{
+		if ((SlotMask & (1u << Slot)) != 0)
+			Result += (Result.empty() ? "&&" : " &&") + std::to_string(Slot);
+	}
+
+	return Result.empty() ? "none" : Result;
+}
+
+int BenchTemplateCommand(int argc, char** argv)
+{
+	if (argc < 1)
+	{
+		printf("usage: d3tool bench-template <database.db> [--reference en_missing.txt]\n");
+		return 1;
+	}
+
+	std::string DatabasePath = argv[0];
+	std::string ReferencePath = "en/en_missing.txt";
+
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (std::strcmp(argv[i], "--reference") == 0)
+			ReferencePath = argv[i + 1];
+	}
+
+	TranslationDB Database;
+	if (!Database.Load(DatabasePath))
+	{
+		printf("Failed to load: %s\n", DatabasePath.c_str());
+		return 1;
+	}
+
+	// Arguments long enough to exercise every slot
+	std::vector<std::string> Arguments = { "12", "Server-3", "A longer third argument", "4", "five", "6", "7", "8", "9" };
+	std::vector<std::string_view> ArgumentViews(Arguments.begin(), Arguments.end());
+
+	auto& View = Database.GetView();
+	std::vector<const TranslationDBEntry*> Templated;
+	uint32_t SlotCounts[PLACEHOLDERS_MAX_SLOT + 1] = { 0 };
+	uint32_t Failures = 0;
+	std::vector<char> Buffer(4096);
+
+	for (uint32_t i = 0; i < View.EntryCount; i++)
+	{
+		auto Entry = &View.Entries[i];
+		std::string Value = Database.GetValue(Entry);
+		auto Template = Database.GetTemplate(Entry);
+
+		// The template must use exactly the slots of the value it was built from
+		auto SlotMask = Placeholders::GetSlotMask(Value.data(), Value.size());
+		if (SlotMask != ((Template != nullptr) ? Template->SlotMask : 0u))
+		{
+			printf("template mismatch: %s\n", Database.GetKey(Entry));
+			Failures++;
+			continue;
+		}
+
+		if (Template == nullptr)
+			continue;
+
+		Templated.push_back(Entry);
+		for (uint32_t Slot = 1; Slot <= PLACEHOLDERS_MAX_SLOT; Slot++)
+			SlotCounts[Slot] += (Template->SlotMask >> Slot) & 1;
+
+		// Formatting must match scanning, with every argument, with too few and into a short buffer
+		for (uint32_t ArgumentCount : { (uint32_t)Arguments.size(), 1u })
+		{
+			std::vector<std::string> Used(Arguments.begin(), Arguments.begin() + ArgumentCount);
+			auto Expected = ScanFormat(Value, Used);
+			auto Length = FormatTranslation(Database, Entry, ArgumentViews.data(), ArgumentCount, Buffer.data(), Buffer.size());
+
+			char Short[8];
+			auto ShortLength = FormatTranslation(Database, Entry, ArgumentViews.data(), ArgumentCount, Short, sizeof(Short));
+
+			if (Length != Expected.size() || Expected != Buffer.data() || ShortLength != Length || Expected.compare(0, sizeof(Short) - 1, Short) != 0)
+			{
+				printf("format mismatch: %s\n", Database.GetKey(Entry));
+				Failures++;
+			}
+		}
+	}
+
+	// The source language strings must use the same slots as their translations
+	auto Reference = ToolUtils::ReadMissingPairs(ReferencePath);
+	if (Reference.empty())
+		Reference = ToolUtils::ReadSourcePairs(ReferencePath);
+
+	uint32_t Compared = 0, SlotMismatches = 0;
+	for (auto& Pair : Reference)
+	{
+		auto Entry = Database.FindEntry(Pair.first.c_str(), Pair.first.size());
+		if (Entry == nullptr)
+			continue;
+
+		auto Template = Database.GetTemplate(Entry);
+		auto Expected = Placeholders::GetSlotMask(Pair.second.data(), Pair.second.size());
+		auto Actual = (Template != nullptr) ? (uint32_t)Template->SlotMask : 0u;
+
+		Compared++;
+		if (Expected != Actual)
+		{
+			printf("slot mismatch:  %s source has %s, translation has %s\n", Pair.first.c_str(), DescribeSlots(Expected).c_str(), DescribeSlots(Actual).c_str());
+			SlotMismatches++;
+		}
+	}
+
+	if (Templated.empty())
+	{
+		printf("No templates in: %s\n", DatabasePath.c_str());
+		return 1;
+	}
+
+	// Throughput over every templated value, against scanning into a temporary
+	std::vector<std::string> Values;
+	size_t Formatted = 0, OutputBytes = 0;
+	for (auto Entry : Templated)
+	{
+		Values.push_back(Database.GetValue(Entry));
+		OutputBytes += ScanFormat(Values.back(), Arguments).size();
+	}
+
+	ToolUtils::Stopwatch Timer;
+	for (uint32_t Round = 0; Round < Rounds; Round++)
+	{
+		for (auto Entry : Templated)
+			Formatted += FormatTranslation(Database, Entry, ArgumentViews.data(), (uint32_t)ArgumentViews.size(), Buffer.data(), Buffer.size());
+	}
+	auto TemplateNs = Timer.ElapsedNanoseconds();
+
+	Timer.Restart();
+	for (uint32_t Round = 0; Round < Rounds; Round++)
+	{
+		for (auto& Value : Values)
+			Formatted += ScanFormat(Value, Arguments).size();
+	}
+	auto ScanNs = Timer.ElapsedNanoseconds();
+
+	// A per frame string, looked up and formatted every call
+	static const char* FrameKey = "EXE_REFRESHTIME";
+	auto FrameEntry = Database.FindEntry(FrameKey, std::strlen(FrameKey));
+	double FrameNs = 0;
+
+	if (FrameEntry != nullptr)
+	{
+		Timer.Restart();
+		for (uint32_t Round = 0; Round < Rounds * 1000; Round++)
+		{
+			auto Entry = Database.FindEntry(FrameKey, std::strlen(FrameKey));
+			Formatted += FormatTranslation(Database, Entry, ArgumentViews.data(), 1, Buffer.data(), Buffer.size());
+		}
+		FrameNs = Timer.ElapsedNanoseconds() / (Rounds * 1000.0);
+	}
+
+	FormatSink = Formatted;
+	auto Operations = (double)Templated.size() * Rounds;
+
+	printf("\ndatabase:       %s (%u entries)\n", DatabasePath.c_str(), View.EntryCount);
+	printf("templates:      %u values,", (uint32_t)Templated.size());
+	for (uint32_t Slot = 1; Slot <= PLACEHOLDERS_MAX_SLOT; Slot++)
+	{
+		if (SlotCounts[Slot] > 0)
+			printf(" &&%u x%u", Slot, SlotCounts[Slot]);
+	}
+	printf("\n");
+	printf("reference:      %u keys compared against %s, %u slot mismatches\n", Compared, ReferencePath.c_str(), SlotMismatches);
+	printf("format:         %.1f ns per value (%.0f MB/s), scanning %.1f ns (%.0f MB/s)\n", TemplateNs / Operations, (OutputBytes * Rounds / (1024.0 * 1024.0)) / (TemplateNs / 1e9),
+		ScanNs / Operations, (OutputBytes * Rounds / (1024.0 * 1024.0)) / (ScanNs / 1e9));
+	if (FrameEntry != nullptr)
+		printf("per frame:      %.1f ns lookup and format of %s\n", FrameNs, FrameKey);
+	printf("failures:       %u\n", Failures);
+
+	return (Failures == 0 && SlotMismatches == 0) ? 0 : 1;
+}
\ No newline at end of file
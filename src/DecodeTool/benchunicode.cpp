@@ -0,0 +1,518 @@
+// Standard includes
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <codecvt>
+#include <locale>
+#include <random>
+#include <string>
+#include <vector>
+
+// Our includes
+#include "commands.h"
+#include "toolutils.h"
+#include "cpufeatures.h"
+#include "missingkeys.h"
+#include "unicode.h"
+
+typedef std::wstring_convert<std::codecvt_utf8_utf16<char16_t>, char16_t> LegacyConverter;
+
+// The utf16 forms of a set of utf8 strings
+static std::vector<std::u16string> ToUtf16Strings(const std::vector<std::string>& Strings)
+{
+	std::vector<std::u16string> Result;
+	for (auto& Text : Strings)
+	{
+		std::u16string Wide(Text.size(), u'\0');
+		size_t Length = 0;
+
+		if (Unicode::Utf8ToUtf16(Text.c_str(), Text.size(), (uint16_t*)&Wide[0], Length))
+		{
+			Wide.resize(Length);
+			Result.push_back(Wide);
+		}
+	}
+
+	return Result;
+}
+
+// Converts every string once per round, returns the input megabytes per second
+template<typename Convert>
+static double MeasureThroughput(size_t Bytes, uint32_t Rounds, Convert&& Function)
+{
+	ToolUtils::Stopwatch Timer;
+	for (uint32_t Round = 0; Round < Rounds; Round++)
+		Function();
+
+	return ((double)Bytes * Rounds / (1024.0 * 1024.0)) / (Timer.ElapsedMilliseconds() / 1000.0);
+}
+
+// Measures one set of strings, one at a time and joined for bulk conversion
+static void BenchStrings(const char* Name, const std::vector<std::string>& Strings, uint32_t Rounds)
+{
+	auto WideStrings = ToUtf16Strings(Strings);
+	if (Strings.empty() || WideStrings.size() != Strings.size())
+	{
+		printf("%s: no valid utf8 strings\n", Name);
+		return;
+	}
+
+	std::string Bulk;
+	size_t Utf8Bytes = 0, Utf16Bytes = 0, Ascii = 0;
+	for (auto& Text : Strings)
+	{
+		Bulk.append(Text);
+		Bulk.push_back('\n');
+		Utf8Bytes += Text.size();
+
+		for (auto Character : Text)
+			Ascii += ((uint8_t)Character < 0x80) ? 1 : 0;
+	}
+
+	for (auto& Wide : WideStrings)
+		Utf16Bytes += Wide.size() * sizeof(char16_t);
+
+	auto WideBulk = ToUtf16Strings({ Bulk })[0];
+
+	std::vector<uint16_t> WideBuffer(Bulk.size() + 1);
+	std::vector<char> Buffer(WideBulk.size() * 3 + 1);
+
+	printf("%s: %u values, %.2f MB utf8 (%.0f%% ascii), %.2f MB utf16\n", Name, (uint32_t)Strings.size(), Utf8Bytes / (1024.0 * 1024.0), 100.0 * Ascii / (double)Utf8Bytes, Utf16Bytes / (1024.0 * 1024.0));
+	printf("%-16s %14s %14s %14s %14s\n", "", "utf8>16 each", "utf8>16 bulk", "utf16>8 each", "utf16>8 bulk");
+
+	// What Utils did before, a converter for every call
+	auto LegacyToWide = MeasureThroughput(Utf8Bytes, Rounds, [&]()
+	{
+		for (auto& Text : Strings)
+			LegacyConverter().from_bytes(Text);
+	});
+	auto LegacyToWideBulk = MeasureThroughput(Utf8Bytes, Rounds, [&]() { LegacyConverter().from_bytes(Bulk); });
+	auto LegacyToUtf8 = MeasureThroughput(Utf16Bytes, Rounds, [&]()
+	{
+		for (auto& Wide : WideStrings)
+			LegacyConverter().to_bytes(Wide);
+	});
+	auto LegacyToUtf8Bulk = MeasureThroughput(Utf16Bytes, Rounds, [&]() { LegacyConverter().to_bytes(WideBulk); });
+
+	printf("%-16s %10.0f MB/s %10.0f MB/s %10.0f MB/s %10.0f MB/s\n", "wstring_convert", LegacyToWide, LegacyToWideBulk, LegacyToUtf8, LegacyToUtf8Bulk);
+
+	// Every level this processor has, into reused buffers
+	auto Supported = CpuFeatures::GetSupportedLevel();
+	for (uint32_t Level = CPU_LEVEL_SCALAR; Level <= (uint32_t)Supported; Level++)
+	{
+		CpuFeatures::SetLevelLimit((CpuLevel)Level);
+
+		auto ToWide = MeasureThroughput(Utf8Bytes, Rounds, [&]()
+		{
+			for (auto& Text : Strings)
+				Unicode::TranscodeUtf8ToUtf16(Text.data(), Text.size(), WideBuffer.data(), WideBuffer.size());
+		});
+		auto ToWideBulk = MeasureThroughput(Utf8Bytes, Rounds, [&]() { Unicode::TranscodeUtf8ToUtf16(Bulk.data(), Bulk.size(), WideBuffer.data(), WideBuffer.size()); });
+		auto ToUtf8 = MeasureThroughput(Utf16Bytes, Rounds, [&]()
+		{
+			for (auto& Wide : WideStrings)
+				Unicode::TranscodeUtf16ToUtf8((const uint16_t*)Wide.data(), Wide.size(), Buffer.data(), Buffer.size());
+		});
+		auto ToUtf8Bulk = MeasureThroughput(Utf16Bytes, Rounds, [&]() { Unicode::TranscodeUtf16ToUtf8((const uint16_t*)WideBulk.data(), WideBulk.size(), Buffer.data(), Buffer.size()); });
+
+		printf("%-16s %10.0f MB/s %10.0f MB/s %10.0f MB/s %10.0f MB/s\n", CpuFeatures::GetLevelName((CpuLevel)Level), ToWide, ToWideBulk, ToUtf8, ToUtf8Bulk);
+	}
+
+	CpuFeatures::SetLevelLimit(CPU_LEVEL_AVX2);
+	printf("\n");
+}
+
+int BenchUnicodeCommand(int argc, char** argv)
+{
+	std::string SourcePath = "en/en_source.txt";
+	std::string LocalizePath = "game_localize.txt";
+	uint32_t Rounds = 20;
+
+	for (int i = 0; i + 1 < argc; i += 2)
+	{
+		if (std::strcmp(argv[i], "--source") == 0)
+			SourcePath = argv[i + 1];
+		else if (std::strcmp(argv[i], "--localize") == 0)
+			LocalizePath = argv[i + 1];
+		else if (std::strcmp(argv[i], "--rounds") == 0)
+			Rounds = (uint32_t)std::max(1, std::atoi(argv[i + 1]));
+	}
+
+	// The pack's values, as the hooks convert them
+	std::vector<std::string> Pack;
+	for (auto& Pair : ToolUtils::ReadSourcePairs(SourcePath))
+		Pack.push_back(Pair.second);
+
+	// The game's own chinese text, mostly 3 byte sequences once in utf8
+	std::vector<std::string> Localize;
+	for (auto& Pair : ToolUtils::ReadLocalizePairs(LocalizePath))
+		Localize.push_back(MissingKeyCollector::EngineToUtf8(Pair.second));
+
+	if (Pack.empty() && Localize.empty())
+	{
+		printf("No strings in: %s, %s\n", SourcePath.c_str(), LocalizePath.c_str());
+		return 1;
+	}
+
+	BenchStrings("pack", Pack, Rounds);
+	BenchStrings("localize", Localize, Rounds);
+
+	return 0;
+}
+
+// Appends a random code point of a random class, runs of one class reach the vector blocks
+static void AppendCodePoint(std::mt19937& Random, uint32_t Class, std::u32string& Result)
+{
+	switch (Class)
+	{
+	case 0: Result.push_back(Random() % 0x80); break;
+	case 1: Result.push_back(0x80 + Random() % (0x800 - 0x80)); break;
+	case 2: Result.push_back(0x4E00 + Random() % (0x9FFF - 0x4E00)); break;
+	case 3: Result.push_back(0x800 + Random() % (0xD800 - 0x800)); break;
+	case 4: Result.push_back(0xE000 + Random() % (0x10000 - 0xE000)); break;
+	case 5: Result.push_back(0x10000 + Random() % (0x110000 - 0x10000)); break;
+	default:
+	{
+		// The edges of every range
+		static const uint32_t Edges[] = { 0, 0x7F, 0x80, 0x7FF, 0x800, 0xD7FF, 0xE000, 0xFEFF, 0xFFFD, 0xFFFF, 0x10000, 0x10FFFF };
+		Result.push_back(Edges[Random() % (sizeof(Edges) / sizeof(Edges[0]))]);
+		break;
+	}
+	}
+}
+
+// Builds a string of runs of random classes
+static std::u32string RandomCodePoints(std::mt19937& Random)
+{
+	std::u32string Result;
+	auto Runs = Random() % 8;
+
+	for (uint32_t Run = 0; Run < Runs; Run++)
+	{
+		auto Class = Random() % 7;
+		auto Length = 1 + Random() % 48;
+
+		for (uint32_t i = 0; i < Length; i++)
+			AppendCodePoint(Random, Class, Result);
+	}
+
+	return Result;
+}
+
+// Encodes code points as utf8
+static std::string EncodeUtf8(const std::u32string& CodePoints)
+{
+	std::string Result;
+	for (auto CodePoint : CodePoints)
+	{
+		uint8_t Encoded[4];
+		auto Length = Unicode::EncodeUtf8(CodePoint, Encoded);
+		Result.append((const char*)Encoded, Length);
+	}
+
+	return Result;
+}
+
+// Encodes code points as utf16
+static std::u16string EncodeUtf16(const std::u32string& CodePoints)
+{
+	std::u16string Result;
+	for (auto CodePoint : CodePoints)
+	{
+		if (CodePoint >= 0x10000)
+		{
+			Result.push_back((char16_t)(0xD800 + ((CodePoint - 0x10000) >> 10)));
+			Result.push_back((char16_t)(0xDC00 + ((CodePoint - 0x10000) & 0x3FF)));
+		}
+		else
+		{
+			Result.push_back((char16_t)CodePoint);
+		}
+	}
+
+	return Result;
+}
+
+// Breaks a utf8 string in the ways real input is broken
+static void MutateUtf8(std::mt19937& Random, std::string& Text)
+{
+	static const char* Broken[] = { "\x80", "\xBF", "\xC0\xAF", "\xC1\xBF", "\xE0\x80\xAF", "\xED\xA0\x80", "\xED\xBF\xBF", "\xF0\x80\x80\xAF", "\xF4\x90\x80\x80", "\xF5", "\xFF", "\xE4\xB8", "\xF0\x9F\x98" };
+
+	switch (Random() % 4)
+	{
+	case 0:
+		if (!Text.empty())
+			Text[Random() % Text.size()] = (char)(Random() & 0xFF);
+		break;
+	case 1:
+		if (!Text.empty())
+			Text.resize(Random() % Text.size());
+		break;
+	default:
+		Text.insert(Text.empty() ? 0 : Random() % Text.size(), Broken[Random() % (sizeof(Broken) / sizeof(Broken[0]))]);
+		break;
+	}
+}
+
+// Breaks a utf16 string with a lone surrogate
+static void MutateUtf16(std::mt19937& Random, std::u16string& Text)
+{
+	auto Unit = (char16_t)(((Random() & 1) ? 0xD800 : 0xDC00) + Random() % 0x400);
+
+	if (!Text.empty() && (Random() & 1))
+		Text[Random() % Text.size()] = Unit;
+	else
+		Text.insert(Text.empty() ? 0 : Random() % Text.size(), 1, Unit);
+}
+
+// One conversion at a level, with its output
+struct FuzzOutcome
+{
+	TranscodeResult Result;
+	std::u16string Wide;
+	std::string Narrow;
+
+	bool operator==(const FuzzOutcome& Other) const
+	{
+		return Result.Status == Other.Result.Status && Result.Read == Other.Result.Read && Result.Written == Other.Result.Written && Wide == Other.Wide && Narrow == Other.Narrow;
+	}
+};
+
+// Converts at every level, false if any two disagree
+static bool ConvertAtEveryLevel(const std::string& Text, size_t ResultSize, FuzzOutcome& Outcome)
+{
+	auto Supported = CpuFeatures::GetSupportedLevel();
+	bool Agree = true;
+
+	for (uint32_t Level = CPU_LEVEL_SCALAR; Level <= (uint32_t)Supported; Level++)
+	{
+		CpuFeatures::SetLevelLimit((CpuLevel)Level);
+
+		FuzzOutcome Current;
+		Current.Wide.assign(ResultSize, u'\0');
+		Current.Result = Unicode::TranscodeUtf8ToUtf16(Text.data(), Text.size(), (uint16_t*)&Current.Wide[0], ResultSize);
+		Current.Wide.resize(Current.Result.Written);
+
+		if (Level == CPU_LEVEL_SCALAR)
+			Outcome = Current;
+		else if (!(Current == Outcome))
+			Agree = false;
+	}
+
+	return Agree;
+}
+
+// Converts at every level, false if any two disagree
+static bool ConvertAtEveryLevel(const std::u16string& Text, size_t ResultSize, FuzzOutcome& Outcome)
+{
+	auto Supported = CpuFeatures::GetSupportedLevel();
+	bool Agree = true;
+
+	for (uint32_t Level = CPU_LEVEL_SCALAR; Level <= (uint32_t)Supported; Level++)
+	{
+		CpuFeatures::SetLevelLimit((CpuLevel)Level);
+
+		FuzzOutcome Current;
+		Current.Narrow.assign(ResultSize, '\0');
+		Current.Result = Unicode::TranscodeUtf16ToUtf8((const uint16_t*)Text.data(), Text.size(), &Current.Narrow[0], ResultSize);
+		Current.Narrow.resize(Current.Result.Written);
+
+		if (Level == CPU_LEVEL_SCALAR)
+			Outcome = Current;
+		else if (!(Current == Outcome))
+			Agree = false;
+	}
+
+	return Agree;
+}
+
+// Whether or not the utf8 input ends with fewer bytes than the lead at a position needs
+static bool IsTruncatedTail(const std::string& Text, size_t Position)
+{
+	auto Lead = (uint8_t)Text[Position];
+	auto Needed = ((Lead & 0xE0) == 0xC0) ? 2u : ((Lead & 0xF0) == 0xE0) ? 3u : ((Lead & 0xF8) == 0xF0) ? 4u : 0u;
+
+	return Needed != 0 && Text.size() - Position < Needed;
+}
+
+// Whether or not the utf8 input has a surrogate (U+D800-DFFF) encoded at a position
+static bool IsEncodedSurrogate(const std::string& Text, size_t Position)
+{
+	return Text.size() - Position >= 3 && (uint8_t)Text[Position] == 0xED && ((uint8_t)Text[Position + 1] & 0xE0) == 0xA0 && ((uint8_t)Text[Position + 2] & 0xC0) == 0x80;
+}
+
+int FuzzUnicodeCommand(int argc, char** argv)
+{
+	std::string SourcePath = "en/en_source.txt";
+	uint32_t Iterations = 200000;
+	uint32_t Seed = 1;
+
+	for (int i = 0; i + 1 < argc; i += 2)
+	{
+		if (std::strcmp(argv[i], "--source") == 0)
+			SourcePath = argv[i + 1];
+		else if (std::strcmp(argv[i], "--iterations") == 0)
+			Iterations = (uint32_t)std::max(1, std::atoi(argv[i + 1]));
+		else if (std::strcmp(argv[i], "--seed") == 0)
+			Seed = (uint32_t)std::atoi(argv[i + 1]);
+	}
+
+	// The pack's values seed a share of the inputs
+	std::vector<std::string> Seeds;
+	for (auto& Pair : ToolUtils::ReadSourcePairs(SourcePath))
+		Seeds.push_back(Pair.second);
+
+	std::mt19937 Random(Seed);
+	uint32_t Valid = 0, Invalid = 0, Short = 0, LevelMismatches = 0, ReferenceMismatches = 0, PrefixMismatches = 0;
+	uint32_t ReferenceSurrogates = 0, ReferenceTruncations = 0;
+
+	// Reports the first few failures in full
+	auto Report = [&](const char* What, uint32_t Iteration)
+	{
+		if (LevelMismatches + ReferenceMismatches + PrefixMismatches <= 5)
+			printf("mismatch: %s at iteration %u\n", What, Iteration);
+	};
+
+	for (uint32_t Iteration = 0; Iteration < Iterations; Iteration++)
+	{
+		auto CodePoints = RandomCodePoints(Random);
+		auto Broken = (Random() % 3) == 0;
+
+		// Utf8 to utf16, against wstring_convert
+		{
+			auto Text = (!Seeds.empty() && (Random() % 4) == 0) ? Seeds[Random() % Seeds.size()] : EncodeUtf8(CodePoints);
+			if (Broken)
+				MutateUtf8(Random, Text);
+
+			FuzzOutcome Outcome;
+			if (!ConvertAtEveryLevel(Text, Text.size(), Outcome))
+			{
+				LevelMismatches++;
+				Report("utf8 levels", Iteration);
+			}
+
+			bool Thrown = false;
+			std::u16string Expected;
+			try
+			{
+				Expected = LegacyConverter().from_bytes(Text);
+			}
+			catch (...)
+			{
+				Thrown = true;
+			}
+
+			// libstdc++ accepts encoded surrogates, and drops a last sequence shorter than its lead needs instead of failing
+			auto Converted = (Outcome.Result.Status == TRANSCODE_OK);
+			if (!Converted && !Thrown && IsEncodedSurrogate(Text, Outcome.Result.Read))
+			{
+				ReferenceSurrogates++;
+			}
+			else if (!Converted && !Thrown && IsTruncatedTail(Text, Outcome.Result.Read) && Expected == Outcome.Wide)
+			{
+				ReferenceTruncations++;
+			}
+			else if (Converted == Thrown || (Converted && (Outcome.Wide != Expected || Outcome.Result.Read != Text.size())))
+			{
+				ReferenceMismatches++;
+				Report("utf8 reference", Iteration);
+			}
+
+			Converted ? Valid++ : Invalid++;
+
+			// A short buffer must stop on a code point boundary with a prefix of the full result
+			if (Converted && !Expected.empty())
+			{
+				FuzzOutcome Partial;
+				auto Size = Random() % Expected.size();
+
+				if (!ConvertAtEveryLevel(Text, Size, Partial))
+				{
+					LevelMismatches++;
+					Report("utf8 short levels", Iteration);
+				}
+
+				if (Partial.Result.Status != TRANSCODE_SHORT_BUFFER || Partial.Wide != Expected.substr(0, Partial.Wide.size()) || Size - Partial.Wide.size() > 1 ||
+					LegacyConverter().from_bytes(Text.substr(0, Partial.Result.Read)) != Partial.Wide)
+				{
+					PrefixMismatches++;
+					Report("utf8 short buffer", Iteration);
+				}
+
+				Short++;
+			}
+		}
+
+		// Utf16 to utf8, against wstring_convert
+		{
+			auto Text = EncodeUtf16(CodePoints);
+			if (Broken)
+				MutateUtf16(Random, Text);
+
+			FuzzOutcome Outcome;
+			if (!ConvertAtEveryLevel(Text, Text.size() * 3, Outcome))
+			{
+				LevelMismatches++;
+				Report("utf16 levels", Iteration);
+			}
+
+			bool Thrown = false;
+			std::string Expected;
+			try
+			{
+				Expected = LegacyConverter().to_bytes(Text);
+			}
+			catch (...)
+			{
+				Thrown = true;
+			}
+
+			// libstdc++ drops a high surrogate at the very end instead of failing
+			auto Converted = (Outcome.Result.Status == TRANSCODE_OK);
+			if (!Converted && !Thrown && Outcome.Result.Read == Text.size() - 1 && Text.back() >= 0xD800 && Text.back() <= 0xDBFF && Expected == Outcome.Narrow)
+			{
+				ReferenceTruncations++;
+			}
+			else if (Converted == Thrown || (Converted && (Outcome.Narrow != Expected || Outcome.Result.Read != Text.size())))
+			{
+				ReferenceMismatches++;
+				Report("utf16 reference", Iteration);
+			}
+
+			Converted ? Valid++ : Invalid++;
+
+			if (Converted && !Expected.empty())
+			{
+				FuzzOutcome Partial;
+				auto Size = Random() % Expected.size();
+
+				if (!ConvertAtEveryLevel(Text, Size, Partial))
+				{
+					LevelMismatches++;
+					Report("utf16 short levels", Iteration);
+				}
+
+				if (Partial.Result.Status != TRANSCODE_SHORT_BUFFER || Partial.Narrow != Expected.substr(0, Partial.Narrow.size()) || Size - Partial.Narrow.size() > 3 ||
+					LegacyConverter().to_bytes(Text.substr(0, Partial.Result.Read)) != Partial.Narrow)
+				{
+					PrefixMismatches++;
+					Report("utf16 short buffer", Iteration);
+				}
+
+				Short++;
+			}
+		}
+	}
+
+	CpuFeatures::SetLevelLimit(CPU_LEVEL_AVX2);
+
+	auto Passed = (LevelMismatches == 0 && ReferenceMismatches == 0 && PrefixMismatches == 0);
+
+	printf("levels:     scalar up to %s\n", CpuFeatures::GetLevelName(CpuFeatures::GetSupportedLevel()));
+	printf("inputs:     %u valid, %u invalid, %u short buffer checks\n", Valid, Invalid, Short);
+	printf("mismatches: %u between levels, %u against wstring_convert, %u short buffer\n", LevelMismatches, ReferenceMismatches, PrefixMismatches);
+	printf("known:      %u encoded surrogates and %u cut off endings wstring_convert accepts, rejected here\n", ReferenceSurrogates, ReferenceTruncations);
+	printf("result:     %s\n", Passed ? "every conversion matches" : "FAILED");
+
+	return Passed ? 0 : 1;
+}
\ No newline at end of file
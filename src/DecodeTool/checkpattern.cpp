@@ -0,0 +1,253 @@
+// Standard includes
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+// Our includes
+#include "commands.h"
+#include "toolutils.h"
+#include "cpufeatures.h"
+#include "patternscan.h"
+
+// Whether or not CompilePattern accepts a signature literal, without failing the build when it doesn't
+#define PatternCompiles(Pattern) (CompiledPattern<PatternCompiler::CountBytes(Pattern)>(Pattern).IsValid())
+
+// Whether or not a compiled signature has the given anchors
+template<size_t Capacity>
+static constexpr bool HasAnchorsAt(const CompiledPattern<Capacity>& Compiled, uint32_t First, uint32_t Second)
+{
+	return Compiled.HasAnchors && Compiled.Anchors[0] == First && Compiled.Anchors[1] == Second;
+}
+
+//
+// Checked by the compiler, the tool doesn't build unless every one of them holds
+//
+
+// The startup signatures, with the anchors bench-pattern reports for them
+static constexpr CompiledPattern<15> SEHTranslateSignature("55 8B EC 83 E4 ? A1 ? ? ? ? 56 57 85 C0");
+static constexpr CompiledPattern<13> ScaleformTranslateSignature("8B 50 ?? 33 F6 56 6A ?? FF D2 3B C6 74");
+static constexpr CompiledPattern<27> DBFindXAssetHeaderSignature("55 8B EC 83 E4 ? 83 EC ? 53 56 57 C7 44 24 ? ? ? ? ? 80 3D ? ? ? ? ?");
+
+static_assert(PatternCompiler::CountBytes("55 8B EC 83 E4 ? A1 ? ? ? ? 56 57 85 C0") == 15, "counts a token a byte");
+static_assert(SEHTranslateSignature.IsValid() && SEHTranslateSignature.Length == 15, "parses every byte");
+static_assert(SEHTranslateSignature.Data[0] == 0x55 && SEHTranslateSignature.Data[14] == 0xC0, "parses hex bytes");
+static_assert(SEHTranslateSignature.Mask[4] == 0xFF && SEHTranslateSignature.Mask[5] == 0 && SEHTranslateSignature.Data[5] == 0, "masks ? out");
+static_assert(SEHTranslateSignature.Mask[15] == 0 && SEHTranslateSignature.GetView().PaddedLength == 16, "pads with wildcards");
+static_assert(HasAnchorsAt(SEHTranslateSignature, 6, 4), "anchors on the rarest bytes");
+static_assert(ScaleformTranslateSignature.Mask[2] == 0 && ScaleformTranslateSignature.Mask[7] == 0, "masks ?? out");
+static_assert(HasAnchorsAt(ScaleformTranslateSignature, 9, 11), "anchors on the rarest bytes");
+static_assert(DBFindXAssetHeaderSignature.Length == 27 && DBFindXAssetHeaderSignature.GetView().PaddedLength == 32, "keeps trailing wildcards");
+static_assert(HasAnchorsAt(DBFindXAssetHeaderSignature, 21, 4), "anchors on the rarest bytes");
+
+// Spacing, case and a single fixed byte
+static constexpr CompiledPattern<3> SpacedSignature("  8b   ?? eC ");
+static_assert(SpacedSignature.IsValid() && SpacedSignature.Length == 3, "skips repeated spaces");
+static_assert(SpacedSignature.Data[0] == 0x8B && SpacedSignature.Data[2] == 0xEC, "reads lower case digits");
+static_assert(HasAnchorsAt(SpacedSignature, 2, 0), "ranks EC rarer than 8B");
+static_assert(HasAnchorsAt(CompiledPattern<2>("? 55"), 1, 1), "repeats a lone anchor");
+static_assert(PatternCompiles("55") && PatternCompiles("?? 55 ?"), "accepts short signatures");
+
+// Malformed signatures, each of these would stop CompilePattern
+static_assert(!PatternCompiles(""), "rejects an empty signature");
+static_assert(!PatternCompiles("   "), "rejects an empty signature");
+static_assert(!PatternCompiles("? ??"), "rejects a signature without a fixed byte");
+static_assert(!PatternCompiles("55 8"), "rejects a lone digit");
+static_assert(!PatternCompiles("558B"), "rejects bytes without a space");
+static_assert(!PatternCompiles("55 8B0"), "rejects three digits");
+static_assert(!PatternCompiles("55 G8"), "rejects a non hex digit");
+static_assert(!PatternCompiles("55 8G"), "rejects a non hex digit");
+static_assert(!PatternCompiles("55 ?A"), "rejects a digit after a wildcard");
+static_assert(!PatternCompiles("55 ???"), "rejects three wildcards in a token");
+static_assert(!PatternCompiles("55\t8B"), "rejects tabs");
+static_assert(!CompiledPattern<1>("55 8B").IsValid(), "rejects more bytes than its room");
+
+// Writes a random signature, sometimes with a malformed token
+static std::string RandomPatternText(std::mt19937& Random)
+{
+	static const char Digits[] = "0123456789ABCDEFabcdef";
+	static const char Junk[] = "0F?G \tx";
+
+	auto Count = 1 + (Random() % 40);
+	std::string Text(Random() % 3, ' ');
+
+	for (uint32_t i = 0; i < Count; i++)
+	{
+		if (i != 0)
+			Text.append(1 + (Random() % 2), ' ');
+
+		if ((Random() % 4) == 0)
+		{
+			Text += ((Random() & 1) != 0) ? "?" : "??";
+			continue;
+		}
+
+		Text += Digits[Random() % 22];
+		Text += Digits[Random() % 22];
+	}
+
+	// A fifth are broken by a character put in, taken out or swapped
+	if ((Random() % 5) == 0)
+	{
+		auto Position = Random() % (Text.size() + 1);
+
+		switch (Random() % 3)
+		{
+		case 0:
+			Text.insert(Text.begin() + Position, Junk[Random() % 7]);
+			break;
+		case 1:
+			if (Position < Text.size())
+				Text.erase(Text.begin() + Position);
+			break;
+		default:
+			if (Position < Text.size())
+				Text[Position] = Junk[Random() % 7];
+			break;
+		}
+	}
+
+	return Text;
+}
+
+// Whether or not a signature is well formed, token by token as the grammar is written
+static bool IsWellFormed(const std::string& Text)
+{
+	size_t Fixed = 0;
+	size_t Position = 0;
+
+	while (Position < Text.size())
+	{
+		if (Text[Position] == ' ')
+		{
+			Position++;
+			continue;
+		}
+
+		auto End = Text.find(' ', Position);
+		auto Token = Text.substr(Position, (End == std::string::npos) ? std::string::npos : End - Position);
+		Position += Token.size();
+
+		if (Token == "?" || Token == "??")
+			continue;
+		if (Token.size() != 2 || PatternCompiler::HexDigit(Token[0]) < 0 || PatternCompiler::HexDigit(Token[1]) < 0)
+			return false;
+
+		Fixed++;
+	}
+
+	return Fixed > 0;
+}
+
+int CheckPatternCommand(int argc, char** argv)
+{
+	uint32_t Iterations = 20000;
+	uint32_t Seed = 1;
+
+	for (int i = 0; i + 1 < argc; i += 2)
+	{
+		if (std::strcmp(argv[i], "--iterations") == 0)
+			Iterations = (uint32_t)std::max(1, std::atoi(argv[i + 1]));
+		else if (std::strcmp(argv[i], "--seed") == 0)
+			Seed = (uint32_t)std::atoi(argv[i + 1]);
+	}
+
+	printf("compile:  the static_assert checks passed when this tool was built\n");
+
+	std::mt19937 Random(Seed);
+	uint32_t WellFormed = 0, Malformed = 0, GrammarMismatches = 0, ParseMismatches = 0, ScanMismatches = 0;
+
+	for (uint32_t Iteration = 0; Iteration < Iterations; Iteration++)
+	{
+		auto Text = RandomPatternText(Random);
+
+		// The parser the compiler runs, run here on text it never saw
+		CompiledPattern<64> Compiled(Text.c_str());
+
+		if (Compiled.IsValid() != IsWellFormed(Text))
+		{
+			if (GrammarMismatches++ < 5)
+				printf("mismatch: \"%s\" %s\n", Text.c_str(), Compiled.IsValid() ? "compiled" : Compiled.Error);
+			continue;
+		}
+
+		if (!Compiled.IsValid())
+		{
+			Malformed++;
+			continue;
+		}
+
+		WellFormed++;
+
+		// The runtime parser reads well formed text the same way
+		PatternScan Scanner(Text.c_str());
+		auto View = Compiled.GetView();
+
+		bool Same = (Scanner.GetLength() == View.Length && Scanner.GetAnchor(0) == View.Anchors[0] && Scanner.GetAnchor(1) == View.Anchors[1]);
+		for (size_t i = 0; Same && i < View.Length; i++)
+			Same = (Scanner.GetByte(i) == View.Data[i] && Scanner.IsFixed(i) == (View.Mask[i] != 0));
+
+		if (!Same)
+		{
+			if (ParseMismatches++ < 5)
+				printf("mismatch: \"%s\" parses differently at runtime\n", Text.c_str());
+			continue;
+		}
+
+		// Few distinct bytes and a copy of the signature, so both scans have matches and near misses to find
+		std::vector<uint8_t> Range(Random() % 300);
+		for (auto& Byte : Range)
+			Byte = (uint8_t)((Random() & 1) ? View.Data[View.Anchors[0]] : View.Data[Random() % View.Length]);
+
+		if (Range.size() >= View.Length && (Random() & 1) != 0)
+		{
+			auto Place = Random() % (Range.size() - View.Length + 1);
+			for (size_t i = 0; i < View.Length; i++)
+			{
+				if (View.Mask[i] != 0)
+					Range[Place + i] = View.Data[i];
+			}
+		}
+
+		auto Source = (uintptr_t)Range.data();
+
+		for (uint32_t Level = CPU_LEVEL_SCALAR; Level <= (uint32_t)CpuFeatures::GetSupportedLevel(); Level++)
+		{
+			CpuFeatures::SetLevelLimit((CpuLevel)Level);
+
+			if (PatternScan::ScanSignature(View, Source, Range.size()) != Scanner.Scan(Source, Range.size()))
+				ScanMismatches++;
+		}
+
+		CpuFeatures::SetLevelLimit(CPU_LEVEL_AVX2);
+	}
+
+	printf("random:   %u signatures, %u well formed and %u malformed\n", Iterations, WellFormed, Malformed);
+	printf("          %u disagree with the grammar, %u parse differently at runtime, %u scans differ\n", GrammarMismatches, ParseMismatches, ScanMismatches);
+
+	// What FindPattern paid before every scan, against the compiled signature it scans with now
+	const uint32_t Calls = 200000;
+	std::vector<uint8_t> Page(4096, 0xCC);
+	auto Source = (uintptr_t)Page.data();
+	// Counted so neither loop is optimized out, the page has no match
+	uint32_t Matches = 0;
+
+	ToolUtils::Stopwatch ParseTimer;
+	for (uint32_t i = 0; i < Calls; i++)
+		Matches += (PatternScan("55 8B EC 83 E4 ? A1 ? ? ? ? 56 57 85 C0").Scan(Source, Page.size()) >= 0);
+	auto ParseTime = ParseTimer.ElapsedMilliseconds();
+
+	ToolUtils::Stopwatch CompiledTimer;
+	for (uint32_t i = 0; i < Calls; i++)
+		Matches += (PatternScan::ScanSignature(CompilePattern("55 8B EC 83 E4 ? A1 ? ? ? ? 56 57 85 C0").GetView(), Source, Page.size()) >= 0);
+	auto CompiledTime = CompiledTimer.ElapsedMilliseconds();
+
+	printf("setup:    %u scans of a 4 KB page, parsed at runtime %.1f ns a call, compiled %.1f ns a call, %u matches\n", Calls, ParseTime * 1000000.0 / Calls, CompiledTime * 1000000.0 / Calls, Matches);
+
+	auto Valid = (GrammarMismatches == 0 && ParseMismatches == 0 && ScanMismatches == 0);
+	printf("result:   %s\n", Valid ? "compiled signatures match the runtime parser" : "FAILED");
+	return Valid ? 0 : 1;
+}
\ No newline at end of file
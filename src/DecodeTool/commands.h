@@ -0,0 +1,57 @@
+#pragma once
+
+// Compiles a source file (KEY|value lines) into a database
+int CompileCommand(int argc, char** argv);
+// Creates the delta from a database to a full build of a source file
+int DeltaCommand(int argc, char** argv);
+// Applies a delta to its base, writing the patched database
+int PatchCommand(int argc, char** argv);
+// Checks a base plus delta is byte identical to a full build of a source file
+int VerifyDeltaCommand(int argc, char** argv);
+// Converts a legacy database into the v2 format
+int ConvertCommand(int argc, char** argv);
+// Benchmarks database load and lookup
+int BenchCommand(int argc, char** argv);
+// Runs every lookup engine against the shipped corpora, writing latency, throughput, load time and memory as JSON
+int BenchSuiteCommand(int argc, char** argv);
+// Benchmarks the Scaleform hook against a mocked translate info
+int BenchScaleformCommand(int argc, char** argv);
+// Benchmarks the StringEd pointer cache against a replayed key stream
+int BenchCacheCommand(int argc, char** argv);
+// Benchmarks the lookup API with every hash policy
+int BenchHashCommand(int argc, char** argv);
+// Checks placeholder templates against their values and the source language, and measures formatting
+int BenchTemplateCommand(int argc, char** argv);
+// Checks the negative filter and measures its false positive rate and throughput
+int FilterCommand(int argc, char** argv);
+// Measures value compression, ratio, decode speed and lookup latency against the plain image
+int BenchCompressCommand(int argc, char** argv);
+// Checks overlay resolution against a merged table and measures stacked lookups
+int BenchOverlayCommand(int argc, char** argv);
+// Watches a database for changes, reloading it under concurrent readers
+int WatchCommand(int argc, char** argv);
+// Replays a recorded key trace against a database, with the original timing or as fast as possible
+int ReplayCommand(int argc, char** argv);
+// Synthesizes a key trace of a play session from the game's localize dump
+int TraceGenerateCommand(int argc, char** argv);
+// Logs from many threads at once, checking producer latency stays bounded and every line or drop is accounted for
+int LogStressCommand(int argc, char** argv);
+// Prints live hook metrics from the game's shared memory block
+int MetricsCommand(int argc, char** argv);
+// Counts lookups from many threads into a shared metrics block and checks a separate reader mapping sees every call
+int MetricsHarnessCommand(int argc, char** argv);
+// Replays missing keys from many threads into a collector and checks every key is written once as valid utf8
+int MissingCollectCommand(int argc, char** argv);
+// Measures utf8 and utf16 conversion throughput on the pack's strings at every instruction set level
+int BenchUnicodeCommand(int argc, char** argv);
+// Converts random and broken strings at every level, checking they agree with each other and wstring_convert
+int FuzzUnicodeCommand(int argc, char** argv);
+// Decodes the game's GBK localize dump and joins it against a source file, writing new, changed and missing keys
+int ImportGameCommand(int argc, char** argv);
+// Checks the GBK table against the platform's decoder and measures decoding the game's dump
+int BenchGbkCommand(int argc, char** argv);
+// Measures signature scans over a synthetic code image at every instruction set level and worker count against the scan phook.h had,
+// and checks the site cache across launches
+int BenchPatternCommand(int argc, char** argv);
+// Checks signatures parsed at compile time against the runtime parser and a byte at a time grammar
+int CheckPatternCommand(int argc, char** argv);
\ No newline at end of file
@@ -0,0 +1,187 @@
+// Standard includes
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Our includes
+#include "commands.h"
+#include "toolutils.h"
+#include "translationdb.h"
+#include "translationdelta.h"
+#include "sourcefile.h"
+#include "parallel.h"
+#include "mappedfile.h"
+
+// Issues of each kind printed before they're only counted
+static const size_t ReportedIssues = 20;
+
+int CompileCommand(int argc, char** argv)
+{
+	if (argc < 1)
+	{
+		printf("usage: d3tool compile <source.txt> [output.db] [--threads N] [--compress] [--legacy] [--strict] [--incremental] [--delta output.delta]\n");
+		return 1;
+	}
+
+	std::string InputPath = argv[0];
+	std::string OutputPath, DeltaPath;
+	auto Threads = Parallel::GetWorkerCount();
+	bool Compress = false, Legacy = false, Strict = false, Incremental = false;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+			Threads = (uint32_t)std::max(1, std::atoi(argv[++i]));
+		else if (std::strcmp(argv[i], "--compress") == 0)
+			Compress = true;
+		else if (std::strcmp(argv[i], "--legacy") == 0)
+			Legacy = true;
+		else if (std::strcmp(argv[i], "--strict") == 0)
+			Strict = true;
+		else if (std::strcmp(argv[i], "--incremental") == 0)
+			Incremental = true;
+		else if (std::strcmp(argv[i], "--delta") == 0 && i + 1 < argc)
+			DeltaPath = argv[++i];
+		else if (OutputPath.empty() && argv[i][0] != '-')
+			OutputPath = argv[i];
+	}
+
+	// Like translategen, the output goes next to the source by default
+	if (OutputPath.empty())
+	{
+		auto Extension = InputPath.find_last_of('.');
+		auto Separator = InputPath.find_last_of("/\\");
+
+		OutputPath = (Extension != std::string::npos && (Separator == std::string::npos || Extension > Separator)) ? InputPath.substr(0, Extension) : InputPath;
+		OutputPath += ".db";
+	}
+
+	if (Legacy && Compress)
+	{
+		printf("Legacy databases can't be compressed\n");
+		return 1;
+	}
+
+	ToolUtils::Stopwatch Total;
+
+	MappedFile Input;
+	if (!Input.Open(InputPath))
+	{
+		printf("Failed to read: %s\n", InputPath.c_str());
+		return 1;
+	}
+
+	auto ReadTime = Total.ElapsedMilliseconds();
+	ToolUtils::Stopwatch Timer;
+
+	std::vector<TranslationPair> Pairs;
+	SourceReport Report;
+	if (!ParseSourceFile(Input.GetData(), Input.GetSize(), Pairs, Report, Threads))
+	{
+		printf("Source file too large: %s\n", InputPath.c_str());
+		return 1;
+	}
+
+	auto ParseTime = Timer.ElapsedMilliseconds();
+	Timer.Restart();
+
+	// The delta is made against the previous build, so it implies an incremental build
+	Incremental |= !DeltaPath.empty();
+
+	// The previous build is only reused when it's in the requested format, otherwise this is a full build
+	std::vector<uint8_t> Previous, Image, Delta;
+	if (Incremental && ToolUtils::ReadFile(OutputPath, Previous))
+	{
+		auto PreviousLegacy = (Previous.size() < sizeof(uint32_t) || *(const uint32_t*)Previous.data() != TRANSLATIONDB_MAGIC);
+		auto SameFormat = (PreviousLegacy == Legacy);
+
+		if (SameFormat && !Legacy)
+		{
+			std::vector<uint8_t> Copy(Previous);
+			TranslationDB Database;
+
+			SameFormat = (Database.LoadImage(Copy) && Database.IsCompressed() == Compress && Database.GetView().HashId == Hashing::HashFnv1a);
+		}
+
+		if (!SameFormat)
+			Previous.clear();
+	}
+
+	if (Incremental && Previous.empty())
+		printf("No previous %s build at %s, building everything\n", Legacy ? "legacy" : (Compress ? "compressed" : "v2"), OutputPath.c_str());
+
+	if (!Previous.empty())
+	{
+		std::string Error;
+		if (!TranslationDelta::Rebuild(Previous, Pairs, Image, DeltaPath.empty() ? nullptr : &Delta, &Error, Threads))
+		{
+			printf("Failed to build database: %s\n", Error.c_str());
+			return 1;
+		}
+	}
+	else if (Legacy)
+	{
+		BuildLegacyDatabase(Pairs, Image);
+	}
+	else
+	{
+		TranslationDBBuilder Builder;
+		Builder.Reserve((uint32_t)Pairs.size());
+		Builder.SetValueCompression(Compress);
+
+		for (auto& Pair : Pairs)
+			Builder.Add(Pair.Key, Pair.KeyLength, Pair.Value, Pair.ValueLength);
+
+		std::string Error;
+		if (!Builder.Build(Image, &Error, Threads))
+		{
+			printf("Failed to build database: %s\n", Error.c_str());
+			return 1;
+		}
+	}
+
+	auto BuildTime = Timer.ElapsedMilliseconds();
+
+	for (size_t i = 0; i < Report.Malformed.size() && i < ReportedIssues; i++)
+		printf("%s(%u): malformed line: %s\n", InputPath.c_str(), Report.Malformed[i].Line, Report.Malformed[i].Text.c_str());
+	for (size_t i = 0; i < Report.Duplicates.size() && i < ReportedIssues; i++)
+		printf("%s(%u): duplicate key %s, replaces line %u\n", InputPath.c_str(), Report.Duplicates[i].Line, Report.Duplicates[i].Text.c_str(), Report.Duplicates[i].FirstLine);
+
+	if (Report.Malformed.size() > ReportedIssues || Report.Duplicates.size() > ReportedIssues)
+		printf("...\n");
+
+	if (Strict && (!Report.Malformed.empty() || !Report.Duplicates.empty()))
+	{
+		printf("Not writing %s, the source has %u malformed lines and %u duplicate keys\n", OutputPath.c_str(), (uint32_t)Report.Malformed.size(), (uint32_t)Report.Duplicates.size());
+		return 1;
+	}
+
+	Timer.Restart();
+	if (!ToolUtils::WriteFile(OutputPath, Image.data(), Image.size()))
+	{
+		printf("Failed to write: %s\n", OutputPath.c_str());
+		return 1;
+	}
+
+	if (!DeltaPath.empty() && !Delta.empty() && !ToolUtils::WriteFile(DeltaPath, Delta.data(), Delta.size()))
+	{
+		printf("Failed to write: %s\n", DeltaPath.c_str());
+		return 1;
+	}
+
+	auto WriteTime = Timer.ElapsedMilliseconds();
+
+	printf("Compiled %u lines (%u pairs, %u comments, %u malformed, %u duplicate keys) into %s\n", Report.LineCount, (uint32_t)Pairs.size(), Report.CommentCount,
+		(uint32_t)Report.Malformed.size(), (uint32_t)Report.Duplicates.size(), OutputPath.c_str());
+	printf("%s database, %u bytes in %.2f ms using %u threads (read %.2f, parse %.2f, build %.2f, write %.2f)\n", Legacy ? "Legacy" : (Compress ? "Compressed" : "v2"),
+		(uint32_t)Image.size(), Total.ElapsedMilliseconds(), Threads, ReadTime, ParseTime, BuildTime, WriteTime);
+
+	if (!Previous.empty())
+		printf("Incremental build against the previous %u byte build\n", (uint32_t)Previous.size());
+	if (!Delta.empty())
+		printf("Delta of %u bytes written to %s\n", (uint32_t)Delta.size(), DeltaPath.c_str());
+
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,75 @@
+// Standard includes
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Our includes
+#include "commands.h"
+#include "toolutils.h"
+#include "translationdb.h"
+#include "parallel.h"
+
+int ConvertCommand(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		printf("usage: d3tool convert <input.db> <output.db> [--threads N] [--compress]\n");
+		return 1;
+	}
+
+	auto Threads = Parallel::GetWorkerCount();
+	bool Compress = false;
+
+	for (int i = 2; i < argc; i++)
+	{
+		if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+			Threads = (uint32_t)std::max(1, std::atoi(argv[++i]));
+		else if (std::strcmp(argv[i], "--compress") == 0)
+			Compress = true;
+	}
+
+	std::vector<uint8_t> Input;
+	if (!ToolUtils::ReadFile(argv[0], Input))
+	{
+		printf("Failed to read: %s\n", argv[0]);
+		return 1;
+	}
+
+	if (Input.size() >= sizeof(uint32_t) && *(const uint32_t*)Input.data() == TRANSLATIONDB_MAGIC)
+	{
+		printf("Already a v2 database: %s\n", argv[0]);
+		return 1;
+	}
+
+	ToolUtils::Stopwatch Timer;
+
+	TranslationDBBuilder Builder;
+	if (!ParseLegacyDatabase(Input.data(), Input.size(), Builder, Threads))
+	{
+		printf("Not a legacy database: %s\n", argv[0]);
+		return 1;
+	}
+
+	Builder.SetValueCompression(Compress);
+
+	std::vector<uint8_t> Image;
+	std::string Error;
+	if (!Builder.Build(Image, &Error, Threads))
+	{
+		printf("Failed to build database: %s\n", Error.c_str());
+		return 1;
+	}
+
+	if (!ToolUtils::WriteFile(argv[1], Image.data(), Image.size()))
+	{
+		printf("Failed to write: %s\n", argv[1]);
+		return 1;
+	}
+
+	auto ImageHeader = (const TranslationDBHeader*)Image.data();
+	printf("Converted %u entries (%u bytes) in %.2f ms using %u threads\n", ImageHeader->EntryCount, ImageHeader->FileSize, Timer.ElapsedMilliseconds(), Threads);
+
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,211 @@
+// Standard includes
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Our includes
+#include "commands.h"
+#include "toolutils.h"
+#include "translationdb.h"
+#include "translationdelta.h"
+#include "sourcefile.h"
+#include "parallel.h"
+#include "mappedfile.h"
+
+// Reads the pairs of a source file, the mapping must outlive them
+static bool ReadSource(const char* Path, MappedFile& Input, std::vector<TranslationPair>& Pairs, uint32_t Threads)
+{
+	if (!Input.Open(Path))
+	{
+		printf("Failed to read: %s\n", Path);
+		return false;
+	}
+
+	SourceReport Report;
+	if (!ParseSourceFile(Input.GetData(), Input.GetSize(), Pairs, Report, Threads))
+	{
+		printf("Source file too large: %s\n", Path);
+		return false;
+	}
+
+	return true;
+}
+
+// Gets the threads argument from the options after the positional arguments
+static uint32_t GetThreads(int argc, char** argv, int First)
+{
+	auto Threads = Parallel::GetWorkerCount();
+
+	for (int i = First; i < argc; i++)
+	{
+		if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+			Threads = (uint32_t)std::max(1, std::atoi(argv[++i]));
+	}
+
+	return Threads;
+}
+
+int DeltaCommand(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		printf("usage: d3tool delta <base.db> <source.txt> [output.delta] [--threads N]\n");
+		return 1;
+	}
+
+	auto Threads = GetThreads(argc, argv, 2);
+
+	// Deltas go next to the base by default, where the loader looks for them
+	std::string OutputPath = (argc >= 3 && argv[2][0] != '-') ? argv[2] : std::string(argv[0]);
+	if (OutputPath == argv[0])
+	{
+		auto Extension = OutputPath.find_last_of('.');
+		OutputPath = ((Extension != std::string::npos) ? OutputPath.substr(0, Extension) : OutputPath) + ".delta";
+	}
+
+	std::vector<uint8_t> Base;
+	if (!ToolUtils::ReadFile(argv[0], Base))
+	{
+		printf("Failed to read: %s\n", argv[0]);
+		return 1;
+	}
+
+	MappedFile Input;
+	std::vector<TranslationPair> Pairs;
+	if (!ReadSource(argv[1], Input, Pairs, Threads))
+		return 1;
+
+	ToolUtils::Stopwatch Timer;
+
+	std::vector<uint8_t> Result, Delta;
+	std::string Error;
+	if (!TranslationDelta::Rebuild(Base, Pairs, Result, &Delta, &Error, Threads))
+	{
+		printf("Failed to build delta: %s\n", Error.c_str());
+		return 1;
+	}
+
+	auto BuildTime = Timer.ElapsedMilliseconds();
+
+	// Never ship a delta that doesn't reproduce the build
+	std::vector<uint8_t> Patched;
+	if (!TranslationDelta::Apply(Base, Delta, Patched, &Error, Threads) || Patched != Result)
+	{
+		printf("The delta doesn't reproduce the build: %s\n", Error.c_str());
+		return 1;
+	}
+
+	if (!ToolUtils::WriteFile(OutputPath, Delta.data(), Delta.size()))
+	{
+		printf("Failed to write: %s\n", OutputPath.c_str());
+		return 1;
+	}
+
+	printf("Wrote %s, %u bytes against a %u byte base for a %u byte build (%.2f%%) in %.2f ms\n", OutputPath.c_str(), (uint32_t)Delta.size(), (uint32_t)Base.size(),
+		(uint32_t)Result.size(), (Delta.size() * 100.0) / Result.size(), BuildTime);
+
+	return 0;
+}
+
+int PatchCommand(int argc, char** argv)
+{
+	if (argc < 3)
+	{
+		printf("usage: d3tool patch <base.db> <input.delta> <output.db> [--threads N]\n");
+		return 1;
+	}
+
+	auto Threads = GetThreads(argc, argv, 3);
+
+	std::vector<uint8_t> Base, Delta;
+	if (!ToolUtils::ReadFile(argv[0], Base) || !ToolUtils::ReadFile(argv[1], Delta))
+	{
+		printf("Failed to read: %s\n", Base.empty() ? argv[0] : argv[1]);
+		return 1;
+	}
+
+	ToolUtils::Stopwatch Timer;
+
+	std::vector<uint8_t> Result;
+	std::string Error;
+	if (!TranslationDelta::Apply(Base, Delta, Result, &Error, Threads))
+	{
+		printf("Failed to apply %s: %s\n", argv[1], Error.c_str());
+		return 1;
+	}
+
+	auto ApplyTime = Timer.ElapsedMilliseconds();
+
+	if (!ToolUtils::WriteFile(argv[2], Result.data(), Result.size()))
+	{
+		printf("Failed to write: %s\n", argv[2]);
+		return 1;
+	}
+
+	printf("Patched %s into %s (%u bytes) in %.2f ms\n", argv[0], argv[2], (uint32_t)Result.size(), ApplyTime);
+	return 0;
+}
+
+int VerifyDeltaCommand(int argc, char** argv)
+{
+	if (argc < 3)
+	{
+		printf("usage: d3tool verify-delta <base.db> <input.delta> <source.txt> [--threads N]\n");
+		return 1;
+	}
+
+	auto Threads = GetThreads(argc, argv, 3);
+
+	std::vector<uint8_t> Base, Delta;
+	if (!ToolUtils::ReadFile(argv[0], Base) || !ToolUtils::ReadFile(argv[1], Delta))
+	{
+		printf("Failed to read: %s\n", Base.empty() ? argv[0] : argv[1]);
+		return 1;
+	}
+
+	MappedFile Input;
+	std::vector<TranslationPair> Pairs;
+	if (!ReadSource(argv[2], Input, Pairs, Threads))
+		return 1;
+
+	ToolUtils::Stopwatch Timer;
+
+	std::vector<uint8_t> Patched;
+	std::string Error;
+	if (!TranslationDelta::Apply(Base, Delta, Patched, &Error, Threads))
+	{
+		printf("Failed to apply %s: %s\n", argv[1], Error.c_str());
+		return 1;
+	}
+
+	auto ApplyTime = Timer.ElapsedMilliseconds();
+	Timer.Restart();
+
+	// A full build of the source, in the base's format, without reusing anything from it
+	std::vector<uint8_t> Rebuilt;
+	if (!TranslationDelta::BuildLike(Base, Pairs, Rebuilt, &Error, Threads))
+	{
+		printf("Failed to build %s: %s\n", argv[2], Error.c_str());
+		return 1;
+	}
+
+	auto BuildTime = Timer.ElapsedMilliseconds();
+
+	printf("base + delta  %u bytes, checksum %016llx, %.2f ms\n", (uint32_t)Patched.size(), (unsigned long long)TranslationDelta::Checksum(Patched.data(), Patched.size()), ApplyTime);
+	printf("full rebuild  %u bytes, checksum %016llx, %.2f ms\n", (uint32_t)Rebuilt.size(), (unsigned long long)TranslationDelta::Checksum(Rebuilt.data(), Rebuilt.size()), BuildTime);
+
+	if (Patched != Rebuilt)
+	{
+		size_t Offset = 0;
+		while (Offset < Patched.size() && Offset < Rebuilt.size() && Patched[Offset] == Rebuilt[Offset])
+			Offset++;
+
+		printf("MISMATCH, first difference at byte %u\n", (uint32_t)Offset);
+		return 1;
+	}
+
+	printf("OK, byte identical\n");
+	return 0;
+}
\ No newline at end of file
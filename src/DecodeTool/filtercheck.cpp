@@ -0,0 +1,198 @@
+// Standard includes
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Our includes
+#include "commands.h"
+#include "toolutils.h"
+#include "translationdb.h"
+#include "translationlookup.h"
+#include "bloomfilter.h"
+
+static const uint32_t Rounds = 20;
+// Keeps the query loops from being optimized away
+static volatile uint32_t FilterSink = 0;
+
+// Hashes a key the way the database placed it
+static uint64_t HashKey(const TranslationDBView& View, std::string_view Key)
+{
+	if (View.HashId == Hashing::HashWordMix)
+		return Hashing::WordMix::Hash(Key.data(), Key.size());
+
+	return Hashing::Fnv1a::Hash(Key.data(), Key.size());
+}
+
+// Times missed lookups, in nanoseconds per key
+static double MeasureMisses(const TranslationDBView& View, const std::vector<std::string>& Keys, uint32_t& Found)
+{
+	TranslationLookup<> Lookup(View);
+	Found = 0;
+
+	ToolUtils::Stopwatch Timer;
+	for (uint32_t Round = 0; Round < Rounds; Round++)
+	{
+		for (auto& Key : Keys)
+		{
+			if (Lookup.FindEntry(std::string_view(Key)) != nullptr)
+				Found++;
+		}
+	}
+
+	Found /= Rounds;
+	return Timer.ElapsedNanoseconds() / ((double)Keys.size() * Rounds);
+}
+
+// Times missed lookups with the tables evicted from the cache before every key, like a game frame thrashing it in between
+static double MeasureColdMisses(const TranslationDBView& View, const std::vector<std::string>& Keys, std::vector<uint8_t>& Thrash)
+{
+	TranslationLookup<> Lookup(View);
+	double Total = 0;
+	uint32_t Found = 0;
+
+	for (auto& Key : Keys)
+	{
+		for (size_t i = 0; i < Thrash.size(); i += 64)
+			Thrash[i]++;
+
+		ToolUtils::Stopwatch Timer;
+		if (Lookup.FindEntry(std::string_view(Key)) != nullptr)
+			Found++;
+		Total += Timer.ElapsedNanoseconds();
+	}
+
+	FilterSink = Found;
+	return Total / (double)Keys.size();
+}
+
+int FilterCommand(int argc, char** argv)
+{
+	if (argc < 1)
+	{
+		printf("usage: d3tool filter <database.db> [--missing en_missing.txt] [--probes 1000000]\n");
+		return 1;
+	}
+
+	std::string DatabasePath = argv[0];
+	std::string MissingPath = "en/en_missing.txt";
+	uint32_t ProbeCount = 1000000;
+
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (std::strcmp(argv[i], "--missing") == 0)
+			MissingPath = argv[i + 1];
+		else if (std::strcmp(argv[i], "--probes") == 0)
+			ProbeCount = (uint32_t)std::max(1, std::atoi(argv[i + 1]));
+	}
+
+	TranslationDB Database;
+	if (!Database.Load(DatabasePath))
+	{
+		printf("Failed to load: %s\n", DatabasePath.c_str());
+		return 1;
+	}
+
+	auto& View = Database.GetView();
+	if (View.HashId != Hashing::HashFnv1a)
+	{
+		printf("Only FNV-1a databases are supported: %s\n", DatabasePath.c_str());
+		return 1;
+	}
+
+	// Every key in the database, and the missing keys it really doesn't have
+	std::vector<uint64_t> KeyHashes;
+	for (uint32_t i = 0; i < View.EntryCount; i++)
+		KeyHashes.push_back(HashKey(View, std::string_view(View.Strings + View.Entries[i].KeyOffset, View.Entries[i].KeyLength)));
+
+	std::vector<std::string> MissingKeys;
+	for (auto& Key : ToolUtils::ReadMissingKeys(MissingPath))
+	{
+		if (Database.Find(Key.c_str(), Key.size()) == nullptr)
+			MissingKeys.push_back(Key);
+	}
+
+	// Synthetic absent keys shaped like real ones
+	std::vector<uint64_t> ProbeHashes;
+	std::mt19937 Random(99);
+	char Probe[64];
+
+	for (uint32_t i = 0; i < ProbeCount; i++)
+	{
+		auto Length = snprintf(Probe, sizeof(Probe), "ZZ_PROBE_%08X_%u", (uint32_t)Random(), i);
+		ProbeHashes.push_back(HashKey(View, std::string_view(Probe, (size_t)Length)));
+	}
+
+	printf("database:       %s (%u entries)\n", DatabasePath.c_str(), View.EntryCount);
+	printf("absent keys:    %u from %s, %u synthetic\n\n", (uint32_t)MissingKeys.size(), MissingPath.c_str(), ProbeCount);
+	printf("bits/key  size       false neg  fpr(missing)  fpr(synthetic)  query\n");
+
+	uint32_t Failures = 0;
+	static const uint32_t BitsPerKey[] = { 8, 10, 12, 16 };
+
+	for (auto Bits : BitsPerKey)
+	{
+		auto BlockCount = BloomFilter::GetBlockCount(View.EntryCount, Bits);
+		std::vector<uint32_t> Blocks((size_t)BlockCount * BloomFilter::BlockWords, 0);
+
+		for (auto Hash : KeyHashes)
+			BloomFilter::Insert(Blocks.data(), BlockCount, Hash);
+
+		// A bloom filter may never reject a key it holds
+		uint32_t FalseNegatives = 0;
+		for (auto Hash : KeyHashes)
+		{
+			if (!BloomFilter::MayContain(Blocks.data(), BlockCount, Hash))
+				FalseNegatives++;
+		}
+
+		uint32_t MissingPositives = 0;
+		for (auto& Key : MissingKeys)
+		{
+			if (BloomFilter::MayContain(Blocks.data(), BlockCount, HashKey(View, Key)))
+				MissingPositives++;
+		}
+
+		uint32_t ProbePositives = 0;
+		ToolUtils::Stopwatch Timer;
+
+		for (auto Hash : ProbeHashes)
+		{
+			if (BloomFilter::MayContain(Blocks.data(), BlockCount, Hash))
+				ProbePositives++;
+		}
+
+		auto QueryNs = Timer.ElapsedNanoseconds() / (double)ProbeHashes.size();
+		FilterSink = ProbePositives;
+		Failures += FalseNegatives;
+
+		printf("%-9u %-10s %-10u %-13s %-15s %.2f ns (%.0f M/s)\n", Bits, (std::to_string(BlockCount * BloomFilter::BlockSize / 1024) + " KB").c_str(), FalseNegatives,
+			(std::to_string(MissingKeys.empty() ? 0.0 : (100.0 * MissingPositives) / MissingKeys.size()).substr(0, 5) + "%").c_str(),
+			(std::to_string((100.0 * ProbePositives) / ProbeHashes.size()).substr(0, 5) + "%").c_str(), QueryNs, 1000.0 / QueryNs);
+	}
+
+	// The database's own filter against the same lookups without one
+	TranslationDBView Unfiltered = View;
+	Unfiltered.FilterBlocks = nullptr;
+	Unfiltered.FilterBlockCount = 0;
+
+	uint32_t FilteredFound = 0, UnfilteredFound = 0;
+	auto FilteredNs = MeasureMisses(View, MissingKeys, FilteredFound);
+	auto UnfilteredNs = MeasureMisses(Unfiltered, MissingKeys, UnfilteredFound);
+
+	// Larger than the last level cache
+	std::vector<uint8_t> Thrash(32 * 1024 * 1024, 0);
+	auto ColdFilteredNs = MeasureColdMisses(View, MissingKeys, Thrash);
+	auto ColdUnfilteredNs = MeasureColdMisses(Unfiltered, MissingKeys, Thrash);
+
+	printf("\nfilter:         %u bits/key, %u KB\n", TRANSLATIONDB_FILTER_BITS_PER_KEY, View.FilterBlockCount * BloomFilter::BlockSize / 1024);
+	printf("miss (warm):    %.1f ns filtered, %.1f ns unfiltered\n", FilteredNs, UnfilteredNs);
+	printf("miss (cold):    %.1f ns filtered, %.1f ns unfiltered\n", ColdFilteredNs, ColdUnfilteredNs);
+	printf("false neg:      %u\n", Failures);
+
+	return (Failures == 0 && FilteredFound == 0 && UnfilteredFound == 0) ? 0 : 1;
+}
\ No newline at end of file
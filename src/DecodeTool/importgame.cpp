@@ -0,0 +1,525 @@
+// Platform includes
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <iconv.h>
+#endif
+
+// Standard includes
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Our includes
+#include "commands.h"
+#include "toolutils.h"
+#include "sourcefile.h"
+#include "bytescan.h"
+#include "gbk.h"
+#include "missingkeys.h"
+#include "unicode.h"
+
+// A key of the game's dump, the value is decoded into the dump's text
+struct DumpEntry
+{
+	std::string_view Key;
+	size_t ValueOffset;
+	size_t ValueLength;
+};
+
+// The game's localize dump decoded to utf8, KEY : value lines in GBK
+struct GameDump
+{
+	std::vector<uint8_t> Data;
+	std::string Text;
+	std::vector<DumpEntry> Entries;
+
+	uint32_t LineCount;
+	uint32_t ContinuationCount;
+	uint32_t RedefinedCount;
+	uint32_t SkippedCount;
+
+	// Gets the decoded value of an entry
+	std::string_view GetValue(const DumpEntry& Entry) const
+	{
+		return std::string_view(this->Text.data() + Entry.ValueOffset, Entry.ValueLength);
+	}
+};
+
+// A source file's pairs by key, the last definition of each
+typedef std::unordered_map<std::string_view, std::string_view> SourceMap;
+
+// Finds the " : " splitting a dump line, nullptr if there is none. GBK trail bytes are never ascii punctuation
+static const uint8_t* FindSeparator(const uint8_t* Line, const uint8_t* End)
+{
+	auto Cursor = Line + 1;
+
+	while (Cursor + 1 < End)
+	{
+		auto Colon = ByteScan::Find(Cursor, End - 1, ':');
+		if (Colon == nullptr)
+			return nullptr;
+
+		if (Colon[-1] == ' ' && Colon[1] == ' ')
+			return Colon - 1;
+
+		Cursor = Colon + 1;
+	}
+
+	return nullptr;
+}
+
+// Whether or not a dump key can be written as a source key, the same ascii names the missing key collector keeps
+static bool IsImportedKey(const uint8_t* Key, size_t Length)
+{
+	for (size_t i = 0; i < Length; i++)
+	{
+		if (Key[i] >= 0x80)
+			return false;
+	}
+
+	return MissingKeyCollector::IsWritableKey((const char*)Key, Length);
+}
+
+// Reads and decodes the game's dump. Lines without a separator continue the value above in game, the source
+// format is one line per value so only the first is kept, as en_source.txt was built
+static bool ReadGameDump(const std::string& Path, GameDump& Result)
+{
+	Result.Entries.clear();
+	Result.LineCount = 0;
+	Result.ContinuationCount = 0;
+	Result.RedefinedCount = 0;
+	Result.SkippedCount = 0;
+
+	if (!ToolUtils::ReadFile(Path, Result.Data))
+		return false;
+
+	// Decoded straight into the text, which is as large as it could ever need
+	Result.Text.assign(Gbk::GetUtf8Bound(Result.Data.size()), '\0');
+	size_t TextLength = 0;
+
+	std::unordered_map<std::string_view, uint32_t> Index;
+	Index.reserve(Result.Data.size() / 32);
+
+	const uint8_t* Cursor = Result.Data.data();
+	auto End = Cursor + Result.Data.size();
+
+	while (Cursor < End)
+	{
+		auto LineEnd = ByteScan::Find(Cursor, End, '\n');
+		if (LineEnd == nullptr)
+			LineEnd = End;
+
+		auto Next = (LineEnd < End) ? LineEnd + 1 : End;
+		if (LineEnd > Cursor && LineEnd[-1] == '\r')
+			LineEnd--;
+
+		Result.LineCount++;
+
+		auto Separator = FindSeparator(Cursor, LineEnd);
+		if (Separator == nullptr)
+		{
+			if (LineEnd > Cursor)
+				Result.ContinuationCount++;
+
+			Cursor = Next;
+			continue;
+		}
+
+		if (!IsImportedKey(Cursor, (size_t)(Separator - Cursor)))
+		{
+			Result.SkippedCount++;
+			Cursor = Next;
+			continue;
+		}
+
+		// Values have their trailing whitespace trimmed, as the source parser does
+		auto Value = &Result.Text[TextLength];
+		auto ValueLength = Gbk::ToUtf8((const char*)Separator + 3, (size_t)(LineEnd - Separator - 3), Value);
+		while (ValueLength > 0 && (Value[ValueLength - 1] == ' ' || Value[ValueLength - 1] == '\t'))
+			ValueLength--;
+
+		DumpEntry Entry;
+		Entry.Key = std::string_view((const char*)Cursor, (size_t)(Separator - Cursor));
+		Entry.ValueOffset = TextLength;
+		Entry.ValueLength = ValueLength;
+		TextLength += ValueLength;
+
+		// A key defined again replaces the earlier definition, and keeps its place
+		auto Existing = Index.emplace(Entry.Key, (uint32_t)Result.Entries.size());
+		if (Existing.second)
+		{
+			Result.Entries.push_back(Entry);
+		}
+		else
+		{
+			Result.Entries[Existing.first->second] = Entry;
+			Result.RedefinedCount++;
+		}
+
+		Cursor = Next;
+	}
+
+	Result.Text.resize(TextLength);
+	return true;
+}
+
+// Reads a source file into a map by key, the pairs reference the data
+static bool ReadSourceMap(const std::string& Path, std::vector<uint8_t>& Data, std::vector<TranslationPair>& Pairs, SourceMap& Result)
+{
+	SourceReport Report;
+	if (!ToolUtils::ReadFile(Path, Data) || !ParseSourceFile(Data.data(), Data.size(), Pairs, Report))
+		return false;
+
+	Result.reserve(Pairs.size());
+	for (auto& Pair : Pairs)
+		Result[std::string_view(Pair.Key, Pair.KeyLength)] = std::string_view(Pair.Value, Pair.ValueLength);
+
+	return true;
+}
+
+// Appends a KEY|value line
+static void AppendPair(std::string& Output, std::string_view Key, std::string_view Value)
+{
+	Output.append(Key.data(), Key.size());
+	Output.push_back('|');
+	Output.append(Value.data(), Value.size());
+	Output.push_back('\n');
+}
+
+// Appends a comment line
+static void AppendComment(std::string& Output, const char* Label, std::string_view Text)
+{
+	Output.append("// ");
+	Output.append(Label);
+	Output.append(Text.data(), Text.size());
+	Output.push_back('\n');
+}
+
+int ImportGameCommand(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		printf("usage: d3tool import-game <game_localize.txt> <en_source.txt> [--previous game_previous.txt] [--output game_import]\n");
+		return 1;
+	}
+
+	std::string DumpPath = argv[0];
+	std::string SourcePath = argv[1];
+	std::string PreviousPath;
+	std::string OutputPrefix = "game_import";
+
+	for (int i = 2; i + 1 < argc; i += 2)
+	{
+		if (std::strcmp(argv[i], "--previous") == 0)
+			PreviousPath = argv[i + 1];
+		else if (std::strcmp(argv[i], "--output") == 0)
+			OutputPrefix = argv[i + 1];
+	}
+
+	ToolUtils::Stopwatch Total;
+	ToolUtils::Stopwatch Timer;
+
+	GameDump Dump;
+	if (!ReadGameDump(DumpPath, Dump))
+	{
+		printf("Failed to read: %s\n", DumpPath.c_str());
+		return 1;
+	}
+
+	auto DumpTime = Timer.ElapsedMilliseconds();
+	printf("dump:     %u lines, %u keys (%u redefined, %u continuation lines, %u lines without a usable key), %.2f MB in %.2f ms (%.0f MB/s)\n", Dump.LineCount, (uint32_t)Dump.Entries.size(), Dump.RedefinedCount, Dump.ContinuationCount, Dump.SkippedCount, Dump.Data.size() / (1024.0 * 1024.0), DumpTime, (Dump.Data.size() / (1024.0 * 1024.0)) / (DumpTime / 1000.0));
+
+	Timer.Restart();
+
+	std::vector<uint8_t> SourceData;
+	std::vector<TranslationPair> SourcePairs;
+	SourceMap Source;
+
+	if (!ReadSourceMap(SourcePath, SourceData, SourcePairs, Source))
+	{
+		printf("Failed to read: %s\n", SourcePath.c_str());
+		return 1;
+	}
+
+	std::vector<uint8_t> PreviousData;
+	std::vector<TranslationPair> PreviousPairs;
+	SourceMap Previous;
+
+	if (!PreviousPath.empty() && !ReadSourceMap(PreviousPath, PreviousData, PreviousPairs, Previous))
+	{
+		printf("Failed to read: %s\n", PreviousPath.c_str());
+		return 1;
+	}
+
+	printf("source:   %u keys, %u in the previous dump, read in %.2f ms\n", (uint32_t)Source.size(), (uint32_t)Previous.size(), Timer.ElapsedMilliseconds());
+
+	Timer.Restart();
+
+	std::string NewOutput = "// Keys the game has that " + SourcePath + " doesn't, with the game's text\n";
+	std::string ChangedOutput = "// Keys whose game text changed since " + (PreviousPath.empty() ? std::string("the previous dump") : PreviousPath) + ", with the translation to review\n";
+	std::string MissingOutput = "// Keys " + SourcePath + " has that the game no longer does\n";
+	std::string CurrentOutput = "// The game's text for every key of " + DumpPath + ", pass it as --previous to the next import\n";
+
+	uint32_t NewCount = 0, ChangedCount = 0, MissingCount = 0;
+	std::unordered_map<std::string_view, uint32_t> DumpKeys;
+	DumpKeys.reserve(Dump.Entries.size());
+
+	for (uint32_t i = 0; i < (uint32_t)Dump.Entries.size(); i++)
+	{
+		auto& Entry = Dump.Entries[i];
+		auto Value = Dump.GetValue(Entry);
+
+		DumpKeys.emplace(Entry.Key, i);
+		AppendPair(CurrentOutput, Entry.Key, Value);
+
+		auto Translation = Source.find(Entry.Key);
+		if (Translation == Source.end())
+		{
+			AppendPair(NewOutput, Entry.Key, Value);
+			NewCount++;
+			continue;
+		}
+
+		// Only a key both dumps have can have changed
+		auto Before = Previous.find(Entry.Key);
+		if (Before == Previous.end() || Before->second == Value)
+			continue;
+
+		AppendComment(ChangedOutput, "game: ", Value);
+		AppendComment(ChangedOutput, "was:  ", Before->second);
+		AppendPair(ChangedOutput, Entry.Key, Translation->second);
+		ChangedCount++;
+	}
+
+	// In source order, each key once
+	for (auto& Pair : SourcePairs)
+	{
+		std::string_view Key(Pair.Key, Pair.KeyLength);
+		auto Translation = Source.find(Key);
+
+		if (Translation == Source.end() || DumpKeys.count(Key) != 0)
+			continue;
+
+		AppendPair(MissingOutput, Key, Translation->second);
+		Source.erase(Translation);
+		MissingCount++;
+	}
+
+	printf("join:     %u new, %u changed, %u missing in %.2f ms\n", NewCount, ChangedCount, MissingCount, Timer.ElapsedMilliseconds());
+
+	Timer.Restart();
+
+	const std::pair<std::string, const std::string*> Outputs[] =
+	{
+		{ OutputPrefix + "_new.txt", &NewOutput },
+		{ OutputPrefix + "_changed.txt", &ChangedOutput },
+		{ OutputPrefix + "_missing.txt", &MissingOutput },
+		{ OutputPrefix + "_current.txt", &CurrentOutput },
+	};
+
+	for (auto& Output : Outputs)
+	{
+		if (!ToolUtils::WriteFile(Output.first, Output.second->data(), Output.second->size()))
+		{
+			printf("Failed to write: %s\n", Output.first.c_str());
+			return 1;
+		}
+	}
+
+	printf("written:  %s_{new,changed,missing,current}.txt in %.2f ms\n", OutputPrefix.c_str(), Timer.ElapsedMilliseconds());
+	printf("total:    %.2f ms\n", Total.ElapsedMilliseconds());
+
+	return 0;
+}
+
+// The platform's own decoder, what the tools used before
+class ReferenceDecoder
+{
+private:
+#ifndef _WIN32
+	iconv_t Converter;
+#endif
+
+public:
+#ifdef _WIN32
+	ReferenceDecoder() { }
+	~ReferenceDecoder() { }
+
+	// Gets the decoder's name
+	const char* GetName() const { return "MultiByteToWideChar"; }
+
+	// Decodes GBK to utf8, invalid bytes as windows replaces them
+	void Decode(const char* Data, size_t Length, std::string& Result)
+	{
+		Result.clear();
+		if (Length == 0)
+			return;
+
+		std::vector<wchar_t> Wide(Length);
+		auto WideLength = MultiByteToWideChar(936, 0, Data, (int)Length, Wide.data(), (int)Wide.size());
+
+		Result.resize((size_t)WideLength * 3);
+		Result.resize(Unicode::Utf16ToUtf8((const uint16_t*)Wide.data(), (size_t)WideLength, &Result[0], Result.size()));
+	}
+#else
+	ReferenceDecoder() : Converter(iconv_open("UTF-8", "CP936")) { }
+	~ReferenceDecoder()
+	{
+		if (this->Converter != (iconv_t)-1)
+			iconv_close(this->Converter);
+	}
+
+	// Gets the decoder's name
+	const char* GetName() const { return "iconv"; }
+
+	// Decodes GBK to utf8, invalid bytes are replaced one at a time with ?
+	void Decode(const char* Data, size_t Length, std::string& Result)
+	{
+		Result.resize(Gbk::GetUtf8Bound(Length));
+
+		auto Input = (char*)Data;
+		auto InputLeft = Length;
+		auto Output = &Result[0];
+		auto OutputLeft = Result.size();
+
+		iconv(this->Converter, nullptr, nullptr, nullptr, nullptr);
+
+		while (InputLeft > 0)
+		{
+			if (iconv(this->Converter, &Input, &InputLeft, &Output, &OutputLeft) == (size_t)-1 && InputLeft > 0)
+			{
+				*Output++ = '?';
+				OutputLeft--;
+				Input++;
+				InputLeft--;
+			}
+		}
+
+		Result.resize((size_t)(Output - &Result[0]));
+	}
+#endif
+};
+
+// Decodes the set once per round, returns the input megabytes per second
+template<typename Decode>
+static double MeasureDecode(size_t Bytes, uint32_t Rounds, Decode&& Function)
+{
+	ToolUtils::Stopwatch Timer;
+	for (uint32_t Round = 0; Round < Rounds; Round++)
+		Function();
+
+	return ((double)Bytes * Rounds / (1024.0 * 1024.0)) / (Timer.ElapsedMilliseconds() / 1000.0);
+}
+
+int BenchGbkCommand(int argc, char** argv)
+{
+	std::string LocalizePath = "game_localize.txt";
+	uint32_t Rounds = 20;
+
+	for (int i = 0; i + 1 < argc; i += 2)
+	{
+		if (std::strcmp(argv[i], "--localize") == 0)
+			LocalizePath = argv[i + 1];
+		else if (std::strcmp(argv[i], "--rounds") == 0)
+			Rounds = (uint32_t)std::max(1, std::atoi(argv[i + 1]));
+	}
+
+	std::vector<uint8_t> Data;
+	if (!ToolUtils::ReadFile(LocalizePath, Data) || Data.empty())
+	{
+		printf("Failed to read: %s\n", LocalizePath.c_str());
+		return 1;
+	}
+
+	auto Pairs = ToolUtils::ReadLocalizePairs(LocalizePath);
+	size_t ValueBytes = 0, Ascii = 0;
+	for (auto& Pair : Pairs)
+		ValueBytes += Pair.second.size();
+	for (auto Byte : Data)
+		Ascii += (Byte < 0x80) ? 1 : 0;
+
+	ReferenceDecoder Reference;
+	std::string Expected, Decoded;
+
+	// Every single byte and every pair, a pair that isn't mapped decodes its trail byte on its own
+	uint32_t Checked = 0, Mismatched = 0;
+	for (uint32_t Lead = 0x80; Lead <= 0xFF; Lead++)
+	{
+		for (uint32_t Trail = 0x3F; Trail <= 0xFF; Trail++)
+		{
+			char Bytes[2] = { (char)Lead, (char)Trail };
+			auto Length = (Trail == 0x3F) ? (size_t)1 : (size_t)2;
+
+			Reference.Decode(Bytes, Length, Expected);
+			Decoded = Gbk::ToUtf8(std::string(Bytes, Length));
+
+			// Windows maps the user defined areas to private use (U+E000-U+F8FF), the table leaves them unmapped
+			auto First = (uint8_t)Expected[0];
+			if (First == 0xEE || (First == 0xEF && (uint8_t)Expected[1] <= 0xA3))
+				continue;
+
+			Checked++;
+			if (Decoded != Expected)
+			{
+				if (Mismatched < 8)
+					printf("mismatch: %02X %02X decoded as %s, %s has %s\n", Lead, Trail, Decoded.c_str(), Reference.GetName(), Expected.c_str());
+				Mismatched++;
+			}
+		}
+	}
+
+	printf("table:    %u sequences, %u differ from %s\n", Checked, Mismatched, Reference.GetName());
+
+	uint32_t ValueMismatches = 0;
+	for (auto& Pair : Pairs)
+	{
+		Reference.Decode(Pair.second.data(), Pair.second.size(), Expected);
+		ValueMismatches += (Gbk::ToUtf8(Pair.second) != Expected) ? 1 : 0;
+	}
+
+	Reference.Decode((const char*)Data.data(), Data.size(), Expected);
+	Decoded = Gbk::ToUtf8(std::string((const char*)Data.data(), Data.size()));
+
+	printf("values:   %u values, %u differ from %s, the whole file %s\n", (uint32_t)Pairs.size(), ValueMismatches, Reference.GetName(), (Decoded == Expected) ? "matches" : "differs");
+	printf("%s: %.2f MB (%.0f%% ascii), %.2f MB in values\n", LocalizePath.c_str(), Data.size() / (1024.0 * 1024.0), 100.0 * Ascii / (double)Data.size(), ValueBytes / (1024.0 * 1024.0));
+	printf("%-20s %14s %14s\n", "", "each value", "whole file");
+
+	std::vector<char> Buffer(Gbk::GetUtf8Bound(Data.size()));
+
+	auto ReferenceEach = MeasureDecode(ValueBytes, Rounds, [&]()
+	{
+		for (auto& Pair : Pairs)
+			Reference.Decode(Pair.second.data(), Pair.second.size(), Expected);
+	});
+	auto ReferenceBulk = MeasureDecode(Data.size(), Rounds, [&]() { Reference.Decode((const char*)Data.data(), Data.size(), Expected); });
+
+	printf("%-20s %10.0f MB/s %10.0f MB/s\n", Reference.GetName(), ReferenceEach, ReferenceBulk);
+
+	auto TableEach = MeasureDecode(ValueBytes, Rounds, [&]()
+	{
+		for (auto& Pair : Pairs)
+			Gbk::ToUtf8(Pair.second.data(), Pair.second.size(), Buffer.data());
+	});
+	auto TableBulk = MeasureDecode(Data.size(), Rounds, [&]() { Gbk::ToUtf8((const char*)Data.data(), Data.size(), Buffer.data()); });
+
+	printf("%-20s %10.0f MB/s %10.0f MB/s\n", "table", TableEach, TableBulk);
+
+	// The whole import without writing anything, dump to decoded keys
+	GameDump Dump;
+	ToolUtils::Stopwatch Timer;
+	for (uint32_t Round = 0; Round < Rounds; Round++)
+		ReadGameDump(LocalizePath, Dump);
+
+	printf("dump:     %u keys read and decoded in %.2f ms\n", (uint32_t)Dump.Entries.size(), Timer.ElapsedMilliseconds() / Rounds);
+
+	auto Valid = (Mismatched == 0 && ValueMismatches == 0 && Decoded == Expected);
+	printf("result:   %s\n", Valid ? "the table decodes as the platform does" : "FAILED");
+
+	return Valid ? 0 : 1;
+}
\ No newline at end of file
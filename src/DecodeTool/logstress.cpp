@@ -0,0 +1,297 @@
+// Standard includes
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Our includes
+#include "commands.h"
+#include "toolutils.h"
+#include "asynclog.h"
+
+// Sub buckets per power of two of the latency histogram, percentiles are within about 6%
+static const uint32_t SubBuckets = 16;
+static const uint32_t HistogramBuckets = 64 * SubBuckets;
+
+// Producer call latencies, log bucketed so every call can be counted
+struct LatencyHistogram
+{
+	std::vector<uint64_t> Counts;
+	uint64_t Total;
+	uint64_t Maximum;
+
+	LatencyHistogram() : Counts(HistogramBuckets, 0), Total(0), Maximum(0) { }
+
+	// Gets the bucket of a latency, exact below the sub bucket count
+	static uint32_t GetBucket(uint64_t Nanoseconds)
+	{
+		if (Nanoseconds < SubBuckets)
+			return (uint32_t)Nanoseconds;
+
+		uint32_t Exponent = 0;
+		while ((Nanoseconds >> Exponent) >= (SubBuckets * 2))
+			Exponent++;
+
+		return (Exponent + 1) * SubBuckets + (uint32_t)((Nanoseconds >> Exponent) - SubBuckets);
+	}
+
+	// Gets the smallest latency of a bucket
+	static uint64_t GetBucketValue(uint32_t Bucket)
+	{
+		if (Bucket < SubBuckets)
+			return Bucket;
+
+		auto Exponent = Bucket / SubBuckets - 1;
+		return (uint64_t)(SubBuckets + Bucket % SubBuckets) << Exponent;
+	}
+
+	void Add(uint64_t Nanoseconds)
+	{
+		this->Counts[std::min(GetBucket(Nanoseconds), HistogramBuckets - 1)]++;
+		this->Total++;
+		this->Maximum = std::max(this->Maximum, Nanoseconds);
+	}
+
+	void Merge(const LatencyHistogram& Other)
+	{
+		for (uint32_t i = 0; i < HistogramBuckets; i++)
+			this->Counts[i] += Other.Counts[i];
+
+		this->Total += Other.Total;
+		this->Maximum = std::max(this->Maximum, Other.Maximum);
+	}
+
+	uint64_t GetPercentile(double Percentile) const
+	{
+		auto Target = (uint64_t)((Percentile / 100.0) * (double)this->Total);
+		uint64_t Seen = 0;
+
+		for (uint32_t i = 0; i < HistogramBuckets; i++)
+		{
+			Seen += this->Counts[i];
+			if (Seen > Target)
+				return GetBucketValue(i);
+		}
+
+		return this->Maximum;
+	}
+};
+
+// What a producer thread did
+struct ProducerResult
+{
+	LatencyHistogram Latency;
+	uint64_t Logged;
+	uint64_t Dropped;
+};
+
+// Runs every producer until the deadline, each logs hook shaped lines numbered per thread
+template<typename LogFunction>
+static std::vector<ProducerResult> RunProducers(uint32_t Threads, uint32_t Seconds, uint32_t Rate, LogFunction Log)
+{
+	std::vector<ProducerResult> Results(Threads);
+	std::vector<std::thread> Workers;
+	std::atomic<bool> Go(false);
+
+	for (uint32_t t = 0; t < Threads; t++)
+	{
+		Workers.push_back(std::thread([&, t]()
+		{
+			auto& Result = Results[t];
+			Result.Logged = 0;
+			Result.Dropped = 0;
+
+			while (!Go.load(std::memory_order_acquire))
+				std::this_thread::yield();
+
+			auto Start = std::chrono::steady_clock::now();
+			auto Deadline = Start + std::chrono::seconds(Seconds);
+			uint32_t Sequence = 0;
+
+			while (true)
+			{
+				// Paced producers log at a fixed rate, the others as fast as they can
+				if (Rate > 0)
+					std::this_thread::sleep_until(Start + std::chrono::nanoseconds((1000000000ull * Sequence) / Rate));
+
+				auto CallStart = std::chrono::steady_clock::now();
+				if (CallStart >= Deadline)
+					break;
+
+				auto Logged = Log(t, Sequence);
+				auto CallEnd = std::chrono::steady_clock::now();
+
+				Result.Latency.Add((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(CallEnd - CallStart).count());
+
+				if (Logged)
+					Result.Logged++;
+				else
+					Result.Dropped++;
+
+				Sequence++;
+			}
+		}));
+	}
+
+	Go.store(true, std::memory_order_release);
+
+	for (auto& Worker : Workers)
+		Worker.join();
+
+	return Results;
+}
+
+// Prints the merged latency of every producer
+static void PrintResults(const char* Name, const std::vector<ProducerResult>& Results, uint32_t Seconds)
+{
+	LatencyHistogram Latency;
+	uint64_t Logged = 0, Dropped = 0;
+
+	for (auto& Result : Results)
+	{
+		Latency.Merge(Result.Latency);
+		Logged += Result.Logged;
+		Dropped += Result.Dropped;
+	}
+
+	printf("%-9s %llu lines logged (%.2f M/s), %llu dropped\n", Name, (unsigned long long)Logged, (double)Logged / Seconds / 1000000.0, (unsigned long long)Dropped);
+	printf("%-9s p50 %llu ns, p99 %llu ns, p99.9 %llu ns, p99.99 %llu ns, max %.1f us per call (clock reads included)\n", "", (unsigned long long)Latency.GetPercentile(50.0), (unsigned long long)Latency.GetPercentile(99.0),
+		(unsigned long long)Latency.GetPercentile(99.9), (unsigned long long)Latency.GetPercentile(99.99), (double)Latency.Maximum / 1000.0);
+}
+
+// Checks every logged line made it to the file, in the order each thread logged it
+static bool VerifyLog(const std::string& Path, const std::vector<ProducerResult>& Results, uint64_t Dropped)
+{
+	std::vector<uint8_t> Data;
+	if (!ToolUtils::ReadFile(Path, Data))
+		return false;
+
+	std::vector<int64_t> LastSequence(Results.size(), -1);
+	std::vector<uint64_t> Lines(Results.size(), 0);
+	uint64_t ReportedDropped = 0;
+	bool Valid = true;
+
+	size_t Position = 0;
+	while (Position < Data.size())
+	{
+		auto End = Position;
+		while (End < Data.size() && Data[End] != '\n')
+			End++;
+
+		std::string Line((const char*)Data.data() + Position, End - Position);
+		Position = End + 1;
+
+		unsigned long long Count = 0;
+		uint32_t Thread = 0, Sequence = 0;
+
+		if (sscanf(Line.c_str(), "Logger: dropped %llu lines", &Count) == 1)
+		{
+			ReportedDropped += Count;
+		}
+		else if (sscanf(Line.c_str(), "STRESS_THREAD_%u_KEY_%u :", &Thread, &Sequence) == 2 && Thread < Results.size())
+		{
+			// Sequences skip dropped lines but never go back
+			if ((int64_t)Sequence <= LastSequence[Thread])
+				Valid = false;
+
+			LastSequence[Thread] = Sequence;
+			Lines[Thread]++;
+		}
+		else
+		{
+			printf("verify:   unexpected line: %s\n", Line.c_str());
+			Valid = false;
+		}
+	}
+
+	uint64_t Expected = 0, Found = 0;
+	for (size_t t = 0; t < Results.size(); t++)
+	{
+		Expected += Results[t].Logged;
+		Found += Lines[t];
+
+		if (Lines[t] != Results[t].Logged)
+			Valid = false;
+	}
+
+	printf("verify:   %llu of %llu lines in the file, %llu of %llu drops reported, per thread order %s\n", (unsigned long long)Found, (unsigned long long)Expected, (unsigned long long)ReportedDropped, (unsigned long long)Dropped, Valid ? "kept" : "BROKEN");
+
+	return Valid && ReportedDropped == Dropped;
+}
+
+int LogStressCommand(int argc, char** argv)
+{
+	uint32_t Threads = 8;
+	uint32_t Seconds = 2;
+	uint32_t Capacity = 16384;
+	uint32_t Rate = 0;
+	bool Baseline = false, KeepOutput = false;
+	std::string OutputPath = "logstress.txt";
+
+	for (int i = 0; i < argc; i++)
+	{
+		if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+			Threads = (uint32_t)std::max(1, std::atoi(argv[++i]));
+		else if (std::strcmp(argv[i], "--seconds") == 0 && i + 1 < argc)
+			Seconds = (uint32_t)std::max(1, std::atoi(argv[++i]));
+		else if (std::strcmp(argv[i], "--capacity") == 0 && i + 1 < argc)
+			Capacity = (uint32_t)std::max(2, std::atoi(argv[++i]));
+		else if (std::strcmp(argv[i], "--rate") == 0 && i + 1 < argc)
+			Rate = (uint32_t)std::max(0, std::atoi(argv[++i]));
+		else if (std::strcmp(argv[i], "--output") == 0 && i + 1 < argc)
+		{
+			OutputPath = argv[++i];
+			KeepOutput = true;
+		}
+		else if (std::strcmp(argv[i], "--baseline") == 0)
+			Baseline = true;
+	}
+
+	printf("producers: %u threads for %u s, %s, ring of %u lines, %u hardware threads\n", Threads, Seconds, (Rate > 0) ? (std::to_string(Rate) + " lines/s each").c_str() : "unpaced", Capacity, std::thread::hardware_concurrency());
+
+	AsyncLogger Logger;
+	if (!Logger.Start(OutputPath, Capacity, 50, false))
+	{
+		printf("Failed to open: %s\n", OutputPath.c_str());
+		return 1;
+	}
+
+	auto Results = RunProducers(Threads, Seconds, Rate, [&](uint32_t Thread, uint32_t Sequence)
+	{
+		return Logger.Log("STRESS_THREAD_%u_KEY_%u : Translated value number %u\n", Thread, Sequence, Sequence);
+	});
+
+	Logger.Stop(true);
+	PrintResults("async:", Results, Seconds);
+
+	auto Verified = VerifyLog(OutputPath, Results, Logger.GetDroppedCount());
+
+	// The original logger, fprintf on the game thread, with the stream's own lock
+	if (Baseline)
+	{
+		auto File = fopen(OutputPath.c_str(), "w");
+		if (File == nullptr)
+			return 1;
+
+		auto BaselineResults = RunProducers(Threads, Seconds, Rate, [&](uint32_t Thread, uint32_t Sequence)
+		{
+			return fprintf(File, "STRESS_THREAD_%u_KEY_%u : Translated value number %u\n", Thread, Sequence, Sequence) > 0;
+		});
+
+		fclose(File);
+		PrintResults("fprintf:", BaselineResults, Seconds);
+	}
+
+	// The async log is kept when asked for, the baseline run overwrites it
+	if (!KeepOutput || Baseline)
+		std::remove(OutputPath.c_str());
+
+	return Verified ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,71 @@
+/*
+	D3code database tool
+	Notes:
+		Portable command line tool for building and benchmarking translation databases.
+		Windows: build DecodeTool.vcxproj
+		Linux: g++ -O2 -std=c++17 -I../ProjectDecode *.cpp ../ProjectDecode/asynclog.cpp ../ProjectDecode/backgroundwriter.cpp ../ProjectDecode/bytescan.cpp ../ProjectDecode/cpufeatures.cpp ../ProjectDecode/gbk.cpp ../ProjectDecode/gbktable.cpp ../ProjectDecode/hookmetrics.cpp ../ProjectDecode/keytrace.cpp ../ProjectDecode/mappedfile.cpp ../ProjectDecode/missingkeys.cpp ../ProjectDecode/patternscan.cpp ../ProjectDecode/placeholders.cpp ../ProjectDecode/sharedmemory.cpp ../ProjectDecode/sitecache.cpp ../ProjectDecode/stringcache.cpp ../ProjectDecode/symboltable.cpp ../ProjectDecode/translationdb.cpp ../ProjectDecode/translationdelta.cpp ../ProjectDecode/translationstack.cpp ../ProjectDecode/translate.cpp ../ProjectDecode/translationstore.cpp ../ProjectDecode/unicode.cpp ../ProjectDecode/valuecache.cpp -o d3tool -lpthread
+*/
+
+// Standard includes
+#include <cstdio>
+#include <cstring>
+
+// Our includes
+#include "commands.h"
+
+struct ToolCommand
+{
+	const char* Name;
+	const char* Usage;
+	int(*Handler)(int argc, char** argv);
+};
+
+static const ToolCommand Commands[] =
+{
+	{ "compile", "compile <source.txt> [output.db] [--threads N] [--compress] [--legacy] [--strict] [--incremental] [--delta output.delta]", CompileCommand },
+	{ "delta", "delta <base.db> <source.txt> [output.delta] [--threads N]", DeltaCommand },
+	{ "patch", "patch <base.db> <input.delta> <output.db> [--threads N]", PatchCommand },
+	{ "verify-delta", "verify-delta <base.db> <input.delta> <source.txt> [--threads N]", VerifyDeltaCommand },
+	{ "convert", "convert <input.db> <output.db> [--threads N] [--compress]", ConvertCommand },
+	{ "bench", "bench <database.db> [--engine map|db] [--source en_source.txt] [--missing en_missing.txt]", BenchCommand },
+	{ "bench-suite", "bench-suite <database.db> [--source en_source.txt] [--missing en_missing.txt] [--localize game_localize.txt] [--engines map,db,store] [--threads 1,2,4,8] [--output bench.json]", BenchSuiteCommand },
+	{ "bench-scaleform", "bench-scaleform <database.db> [--source en_source.txt] [--missing en_missing.txt]", BenchScaleformCommand },
+	{ "bench-cache", "bench-cache <database.db> [--source en_source.txt] [--missing en_missing.txt] [--literals 400] [--frames 2000] [--threads 4]", BenchCacheCommand },
+	{ "bench-hash", "bench-hash <database.db> [--source en_source.txt] [--missing en_missing.txt]", BenchHashCommand },
+	{ "bench-compress", "bench-compress <database.db> [--source en_source.txt]", BenchCompressCommand },
+	{ "bench-overlay", "bench-overlay <database.db> [--overlays 2] [--keys 500] [--missing en_missing.txt]", BenchOverlayCommand },
+	{ "bench-template", "bench-template <database.db> [--reference en_missing.txt]", BenchTemplateCommand },
+	{ "filter", "filter <database.db> [--missing en_missing.txt] [--probes 1000000]", FilterCommand },
+	{ "watch", "watch <database.db> [--readers 4] [--seconds 0] [--source en_source.txt]", WatchCommand },
+	{ "replay", "replay <trace.d3trace> <database.db> [--timing original|fast] [--speed 1.0] [--strict]", ReplayCommand },
+	{ "trace-generate", "trace-generate <database.db> <output.d3trace> [--localize game_localize.txt] [--seconds 10] [--seed 1]", TraceGenerateCommand },
+	{ "log-stress", "log-stress [--threads 8] [--seconds 2] [--capacity 16384] [--rate 0] [--output logstress.txt] [--baseline]", LogStressCommand },
+	{ "metrics", "metrics [--name D3codeMetrics] [--interval 1000] [--samples 0]", MetricsCommand },
+	{ "metrics-harness", "metrics-harness <database.db> [--source en_source.txt] [--missing en_missing.txt] [--threads 4] [--rounds 20] [--name D3codeMetricsHarness]", MetricsHarnessCommand },
+	{ "missing-collect", "missing-collect <database.db> [--localize game_localize.txt] [--missing en_missing.txt] [--threads 4] [--rounds 20] [--output missing.txt]", MissingCollectCommand },
+	{ "bench-unicode", "bench-unicode [--source en_source.txt] [--localize game_localize.txt] [--rounds 20]", BenchUnicodeCommand },
+	{ "fuzz-unicode", "fuzz-unicode [--source en_source.txt] [--iterations 200000] [--seed 1]", FuzzUnicodeCommand },
+	{ "import-game", "import-game <game_localize.txt> <en_source.txt> [--previous game_previous.txt] [--output game_import]", ImportGameCommand },
+	{ "bench-gbk", "bench-gbk [--localize game_localize.txt] [--rounds 20]", BenchGbkCommand },
+	{ "bench-pattern", "bench-pattern [--size 30] [--rounds 5] [--seed 1] [--threads N] [--image code.bin]", BenchPatternCommand },
+	{ "check-pattern", "check-pattern [--iterations 20000] [--seed 1]", CheckPatternCommand },
+};
+
+int main(int argc, char** argv)
+{
+	if (argc >= 2)
+	{
+		for (auto& Command : Commands)
+		{
+			if (std::strcmp(argv[1], Command.Name) == 0)
+				return Command.Handler(argc - 2, argv + 2);
+		}
+	}
+
+	// Unknown command, print usage
+	printf("usage: d3tool <command> [args]\n\n");
+	for (auto& Command : Commands)
+		printf("  %s\n", Command.Usage);
+
+	return 1;
+}
\ No newline at end of file
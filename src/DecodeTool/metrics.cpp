@@ -0,0 +1,332 @@
+// Standard includes
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Our includes
+#include "commands.h"
+#include "toolutils.h"
+#include "hookmetrics.h"
+#include "sharedmemory.h"
+#include "hashing.h"
+#include "translate.h"
+#include "translationstack.h"
+#include "translationstore.h"
+#include "stringcache.h"
+
+// Gets the calls of a path between two snapshots, counters wrap at 32 bits
+static uint32_t GetCalls(const HookMetricsSnapshot& Current, const HookMetricsSnapshot* Previous, uint32_t Path)
+{
+	return Current.Calls[Path] - ((Previous != nullptr) ? Previous->Calls[Path] : 0);
+}
+
+// Gets the upper bound in nanoseconds of the bucket holding a percentile of a path's calls between two snapshots
+static double GetPercentile(const HookMetricsSnapshot& Current, const HookMetricsSnapshot* Previous, uint32_t Path, double Percentile)
+{
+	uint64_t Total = 0;
+	uint32_t Counts[HOOKMETRICS_BUCKETS];
+
+	for (uint32_t b = 0; b < HOOKMETRICS_BUCKETS; b++)
+	{
+		Counts[b] = Current.Buckets[Path][b] - ((Previous != nullptr) ? Previous->Buckets[Path][b] : 0);
+		Total += Counts[b];
+	}
+
+	if (Total == 0 || Current.CyclesPerSecond == 0)
+		return 0.0;
+
+	auto Target = (uint64_t)((Percentile / 100.0) * (double)Total);
+	uint64_t Seen = 0;
+	uint32_t Bucket = 0;
+
+	for (; Bucket < HOOKMETRICS_BUCKETS; Bucket++)
+	{
+		Seen += Counts[Bucket];
+		if (Seen > Target)
+			break;
+	}
+
+	auto Cycles = (double)(1ull << std::min<uint32_t>(Bucket, HOOKMETRICS_BUCKETS - 1));
+	return (Cycles * 1000000000.0) / (double)Current.CyclesPerSecond;
+}
+
+// Prints the calls, rates and latency of every path, since the previous snapshot when there is one
+static void PrintSnapshot(const HookMetricsSnapshot& Current, const HookMetricsSnapshot* Previous, double Seconds)
+{
+	printf("process %u, %u threads, %.2f GHz cycle counter, %s\n", Current.ProcessId, Current.ThreadCount, (double)Current.CyclesPerSecond / 1000000000.0, Current.Enabled ? "counting" : "stopped");
+	printf("  %-30s %12s %12s %8s %10s %10s %10s\n", "path", "calls", "calls/s", "share", "p50", "p99", "p99.9");
+
+	uint32_t Totals[2] = { 0, 0 };
+	for (uint32_t p = 0; p < HOOKMETRIC_PATH_COUNT; p++)
+		Totals[(p < HOOKMETRIC_SCALEFORM_TRANSLATED) ? 0 : 1] += GetCalls(Current, Previous, p);
+
+	for (uint32_t p = 0; p < HOOKMETRIC_PATH_COUNT; p++)
+	{
+		auto Calls = GetCalls(Current, Previous, p);
+		auto Total = Totals[(p < HOOKMETRIC_SCALEFORM_TRANSLATED) ? 0 : 1];
+
+		// Rates only make sense over a known interval
+		char Rate[32] = "-";
+		if (Seconds > 0.0)
+			snprintf(Rate, sizeof(Rate), "%.0f", (double)Calls / Seconds);
+
+		printf("  %-30s %12u %12s %7.2f%% %7.0f ns %7.0f ns %7.0f ns\n", HookMetrics::GetPathName((HookMetricPath)p), Calls, Rate, (Total > 0) ? (100.0 * Calls) / Total : 0.0,
+			GetPercentile(Current, Previous, p, 50.0), GetPercentile(Current, Previous, p, 99.0), GetPercentile(Current, Previous, p, 99.9));
+	}
+}
+
+int MetricsCommand(int argc, char** argv)
+{
+	std::string Name = HOOKMETRICS_DEFAULT_NAME;
+	uint32_t Interval = 1000;
+	uint32_t Samples = 0;
+
+	for (int i = 0; i + 1 < argc; i += 2)
+	{
+		if (std::strcmp(argv[i], "--name") == 0)
+			Name = argv[i + 1];
+		else if (std::strcmp(argv[i], "--interval") == 0)
+			Interval = (uint32_t)std::max(10, std::atoi(argv[i + 1]));
+		else if (std::strcmp(argv[i], "--samples") == 0)
+			Samples = (uint32_t)std::max(0, std::atoi(argv[i + 1]));
+	}
+
+	SharedMemory Block;
+	if (!Block.Open(Name))
+	{
+		printf("No metrics block named %s, is the game running with Metrics=1?\n", Name.c_str());
+		return 1;
+	}
+
+	HookMetricsSnapshot Previous;
+	if (!HookMetrics::Aggregate(Block.GetData(), Block.GetSize(), Previous))
+	{
+		printf("Not a metrics block: %s\n", Name.c_str());
+		return 1;
+	}
+
+	printf("since start:\n");
+	PrintSnapshot(Previous, nullptr, 0.0);
+
+	// Every sample shows what happened since the one before it
+	for (uint32_t Sample = 0; Samples == 0 || Sample < Samples; Sample++)
+	{
+		ToolUtils::Stopwatch Timer;
+		std::this_thread::sleep_for(std::chrono::milliseconds(Interval));
+
+		HookMetricsSnapshot Current;
+		HookMetrics::Aggregate(Block.GetData(), Block.GetSize(), Current);
+
+		printf("\nlast %.2f s:\n", Timer.ElapsedMilliseconds() / 1000.0);
+		PrintSnapshot(Current, &Previous, Timer.ElapsedMilliseconds() / 1000.0);
+		fflush(stdout);
+
+		Previous = Current;
+	}
+
+	return 0;
+}
+
+int MetricsHarnessCommand(int argc, char** argv)
+{
+	if (argc < 1)
+	{
+		printf("usage: d3tool metrics-harness <database.db> [--source en_source.txt] [--missing en_missing.txt] [--threads 4] [--rounds 20] [--name D3codeMetricsHarness]\n");
+		return 1;
+	}
+
+	std::string DatabasePath = argv[0];
+	std::string SourcePath = "en/en_source.txt";
+	std::string MissingPath = "en/en_missing.txt";
+	std::string Name = "D3codeMetricsHarness";
+	uint32_t Threads = 4;
+	uint32_t Rounds = 20;
+
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (std::strcmp(argv[i], "--source") == 0)
+			SourcePath = argv[i + 1];
+		else if (std::strcmp(argv[i], "--missing") == 0)
+			MissingPath = argv[i + 1];
+		else if (std::strcmp(argv[i], "--threads") == 0)
+			Threads = (uint32_t)std::max(1, std::atoi(argv[i + 1]));
+		else if (std::strcmp(argv[i], "--rounds") == 0)
+			Rounds = (uint32_t)std::max(1, std::atoi(argv[i + 1]));
+		else if (std::strcmp(argv[i], "--name") == 0)
+			Name = argv[i + 1];
+	}
+
+	std::unique_ptr<TranslationStack> Stack(new TranslationStack());
+	if (!Stack->Load(DatabasePath))
+	{
+		printf("Failed to load: %s\n", DatabasePath.c_str());
+		return 1;
+	}
+
+	TranslationStore Store;
+	StringReferenceCache Cache;
+	Store.Publish(std::move(Stack));
+
+	// Hits and misses in the proportions the hooks see them
+	auto Keys = ToolUtils::ReadSourceKeys(SourcePath);
+	auto MissingKeys = ToolUtils::ReadMissingKeys(MissingPath);
+	Keys.insert(Keys.end(), MissingKeys.begin(), MissingKeys.end());
+
+	if (Keys.empty())
+	{
+		printf("No keys in: %s\n", SourcePath.c_str());
+		return 1;
+	}
+
+	std::vector<std::vector<uint16_t>> WideKeys;
+	for (size_t i = 0; i < Keys.size(); i += 4)
+	{
+		WideKeys.push_back(std::vector<uint16_t>(Keys[i].begin(), Keys[i].end()));
+		WideKeys.back().push_back(0);
+	}
+
+	// The game side, as the DLL does it
+	HookMetrics Metrics;
+	if (!Metrics.Start(Name, std::max<uint32_t>(Threads, 2)))
+	{
+		printf("Failed to create the shared block: %s\n", Name.c_str());
+		return 1;
+	}
+
+	// The reader side, a separate read-only mapping of the same block, like d3tool metrics in another process
+	SharedMemory Reader;
+	if (!Reader.Open(Name))
+	{
+		printf("Failed to open the shared block: %s\n", Name.c_str());
+		return 1;
+	}
+
+	std::vector<std::vector<uint64_t>> Expected(Threads, std::vector<uint64_t>(HOOKMETRIC_PATH_COUNT, 0));
+	std::atomic<uint32_t> Running(Threads);
+	std::atomic<bool> ReaderValid(true);
+	std::atomic<uint32_t> ReaderSamples(0);
+
+	// Samples while the hooks run, totals may only ever grow
+	std::thread Sampler([&]()
+	{
+		HookMetricsSnapshot Previous;
+		HookMetrics::Aggregate(Reader.GetData(), Reader.GetSize(), Previous);
+
+		while (Running.load() > 0)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+			HookMetricsSnapshot Current;
+			if (!HookMetrics::Aggregate(Reader.GetData(), Reader.GetSize(), Current))
+				ReaderValid.store(false);
+
+			for (uint32_t p = 0; p < HOOKMETRIC_PATH_COUNT; p++)
+			{
+				if (Current.Calls[p] < Previous.Calls[p])
+					ReaderValid.store(false);
+			}
+
+			Previous = Current;
+			ReaderSamples.fetch_add(1);
+		}
+	});
+
+	ToolUtils::Stopwatch Timer;
+	std::vector<std::thread> Workers;
+
+	for (uint32_t t = 0; t < Threads; t++)
+	{
+		Workers.push_back(std::thread([&, t]()
+		{
+			auto& Counts = Expected[t];
+
+			for (uint32_t Round = 0; Round < Rounds; Round++)
+			{
+				for (size_t i = 0; i < Keys.size(); i++)
+				{
+					auto Started = Metrics.Begin();
+					auto Path = HOOKMETRIC_STRINGED_TRANSLATED;
+
+					// Misses fall through to one of the engine's paths, the same one every time for a key
+					if (TranslateStringReference(Cache, Store, Keys[i].c_str()) == nullptr)
+					{
+						auto Fallback = Hashing::WordMix::Hash(Keys[i].data(), Keys[i].size()) % 3;
+						Path = (Fallback == 0) ? HOOKMETRIC_STRINGED_ENGINE : ((Fallback == 1) ? HOOKMETRIC_STRINGED_ASSET : HOOKMETRIC_STRINGED_UNRESOLVED);
+					}
+
+					Metrics.End(Path, Started);
+					Counts[Path]++;
+
+					if ((i & 3) == 0)
+					{
+						Started = Metrics.Begin();
+
+						uint32_t ResultLength = 0;
+						auto Translated = TranslateScaleformKey(*Store.Acquire(), WideKeys[i / 4].data(), ResultLength);
+						Path = (Translated != nullptr) ? HOOKMETRIC_SCALEFORM_TRANSLATED : HOOKMETRIC_SCALEFORM_ENGINE;
+
+						Metrics.End(Path, Started);
+						Counts[Path]++;
+					}
+				}
+			}
+
+			Running.fetch_sub(1);
+		}));
+	}
+
+	for (auto& Worker : Workers)
+		Worker.join();
+
+	Sampler.join();
+	auto Elapsed = Timer.ElapsedMilliseconds() / 1000.0;
+
+	HookMetricsSnapshot Final;
+	auto Valid = HookMetrics::Aggregate(Reader.GetData(), Reader.GetSize(), Final) && ReaderValid.load();
+
+	PrintSnapshot(Final, nullptr, Elapsed);
+
+	// Every call must be counted once, on its path and in one bucket
+	for (uint32_t p = 0; p < HOOKMETRIC_PATH_COUNT; p++)
+	{
+		uint64_t Calls = 0, Bucketed = 0;
+		for (auto& Counts : Expected)
+			Calls += Counts[p];
+		for (uint32_t b = 0; b < HOOKMETRICS_BUCKETS; b++)
+			Bucketed += Final.Buckets[p][b];
+
+		if (Final.Calls[p] != (uint32_t)Calls || Bucketed != Calls)
+		{
+			printf("mismatch: %s counted %u calls in %llu buckets, made %llu\n", HookMetrics::GetPathName((HookMetricPath)p), Final.Calls[p], (unsigned long long)Bucketed, (unsigned long long)Calls);
+			Valid = false;
+		}
+	}
+
+	if (Final.ThreadCount != Threads)
+		Valid = false;
+
+	// The cost of counting, a call with nothing in it
+	const uint32_t OverheadCalls = 1000000;
+	ToolUtils::Stopwatch OverheadTimer;
+	for (uint32_t i = 0; i < OverheadCalls; i++)
+		Metrics.End(HOOKMETRIC_STRINGED_UNRESOLVED, Metrics.Begin());
+	auto Overhead = OverheadTimer.ElapsedNanoseconds() / OverheadCalls;
+
+	Metrics.Stop();
+
+	HookMetricsSnapshot Stopped;
+	HookMetrics::Aggregate(Reader.GetData(), Reader.GetSize(), Stopped);
+
+	printf("overhead: %.1f ns per counted call\n", Overhead);
+	printf("reader:   %u live samples, totals %s, block %s after stop\n", ReaderSamples.load(), ReaderValid.load() ? "never went back" : "WENT BACK", Stopped.Enabled ? "still counting" : "stopped");
+	printf("result:   %s\n", (Valid && !Stopped.Enabled) ? "every call counted on its path" : "FAILED");
+
+	return (Valid && !Stopped.Enabled) ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,257 @@
+// Standard includes
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Our includes
+#include "commands.h"
+#include "toolutils.h"
+#include "sourcefile.h"
+#include "missingkeys.h"
+#include "translate.h"
+#include "translationdb.h"
+#include "unicode.h"
+
+// A miss as the hooks see it, one in four comes from Scaleform
+struct CollectCall
+{
+	const char* Key;
+	const char* Fallback;
+	std::vector<uint16_t> WideKey;
+};
+
+// Whether or not the collector keeps a key, ascii names that survive a KEY|value line
+static bool IsCollectedKey(const std::string& Key)
+{
+	if (Key.empty() || Key.front() == ' ' || Key.back() == ' ' || Key.compare(0, 2, "//") == 0)
+		return false;
+
+	for (auto Character : Key)
+	{
+		if ((uint8_t)Character < 0x20 || (uint8_t)Character >= 0x80 || Character == '|')
+			return false;
+	}
+
+	return true;
+}
+
+// Replays every call on a few threads, each in its own order, returns the nanoseconds per call of the last round
+static double ReplayCalls(MissingKeyCollector& Collector, const std::vector<CollectCall>& Calls, uint32_t Threads, uint32_t Rounds)
+{
+	std::vector<std::thread> Workers;
+	std::vector<double> LastRound(Threads, 0.0);
+
+	for (uint32_t t = 0; t < Threads; t++)
+	{
+		Workers.push_back(std::thread([&, t]()
+		{
+			std::vector<uint32_t> Order(Calls.size());
+			for (uint32_t i = 0; i < (uint32_t)Order.size(); i++)
+				Order[i] = i;
+
+			std::mt19937 Random(t + 1);
+			std::shuffle(Order.begin(), Order.end(), Random);
+
+			for (uint32_t Round = 0; Round < Rounds; Round++)
+			{
+				ToolUtils::Stopwatch Timer;
+
+				for (auto Index : Order)
+				{
+					auto& Call = Calls[Index];
+					if (!Call.WideKey.empty())
+						Collector.RecordScaleformKey(Call.WideKey.data());
+					else
+						Collector.RecordStringReference(Call.Key, Call.Fallback);
+				}
+
+				LastRound[t] = Timer.ElapsedNanoseconds() / (double)Order.size();
+			}
+		}));
+	}
+
+	for (auto& Worker : Workers)
+		Worker.join();
+
+	double Total = 0.0;
+	for (auto Time : LastRound)
+		Total += Time;
+
+	return Total / Threads;
+}
+
+int MissingCollectCommand(int argc, char** argv)
+{
+	if (argc < 1)
+	{
+		printf("usage: d3tool missing-collect <database.db> [--localize game_localize.txt] [--missing en_missing.txt] [--threads 4] [--rounds 20] [--output missing.txt]\n");
+		return 1;
+	}
+
+	std::string DatabasePath = argv[0];
+	std::string LocalizePath = "game_localize.txt";
+	std::string MissingPath = "en/en_missing.txt";
+	std::string OutputPath = "missing_collected.txt";
+	uint32_t Threads = 4;
+	uint32_t Rounds = 20;
+	bool KeepOutput = false;
+
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (std::strcmp(argv[i], "--localize") == 0)
+			LocalizePath = argv[i + 1];
+		else if (std::strcmp(argv[i], "--missing") == 0)
+			MissingPath = argv[i + 1];
+		else if (std::strcmp(argv[i], "--threads") == 0)
+			Threads = (uint32_t)std::max(1, std::atoi(argv[i + 1]));
+		else if (std::strcmp(argv[i], "--rounds") == 0)
+			Rounds = (uint32_t)std::max(2, std::atoi(argv[i + 1]));
+		else if (std::strcmp(argv[i], "--output") == 0)
+		{
+			OutputPath = argv[i + 1];
+			KeepOutput = true;
+		}
+	}
+
+	TranslationDB Database;
+	if (!Database.Load(DatabasePath))
+	{
+		printf("Failed to load: %s\n", DatabasePath.c_str());
+		return 1;
+	}
+
+	// The game's own text for every key, what the engine falls back to when we don't have it
+	auto Pairs = ToolUtils::ReadLocalizePairs(LocalizePath);
+	auto MissingPairs = ToolUtils::ReadMissingPairs(MissingPath);
+	Pairs.insert(Pairs.end(), MissingPairs.begin(), MissingPairs.end());
+
+	std::vector<CollectCall> Calls;
+	std::unordered_map<std::string, std::unordered_set<std::string>> Expected;
+	uint32_t Modified = 0;
+
+	for (size_t i = 0; i < Pairs.size(); i++)
+	{
+		auto& Pair = Pairs[i];
+		if (TranslateStringReference(Database, Pair.first.c_str()) != nullptr || !IsCollectedKey(Pair.first))
+			continue;
+
+		CollectCall Call;
+		Call.Key = Pair.first.c_str();
+		Call.Fallback = Pair.second.c_str();
+
+		// Scaleform doesn't tell us the engine's text, the key stands in for it. Half of them have the @ modifier, which
+		// the lookup only strips from keys of more than one character
+		auto Scaleform = ((Calls.size() & 3) == 3);
+		auto Modifiable = (Pair.first.size() > 1);
+		if (Scaleform)
+		{
+			if (Modifiable && (Calls.size() & 7) == 7)
+			{
+				Call.WideKey.push_back('@');
+				Modified++;
+			}
+
+			Call.WideKey.insert(Call.WideKey.end(), Pair.first.begin(), Pair.first.end());
+			Call.WideKey.push_back(0);
+		}
+
+		Expected[Pair.first].insert(Scaleform ? Pair.first : MissingKeyCollector::EngineToUtf8(Pair.second));
+
+		// Some keys are also asked for by Scaleform with the modifier, they're still collected once
+		if (!Scaleform && Modifiable && (Calls.size() & 7) == 1)
+		{
+			CollectCall Both;
+			Both.Key = Call.Key;
+			Both.Fallback = Call.Fallback;
+			Both.WideKey.push_back('@');
+			Both.WideKey.insert(Both.WideKey.end(), Pair.first.begin(), Pair.first.end());
+			Both.WideKey.push_back(0);
+
+			Expected[Pair.first].insert(Pair.first);
+			Calls.push_back(std::move(Both));
+			Modified++;
+		}
+
+		Calls.push_back(std::move(Call));
+	}
+
+	if (Calls.empty())
+	{
+		printf("No missing keys in: %s, %s\n", LocalizePath.c_str(), MissingPath.c_str());
+		return 1;
+	}
+
+	std::remove(OutputPath.c_str());
+
+	MissingKeyCollector Collector;
+	if (!Collector.Start(OutputPath, 65536, 50))
+	{
+		printf("Failed to open: %s\n", OutputPath.c_str());
+		return 1;
+	}
+
+	auto SeenTime = ReplayCalls(Collector, Calls, Threads, Rounds);
+	Collector.Stop(true);
+
+	printf("calls:    %u misses (%u distinct keys, %u with the @ modifier) from %u threads, %u rounds each\n", (uint32_t)Calls.size(), (uint32_t)Expected.size(), Modified, Threads, Rounds);
+	printf("session:  %u keys recorded, %u written, %u overflowed, %.1f ns per call once every key was seen\n", Collector.GetRecordedCount(), Collector.GetWrittenCount(), Collector.GetOverflowCount(), SeenTime);
+
+	// The file must parse as a source file with every key once
+	std::vector<uint8_t> Data;
+	std::vector<TranslationPair> Collected;
+	SourceReport Report;
+	bool Valid = ToolUtils::ReadFile(OutputPath, Data) && ParseSourceFile(Data.data(), Data.size(), Collected, Report);
+
+	uint32_t WrongValues = 0, InvalidUtf8 = 0;
+	std::unordered_set<std::string> Found;
+
+	for (auto& Pair : Collected)
+	{
+		std::string Key(Pair.Key, Pair.KeyLength);
+		std::string Value(Pair.Value, Pair.ValueLength);
+		Found.insert(Key);
+
+		auto Values = Expected.find(Key);
+		if (Values == Expected.end() || Values->second.count(Value) == 0)
+			WrongValues++;
+
+		size_t Position = 0;
+		uint32_t CodePoint = 0;
+		while (Position < Value.size())
+		{
+			if (!Unicode::DecodeUtf8((const uint8_t*)Value.data(), Value.size(), Position, CodePoint))
+			{
+				InvalidUtf8++;
+				break;
+			}
+		}
+	}
+
+	Valid = Valid && Report.Malformed.empty() && Report.Duplicates.empty() && WrongValues == 0 && InvalidUtf8 == 0 && Found.size() == Expected.size() && Collected.size() == Expected.size();
+	printf("file:     %u pairs, %u malformed, %u duplicates, %u unexpected values, %u not utf8\n", (uint32_t)Collected.size(), (uint32_t)Report.Malformed.size(), (uint32_t)Report.Duplicates.size(), WrongValues, InvalidUtf8);
+
+	// A later session appends nothing, the keys are already in the file
+	MissingKeyCollector Again;
+	Again.Start(OutputPath, 65536, 50);
+	ReplayCalls(Again, Calls, 1, 1);
+	Again.Stop(true);
+
+	printf("resumed:  %u keys written by a second session over the same file\n", Again.GetWrittenCount());
+	Valid = Valid && Again.GetWrittenCount() == 0;
+
+	printf("result:   %s\n", Valid ? "every missing key collected once" : "FAILED");
+
+	if (!KeepOutput)
+		std::remove(OutputPath.c_str());
+
+	return Valid ? 0 : 1;
+}
\ No newline at end of file
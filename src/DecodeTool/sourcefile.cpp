@@ -0,0 +1,244 @@
+// Standard includes
+#include <algorithm>
+#include <cstring>
+
+// The class we are implementing
+#include "sourcefile.h"
+
+// Our includes
+#include "bytescan.h"
+#include "parallel.h"
+#include "hashing.h"
+
+// Smallest slice of a source file worth giving its own thread
+static const size_t SourceChunkSize = 64 * 1024;
+// Longest part of a malformed line kept for the report
+static const size_t IssueTextLength = 64;
+
+// Whitespace trimmed from the end of values
+static bool IsSpace(uint8_t Value)
+{
+	return (Value == ' ' || Value == '\t' || Value == '\r' || Value == '\v' || Value == '\f');
+}
+
+// The pairs and issues of one chunk, lines are counted from the start of the chunk
+struct SourceChunk
+{
+	std::vector<TranslationPair> Pairs;
+	std::vector<uint32_t> PairLines;
+	std::vector<uint64_t> PairHashes;
+	std::vector<SourceIssue> Malformed;
+	uint32_t LineCount;
+	uint32_t CommentCount;
+};
+
+// Records a line that couldn't be used
+static void AddMalformed(SourceChunk& Chunk, uint32_t Line, const uint8_t* Text, const uint8_t* TextEnd)
+{
+	SourceIssue Issue;
+	Issue.Line = Line;
+	Issue.FirstLine = 0;
+	Issue.Text.assign((const char*)Text, std::min<size_t>(TextEnd - Text, IssueTextLength));
+	Chunk.Malformed.push_back(Issue);
+}
+
+// Parses every line in [Data, End), which starts and ends on a line boundary.
+// One vectorized pass indexes every separator and line end, lines are then cut from the index without touching the text again
+static void ParseChunk(const uint8_t* Data, const uint8_t* End, SourceChunk& Chunk)
+{
+	Chunk.LineCount = 0;
+	Chunk.CommentCount = 0;
+
+	std::vector<uint32_t> Delimiters;
+	Delimiters.reserve((End - Data) / 16);
+	ByteScan::FindAll(Data, End, '|', '\n', Delimiters);
+
+	Chunk.Pairs.reserve(Delimiters.size() / 2 + 1);
+	Chunk.PairLines.reserve(Delimiters.size() / 2 + 1);
+	Chunk.PairHashes.reserve(Delimiters.size() / 2 + 1);
+
+	auto Cursor = Data;
+	size_t Next = 0;
+
+	// Gets the next indexed delimiter, the end of the chunk when there are none left
+	auto NextDelimiter = [&]() -> const uint8_t*
+	{
+		return (Next < Delimiters.size()) ? Data + Delimiters[Next++] : End;
+	};
+
+	// Moves past the end of the current line, from a delimiter on it
+	auto SkipLine = [&](const uint8_t* Delimiter) -> const uint8_t*
+	{
+		while (Delimiter < End && *Delimiter != '\n')
+			Delimiter = NextDelimiter();
+
+		return Delimiter;
+	};
+
+	while (Cursor < End)
+	{
+		auto Line = ++Chunk.LineCount;
+		auto Delimiter = NextDelimiter();
+
+		// Comments run to the end of the line
+		if (End - Cursor >= 2 && Cursor[0] == '/' && Cursor[1] == '/')
+		{
+			auto LineEnd = SkipLine(Delimiter);
+			Cursor = (LineEnd < End) ? LineEnd + 1 : End;
+			Chunk.CommentCount++;
+			continue;
+		}
+
+		if (Delimiter == End || *Delimiter == '\n')
+		{
+			auto TextEnd = Delimiter;
+			while (TextEnd > Cursor && IsSpace(TextEnd[-1]))
+				TextEnd--;
+
+			// Blank lines are fine, anything else needs a separator
+			if (TextEnd > Cursor)
+				AddMalformed(Chunk, Line, Cursor, TextEnd);
+
+			Cursor = (Delimiter < End) ? Delimiter + 1 : End;
+			continue;
+		}
+
+		// Later separators on the line are part of the value
+		auto LineEnd = SkipLine(NextDelimiter());
+		auto Value = Delimiter + 1;
+		auto ValueEnd = LineEnd;
+
+		while (ValueEnd > Value && IsSpace(ValueEnd[-1]))
+			ValueEnd--;
+
+		if (Delimiter == Cursor)
+		{
+			AddMalformed(Chunk, Line, Cursor, ValueEnd);
+		}
+		else
+		{
+			TranslationPair Pair;
+			Pair.Key = (const char*)Cursor;
+			Pair.KeyLength = (uint32_t)(Delimiter - Cursor);
+			Pair.Value = (const char*)Value;
+			Pair.ValueLength = (uint32_t)(ValueEnd - Value);
+
+			Chunk.Pairs.push_back(Pair);
+			Chunk.PairLines.push_back(Line);
+			Chunk.PairHashes.push_back(Hashing::WordMix::Hash(Pair.Key, Pair.KeyLength));
+		}
+
+		Cursor = (LineEnd < End) ? LineEnd + 1 : End;
+	}
+}
+
+bool ParseSourceFile(const uint8_t* Data, size_t Size, std::vector<TranslationPair>& Pairs, SourceReport& Report, uint32_t Threads)
+{
+	Pairs.clear();
+	Report.LineCount = 0;
+	Report.CommentCount = 0;
+	Report.Malformed.clear();
+	Report.Duplicates.clear();
+
+	// The delimiter index holds 32 bit offsets
+	if (Size > UINT32_MAX)
+		return false;
+
+	auto Body = Data;
+	auto End = Data + Size;
+
+	// Skip a utf8 byte order mark
+	if (Size >= 3 && std::memcmp(Data, "\xEF\xBB\xBF", 3) == 0)
+		Body += 3;
+
+	// Chunks are moved forward to the next line start, so no line is split
+	auto Chunks = Parallel::GetChunkCount((size_t)(End - Body), SourceChunkSize, Threads);
+	std::vector<const uint8_t*> Bounds(Chunks + 1);
+
+	Bounds[0] = Body;
+	Bounds[Chunks] = End;
+
+	for (uint32_t Chunk = 1; Chunk < Chunks; Chunk++)
+	{
+		auto Bound = std::max(Bounds[Chunk - 1], Body + (((uint64_t)(End - Body) * Chunk) / Chunks));
+
+		if (Bound > Body && Bound < End && Bound[-1] != '\n')
+		{
+			auto LineEnd = ByteScan::Find(Bound, End, '\n');
+			Bound = (LineEnd != nullptr) ? LineEnd + 1 : End;
+		}
+
+		Bounds[Chunk] = Bound;
+	}
+
+	std::vector<SourceChunk> Parsed(Chunks);
+	Parallel::For(Chunks, [&](uint32_t Chunk)
+	{
+		ParseChunk(Bounds[Chunk], Bounds[Chunk + 1], Parsed[Chunk]);
+	});
+
+	// Merge in file order onto the first chunk, turning chunk lines into file lines
+	auto& First = Parsed[0];
+	Pairs = std::move(First.Pairs);
+
+	auto PairLines = std::move(First.PairLines);
+	auto PairHashes = std::move(First.PairHashes);
+
+	for (auto& Chunk : Parsed)
+	{
+		for (auto& Issue : Chunk.Malformed)
+		{
+			Issue.Line += Report.LineCount;
+			Report.Malformed.push_back(std::move(Issue));
+		}
+
+		if (&Chunk != &First)
+		{
+			Pairs.insert(Pairs.end(), Chunk.Pairs.begin(), Chunk.Pairs.end());
+			PairHashes.insert(PairHashes.end(), Chunk.PairHashes.begin(), Chunk.PairHashes.end());
+
+			for (auto Line : Chunk.PairLines)
+				PairLines.push_back(Line + Report.LineCount);
+		}
+
+		Report.LineCount += Chunk.LineCount;
+		Report.CommentCount += Chunk.CommentCount;
+	}
+
+	// Every key defined again, against the definition it replaces, found with an open addressed table of the key hashes
+	size_t Capacity = 16;
+	while (Capacity < Pairs.size() * 2)
+		Capacity *= 2;
+
+	std::vector<uint32_t> Defined(Capacity, UINT32_MAX);
+
+	for (uint32_t i = 0; i < (uint32_t)Pairs.size(); i++)
+	{
+		auto& Pair = Pairs[i];
+		auto Position = (size_t)PairHashes[i] & (Capacity - 1);
+
+		while (Defined[Position] != UINT32_MAX)
+		{
+			auto Previous = Defined[Position];
+			auto& Other = Pairs[Previous];
+
+			if (PairHashes[Previous] == PairHashes[i] && Other.KeyLength == Pair.KeyLength && std::memcmp(Other.Key, Pair.Key, Pair.KeyLength) == 0)
+				break;
+
+			Position = (Position + 1) & (Capacity - 1);
+		}
+
+		if (Defined[Position] != UINT32_MAX)
+		{
+			SourceIssue Issue;
+			Issue.Line = PairLines[i];
+			Issue.FirstLine = PairLines[Defined[Position]];
+			Issue.Text.assign(Pair.Key, Pair.KeyLength);
+			Report.Duplicates.push_back(Issue);
+		}
+
+		Defined[Position] = i;
+	}
+
+	return true;
+}
\ No newline at end of file
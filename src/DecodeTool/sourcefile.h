@@ -0,0 +1,38 @@
+#pragma once
+
+// Standard includes
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Our includes
+#include "translationdb.h"
+
+//
+// Translation source files, one KEY|value pair per line in utf8:
+//   Lines starting with // are comments, blank lines are ignored
+//   The key ends at the first |, the value runs to the end of the line with trailing whitespace trimmed
+//   A key defined again replaces the earlier definition
+// These are the rules translategen.exe compiled with, so compiled output matches it.
+//
+
+// A line that couldn't be used, or a key that was defined more than once
+struct SourceIssue
+{
+	uint32_t Line;			// One based
+	uint32_t FirstLine;		// For duplicates, the line of the definition it replaces
+	std::string Text;		// The key, or the start of a malformed line
+};
+
+// What was found while parsing a source file
+struct SourceReport
+{
+	uint32_t LineCount;
+	uint32_t CommentCount;
+	std::vector<SourceIssue> Malformed;
+	std::vector<SourceIssue> Duplicates;
+};
+
+// Parses a source file, split on line boundaries across threads. Pairs are in file order and reference the input, false if the file is over 4GB
+bool ParseSourceFile(const uint8_t* Data, size_t Size, std::vector<TranslationPair>& Pairs, SourceReport& Report, uint32_t Threads = 1);
\ No newline at end of file
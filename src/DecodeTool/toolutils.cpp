@@ -0,0 +1,278 @@
+// Platform includes
+#ifdef _WIN32
+#include <Windows.h>
+#include <Psapi.h>
+#else
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+// Standard includes
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <atomic>
+#include <new>
+
+// The class we are implementing
+#include "toolutils.h"
+
+// Every operator new in the tool is counted, so benchmarks can report allocations
+static std::atomic<uint64_t> AllocationCount(0);
+
+void* operator new(size_t Size)
+{
+	AllocationCount.fetch_add(1, std::memory_order_relaxed);
+
+	auto Result = std::malloc((Size > 0) ? Size : 1);
+	if (Result == nullptr)
+		throw std::bad_alloc();
+
+	return Result;
+}
+
+void* operator new[](size_t Size)
+{
+	return operator new(Size);
+}
+
+void operator delete(void* Block) throw()
+{
+	std::free(Block);
+}
+
+void operator delete[](void* Block) throw()
+{
+	std::free(Block);
+}
+
+void operator delete(void* Block, size_t) throw()
+{
+	std::free(Block);
+}
+
+void operator delete[](void* Block, size_t) throw()
+{
+	std::free(Block);
+}
+
+bool ToolUtils::ReadFile(const std::string& Path, std::vector<uint8_t>& Result)
+{
+	auto Handle = fopen(Path.c_str(), "rb");
+	if (Handle == nullptr)
+		return false;
+
+	fseek(Handle, 0, SEEK_END);
+	auto Size = ftell(Handle);
+	fseek(Handle, 0, SEEK_SET);
+
+	Result.resize((Size > 0) ? (size_t)Size : 0);
+	auto Read = Result.empty() ? 0 : fread(Result.data(), 1, Result.size(), Handle);
+	fclose(Handle);
+
+	return (Read == Result.size());
+}
+
+bool ToolUtils::WriteFile(const std::string& Path, const void* Data, size_t Size)
+{
+	auto Handle = fopen(Path.c_str(), "wb");
+	if (Handle == nullptr)
+		return false;
+
+	auto Written = (Size > 0) ? fwrite(Data, 1, Size, Handle) : 0;
+	fclose(Handle);
+
+	return (Written == Size);
+}
+
+static std::vector<std::string> ReadLines(const std::string& Path)
+{
+	std::vector<std::string> Result;
+	std::vector<uint8_t> Buffer;
+
+	if (!ToolUtils::ReadFile(Path, Buffer))
+		return Result;
+
+	auto Cursor = (const char*)Buffer.data();
+	auto End = Cursor + Buffer.size();
+
+	// Skip a utf8 byte order mark
+	if (Buffer.size() >= 3 && std::memcmp(Cursor, "\xEF\xBB\xBF", 3) == 0)
+		Cursor += 3;
+
+	while (Cursor < End)
+	{
+		auto LineEnd = (const char*)std::memchr(Cursor, '\n', End - Cursor);
+		if (LineEnd == nullptr)
+			LineEnd = End;
+
+		auto Line = std::string(Cursor, LineEnd);
+		if (!Line.empty() && Line.back() == '\r')
+			Line.pop_back();
+
+		Result.push_back(Line);
+		Cursor = LineEnd + 1;
+	}
+
+	return Result;
+}
+
+std::vector<std::string> ToolUtils::ReadSourceKeys(const std::string& Path)
+{
+	std::vector<std::string> Result;
+
+	for (auto& Pair : ReadSourcePairs(Path))
+		Result.push_back(Pair.first);
+
+	return Result;
+}
+
+std::vector<std::string> ToolUtils::ReadMissingKeys(const std::string& Path)
+{
+	std::vector<std::string> Result;
+
+	for (auto& Pair : ReadMissingPairs(Path))
+		Result.push_back(Pair.first);
+
+	return Result;
+}
+
+std::vector<std::string> ToolUtils::ReadLocalizeKeys(const std::string& Path)
+{
+	std::vector<std::string> Result;
+
+	// Values are in the game's codepage, only the ascii keys are used
+	for (auto& Pair : ReadLocalizePairs(Path))
+		Result.push_back(Pair.first);
+
+	return Result;
+}
+
+std::vector<std::pair<std::string, std::string>> ToolUtils::ReadLocalizePairs(const std::string& Path)
+{
+	static const std::string Separator = " : ";
+	std::vector<std::pair<std::string, std::string>> Result;
+
+	for (auto& Line : ReadLines(Path))
+	{
+		auto Split = Line.find(Separator);
+		if (Split != std::string::npos && Split > 0)
+			Result.push_back(std::make_pair(Line.substr(0, Split), Line.substr(Split + Separator.size())));
+	}
+
+	return Result;
+}
+
+std::vector<std::pair<std::string, std::string>> ToolUtils::ReadSourcePairs(const std::string& Path)
+{
+	std::vector<std::pair<std::string, std::string>> Result;
+
+	for (auto& Line : ReadLines(Path))
+	{
+		auto Split = Line.find('|');
+		if (Split != std::string::npos && Split > 0)
+			Result.push_back(std::make_pair(Line.substr(0, Split), Line.substr(Split + 1)));
+	}
+
+	return Result;
+}
+
+std::vector<std::pair<std::string, std::string>> ToolUtils::ReadMissingPairs(const std::string& Path)
+{
+	static const std::string Prefix = "MISSING: ";
+	static const std::string Separator = " : ";
+	std::vector<std::pair<std::string, std::string>> Result;
+
+	for (auto& Line : ReadLines(Path))
+	{
+		if (Line.compare(0, Prefix.size(), Prefix) != 0)
+			continue;
+
+		auto Split = Line.find(Separator, Prefix.size());
+		if (Split != std::string::npos && Split > Prefix.size())
+			Result.push_back(std::make_pair(Line.substr(Prefix.size(), Split - Prefix.size()), Line.substr(Split + Separator.size())));
+	}
+
+	return Result;
+}
+
+// Reads a null-term string one byte at a time, as the original loader did
+static std::string ReadNullString(FILE* Handle)
+{
+	std::string Result = "";
+
+	char ch = 0;
+	fread(&ch, 1, 1, Handle);
+	while (ch != 0)
+	{
+		Result += ch;
+		fread(&ch, 1, 1, Handle);
+	}
+
+	return Result;
+}
+
+bool ToolUtils::LoadLegacyMap(const std::string& Path, std::unordered_map<std::string, std::string>& Result)
+{
+	auto Db = fopen(Path.c_str(), "rb");
+	if (Db == nullptr)
+		return false;
+
+	uint32_t Entries = 0;
+	fread(&Entries, 4, 1, Db);
+
+	for (uint32_t i = 0; i < Entries; i++)
+	{
+		auto Key = ReadNullString(Db);
+		auto Value = ReadNullString(Db);
+
+		Result[Key] = Value;
+	}
+
+	fclose(Db);
+	return true;
+}
+
+uint64_t ToolUtils::GetResidentBytes()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS Counters;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &Counters, sizeof(Counters)))
+		return (uint64_t)Counters.WorkingSetSize;
+
+	return 0;
+#else
+	// The second field of statm is the resident page count
+	auto Handle = fopen("/proc/self/statm", "r");
+	if (Handle == nullptr)
+		return 0;
+
+	unsigned long long Size = 0, Resident = 0;
+	auto Parsed = fscanf(Handle, "%llu %llu", &Size, &Resident);
+	fclose(Handle);
+
+	return (Parsed == 2) ? (uint64_t)Resident * (uint64_t)sysconf(_SC_PAGESIZE) : 0;
+#endif
+}
+
+uint64_t ToolUtils::GetPeakResidentBytes()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS Counters;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &Counters, sizeof(Counters)))
+		return (uint64_t)Counters.PeakWorkingSetSize;
+
+	return 0;
+#else
+	struct rusage Usage;
+	if (getrusage(RUSAGE_SELF, &Usage) == 0)
+		return (uint64_t)Usage.ru_maxrss * 1024;
+
+	return 0;
+#endif
+}
+
+uint64_t ToolUtils::GetAllocationCount()
+{
+	return AllocationCount.load(std::memory_order_relaxed);
+}
\ No newline at end of file
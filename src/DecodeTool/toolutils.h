@@ -0,0 +1,57 @@
+#pragma once
+
+// Standard includes
+#include <cstdint>
+#include <chrono>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace ToolUtils
+{
+	// A simple monotonic stopwatch
+	class Stopwatch
+	{
+	private:
+		std::chrono::steady_clock::time_point Start;
+
+	public:
+		Stopwatch() : Start(std::chrono::steady_clock::now()) { }
+
+		// Restarts the stopwatch
+		void Restart() { this->Start = std::chrono::steady_clock::now(); }
+		// Gets the elapsed time in nanoseconds
+		double ElapsedNanoseconds() const { return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - this->Start).count(); }
+		// Gets the elapsed time in milliseconds
+		double ElapsedMilliseconds() const { return this->ElapsedNanoseconds() / 1000000.0; }
+	};
+
+	// Reads an entire file into a buffer
+	bool ReadFile(const std::string& Path, std::vector<uint8_t>& Result);
+	// Writes a buffer to a file in one call
+	bool WriteFile(const std::string& Path, const void* Data, size_t Size);
+
+	// Reads the keys of a source file (KEY|value lines)
+	std::vector<std::string> ReadSourceKeys(const std::string& Path);
+	// Reads the keys of a missing log (MISSING: KEY : value lines)
+	std::vector<std::string> ReadMissingKeys(const std::string& Path);
+	// Reads the keys of the game's localize dump (KEY : value lines)
+	std::vector<std::string> ReadLocalizeKeys(const std::string& Path);
+	// Reads the pairs of a source file (KEY|value lines)
+	std::vector<std::pair<std::string, std::string>> ReadSourcePairs(const std::string& Path);
+	// Reads the pairs of a missing log (MISSING: KEY : value lines), values are in the engine's encoding
+	std::vector<std::pair<std::string, std::string>> ReadMissingPairs(const std::string& Path);
+	// Reads the pairs of the game's localize dump (KEY : value lines), values are in the engine's encoding
+	std::vector<std::pair<std::string, std::string>> ReadLocalizePairs(const std::string& Path);
+
+	// Loads a v1 database into an unordered_map one byte at a time, the original loader
+	bool LoadLegacyMap(const std::string& Path, std::unordered_map<std::string, std::string>& Result);
+
+	// Gets the current resident set size of this process in bytes
+	uint64_t GetResidentBytes();
+	// Gets the peak resident set size of this process in bytes
+	uint64_t GetPeakResidentBytes();
+	// Gets the amount of heap allocations made by this process so far
+	uint64_t GetAllocationCount();
+}
\ No newline at end of file
@@ -0,0 +1,445 @@
+// Standard includes
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Our includes
+#include "commands.h"
+#include "toolutils.h"
+#include "keytrace.h"
+#include "translate.h"
+#include "translationdb.h"
+#include "translationstack.h"
+#include "translationstore.h"
+#include "stringcache.h"
+
+// Records of a trace compared against what the replay resolved, printed before they're only counted
+static const size_t ReportedMismatches = 10;
+
+// Gets the value at a percentile of sorted samples
+static double GetPercentile(const std::vector<double>& Sorted, double Percentile)
+{
+	if (Sorted.empty())
+		return 0.0;
+
+	auto Index = (size_t)((Percentile / 100.0) * (double)(Sorted.size() - 1) + 0.5);
+	return Sorted[std::min(Index, Sorted.size() - 1)];
+}
+
+// Widens an ascii key into a null-term utf16 key
+static std::vector<uint16_t> WidenKey(const std::string& Key)
+{
+	std::vector<uint16_t> Result(Key.begin(), Key.end());
+	Result.push_back(0);
+	return Result;
+}
+
+// The records of one recorded thread, replayed on a thread of its own
+struct ReplayThread
+{
+	uint32_t ThreadId;
+	std::vector<uint32_t> Records;
+	// Buffers standing in for addresses the engine wrote different keys to, by address group
+	std::vector<std::vector<char>> Buffers;
+	std::vector<double> CallTimes;
+	std::vector<double> Lateness;
+	std::vector<uint32_t> Mismatches;
+};
+
+int ReplayCommand(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		printf("usage: d3tool replay <trace.d3trace> <database.db> [--timing original|fast] [--speed 1.0] [--strict]\n");
+		return 1;
+	}
+
+	std::string TracePath = argv[0];
+	std::string DatabasePath = argv[1];
+	bool Original = false, Strict = false;
+	double Speed = 1.0;
+
+	for (int i = 2; i < argc; i++)
+	{
+		if (std::strcmp(argv[i], "--timing") == 0 && i + 1 < argc)
+			Original = (std::strcmp(argv[++i], "original") == 0);
+		else if (std::strcmp(argv[i], "--speed") == 0 && i + 1 < argc)
+			Speed = std::max(0.001, std::atof(argv[++i]));
+		else if (std::strcmp(argv[i], "--strict") == 0)
+			Strict = true;
+	}
+
+	KeyTraceReader Trace;
+	if (!Trace.Load(TracePath))
+	{
+		printf("Failed to read trace: %s\n", TracePath.c_str());
+		return 1;
+	}
+
+	std::unique_ptr<TranslationStack> Stack(new TranslationStack());
+	if (!Stack->Load(DatabasePath))
+	{
+		printf("Failed to load: %s\n", DatabasePath.c_str());
+		return 1;
+	}
+
+	TranslationStore Store;
+	StringReferenceCache Cache;
+	Store.Publish(std::move(Stack));
+
+	auto& Keys = Trace.GetKeys();
+	auto& Records = Trace.GetRecords();
+
+	// Addresses that only ever held one key are literals and shared by every thread,
+	// the others were buffers the engine formatted into, every replay thread gets its own copy of those
+	std::map<uint64_t, std::vector<uint32_t>> Addresses;
+	for (uint32_t i = 0; i < (uint32_t)Keys.size(); i++)
+	{
+		if (Keys[i].Hook == KEYTRACE_HOOK_STRINGED)
+			Addresses[Keys[i].Address].push_back(i);
+	}
+
+	std::vector<int32_t> KeyGroups(Keys.size(), -1);
+	std::vector<size_t> GroupSizes;
+
+	for (auto& Address : Addresses)
+	{
+		if (Address.second.size() < 2)
+			continue;
+
+		size_t Longest = 0;
+		for (auto Key : Address.second)
+		{
+			KeyGroups[Key] = (int32_t)GroupSizes.size();
+			Longest = std::max(Longest, Keys[Key].Text.size());
+		}
+
+		GroupSizes.push_back(Longest + 1);
+	}
+
+	std::vector<std::vector<uint16_t>> WideKeys(Keys.size());
+	for (size_t i = 0; i < Keys.size(); i++)
+	{
+		if (Keys[i].Hook == KEYTRACE_HOOK_SCALEFORM)
+		{
+			WideKeys[i].resize(Keys[i].Text.size() / 2 + 1, 0);
+			std::memcpy(WideKeys[i].data(), Keys[i].Text.data(), Keys[i].Text.size() & ~(size_t)1);
+		}
+	}
+
+	std::vector<std::unique_ptr<ReplayThread>> Threads;
+	std::map<uint32_t, ReplayThread*> ThreadIndex;
+	uint32_t StringEdRecords = 0, RecordedHits = 0;
+
+	for (uint32_t i = 0; i < (uint32_t)Records.size(); i++)
+	{
+		auto& Thread = ThreadIndex[Records[i].ThreadId];
+		if (Thread == nullptr)
+		{
+			Threads.emplace_back(new ReplayThread());
+			Thread = Threads.back().get();
+			Thread->ThreadId = Records[i].ThreadId;
+
+			for (auto Size : GroupSizes)
+				Thread->Buffers.push_back(std::vector<char>(Size, 0));
+		}
+
+		Thread->Records.push_back(i);
+		StringEdRecords += (Records[i].Hook == KEYTRACE_HOOK_STRINGED) ? 1 : 0;
+		RecordedHits += Records[i].Hit ? 1 : 0;
+	}
+
+	auto Frequency = (double)Trace.GetFrequency();
+	auto Duration = Records.empty() ? 0.0 : (double)Records.back().Ticks / Frequency;
+
+	printf("trace:          %s\n", TracePath.c_str());
+	printf("records:        %u over %.2f s, %u threads, %u distinct keys, %u reused buffers\n", (uint32_t)Records.size(), Duration, (uint32_t)Threads.size(), (uint32_t)Keys.size(), (uint32_t)GroupSizes.size());
+	printf("hooks:          %u StringEd, %u Scaleform, %.2f%% recorded hits\n", StringEdRecords, (uint32_t)Records.size() - StringEdRecords, Records.empty() ? 0.0 : (100.0 * RecordedHits) / Records.size());
+
+	// Every thread waits for the others, so the schedule starts at the same time for all of them
+	std::atomic<uint32_t> Ready(0);
+	std::atomic<bool> Go(false);
+	std::chrono::steady_clock::time_point Start;
+	std::vector<std::thread> Workers;
+
+	for (auto& Thread : Threads)
+	{
+		Workers.push_back(std::thread([&, Thread = Thread.get()]()
+		{
+			Thread->CallTimes.reserve(Thread->Records.size());
+			if (Original)
+				Thread->Lateness.reserve(Thread->Records.size());
+
+			Ready.fetch_add(1);
+			while (!Go.load(std::memory_order_acquire))
+				std::this_thread::yield();
+
+			for (auto Index : Thread->Records)
+			{
+				auto& Record = Records[Index];
+				auto& Key = Keys[Record.Key];
+
+				if (Original)
+				{
+					auto Due = Start + std::chrono::nanoseconds((int64_t)(((double)Record.Ticks * 1000000000.0) / (Frequency * Speed)));
+
+					// Sleep through long gaps, then spin the rest so calls land close to their time
+					auto Now = std::chrono::steady_clock::now();
+					if (Due - Now > std::chrono::milliseconds(2))
+						std::this_thread::sleep_until(Due - std::chrono::milliseconds(1));
+					while (std::chrono::steady_clock::now() < Due)
+						std::this_thread::yield();
+
+					Thread->Lateness.push_back((double)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - Due).count());
+				}
+
+				bool Hit = false;
+				auto CallStart = std::chrono::steady_clock::now();
+
+				if (Record.Hook == KEYTRACE_HOOK_STRINGED)
+				{
+					// The engine wrote this key into a buffer it reuses
+					auto Reference = Key.Text.c_str();
+					if (KeyGroups[Record.Key] >= 0)
+					{
+						auto& Buffer = Thread->Buffers[KeyGroups[Record.Key]];
+						if (std::strcmp(Buffer.data(), Reference) != 0)
+							std::memcpy(Buffer.data(), Reference, Key.Text.size() + 1);
+
+						Reference = Buffer.data();
+					}
+
+					Hit = (TranslateStringReference(Cache, Store, Reference) != nullptr);
+				}
+				else
+				{
+					uint32_t ResultLength = 0;
+					Hit = (TranslateScaleformKey(*Store.Acquire(), WideKeys[Record.Key].data(), ResultLength) != nullptr);
+				}
+
+				Thread->CallTimes.push_back((double)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - CallStart).count());
+
+				if (Hit != Record.Hit)
+					Thread->Mismatches.push_back(Index);
+			}
+		}));
+	}
+
+	while (Ready.load() != (uint32_t)Threads.size())
+		std::this_thread::yield();
+
+	Start = std::chrono::steady_clock::now();
+	Go.store(true, std::memory_order_release);
+
+	for (auto& Worker : Workers)
+		Worker.join();
+
+	auto Elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - Start).count() / 1000000.0;
+
+	std::vector<double> CallTimes, Lateness;
+	std::vector<uint32_t> Mismatches;
+	for (auto& Thread : Threads)
+	{
+		CallTimes.insert(CallTimes.end(), Thread->CallTimes.begin(), Thread->CallTimes.end());
+		Lateness.insert(Lateness.end(), Thread->Lateness.begin(), Thread->Lateness.end());
+		Mismatches.insert(Mismatches.end(), Thread->Mismatches.begin(), Thread->Mismatches.end());
+	}
+
+	std::sort(CallTimes.begin(), CallTimes.end());
+	std::sort(Lateness.begin(), Lateness.end());
+	std::sort(Mismatches.begin(), Mismatches.end());
+
+	double TotalCallTime = 0.0;
+	for (auto Time : CallTimes)
+		TotalCallTime += Time;
+
+	printf("replay:         %s timing, %.2f ms wall, %.1f ns mean call (p50 %.0f, p99 %.0f, max %.0f ns, clock reads included)\n", Original ? "original" : "fast", Elapsed,
+		CallTimes.empty() ? 0.0 : TotalCallTime / CallTimes.size(), GetPercentile(CallTimes, 50.0), GetPercentile(CallTimes, 99.0), CallTimes.empty() ? 0.0 : CallTimes.back());
+
+	if (Original)
+		printf("lateness:       p50 %.1f us, p99 %.1f us, max %.1f us behind schedule\n", GetPercentile(Lateness, 50.0) / 1000.0, GetPercentile(Lateness, 99.0) / 1000.0, Lateness.empty() ? 0.0 : Lateness.back() / 1000.0);
+
+	printf("string cache:   %u hits, %u misses\n", Cache.GetHits(), Cache.GetMisses());
+
+	// The database decides hits, a different one than the game had shows up here
+	for (size_t i = 0; i < Mismatches.size() && i < ReportedMismatches; i++)
+	{
+		auto& Record = Records[Mismatches[i]];
+		auto& Key = Keys[Record.Key];
+		auto Text = (Key.Hook == KEYTRACE_HOOK_STRINGED) ? Key.Text : std::string("(utf16 key)");
+
+		printf("mismatch:       %s %s was a %s, now a %s\n", (Key.Hook == KEYTRACE_HOOK_STRINGED) ? "StringEd" : "Scaleform", Text.c_str(), Record.Hit ? "hit" : "miss", Record.Hit ? "miss" : "hit");
+	}
+
+	printf("mismatches:     %u\n", (uint32_t)Mismatches.size());
+
+	return (Strict && !Mismatches.empty()) ? 1 : 0;
+}
+
+int TraceGenerateCommand(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		printf("usage: d3tool trace-generate <database.db> <output.d3trace> [--localize game_localize.txt] [--seconds 10] [--seed 1]\n");
+		return 1;
+	}
+
+	std::string DatabasePath = argv[0];
+	std::string OutputPath = argv[1];
+	std::string LocalizePath = "game_localize.txt";
+	uint32_t Seconds = 10;
+	uint32_t Seed = 1;
+
+	for (int i = 2; i + 1 < argc; i += 2)
+	{
+		if (std::strcmp(argv[i], "--localize") == 0)
+			LocalizePath = argv[i + 1];
+		else if (std::strcmp(argv[i], "--seconds") == 0)
+			Seconds = (uint32_t)std::max(1, std::atoi(argv[i + 1]));
+		else if (std::strcmp(argv[i], "--seed") == 0)
+			Seed = (uint32_t)std::atoi(argv[i + 1]);
+	}
+
+	TranslationDB Database;
+	if (!Database.Load(DatabasePath))
+	{
+		printf("Failed to load: %s\n", DatabasePath.c_str());
+		return 1;
+	}
+
+	auto LocalizeKeys = ToolUtils::ReadLocalizeKeys(LocalizePath);
+	if (LocalizeKeys.empty())
+	{
+		printf("No keys in: %s\n", LocalizePath.c_str());
+		return 1;
+	}
+
+	// The session: the game thread draws a screen of literals every frame at 60 fps, a few calls format into
+	// reused buffers, and the screen changes every few seconds, when the ui thread creates its Scaleform text fields
+	static const uint32_t FramesPerSecond = 60;
+	static const uint32_t DynamicBuffers = 4;
+	static const uint64_t LiteralBase = 0x00A00000, BufferBase = 0x0F000000;
+	static const uint32_t GameThread = 1, UiThread = 2;
+
+	std::mt19937 Random(Seed);
+	std::vector<double> Cumulative(LocalizeKeys.size());
+	double Total = 0;
+	for (size_t i = 0; i < LocalizeKeys.size(); i++)
+	{
+		Total += 1.0 / (double)(i + 1);
+		Cumulative[i] = Total;
+	}
+
+	// Popular keys are spread over the file
+	std::vector<uint32_t> Ranked(LocalizeKeys.size());
+	for (uint32_t i = 0; i < (uint32_t)Ranked.size(); i++)
+		Ranked[i] = i;
+
+	std::shuffle(Ranked.begin(), Ranked.end(), Random);
+
+	std::uniform_real_distribution<double> Uniform(0, Total);
+	auto DrawKey = [&]() -> uint32_t
+	{
+		auto Index = std::lower_bound(Cumulative.begin(), Cumulative.end(), Uniform(Random)) - Cumulative.begin();
+		return Ranked[std::min<size_t>(Index, Ranked.size() - 1)];
+	};
+
+	std::vector<uint8_t> Output;
+	KeyTraceRecorder::WriteHeader(Output, 1000000000ull, 0);
+
+	KeyTraceBlock GameBlock, UiBlock;
+	GameBlock.Reset(GameThread);
+	UiBlock.Reset(UiThread);
+
+	std::vector<uint8_t> Filled;
+	uint32_t RecordCount = 0;
+
+	auto AddRecord = [&](KeyTraceBlock& Block, uint32_t ThreadId, uint64_t Ticks, uint8_t Hook, uint64_t Address, const void* Key, uint32_t KeyBytes, bool Hit)
+	{
+		if (!Block.Add(Ticks, Hook, Address, Key, KeyBytes, Hit))
+		{
+			Block.Take(Filled);
+			Output.insert(Output.end(), Filled.begin(), Filled.end());
+			Block.Reset(ThreadId);
+			Block.Add(Ticks, Hook, Address, Key, KeyBytes, Hit);
+		}
+
+		RecordCount++;
+	};
+
+	std::uniform_int_distribution<uint32_t> ScreenSize(60, 180), ScreenSeconds(2, 5), Percent(0, 99), BufferPick(0, DynamicBuffers - 1);
+	std::vector<uint32_t> Screen;
+	uint64_t NextScreen = 0;
+
+	for (uint64_t Frame = 0; Frame < (uint64_t)Seconds * FramesPerSecond; Frame++)
+	{
+		auto Ticks = (Frame * 1000000000ull) / FramesPerSecond;
+
+		if (Ticks >= NextScreen)
+		{
+			Screen.clear();
+			for (uint32_t i = ScreenSize(Random); i > 0; i--)
+				Screen.push_back(DrawKey());
+
+			NextScreen = Ticks + ScreenSeconds(Random) * 1000000000ull;
+
+			// Text fields are created once per screen, a few of them are translated by Scaleform
+			auto UiTicks = Ticks + 500000;
+			for (size_t i = 0; i < Screen.size(); i += 4)
+			{
+				auto& Key = LocalizeKeys[Screen[i]];
+				auto Wide = WidenKey(Key);
+				uint32_t ResultLength = 0;
+				auto Hit = (TranslateScaleformKey(Database, Wide.data(), ResultLength) != nullptr);
+
+				AddRecord(UiBlock, UiThread, UiTicks, KEYTRACE_HOOK_SCALEFORM, BufferBase + 0x100000, Wide.data(), (uint32_t)(Key.size() * 2), Hit);
+				UiTicks += 20000;
+			}
+		}
+
+		// Every call takes a couple of microseconds of the frame
+		for (auto KeyIndex : Screen)
+		{
+			auto Address = LiteralBase + (uint64_t)KeyIndex * 32;
+
+			if (Percent(Random) < 5)
+			{
+				KeyIndex = DrawKey();
+				Address = BufferBase + (uint64_t)BufferPick(Random) * 0x100;
+			}
+
+			auto& Text = LocalizeKeys[KeyIndex];
+			auto Hit = (TranslateStringReference(Database, Text.c_str()) != nullptr);
+
+			AddRecord(GameBlock, GameThread, Ticks, KEYTRACE_HOOK_STRINGED, Address, Text.c_str(), (uint32_t)Text.size(), Hit);
+			Ticks += 2000;
+		}
+	}
+
+	for (auto Block : { &GameBlock, &UiBlock })
+	{
+		if (Block->IsEmpty())
+			continue;
+
+		Block->Take(Filled);
+		Output.insert(Output.end(), Filled.begin(), Filled.end());
+	}
+
+	if (!ToolUtils::WriteFile(OutputPath, Output.data(), Output.size()))
+	{
+		printf("Failed to write: %s\n", OutputPath.c_str());
+		return 1;
+	}
+
+	printf("Wrote %s, %u records over %u seconds in %u bytes (%.2f bytes per record)\n", OutputPath.c_str(), RecordCount, Seconds, (uint32_t)Output.size(), (double)Output.size() / std::max<uint32_t>(1, RecordCount));
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,98 @@
+// Standard includes
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Our includes
+#include "commands.h"
+#include "toolutils.h"
+#include "translationstore.h"
+
+int WatchCommand(int argc, char** argv)
+{
+	if (argc < 1)
+	{
+		printf("usage: d3tool watch <database.db> [--readers 4] [--seconds 0] [--source en_source.txt]\n");
+		return 1;
+	}
+
+	std::string DatabasePath = argv[0];
+	std::string SourcePath = "en/en_source.txt";
+	uint32_t ReaderCount = 4, Seconds = 0;
+
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (std::strcmp(argv[i], "--readers") == 0)
+			ReaderCount = (uint32_t)strtoul(argv[i + 1], nullptr, 10);
+		else if (std::strcmp(argv[i], "--seconds") == 0)
+			Seconds = (uint32_t)strtoul(argv[i + 1], nullptr, 10);
+		else if (std::strcmp(argv[i], "--source") == 0)
+			SourcePath = argv[i + 1];
+	}
+
+	auto Keys = ToolUtils::ReadSourceKeys(SourcePath);
+
+	// Same setup as the hooks: initial load of the database and its overlays, then a watcher that copies the files on change
+	TranslationStore Store;
+	std::unique_ptr<TranslationStack> Stack(new TranslationStack());
+	if (Stack->Load(DatabasePath, false))
+		Store.Publish(std::move(Stack));
+
+	Store.StartWatching(DatabasePath, 100, 1000);
+
+	// Readers hammer the store the way the game threads do, dereferencing every value they get
+	std::atomic<bool> Stop(false);
+	std::atomic<uint64_t> Lookups(0);
+	std::vector<std::thread> Readers;
+
+	for (uint32_t i = 0; i < ReaderCount; i++)
+	{
+		Readers.push_back(std::thread([&Store, &Keys, &Stop, &Lookups, i]()
+		{
+			uint64_t Local = 0, Checksum = 0;
+			size_t Index = i;
+
+			while (!Stop.load(std::memory_order_relaxed) && !Keys.empty())
+			{
+				auto Value = Store.Acquire()->Find(Keys[Index % Keys.size()].c_str());
+				if (Value != nullptr)
+					Checksum += (uint8_t)Value[0];
+
+				Index += 7;
+				Local++;
+			}
+
+			Lookups.fetch_add(Local + (Checksum & 0), std::memory_order_relaxed);
+		}));
+	}
+
+	printf("Watching %s with %u readers, edit the file to reload...\n", DatabasePath.c_str(), ReaderCount);
+
+	uint32_t LastGeneration = Store.GetGeneration();
+	ToolUtils::Stopwatch Timer;
+
+	while (Seconds == 0 || Timer.ElapsedMilliseconds() < Seconds * 1000.0)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+		auto Generation = Store.GetGeneration();
+		if (Generation != LastGeneration)
+		{
+			printf("[%.2fs] generation %u: %u entries in %u layers\n", Timer.ElapsedMilliseconds() / 1000.0, Generation, Store.Acquire()->GetEntryCount(), Store.Acquire()->GetLayerCount());
+			LastGeneration = Generation;
+		}
+	}
+
+	Stop.store(true);
+	for (auto& Reader : Readers)
+		Reader.join();
+
+	Store.StopWatching(true);
+	printf("%llu lookups across %u generations\n", (unsigned long long)Lookups.load(), LastGeneration);
+
+	return 0;
+}
\ No newline at end of file
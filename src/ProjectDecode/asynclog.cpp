@@ -0,0 +1,214 @@
+#include "asynclog.h"
+
+// Standard includes
+#include <cstdarg>
+#include <cstring>
+
+// A line of the ring, the sequence tells producers and the flusher whose turn it is
+struct AsyncLogger::Slot
+{
+	std::atomic<uint32_t> Sequence;
+	uint32_t Length;
+	char Text[AsyncLogger::MaximumLineLength];
+};
+
+AsyncLogger::AsyncLogger()
+{
+	this->Enabled.store(false);
+	this->Capacity = 0;
+	this->EnqueuePosition.store(0);
+	this->DequeuePosition = 0;
+	this->Logged.store(0);
+	this->Dropped.store(0);
+	this->ReportedDropped = 0;
+	this->File = nullptr;
+	this->Echo = false;
+}
+
+AsyncLogger::~AsyncLogger()
+{
+	this->Stop(true);
+}
+
+bool AsyncLogger::Start(const std::string& Path, uint32_t Capacity, uint32_t FlushMilliseconds, bool Echo)
+{
+	if (this->Enabled.load() || this->Flusher.IsRunning())
+		return false;
+
+	this->File = fopen(Path.c_str(), "w");
+	if (this->File == nullptr)
+		return false;
+
+	// The ring lives as long as the logger, a producer may still be finishing a line of the previous session
+	if (this->Slots == nullptr)
+	{
+		this->Capacity = 2;
+		while (this->Capacity < Capacity && this->Capacity < (1u << 24))
+			this->Capacity <<= 1;
+
+		this->Slots.reset(new Slot[this->Capacity]);
+		for (uint32_t i = 0; i < this->Capacity; i++)
+			this->Slots[i].Sequence.store(i, std::memory_order_relaxed);
+	}
+
+	this->Echo = Echo;
+	this->Logged.store(0);
+	this->Dropped.store(0);
+	this->ReportedDropped = 0;
+	this->Batch.reserve((size_t)this->Capacity * 64);
+
+	this->Enabled.store(true);
+	this->Flusher.Start([this]() { this->Drain(); }, FlushMilliseconds);
+
+	return true;
+}
+
+void AsyncLogger::Stop(bool Wait)
+{
+	if (!this->Enabled.exchange(false))
+		return;
+
+	// The rest is written here, the flusher may not get to run again when the process is exiting
+	this->Flusher.Stop(Wait, [this]()
+	{
+		this->Drain();
+
+		fclose(this->File);
+		this->File = nullptr;
+	});
+}
+
+void AsyncLogger::Drain()
+{
+	this->Batch.clear();
+
+	// Stops at the first line that isn't published yet, it's picked up by the next drain
+	while (true)
+	{
+		auto& Target = this->Slots[this->DequeuePosition & (this->Capacity - 1)];
+		auto Sequence = Target.Sequence.load(std::memory_order_acquire);
+
+		if ((int32_t)(Sequence - (this->DequeuePosition + 1)) < 0)
+			break;
+
+		this->Batch.append(Target.Text, Target.Length);
+
+		// Hands the slot back to producers one lap later
+		Target.Sequence.store(this->DequeuePosition + this->Capacity, std::memory_order_release);
+		this->DequeuePosition++;
+	}
+
+	auto Dropped = this->Dropped.load(std::memory_order_relaxed);
+	if (Dropped != this->ReportedDropped)
+	{
+		char Line[96];
+		auto Length = snprintf(Line, sizeof(Line), "Logger: dropped %llu lines, the ring was full\n", (unsigned long long)(Dropped - this->ReportedDropped));
+
+		this->Batch.append(Line, (size_t)Length);
+		this->ReportedDropped = Dropped;
+	}
+
+	if (this->Batch.empty())
+		return;
+
+	fwrite(this->Batch.data(), 1, this->Batch.size(), this->File);
+	fflush(this->File);
+
+	if (this->Echo)
+	{
+		fwrite(this->Batch.data(), 1, this->Batch.size(), stdout);
+		fflush(stdout);
+	}
+}
+
+AsyncLogger::Slot* AsyncLogger::Claim(uint32_t& Position)
+{
+	Position = this->EnqueuePosition.load(std::memory_order_relaxed);
+
+	while (true)
+	{
+		auto& Target = this->Slots[Position & (this->Capacity - 1)];
+		auto Sequence = Target.Sequence.load(std::memory_order_acquire);
+		auto Difference = (int32_t)(Sequence - Position);
+
+		if (Difference == 0)
+		{
+			// Free for this lap, on failure the position is reloaded for us
+			if (this->EnqueuePosition.compare_exchange_weak(Position, Position + 1, std::memory_order_relaxed))
+				return &Target;
+		}
+		else if (Difference < 0)
+		{
+			// The flusher hasn't drained this slot from the previous lap, we never wait for it
+			this->Dropped.fetch_add(1, std::memory_order_relaxed);
+			return nullptr;
+		}
+		else
+		{
+			Position = this->EnqueuePosition.load(std::memory_order_relaxed);
+		}
+	}
+}
+
+void AsyncLogger::Publish(Slot* Target, uint32_t Position, size_t Length)
+{
+	Target->Length = (uint32_t)Length;
+	Target->Sequence.store(Position + 1, std::memory_order_release);
+
+	this->Logged.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool AsyncLogger::Log(const char* Format, ...)
+{
+	if (!this->IsEnabled())
+		return false;
+
+	uint32_t Position = 0;
+	auto Target = this->Claim(Position);
+	if (Target == nullptr)
+		return false;
+
+	va_list Arguments;
+	va_start(Arguments, Format);
+	auto Length = vsnprintf(Target->Text, MaximumLineLength, Format, Arguments);
+	va_end(Arguments);
+
+	// Cut lines still end the line
+	if (Length < 0)
+		Length = 0;
+	else if ((size_t)Length >= MaximumLineLength)
+	{
+		Length = (int)MaximumLineLength;
+		Target->Text[Length - 1] = '\n';
+	}
+
+	this->Publish(Target, Position, (size_t)Length);
+	return true;
+}
+
+bool AsyncLogger::Write(const char* Text, size_t Length)
+{
+	if (!this->IsEnabled())
+		return false;
+
+	uint32_t Position = 0;
+	auto Target = this->Claim(Position);
+	if (Target == nullptr)
+		return false;
+
+	Length = (Length < MaximumLineLength) ? Length : MaximumLineLength;
+	std::memcpy(Target->Text, Text, Length);
+
+	this->Publish(Target, Position, Length);
+	return true;
+}
+
+uint64_t AsyncLogger::GetLoggedCount() const
+{
+	return this->Logged.load(std::memory_order_relaxed);
+}
+
+uint64_t AsyncLogger::GetDroppedCount() const
+{
+	return this->Dropped.load(std::memory_order_relaxed);
+}
\ No newline at end of file
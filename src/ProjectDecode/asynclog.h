@@ -0,0 +1,81 @@
+#pragma once
+
+// Standard includes
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <atomic>
+#include <memory>
+#include <string>
+
+// Our includes
+#include "backgroundwriter.h"
+
+//
+// A logger the hooks can call from game threads without ever blocking them.
+// Lines are formatted straight into a slot of a bounded multi-producer ring, claimed with a single compare exchange.
+// A flusher thread drains the ring in batches and writes each batch with one call, when the ring is full lines are
+// dropped and counted instead, the count is written to the log with the next batch.
+//
+
+class AsyncLogger
+{
+private:
+	struct Slot;
+
+	std::atomic<bool> Enabled;
+	std::unique_ptr<Slot[]> Slots;
+	uint32_t Capacity;
+
+	// Producers claim positions here, the flusher is the only consumer
+	alignas(64) std::atomic<uint32_t> EnqueuePosition;
+	alignas(64) uint32_t DequeuePosition;
+	std::atomic<uint64_t> Logged;
+	std::atomic<uint64_t> Dropped;
+	uint64_t ReportedDropped;
+
+	// Only used by the flusher, or by stopping once the flusher is done
+	FILE* File;
+	bool Echo;
+	std::string Batch;
+	BackgroundWriter Flusher;
+
+	// Drains every published line into the batch and writes it
+	void Drain();
+	// Claims a slot, nullptr when the ring is full
+	Slot* Claim(uint32_t& Position);
+	// Publishes a claimed slot to the flusher
+	void Publish(Slot* Target, uint32_t Position, size_t Length);
+
+public:
+	AsyncLogger();
+	~AsyncLogger();
+
+	AsyncLogger(const AsyncLogger&) = delete;
+	AsyncLogger& operator=(const AsyncLogger&) = delete;
+
+	// Starts logging to a new file, the capacity is rounded up to a power of two lines, echo also writes every batch to stdout
+	bool Start(const std::string& Path, uint32_t Capacity, uint32_t FlushMilliseconds, bool Echo);
+	// Stops logging, writing every logged line. When not waiting nothing is waited on (required under the loader lock),
+	// the last lines are dropped if the flusher was cut off in the middle of writing
+	void Stop(bool Wait);
+
+	// Whether or not lines are being logged, cheap enough to check on every hook call
+	bool IsEnabled() const
+	{
+		return this->Enabled.load(std::memory_order_relaxed);
+	}
+
+	// Logs a printf formatted line, lines longer than a slot are cut, false if it was dropped
+	bool Log(const char* Format, ...);
+	// Logs a line of text as is
+	bool Write(const char* Text, size_t Length);
+
+	// Gets the amount of lines logged so far
+	uint64_t GetLoggedCount() const;
+	// Gets the amount of lines dropped because the ring was full
+	uint64_t GetDroppedCount() const;
+
+	// The longest line a slot holds, newline included
+	static const size_t MaximumLineLength = 248;
+};
\ No newline at end of file
@@ -0,0 +1,103 @@
+// The class we are implementing
+#include "backgroundwriter.h"
+
+// Standard includes
+#include <chrono>
+
+BackgroundWriter::BackgroundWriter()
+{
+	this->Generation.store(0);
+	this->WakeRequested.store(false);
+}
+
+BackgroundWriter::~BackgroundWriter()
+{
+	if (this->Thread.joinable())
+		this->Stop(true, nullptr);
+}
+
+bool BackgroundWriter::Start(std::function<void()> Work, uint32_t IntervalMilliseconds)
+{
+	if (this->Thread.joinable())
+		return false;
+
+	// A thread detached by an earlier stop may still be around, it never runs the new work
+	std::lock_guard<std::mutex> WorkGuard(this->WorkLock);
+
+	this->Work = std::move(Work);
+	this->WakeRequested.store(false);
+	this->Thread = std::thread(&BackgroundWriter::Loop, this, this->Generation.fetch_add(1) + 1, (IntervalMilliseconds > 0) ? IntervalMilliseconds : 1);
+
+	return true;
+}
+
+bool BackgroundWriter::Stop(bool Wait, const std::function<void()>& Final)
+{
+	if (!this->Thread.joinable())
+		return false;
+
+	// Bumped before taking the work lock, so a thread that gets the lock after us sees it and runs nothing
+	this->Generation.fetch_add(1);
+
+	if (Wait)
+	{
+		// Taken once, so the thread is either waiting already or sees the stop before it does
+		{
+			std::lock_guard<std::mutex> Guard(this->Lock);
+		}
+
+		this->Signal.notify_all();
+		this->Thread.join();
+
+		if (Final)
+			Final();
+
+		return true;
+	}
+
+	// The thread may have died holding either lock, a missed wake up only costs it an interval
+	if (this->Lock.try_lock())
+		this->Lock.unlock();
+
+	this->Signal.notify_all();
+	this->Thread.detach();
+
+	if (!this->WorkLock.try_lock())
+		return false;
+
+	if (Final)
+		Final();
+
+	this->WorkLock.unlock();
+	return true;
+}
+
+void BackgroundWriter::Wake()
+{
+	this->WakeRequested.store(true, std::memory_order_release);
+	this->Signal.notify_one();
+}
+
+bool BackgroundWriter::IsRunning() const
+{
+	return this->Thread.joinable();
+}
+
+void BackgroundWriter::Loop(uint32_t Started, uint32_t IntervalMilliseconds)
+{
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> Guard(this->Lock);
+			this->Signal.wait_for(Guard, std::chrono::milliseconds(IntervalMilliseconds), [this, Started]() { return this->Generation.load() != Started || this->WakeRequested.load(); });
+		}
+
+		this->WakeRequested.store(false, std::memory_order_relaxed);
+
+		std::lock_guard<std::mutex> WorkGuard(this->WorkLock);
+		if (this->Generation.load() != Started)
+			return;
+
+		this->Work();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+
+// Standard includes
+#include <cstdint>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+//
+// A background thread that runs a unit of work every interval, or sooner when woken, shared by the writers of
+// the hooks. Stopping runs the work one last time on the stopping thread. Under the loader lock nothing may be
+// waited on: ExitProcess kills threads wherever they are without releasing their locks, so when the writer was
+// cut off in the middle of its work the last run is skipped and whatever it had left is dropped.
+//
+
+class BackgroundWriter
+{
+private:
+	std::function<void()> Work;
+
+	// Held while the work runs, on either thread
+	std::mutex WorkLock;
+
+	// Wakes the thread early, the interval still bounds a missed wake up
+	std::mutex Lock;
+	std::condition_variable Signal;
+	// Bumped by every start and stop, a thread runs for as long as it's the one it started with
+	std::atomic<uint32_t> Generation;
+	std::atomic<bool> WakeRequested;
+	std::thread Thread;
+
+	// The thread loop, runs the work every interval until stopped
+	void Loop(uint32_t Started, uint32_t IntervalMilliseconds);
+
+public:
+	BackgroundWriter();
+	~BackgroundWriter();
+
+	BackgroundWriter(const BackgroundWriter&) = delete;
+	BackgroundWriter& operator=(const BackgroundWriter&) = delete;
+
+	// Starts running the work every interval on a new thread
+	bool Start(std::function<void()> Work, uint32_t IntervalMilliseconds);
+	// Stops the thread and runs the final work, once nothing else runs. When not waiting the thread is detached and
+	// nothing is waited on (required under the loader lock), false when the final work was skipped because of it
+	bool Stop(bool Wait, const std::function<void()>& Final);
+
+	// Runs the work soon, never blocks, safe to call from game threads
+	void Wake();
+
+	// Whether or not the thread was started and not stopped yet
+	bool IsRunning() const;
+};
\ No newline at end of file
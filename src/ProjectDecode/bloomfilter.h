@@ -0,0 +1,65 @@
+#pragma once
+
+// Standard includes
+#include <cstdint>
+#include <cstddef>
+
+//
+// Split block bloom filter over 64bit key hashes, used to reject keys the database doesn't have.
+// Each key maps to one 32 byte block and sets one bit in each of its 8 words, so a query reads a
+// single cache line. The filter works on raw blocks, so it can be queried straight from a mapping.
+//
+
+namespace BloomFilter
+{
+	// Words per block, one bit is set in each
+	static const uint32_t BlockWords = 8;
+	// Size of a block in bytes
+	static const uint32_t BlockSize = BlockWords * sizeof(uint32_t);
+
+	// Odd multipliers that pick the bit of each word
+	static const uint32_t Salts[BlockWords] =
+	{
+		0x47B6137Bu, 0x44974D91u, 0x8824AD5Bu, 0xA2B7289Du,
+		0x705495C7u, 0x2DF1424Bu, 0x9EFC4947u, 0x5C6BFB31u,
+	};
+
+	// Gets the amount of blocks for a key count at a given amount of bits per key
+	inline uint32_t GetBlockCount(uint32_t KeyCount, uint32_t BitsPerKey)
+	{
+		auto Bits = (uint64_t)KeyCount * BitsPerKey;
+		auto Blocks = (Bits + (BlockSize * 8) - 1) / (BlockSize * 8);
+
+		return (uint32_t)((Blocks > 0) ? Blocks : 1);
+	}
+
+	// Maps the upper half of a hash onto [0, BlockCount) without a division
+	inline uint32_t GetBlockIndex(uint64_t Hash, uint32_t BlockCount)
+	{
+		return (uint32_t)(((Hash >> 32) * BlockCount) >> 32);
+	}
+
+	// Adds a key hash to the filter
+	inline void Insert(uint32_t* Blocks, uint32_t BlockCount, uint64_t Hash)
+	{
+		auto Block = Blocks + ((size_t)GetBlockIndex(Hash, BlockCount) * BlockWords);
+		auto Key = (uint32_t)Hash;
+
+		for (uint32_t i = 0; i < BlockWords; i++)
+			Block[i] |= 1u << ((Key * Salts[i]) >> 27);
+	}
+
+	// Whether or not a key hash may be in the filter, false means it's definitely absent
+	inline bool MayContain(const uint32_t* Blocks, uint32_t BlockCount, uint64_t Hash)
+	{
+		auto Block = Blocks + ((size_t)GetBlockIndex(Hash, BlockCount) * BlockWords);
+		auto Key = (uint32_t)Hash;
+
+		// Fold every word without branching, the loop vectorizes
+		uint32_t Missing = 0;
+		for (uint32_t i = 0; i < BlockWords; i++)
+			Missing |= ~Block[i] & (1u << ((Key * Salts[i]) >> 27));
+
+		return (Missing == 0);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,210 @@
+// Platform includes
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#include <emmintrin.h>
+#define BYTESCAN_SSE2 1
+#else
+#define BYTESCAN_SSE2 0
+#endif
+
+// The class we are implementing
+#include "bytescan.h"
+
+#if BYTESCAN_SSE2
+
+// Gets the index of the lowest set bit of a non zero mask
+static uint32_t LowestBit(uint32_t Mask)
+{
+#ifdef _MSC_VER
+	unsigned long Index = 0;
+	_BitScanForward(&Index, Mask);
+	return (uint32_t)Index;
+#else
+	return (uint32_t)__builtin_ctz(Mask);
+#endif
+}
+
+const uint8_t* ByteScan::Find(const uint8_t* Data, const uint8_t* End, uint8_t Value)
+{
+	// Scalar until aligned, so every vector load stays inside an aligned block
+	while (Data < End && ((uintptr_t)Data & 15) != 0)
+	{
+		if (*Data == Value)
+			return Data;
+		Data++;
+	}
+
+	auto Needle = _mm_set1_epi8((char)Value);
+
+	while (End - Data >= 16)
+	{
+		auto Block = _mm_load_si128((const __m128i*)Data);
+		auto Mask = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(Block, Needle));
+
+		if (Mask != 0)
+			return Data + LowestBit(Mask);
+
+		Data += 16;
+	}
+
+	while (Data < End)
+	{
+		if (*Data == Value)
+			return Data;
+		Data++;
+	}
+
+	return nullptr;
+}
+
+const uint8_t* ByteScan::FindNonAscii(const uint8_t* Data, const uint8_t* End)
+{
+	while (Data < End && ((uintptr_t)Data & 15) != 0)
+	{
+		if (*Data >= 0x80)
+			return Data;
+		Data++;
+	}
+
+	// The mask is the high bit of every byte, no compare needed
+	while (End - Data >= 16)
+	{
+		auto Mask = (uint32_t)_mm_movemask_epi8(_mm_load_si128((const __m128i*)Data));
+
+		if (Mask != 0)
+			return Data + LowestBit(Mask);
+
+		Data += 16;
+	}
+
+	while (Data < End)
+	{
+		if (*Data >= 0x80)
+			return Data;
+		Data++;
+	}
+
+	return nullptr;
+}
+
+void ByteScan::FindAll(const uint8_t* Data, const uint8_t* End, uint8_t First, uint8_t Second, std::vector<uint32_t>& Offsets)
+{
+	auto Cursor = Data;
+
+	while (Cursor < End && ((uintptr_t)Cursor & 15) != 0)
+	{
+		if (*Cursor == First || *Cursor == Second)
+			Offsets.push_back((uint32_t)(Cursor - Data));
+		Cursor++;
+	}
+
+	auto FirstNeedle = _mm_set1_epi8((char)First);
+	auto SecondNeedle = _mm_set1_epi8((char)Second);
+
+	// Every block turns into a bit mask of matches, emitted lowest bit first
+	while (End - Cursor >= 16)
+	{
+		auto Block = _mm_load_si128((const __m128i*)Cursor);
+		auto Matches = _mm_or_si128(_mm_cmpeq_epi8(Block, FirstNeedle), _mm_cmpeq_epi8(Block, SecondNeedle));
+		auto Mask = (uint32_t)_mm_movemask_epi8(Matches);
+		auto Base = (uint32_t)(Cursor - Data);
+
+		while (Mask != 0)
+		{
+			Offsets.push_back(Base + LowestBit(Mask));
+			Mask &= Mask - 1;
+		}
+
+		Cursor += 16;
+	}
+
+	while (Cursor < End)
+	{
+		if (*Cursor == First || *Cursor == Second)
+			Offsets.push_back((uint32_t)(Cursor - Data));
+		Cursor++;
+	}
+}
+
+size_t ByteScan::Count(const uint8_t* Data, const uint8_t* End, uint8_t Value)
+{
+	size_t Result = 0;
+
+	while (Data < End && ((uintptr_t)Data & 15) != 0)
+		Result += (*Data++ == Value) ? 1 : 0;
+
+	auto Needle = _mm_set1_epi8((char)Value);
+	auto Zero = _mm_setzero_si128();
+
+	while (End - Data >= 16)
+	{
+		// Byte counters overflow after 255 blocks, so fold them every 255
+		auto Blocks = (size_t)(End - Data) / 16;
+		if (Blocks > 255)
+			Blocks = 255;
+
+		auto Counters = _mm_setzero_si128();
+		for (size_t i = 0; i < Blocks; i++)
+		{
+			auto Block = _mm_load_si128((const __m128i*)Data);
+			// Matches are -1, so subtracting counts them
+			Counters = _mm_sub_epi8(Counters, _mm_cmpeq_epi8(Block, Needle));
+			Data += 16;
+		}
+
+		auto Sums = _mm_sad_epu8(Counters, Zero);
+		Result += (size_t)_mm_cvtsi128_si32(Sums) + (size_t)_mm_cvtsi128_si32(_mm_srli_si128(Sums, 8));
+	}
+
+	while (Data < End)
+		Result += (*Data++ == Value) ? 1 : 0;
+
+	return Result;
+}
+
+#else
+
+const uint8_t* ByteScan::Find(const uint8_t* Data, const uint8_t* End, uint8_t Value)
+{
+	for (; Data < End; Data++)
+	{
+		if (*Data == Value)
+			return Data;
+	}
+
+	return nullptr;
+}
+
+const uint8_t* ByteScan::FindNonAscii(const uint8_t* Data, const uint8_t* End)
+{
+	for (; Data < End; Data++)
+	{
+		if (*Data >= 0x80)
+			return Data;
+	}
+
+	return nullptr;
+}
+
+void ByteScan::FindAll(const uint8_t* Data, const uint8_t* End, uint8_t First, uint8_t Second, std::vector<uint32_t>& Offsets)
+{
+	for (auto Cursor = Data; Cursor < End; Cursor++)
+	{
+		if (*Cursor == First || *Cursor == Second)
+			Offsets.push_back((uint32_t)(Cursor - Data));
+	}
+}
+
+size_t ByteScan::Count(const uint8_t* Data, const uint8_t* End, uint8_t Value)
+{
+	size_t Result = 0;
+
+	for (; Data < End; Data++)
+		Result += (*Data == Value) ? 1 : 0;
+
+	return Result;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,22 @@
+#pragma once
+
+// Standard includes
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+//
+// Vectorized byte scanning (SSE2 with a scalar fallback), used to find record delimiters
+//
+
+namespace ByteScan
+{
+	// Finds the first occurrence of a byte in [Data, End), nullptr if not found
+	const uint8_t* Find(const uint8_t* Data, const uint8_t* End, uint8_t Value);
+	// Finds the first byte at or above 0x80 in [Data, End), nullptr if it is all ascii
+	const uint8_t* FindNonAscii(const uint8_t* Data, const uint8_t* End);
+	// Appends the offset (from Data) of every occurrence of either byte in [Data, End), in order
+	void FindAll(const uint8_t* Data, const uint8_t* End, uint8_t First, uint8_t Second, std::vector<uint32_t>& Offsets);
+	// Counts the occurrences of a byte in [Data, End)
+	size_t Count(const uint8_t* Data, const uint8_t* End, uint8_t Value);
+}
\ No newline at end of file
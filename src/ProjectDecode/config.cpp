@@ -0,0 +1,88 @@
+// Standard includes
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+// The class we are implementing
+#include "config.h"
+
+// Trims whitespace from both ends of a string
+static std::string Trim(const std::string& Value)
+{
+	auto Start = Value.find_first_not_of(" \t\r\n");
+	if (Start == std::string::npos)
+		return "";
+
+	auto End = Value.find_last_not_of(" \t\r\n");
+	return Value.substr(Start, End - Start + 1);
+}
+
+// Lowercases an ascii string
+static std::string ToLower(std::string Value)
+{
+	std::transform(Value.begin(), Value.end(), Value.begin(), [](char ch) { return (ch >= 'A' && ch <= 'Z') ? (char)(ch + ('a' - 'A')) : ch; });
+	return Value;
+}
+
+DecodeConfig::DecodeConfig()
+{
+}
+
+DecodeConfig::~DecodeConfig()
+{
+}
+
+bool DecodeConfig::Load(const std::string& Path)
+{
+	auto Handle = fopen(Path.c_str(), "r");
+	if (Handle == nullptr)
+		return false;
+
+	char Line[1024];
+	while (fgets(Line, sizeof(Line), Handle) != nullptr)
+	{
+		auto Text = Trim(Line);
+
+		// Skip comments, sections and blank lines
+		if (Text.empty() || Text[0] == '#' || Text[0] == ';' || Text[0] == '[')
+			continue;
+
+		auto Split = Text.find('=');
+		if (Split == std::string::npos)
+			continue;
+
+		// Keys are case insensitive
+		this->Values[ToLower(Trim(Text.substr(0, Split)))] = Trim(Text.substr(Split + 1));
+	}
+
+	fclose(Handle);
+	return true;
+}
+
+std::string DecodeConfig::GetString(const std::string& Key, const std::string& Default) const
+{
+	auto Value = this->Values.find(ToLower(Key));
+	if (Value == this->Values.end())
+		return Default;
+
+	return Value->second;
+}
+
+bool DecodeConfig::GetBool(const std::string& Key, bool Default) const
+{
+	auto Value = this->Values.find(ToLower(Key));
+	if (Value == this->Values.end())
+		return Default;
+
+	auto Setting = ToLower(Value->second);
+	return (Setting == "1" || Setting == "true" || Setting == "yes" || Setting == "on");
+}
+
+uint32_t DecodeConfig::GetInteger(const std::string& Key, uint32_t Default) const
+{
+	auto Value = this->Values.find(ToLower(Key));
+	if (Value == this->Values.end() || Value->second.empty())
+		return Default;
+
+	return (uint32_t)strtoul(Value->second.c_str(), nullptr, 10);
+}
\ No newline at end of file
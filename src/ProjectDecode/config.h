@@ -0,0 +1,27 @@
+#pragma once
+
+// Standard includes
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+// Runtime settings, read from a key=value ini file next to the executable
+class DecodeConfig
+{
+private:
+	std::unordered_map<std::string, std::string> Values;
+
+public:
+	DecodeConfig();
+	~DecodeConfig();
+
+	// Loads the settings from the given file, missing files leave every setting at its default
+	bool Load(const std::string& Path);
+
+	// Gets a setting as a string
+	std::string GetString(const std::string& Key, const std::string& Default) const;
+	// Gets a setting as a boolean (1, true, yes, on)
+	bool GetBool(const std::string& Key, bool Default) const;
+	// Gets a setting as an unsigned integer
+	uint32_t GetInteger(const std::string& Key, uint32_t Default) const;
+};
\ No newline at end of file
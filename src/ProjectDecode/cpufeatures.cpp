@@ -0,0 +1,115 @@
+// Platform includes
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#define CPUFEATURES_X86 1
+#else
+#define CPUFEATURES_X86 0
+#endif
+
+// The class we are implementing
+#include "cpufeatures.h"
+
+// Standard includes
+#include <atomic>
+
+// The cap set by tools, the highest level by default
+static std::atomic<uint32_t> LevelLimit(CPU_LEVEL_AVX2);
+
+#if CPUFEATURES_X86
+
+// Runs cpuid for a leaf, zeros when the leaf isn't supported
+static void ReadCpuid(uint32_t Leaf, uint32_t Registers[4])
+{
+#ifdef _MSC_VER
+	int Info[4];
+	__cpuid(Info, 0);
+
+	if ((uint32_t)Info[0] < Leaf)
+	{
+		Registers[0] = Registers[1] = Registers[2] = Registers[3] = 0;
+		return;
+	}
+
+	__cpuidex(Info, (int)Leaf, 0);
+	for (uint32_t i = 0; i < 4; i++)
+		Registers[i] = (uint32_t)Info[i];
+#else
+	if (!__get_cpuid_count(Leaf, 0, &Registers[0], &Registers[1], &Registers[2], &Registers[3]))
+		Registers[0] = Registers[1] = Registers[2] = Registers[3] = 0;
+#endif
+}
+
+// Reads the OS enabled state components, only valid when OSXSAVE is set
+static uint64_t ReadXcr0()
+{
+#ifdef _MSC_VER
+	return (uint64_t)_xgetbv(0);
+#else
+	uint32_t Low = 0, High = 0;
+	__asm__ volatile("xgetbv" : "=a"(Low), "=d"(High) : "c"(0));
+	return ((uint64_t)High << 32) | Low;
+#endif
+}
+
+static CpuLevel DetectLevel()
+{
+	uint32_t Features[4], Extended[4];
+	ReadCpuid(1, Features);
+	ReadCpuid(7, Extended);
+
+	if ((Features[3] & (1u << 26)) == 0)
+		return CPU_LEVEL_SCALAR;
+	if ((Features[2] & (1u << 9)) == 0)
+		return CPU_LEVEL_SSE2;
+
+	// Avx2 also needs the OS to save the upper halves of the registers
+	auto OsSaves = (Features[2] & (1u << 27)) != 0 && (Features[2] & (1u << 28)) != 0 && (ReadXcr0() & 6) == 6;
+	if (OsSaves && (Extended[1] & (1u << 5)) != 0)
+		return CPU_LEVEL_AVX2;
+
+	return CPU_LEVEL_SSSE3;
+}
+
+#else
+
+static CpuLevel DetectLevel()
+{
+	return CPU_LEVEL_SCALAR;
+}
+
+#endif
+
+CpuLevel CpuFeatures::GetSupportedLevel()
+{
+	static const CpuLevel Supported = DetectLevel();
+	return Supported;
+}
+
+CpuLevel CpuFeatures::GetLevel()
+{
+	auto Supported = GetSupportedLevel();
+	auto Limit = (CpuLevel)LevelLimit.load(std::memory_order_relaxed);
+
+	return (Limit < Supported) ? Limit : Supported;
+}
+
+void CpuFeatures::SetLevelLimit(CpuLevel Limit)
+{
+	LevelLimit.store(Limit, std::memory_order_relaxed);
+}
+
+const char* CpuFeatures::GetLevelName(CpuLevel Level)
+{
+	switch (Level)
+	{
+	case CPU_LEVEL_SCALAR: return "scalar";
+	case CPU_LEVEL_SSE2: return "sse2";
+	case CPU_LEVEL_SSSE3: return "ssse3";
+	case CPU_LEVEL_AVX2: return "avx2";
+	default: return "unknown";
+	}
+}
\ No newline at end of file
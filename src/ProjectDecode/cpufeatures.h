@@ -0,0 +1,30 @@
+#pragma once
+
+// Standard includes
+#include <cstdint>
+
+//
+// Instruction set detection for the vectorized paths, checked once and cached. Tools can cap the level
+// to measure or compare the slower paths on the same machine.
+//
+
+enum CpuLevel : uint32_t
+{
+	CPU_LEVEL_SCALAR,		// No vector instructions, or not an x86 build
+	CPU_LEVEL_SSE2,			// Baseline for every x86 target we build
+	CPU_LEVEL_SSSE3,		// Adds byte shuffles
+	CPU_LEVEL_AVX2,			// 256 bit integer vectors, with the OS saving their state
+};
+
+namespace CpuFeatures
+{
+	// Gets the best level this processor supports
+	CpuLevel GetSupportedLevel();
+	// Gets the level the vectorized paths should use, the supported level unless capped
+	CpuLevel GetLevel();
+	// Caps the level the vectorized paths use, levels above the supported one are ignored
+	void SetLevelLimit(CpuLevel Limit);
+
+	// Gets the name of a level
+	const char* GetLevelName(CpuLevel Level);
+}
\ No newline at end of file
@@ -1,9 +1,26 @@
 #include "decode.h"
 #include "utils.h"
 #include "phook.h"
-
-// Our loaded translation mappings
-std::unordered_map<std::string, std::string> TranslationDatabase;
+#include "translationdb.h"
+#include "translationstack.h"
+#include "translationstore.h"
+#include "translate.h"
+#include "stringcache.h"
+#include "keytrace.h"
+#include "asynclog.h"
+#include "hookmetrics.h"
+#include "missingkeys.h"
+#include "unicode.h"
+#include "config.h"
+#include "parallel.h"
+#include "sitecache.h"
+
+// Our loaded translation mappings, swapped atomically when hot reloading
+TranslationStore Translations;
+// Results for the reference pointers the engine keeps passing us
+StringReferenceCache StringReferences;
+// Every key the hooks are asked for, when enabled
+KeyTraceRecorder KeyTrace;
 
 // Our proc definitions
 typedef char*(__thiscall *SE_GetStringProc)(const char* StringReferenceText);
@@ -17,14 +34,19 @@ DB_FindXAssetHeaderProc DB_FindXAssetHeader;
 TranslateInfoTranslateProc TranslateInfoTranslate;
 TranslateInfoSetResultProc TranslateInfoSetResult;
 
-// Logging instance
-#if LOGGER_MODE
-FILE* LoggerHandle = NULL;
-#endif
+// Logging instance, enabled at runtime with Logging=1
+AsyncLogger Logger;
+// Hook counters and timings, read from shared memory with d3tool metrics
+HookMetrics Metrics;
+// Every distinct key we didn't have, written as a source file to merge
+MissingKeyCollector MissingKeys;
 
 // Our function hooks
 char* __cdecl SEH_StringEd_GetStringHook(const char* StringReferenceText)
 {
+	// Time the whole call, by the path it takes
+	auto Started = Metrics.Begin();
+
 	// Strip the @ modifier
 	char* StrReference = (char*)StringReferenceText;
 	if (*StringReferenceText == '@')
@@ -32,17 +54,25 @@ char* __cdecl SEH_StringEd_GetStringHook(const char* StringReferenceText)
 		StrReference = (char*)(StringReferenceText + 1);
 	}
 
-	// Here, we can perform our translation swapping...
-	if (TranslationDatabase.find(StrReference) != TranslationDatabase.end())
+	// Here, we can perform our translation swapping, repeated references are served from the cache...
+	auto Translated = TranslateStringReference(StringReferences, Translations, StringReferenceText);
+
+	// Record the key as it was passed to us
+	if (KeyTrace.IsRecording())
+		KeyTrace.RecordStringReference(StringReferenceText, Translated != nullptr);
+
+	if (Translated != nullptr)
 	{
 		// We found it, use this one...
-		return (char*)TranslationDatabase[StrReference].c_str();
+		Metrics.End(HOOKMETRIC_STRINGED_TRANSLATED, Started);
+		return (char*)Translated;
 	}
 
 	// Else, find an existing one...
 	char* Result = (char*)StringReferenceText;
 
 	// Perform engine localized string overriding first
+	auto Path = HOOKMETRIC_STRINGED_ENGINE;
 	Result = SE_GetString(StrReference);
 	if (!Result)
 	{
@@ -51,123 +81,184 @@ char* __cdecl SEH_StringEd_GetStringHook(const char* StringReferenceText)
 		if (Header)
 		{
 			Result = (char*)*Header;
+			Path = HOOKMETRIC_STRINGED_ASSET;
 		}
 		else
 		{
 			Result = (char*)StringReferenceText;
+			Path = HOOKMETRIC_STRINGED_UNRESOLVED;
 		}
 	}
 
-	// Log the key and value if not read
-#if LOGGER_MODE
-	if (StringReferenceText && Result)
+	// Collect the key with what the game showed instead, a key seen before costs one lookup
+	if (MissingKeys.IsEnabled())
+		MissingKeys.RecordStringReference(StrReference, Result);
+
+	// Log the key and value if not read, the line is written off this thread
+	if (Logger.IsEnabled() && StringReferenceText && Result)
 	{
-		fprintf(LoggerHandle, "%s : %s\n", StringReferenceText, Result);
+		Logger.Log("%s : %s\n", StringReferenceText, Result);
 	}
-#endif
 
 	// Return the result
+	Metrics.End(Path, Started);
 	return Result;
 }
 
 int __stdcall Scaleform_TranslateSetResultHook(DWORD* TranslateInfo)
 {
-	// Convert it
-	auto WideKeyStr = std::wstring((const wchar_t*)TranslateInfo[0]);
-	auto KeyStr = Utils::WideStringToString(WideKeyStr);
-	auto KeyFind = std::string(KeyStr);
+	// Time the whole call, by the path it takes
+	auto Started = Metrics.Begin();
 
-	// Strip the @ modifier
-	if (KeyStr.size() > 2 && KeyStr[0] == '@')
+	// Check for a match, the key is looked up as utf16 and the value is already utf16
+	uint32_t ResultLength = 0;
+	auto Translated = TranslateScaleformKey(*Translations.Acquire(), (const uint16_t*)TranslateInfo[0], ResultLength);
+
+	// Record the key as it was passed to us
+	if (KeyTrace.IsRecording())
+		KeyTrace.RecordScaleformKey((const uint16_t*)TranslateInfo[0], Translated != nullptr);
+
+	if (Translated != nullptr)
 	{
-		KeyFind = KeyStr.substr(1);
+		// Apply the translation, with its length so the engine doesn't measure it
+		auto Applied = TranslateInfoSetResult(TranslateInfo, (const wchar_t*)Translated, (int)ResultLength);
+
+		Metrics.End(HOOKMETRIC_SCALEFORM_TRANSLATED, Started);
+		return Applied;
 	}
 
-	// Check for a match...
-	if (TranslationDatabase.find(KeyFind) != TranslationDatabase.end())
+	// Collect the key, a key seen before costs one lookup
+	if (MissingKeys.IsEnabled())
+		MissingKeys.RecordScaleformKey((const uint16_t*)TranslateInfo[0]);
+
+	// Log the key if we didn't get it, converted on the stack so the game thread never allocates
+	if (Logger.IsEnabled())
 	{
-		try
-		{
-			// Load this one
-			auto ResultLoad = Utils::StringToWideString(TranslationDatabase[KeyFind]);
-			// Apply the converted translation
-			return TranslateInfoSetResult(TranslateInfo, ResultLoad.c_str(), -1);
-		}
-		catch (...)
-		{
-			// Default
-			return TranslateInfoTranslate(TranslateInfo);
-		}
-	}
+		auto Key = (const uint16_t*)TranslateInfo[0];
+		size_t KeyLength = 0;
+		while (KeyLength < AsyncLogger::MaximumLineLength && Key[KeyLength] != 0)
+			KeyLength++;
 
-	// Log the key if we didn't get it
-#if LOGGER_MODE
-	fprintf(LoggerHandle, "%s\n", KeyStr.c_str());
-#endif
+		char Line[AsyncLogger::MaximumLineLength];
+		auto LineLength = Unicode::Utf16ToUtf8(Key, KeyLength, Line, sizeof(Line) - 1);
+		Line[LineLength++] = '\n';
+
+		Logger.Write(Line, LineLength);
+	}
 
 	// Default...
-	return TranslateInfoTranslate(TranslateInfo);
+	auto Result = TranslateInfoTranslate(TranslateInfo);
+
+	Metrics.End(HOOKMETRIC_SCALEFORM_ENGINE, Started);
+	return Result;
 }
 
-void DecodeLoadTranslations(MainModule& AppModule)
+void DecodeLoadTranslations(MainModule& AppModule, const DecodeConfig& Config)
 {
 	// We load the translations next to the application
-	auto DbPath = Utils::CombinePath(Utils::GetDirectoryName(AppModule.GetModulePath()), "TranslationsDB.db");
+	auto AppDirectory = Utils::GetDirectoryName(AppModule.GetModulePath());
+	auto DbPath = Utils::CombinePath(AppDirectory, "TranslationsDB.db");
 
-	// Load the database if the user was smart enough to copy it
-	if (Utils::FileExists(DbPath))
+	// Hot reload keeps the files writable, so the databases are copied instead of mapped
+	auto HotReload = Config.GetBool("HotReload", false);
+	auto Stack = std::make_unique<TranslationStack>();
+
+	// Load the database if the user was smart enough to copy it, plus any TranslationsDB.*.db overlays on top of it, v2 files are mapped in place, v1 files are converted.
+	// A TranslationsDB.delta next to it is applied first, so an update only has to ship what changed
+	if (Utils::FileExists(DbPath) && Stack->Load(DbPath, !HotReload))
 	{
-		auto Db = fopen(DbPath.c_str(), "rb");
+		// Log entries loaded
+		for (uint32_t i = 0; i < Stack->GetLayerCount(); i++)
+			Logger.Log("Loaded: %d translation entries from %s (%s)\n", Stack->GetLayer(i).GetEntryCount(), Stack->GetLayerPath(i).c_str(), Stack->GetLayer(i).IsPatched() ? "patched" : (Stack->GetLayer(i).IsMapped() ? "mapped" : "copied"));
 
-		if (Db)
-		{
-			//
-			// Simple format <uint32_t> entry count X null-term utf8-string KVP
-			//
+		Logger.Log("Loaded: %d distinct translation entries across %d layers\n", Stack->GetEntryCount(), Stack->GetLayerCount());
 
-			uint32_t Entries = 0;
-			fread(&Entries, 4, 1, Db);
+		Translations.Publish(std::move(Stack));
+	}
+	else
+	{
+		// Log failure to find database
+		Logger.Log("No database file found...\n");
+	}
 
-			for (uint32_t i = 0; i < Entries; i++)
-			{
-				auto Key = Utils::ReadNullString(Db);
-				auto Value = Utils::ReadNullString(Db);
+	// Record every requested key for replaying with d3tool, the writes happen off the game threads
+	if (Config.GetBool("TraceKeys", false))
+	{
+		auto TracePath = Config.GetString("TracePath", Utils::CombinePath(AppDirectory, "D3code.d3trace"));
+		auto Started = KeyTrace.Start(TracePath);
 
-				TranslationDatabase[Key] = Value;
-			}
+		Logger.Log("Key trace %s: %s\n", Started ? "recording to" : "failed to open", TracePath.c_str());
+	}
 
-			// Log entries loaded
-#if LOGGER_MODE
-			printf("Loaded: %d translation entries\n", Entries);
-#endif
-		}
+	// Collect the keys we don't have, into a file in the source format
+	if (Config.GetBool("CollectMissing", false))
+	{
+		auto MissingPath = Config.GetString("MissingPath", Utils::CombinePath(AppDirectory, "D3code_missing.txt"));
+		auto Started = MissingKeys.Start(MissingPath, Config.GetInteger("MissingCapacity", 65536), Config.GetInteger("MissingFlushInterval", 1000));
 
-		fclose(Db);
+		Logger.Log("Missing keys %s: %s\n", Started ? "collected to" : "failed to open", MissingPath.c_str());
 	}
-	else
+
+	// Watch for changes, the files may also show up later
+	if (HotReload)
 	{
-		// Log failure to find database
-#if LOGGER_MODE
-		printf("No database file found...\n");
-#endif
+		// Anything shorter would poll the disk in a loop, 0 wouldn't sleep at all
+		const uint32_t MinimumMilliseconds = 50;
+		auto PollMilliseconds = Config.GetInteger("HotReloadInterval", 500);
+		auto GraceMilliseconds = Config.GetInteger("HotReloadGracePeriod", 30000);
+
+		Translations.StartWatching(DbPath, (PollMilliseconds < MinimumMilliseconds) ? MinimumMilliseconds : PollMilliseconds, (GraceMilliseconds < MinimumMilliseconds) ? MinimumMilliseconds : GraceMilliseconds);
+
+		Logger.Log("Hot reload enabled for: %s\n", DbPath.c_str());
 	}
 }
 
-void DecodeApplyPatches(MainModule& AppModule)
+// Reads the vtable ScaleformTranslate loads at +0x24, as an offset from the module base
+static bool ReadScaleformVTable(MainModule& AppModule, uint32_t ScaleformTranslate, uint32_t& VTable)
 {
-	// We must apply the hooks here, only after the patterns are found
-	auto SEHTranslate = FindPattern("55 8B EC 83 E4 ? A1 ? ? ? ? 56 57 85 C0", AppModule.GetBaseAddress(), AppModule.GetCodeSize());
-	auto ScaleformTranslate = FindPattern("8B 50 ?? 33 F6 56 6A ?? FF D2 3B C6 74", AppModule.GetBaseAddress(), AppModule.GetCodeSize());
-	auto DBFindFAssetHeaderFunc = FindPattern("55 8B EC 83 E4 ? 83 EC ? 53 56 57 C7 44 24 ? ? ? ? ? 80 3D ? ? ? ? ?", AppModule.GetBaseAddress(), AppModule.GetCodeSize());
-	auto SEGetStringFunc = FindPattern("55 8B EC 83 EC ? 53 56 BE ? ? ? ? 2B CE", AppModule.GetBaseAddress(), AppModule.GetCodeSize());
-	auto ScaleformTranslateSetInfo = FindPattern("55 8B EC 8B 45 ? 56 8B F1 85 C0 74 ? 53", AppModule.GetBaseAddress(), AppModule.GetCodeSize());
+	if ((uintptr_t)ScaleformTranslate + 0x28 > AppModule.GetCodeSize())
+		return false;
+
+	VTable = *(uint32_t*)((char*)(ScaleformTranslate + AppModule.GetBaseAddress()) + 0x24) - (uint32_t)AppModule.GetBaseAddress();
+	return true;
+}
+
+void DecodeApplyPatches(MainModule& AppModule, const DecodeConfig& Config)
+{
+	// We must apply the hooks here, only after the patterns are found, all in one pass over the code split across workers
+	MultiPatternScan Signatures;
+	auto SEHTranslateId = Signatures.Add(CompilePattern("55 8B EC 83 E4 ? A1 ? ? ? ? 56 57 85 C0").GetView());
+	auto ScaleformTranslateId = Signatures.Add(CompilePattern("8B 50 ?? 33 F6 56 6A ?? FF D2 3B C6 74").GetView());
+	auto DBFindFAssetHeaderId = Signatures.Add(CompilePattern("55 8B EC 83 E4 ? 83 EC ? 53 56 57 C7 44 24 ? ? ? ? ? 80 3D ? ? ? ? ?").GetView());
+	auto SEGetStringId = Signatures.Add(CompilePattern("55 8B EC 83 EC ? 53 56 BE ? ? ? ? 2B CE").GetView());
+	auto ScaleformTranslateSetInfoId = Signatures.Add(CompilePattern("55 8B EC 8B 45 ? 56 8B F1 85 C0 74 ? 53").GetView());
+
+	// Sites found by an earlier launch of the same executable are checked against the signatures instead of scanning for them,
+	// the vtable ScaleformTranslate loads must also still be the cached one
+	auto Image = (const uint8_t*)AppModule.GetBaseAddress();
+	auto UseCache = Config.GetBool("SiteCache", true);
+	SiteCache Cache(Config.GetString("SiteCachePath", Utils::CombinePath(Utils::GetDirectoryName(AppModule.GetModulePath()), "D3code.sites")), Image, AppModule.GetCodeSize(), Signatures);
+
+	std::vector<uint32_t> Sites, Extras;
+	uint32_t CachedVTable = 0;
+	auto Cached = UseCache && Cache.Load(Signatures, Image, AppModule.GetCodeSize(), Sites, Extras) && Extras.size() == 1 && ReadScaleformVTable(AppModule, Sites[ScaleformTranslateId], CachedVTable) && CachedVTable == Extras[0];
+
+	std::vector<intptr_t> Offsets(Sites.begin(), Sites.end());
+	if (!Cached)
+		Signatures.ScanFirst(AppModule.GetBaseAddress(), AppModule.GetCodeSize(), Offsets, Parallel::GetWorkerCount());
+
+	Logger.Log("Signature sites: %s\n", Cached ? "cached" : "scanned");
+
+	auto SEHTranslate = Offsets[SEHTranslateId];
+	auto ScaleformTranslate = Offsets[ScaleformTranslateId];
+	auto DBFindFAssetHeaderFunc = Offsets[DBFindFAssetHeaderId];
+	auto SEGetStringFunc = Offsets[SEGetStringId];
+	auto ScaleformTranslateSetInfo = Offsets[ScaleformTranslateSetInfoId];
 
 	// Log initial patterns
-#if LOGGER_MODE
-	printf("SEHTranslate: 0x%X\nScaleformTranslate: 0x%X\n", SEHTranslate, ScaleformTranslate);
-	printf("DBFindFAssetHeaderFunc: 0x%X\nSEGetStringFunc: 0x%X\n", DBFindFAssetHeaderFunc, SEGetStringFunc);
-	printf("ScaleformTranslateSetInfo: 0x%X\n", ScaleformTranslateSetInfo);
-#endif
+	Logger.Log("SEHTranslate: 0x%X\nScaleformTranslate: 0x%X\n", SEHTranslate, ScaleformTranslate);
+	Logger.Log("DBFindFAssetHeaderFunc: 0x%X\nSEGetStringFunc: 0x%X\n", DBFindFAssetHeaderFunc, SEGetStringFunc);
+	Logger.Log("ScaleformTranslateSetInfo: 0x%X\n", ScaleformTranslateSetInfo);
 
 	// Continue if all were found
 	if (SEHTranslate > 0 && ScaleformTranslate > 0 && DBFindFAssetHeaderFunc > 0 && SEGetStringFunc > 0 && ScaleformTranslateSetInfo > 0)
@@ -187,10 +278,8 @@ void DecodeApplyPatches(MainModule& AppModule)
 		uint32_t ScaleformTranslateInfoAddr = *((uint32_t*)ScaleformTranslateVTable + 2);
 		
 		// Log heuristic info
-#if LOGGER_MODE
-		printf("SE_GetStringAddr: 0x%X\nDB_FindXAssetHeaderAddr: 0x%X\n", SE_GetStringAddr, DB_FindXAssetHeaderAddr);
-		printf("ScaleformTranslateVTable: 0x%X\nScaleformTranslateInfoAddr: 0x%X\n", ScaleformTranslateVTable, ScaleformTranslateInfoAddr);
-#endif
+		Logger.Log("SE_GetStringAddr: 0x%X\nDB_FindXAssetHeaderAddr: 0x%X\n", SE_GetStringAddr, DB_FindXAssetHeaderAddr);
+		Logger.Log("ScaleformTranslateVTable: 0x%X\nScaleformTranslateInfoAddr: 0x%X\n", ScaleformTranslateVTable, ScaleformTranslateInfoAddr);
 
 		// Resolve info function
 		auto TranslateSetInfoProc = (ScaleformTranslateSetInfo + AppModule.GetBaseAddress());
@@ -200,9 +289,16 @@ void DecodeApplyPatches(MainModule& AppModule)
 		TranslateInfoSetResult = (TranslateInfoSetResultProc)TranslateSetInfoProc;
 
 		// Log other info
-#if LOGGER_MODE
-		printf("TranslateSetInfoProc: 0x%X\n", TranslateSetInfoProc);
-#endif
+		Logger.Log("TranslateSetInfoProc: 0x%X\n", TranslateSetInfoProc);
+
+		// Every site was found, keep them for the next launch
+		if (UseCache && !Cached)
+		{
+			Sites.assign(Offsets.begin(), Offsets.end());
+			Extras.assign(1, (uint32_t)(ScaleformTranslateVTable - AppModule.GetBaseAddress()));
+
+			Logger.Log("Signature sites %s\n", Cache.Save(Sites, Extras) ? "saved" : "failed to save");
+		}
 
 		// If we got here, we can apply the hooks
 		JumpHook().Hook(SEHTranslateProc, (uintptr_t)&SEH_StringEd_GetStringHook);
@@ -218,26 +314,45 @@ DWORD WINAPI DecodeInitialize(LPVOID lpParam)
 	// Ensure that we are the main game
 	if (Utils::HasEnding(ApplicationModule.GetModulePath(), "codomp_client_shipretail.exe"))
 	{
-		// Setup logger
-#if LOGGER_MODE
-		AllocConsole();
-		freopen_s((FILE**)stdout, "CONOUT$", "w", stdout);
-		LoggerHandle = fopen("C:\\decodelog.txt", "w");
-#endif
+		// Load the settings next to the application
+		auto AppDirectory = Utils::GetDirectoryName(ApplicationModule.GetModulePath());
+
+		DecodeConfig Config;
+		Config.Load(Utils::CombinePath(AppDirectory, "D3code.ini"));
+
+		// Setup logger, lines are queued by the hooks and written by a background thread
+		if (Config.GetBool("Logging", false))
+		{
+			auto Console = Config.GetBool("LogConsole", false);
+			if (Console)
+			{
+				AllocConsole();
+				freopen_s((FILE**)stdout, "CONOUT$", "w", stdout);
+			}
+
+			Logger.Start(Config.GetString("LogPath", Utils::CombinePath(AppDirectory, "decodelog.txt")), Config.GetInteger("LogCapacity", 16384), Config.GetInteger("LogFlushInterval", 50), Console);
+		}
+
+		// Count hook calls into shared memory, for d3tool metrics to read while the game runs
+		if (Config.GetBool("Metrics", false))
+		{
+			auto MetricsName = Config.GetString("MetricsName", HOOKMETRICS_DEFAULT_NAME);
+			auto Started = Metrics.Start(MetricsName, Config.GetInteger("MetricsThreads", 64));
+
+			Logger.Log("Hook metrics %s: %s\n", Started ? "published as" : "failed to create", MetricsName.c_str());
+		}
 
 		// Load translation database
-		DecodeLoadTranslations(ApplicationModule);
+		DecodeLoadTranslations(ApplicationModule, Config);
 
 		// We must prepare the module, but, apply patches after the window loads (Unpacked)
 		while (FindWindow(L"CODO", NULL) == NULL) Sleep(1);
 
 		// Attempt to apply patches
-		DecodeApplyPatches(ApplicationModule);
+		DecodeApplyPatches(ApplicationModule, Config);
 
 		// Log end
-#if LOGGER_MODE
-		printf("Initialize has finished, see decodelog.txt for translating...\n");
-#endif
+		Logger.Log("Initialize has finished, see decodelog.txt for translating...\n");
 	}
 
 	// Success
@@ -246,10 +361,19 @@ DWORD WINAPI DecodeInitialize(LPVOID lpParam)
 
 void WINAPI DecodeShutdown()
 {
-	// Close logger
-#if LOGGER_MODE
-	if (LoggerHandle != NULL)
-		fclose(LoggerHandle);
-	FreeConsole();
-#endif
+	// Called under the loader lock, the watcher and writers can't be joined here
+	Translations.StopWatching(false);
+	KeyTrace.Stop(false);
+	MissingKeys.Stop(false);
+	Metrics.Stop();
+
+	// Close logger, the remaining lines are written here
+	if (Logger.IsEnabled())
+	{
+		Logger.Log("String reference cache: %u hits, %u misses\n", StringReferences.GetHits(), StringReferences.GetMisses());
+		Logger.Log("Logger: %llu lines logged, %llu dropped\n", (unsigned long long)Logger.GetLoggedCount(), (unsigned long long)Logger.GetDroppedCount());
+		Logger.Stop(false);
+
+		FreeConsole();
+	}
 }
\ No newline at end of file
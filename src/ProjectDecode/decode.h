@@ -5,9 +5,6 @@
 #include <unordered_map>
 #include <string>
 
-// Log all key requests
-#define LOGGER_MODE 0
-
 // The entry point for D3code logic
 DWORD WINAPI DecodeInitialize(LPVOID lpParam);
 // Shutdown the api
@@ -0,0 +1,89 @@
+// The class we are implementing
+#include "gbk.h"
+
+// Standard includes
+#include <cstring>
+
+// Our includes
+#include "bytescan.h"
+
+// Generated in gbktable.cpp
+extern const uint16_t GbkDoubleByteTable[126 * 191];
+
+uint32_t Gbk::DecodePair(uint8_t Lead, uint8_t Trail)
+{
+	// Lead bytes are 0x81-0xFE, trail bytes 0x40-0xFE without 0x7F
+	if (Lead < 0x81 || Lead == 0xFF || Trail < 0x40 || Trail == 0x7F || Trail == 0xFF)
+		return 0;
+
+	return GbkDoubleByteTable[(uint32_t)(Lead - 0x81) * 191 + (uint32_t)(Trail - 0x40)];
+}
+
+size_t Gbk::ToUtf8(const char* Data, size_t Length, char* Result)
+{
+	auto Cursor = (const uint8_t*)Data;
+	auto End = Cursor + Length;
+	auto Output = (uint8_t*)Result;
+
+	while (Cursor < End)
+	{
+		// Ascii is the same in both, copied a run at a time
+		auto Run = ByteScan::FindNonAscii(Cursor, End);
+		if (Run == nullptr)
+			Run = End;
+
+		std::memcpy(Output, Cursor, (size_t)(Run - Cursor));
+		Output += Run - Cursor;
+		Cursor = Run;
+
+		// Then characters until the next ascii byte
+		while (Cursor < End && *Cursor >= 0x80)
+		{
+			uint32_t CodePoint = 0;
+
+			if (*Cursor == 0x80)
+			{
+				// The only single byte character above ascii, U+20AC
+				CodePoint = 0x20AC;
+				Cursor++;
+			}
+			else if (End - Cursor >= 2 && (CodePoint = DecodePair(Cursor[0], Cursor[1])) != 0)
+			{
+				Cursor += 2;
+			}
+			else
+			{
+				*Output++ = '?';
+				Cursor++;
+				continue;
+			}
+
+			// Every mapped character is in the basic plane and above ascii
+			if (CodePoint < 0x800)
+			{
+				Output[0] = (uint8_t)(0xC0 | (CodePoint >> 6));
+				Output[1] = (uint8_t)(0x80 | (CodePoint & 0x3F));
+				Output += 2;
+			}
+			else
+			{
+				Output[0] = (uint8_t)(0xE0 | (CodePoint >> 12));
+				Output[1] = (uint8_t)(0x80 | ((CodePoint >> 6) & 0x3F));
+				Output[2] = (uint8_t)(0x80 | (CodePoint & 0x3F));
+				Output += 3;
+			}
+		}
+	}
+
+	return (size_t)(Output - (uint8_t*)Result);
+}
+
+std::string Gbk::ToUtf8(const std::string& Text)
+{
+	std::string Result(GetUtf8Bound(Text.size()), '\0');
+	if (Result.empty())
+		return Result;
+
+	Result.resize(ToUtf8(Text.data(), Text.size(), &Result[0]));
+	return Result;
+}
\ No newline at end of file
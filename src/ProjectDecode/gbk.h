@@ -0,0 +1,30 @@
+#pragma once
+
+// Standard includes
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+//
+// The engine's codepage (GBK, windows 936) decoded with our own table, so the tools read game dumps the
+// same way on every platform without iconv or MultiByteToWideChar. Ascii runs are skipped with ByteScan.
+//
+
+namespace Gbk
+{
+	// Gets the most utf8 bytes a GBK string of a length can decode to
+	inline size_t GetUtf8Bound(size_t Length)
+	{
+		// The euro sign is one byte in and three out, a pair is never more than three
+		return Length * 3;
+	}
+
+	// Decodes GBK to utf8, the result must hold GetUtf8Bound(Length) bytes, returns the amount written.
+	// A byte that doesn't start a mapped character becomes '?', and the next one is decoded on its own
+	size_t ToUtf8(const char* Data, size_t Length, char* Result);
+	// Decodes GBK to utf8
+	std::string ToUtf8(const std::string& Text);
+
+	// Gets the code point of a double byte character, zero if the pair isn't mapped
+	uint32_t DecodePair(uint8_t Lead, uint8_t Trail);
+}
\ No newline at end of file
@@ -0,0 +1,165 @@
+#pragma once
+
+// Standard includes
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+namespace Hashing
+{
+	// FNV-1a 64bit offset basis and prime
+	static const uint64_t Fnv1aOffsetBasis = 0xCBF29CE484222325ull;
+	static const uint64_t Fnv1aPrime = 0x100000001B3ull;
+
+	// Feeds a single byte into a FNV-1a 64bit hash
+	inline uint64_t Fnv1a64Update(uint64_t Hash, uint8_t Byte)
+	{
+		return (Hash ^ Byte) * Fnv1aPrime;
+	}
+
+	// Hashes a block of bytes using FNV-1a 64bit
+	inline uint64_t Fnv1a64(const void* Data, size_t Length)
+	{
+		auto Bytes = (const uint8_t*)Data;
+		uint64_t Result = Fnv1aOffsetBasis;
+
+		for (size_t i = 0; i < Length; i++)
+			Result = Fnv1a64Update(Result, Bytes[i]);
+
+		return Result;
+	}
+
+	// Final avalanche step (murmur3 fmix64), used to derive table positions from a hash
+	inline uint64_t Mix64(uint64_t Value)
+	{
+		Value ^= Value >> 33;
+		Value *= 0xFF51AFD7ED558CCDull;
+		Value ^= Value >> 33;
+		Value *= 0xC4CEB9FE1A85EC53ull;
+		Value ^= Value >> 33;
+
+		return Value;
+	}
+
+	//
+	// Hash policies for the database, the id is stored in the file so lookups know which one built it.
+	// Keys are either hashed as a block or streamed a byte at a time (when decoding utf16), both must agree.
+	//
+
+	// Identifiers of the hash policies
+	enum HashId : uint32_t
+	{
+		HashFnv1a = 0,
+		HashWordMix = 1,
+	};
+
+	// FNV-1a 64bit, the original database hash
+	struct Fnv1a
+	{
+		static const uint32_t Id = HashFnv1a;
+		// Byte at a time either way, so null-term keys are hashed while they're measured
+		static const bool StreamsBytes = true;
+
+		struct State
+		{
+			uint64_t Hash;
+		};
+
+		static State Begin()
+		{
+			State Result = { Fnv1aOffsetBasis };
+			return Result;
+		}
+
+		static void Update(State& Current, uint8_t Byte)
+		{
+			Current.Hash = Fnv1a64Update(Current.Hash, Byte);
+		}
+
+		static uint64_t Finish(const State& Current, size_t)
+		{
+			return Current.Hash;
+		}
+
+		static uint64_t Hash(const void* Data, size_t Length)
+		{
+			return Fnv1a64(Data, Length);
+		}
+	};
+
+	// Word at a time multiply-xorshift hash with a final avalanche, reads 8 bytes per step instead of 1.
+	// A plain rotate-multiply step (FxHash) isn't enough, differences in the top byte of one word cancel against the next
+	struct WordMix
+	{
+		static const uint32_t Id = HashWordMix;
+		// Streaming packs words a byte at a time, null-term keys are faster measured first
+		static const bool StreamsBytes = false;
+		static const uint64_t Multiplier = 0x9E3779B97F4A7C15ull;
+
+		struct State
+		{
+			uint64_t Hash;
+			uint64_t Word;
+			uint32_t WordBytes;
+		};
+
+		static uint64_t Absorb(uint64_t Hash, uint64_t Word)
+		{
+			Hash = (Hash ^ Word) * Multiplier;
+			return Hash ^ (Hash >> 32);
+		}
+
+		static State Begin()
+		{
+			State Result = { 0, 0, 0 };
+			return Result;
+		}
+
+		static void Update(State& Current, uint8_t Byte)
+		{
+			Current.Word |= (uint64_t)Byte << (Current.WordBytes * 8);
+
+			if (++Current.WordBytes == sizeof(uint64_t))
+			{
+				Current.Hash = Absorb(Current.Hash, Current.Word);
+				Current.Word = 0;
+				Current.WordBytes = 0;
+			}
+		}
+
+		static uint64_t Finish(const State& Current, size_t Length)
+		{
+			auto Result = Current.Hash;
+			if (Current.WordBytes != 0)
+				Result = Absorb(Result, Current.Word);
+
+			return Mix64(Result ^ Length);
+		}
+
+		static uint64_t Hash(const void* Data, size_t Length)
+		{
+			auto Bytes = (const uint8_t*)Data;
+			uint64_t Result = 0;
+			size_t i = 0;
+
+			// Little-endian words, the tail is packed the same way Update does
+			for (; i + sizeof(uint64_t) <= Length; i += sizeof(uint64_t))
+			{
+				uint64_t Word;
+				std::memcpy(&Word, Bytes + i, sizeof(Word));
+				Result = Absorb(Result, Word);
+			}
+
+			if (i < Length)
+			{
+				uint64_t Word = 0;
+				for (uint32_t Shift = 0; i < Length; i++, Shift += 8)
+					Word |= (uint64_t)Bytes[i] << Shift;
+
+				Result = Absorb(Result, Word);
+			}
+
+			return Mix64(Result ^ Length);
+		}
+	};
+}
\ No newline at end of file
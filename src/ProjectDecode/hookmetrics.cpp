@@ -0,0 +1,201 @@
+// Platform includes
+#ifdef _WIN32
+#include <Windows.h>
+#include <intrin.h>
+#else
+#include <unistd.h>
+#include <x86intrin.h>
+#endif
+
+// The class we are implementing
+#include "hookmetrics.h"
+
+// Standard includes
+#include <cstring>
+#include <chrono>
+#include <functional>
+#include <thread>
+
+// How long the cycle counter is measured against the clock
+static const uint32_t CalibrationMilliseconds = 20;
+
+// Gets the histogram bucket of a call, the bit width of its cycles
+static uint32_t GetBucket(uint64_t Cycles)
+{
+	if (Cycles >= (1ull << (HOOKMETRICS_BUCKETS - 2)))
+		return HOOKMETRICS_BUCKETS - 1;
+	if (Cycles == 0)
+		return 0;
+
+#ifdef _MSC_VER
+	unsigned long Index = 0;
+	_BitScanReverse(&Index, (unsigned long)Cycles);
+	return (uint32_t)Index + 1;
+#else
+	return 32 - (uint32_t)__builtin_clz((uint32_t)Cycles);
+#endif
+}
+
+// Bumps a counter only this thread writes, without a locked instruction
+static void Bump(std::atomic<uint32_t>& Counter)
+{
+	Counter.store(Counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+HookMetrics::HookMetrics()
+{
+	this->Header = nullptr;
+	this->Threads = nullptr;
+	this->Enabled.store(false);
+}
+
+HookMetrics::~HookMetrics()
+{
+	this->Stop();
+}
+
+bool HookMetrics::Start(const std::string& Name, uint32_t ThreadCapacity)
+{
+	// The block is only ever created once, threads keep pointers into it
+	if (this->Header != nullptr)
+		return false;
+
+	ThreadCapacity = (ThreadCapacity > 0) ? ThreadCapacity : 1;
+
+	if (!this->Block.Create(Name, sizeof(HookMetricsHeader) + (size_t)ThreadCapacity * sizeof(HookMetricsThread)))
+		return false;
+
+	// Measure the cycle counter, so readers can show times
+	auto ClockStart = std::chrono::steady_clock::now();
+	auto CyclesStart = ReadCycles();
+	std::this_thread::sleep_for(std::chrono::milliseconds(CalibrationMilliseconds));
+	auto Cycles = ReadCycles() - CyclesStart;
+	auto Elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - ClockStart).count();
+
+	this->Header = (HookMetricsHeader*)this->Block.GetData();
+	this->Threads = (HookMetricsThread*)(this->Block.GetData() + sizeof(HookMetricsHeader));
+
+	this->Header->Magic = HOOKMETRICS_MAGIC;
+	this->Header->Version = HOOKMETRICS_VERSION;
+	this->Header->HeaderSize = (uint32_t)sizeof(HookMetricsHeader);
+	this->Header->ThreadBlockSize = (uint32_t)sizeof(HookMetricsThread);
+	this->Header->ThreadCapacity = ThreadCapacity;
+	this->Header->PathCount = HOOKMETRIC_PATH_COUNT;
+	this->Header->BucketCount = HOOKMETRICS_BUCKETS;
+#ifdef _WIN32
+	this->Header->ProcessId = (uint32_t)GetCurrentProcessId();
+#else
+	this->Header->ProcessId = (uint32_t)getpid();
+#endif
+	this->Header->CyclesPerSecond = (Elapsed > 0) ? (uint64_t)(((double)Cycles * 1000000000.0) / (double)Elapsed) : 0;
+	this->Header->ThreadCount.store(0);
+	this->Header->Enabled.store(1, std::memory_order_release);
+
+	this->Enabled.store(true);
+	return true;
+}
+
+void HookMetrics::Stop()
+{
+	if (!this->Enabled.exchange(false))
+		return;
+
+	this->Header->Enabled.store(0, std::memory_order_release);
+}
+
+void HookMetrics::End(HookMetricPath Path, uint64_t Started)
+{
+	if (Started == 0 || !this->IsEnabled())
+		return;
+
+	auto Cycles = ReadCycles() - Started;
+	auto& Counters = this->GetThreadBlock()->Paths[Path];
+
+	Bump(Counters.Calls);
+	Bump(Counters.Buckets[GetBucket(Cycles)]);
+}
+
+HookMetricsThread* HookMetrics::GetThreadBlock()
+{
+	// Cached per thread, there's only ever one metrics block per process
+	static thread_local const HookMetrics* CachedOwner = nullptr;
+	static thread_local HookMetricsThread* CachedBlock = nullptr;
+
+	if (CachedOwner == this)
+		return CachedBlock;
+
+	// Threads past the capacity share the last block and may lose increments
+	auto Index = this->Header->ThreadCount.fetch_add(1);
+	if (Index >= this->Header->ThreadCapacity)
+		Index = this->Header->ThreadCapacity - 1;
+
+	auto Block = &this->Threads[Index];
+
+#ifdef _WIN32
+	Block->ThreadId.store((uint32_t)GetCurrentThreadId(), std::memory_order_relaxed);
+#else
+	Block->ThreadId.store((uint32_t)std::hash<std::thread::id>()(std::this_thread::get_id()), std::memory_order_relaxed);
+#endif
+
+	CachedOwner = this;
+	CachedBlock = Block;
+
+	return Block;
+}
+
+uint64_t HookMetrics::ReadCycles()
+{
+	return (uint64_t)__rdtsc();
+}
+
+bool HookMetrics::Aggregate(const uint8_t* Data, size_t Size, HookMetricsSnapshot& Result)
+{
+	std::memset(&Result, 0, sizeof(Result));
+
+	if (Data == nullptr || Size < sizeof(HookMetricsHeader))
+		return false;
+
+	auto Header = (const HookMetricsHeader*)Data;
+	if (Header->Magic != HOOKMETRICS_MAGIC || Header->Version != HOOKMETRICS_VERSION || Header->HeaderSize != sizeof(HookMetricsHeader) || Header->ThreadBlockSize != sizeof(HookMetricsThread) ||
+		Header->PathCount != HOOKMETRIC_PATH_COUNT || Header->BucketCount != HOOKMETRICS_BUCKETS || Header->ThreadCapacity == 0)
+		return false;
+
+	if ((Size - sizeof(HookMetricsHeader)) / sizeof(HookMetricsThread) < Header->ThreadCapacity)
+		return false;
+
+	Result.CyclesPerSecond = Header->CyclesPerSecond;
+	Result.ProcessId = Header->ProcessId;
+	Result.ThreadCount = Header->ThreadCount.load(std::memory_order_acquire);
+	Result.Enabled = (Header->Enabled.load(std::memory_order_acquire) != 0);
+
+	auto Threads = (const HookMetricsThread*)(Data + sizeof(HookMetricsHeader));
+	auto Used = (Result.ThreadCount < Header->ThreadCapacity) ? Result.ThreadCount : Header->ThreadCapacity;
+
+	for (uint32_t t = 0; t < Used; t++)
+	{
+		for (uint32_t p = 0; p < HOOKMETRIC_PATH_COUNT; p++)
+		{
+			auto& Counters = Threads[t].Paths[p];
+
+			Result.Calls[p] += Counters.Calls.load(std::memory_order_relaxed);
+			for (uint32_t b = 0; b < HOOKMETRICS_BUCKETS; b++)
+				Result.Buckets[p][b] += Counters.Buckets[b].load(std::memory_order_relaxed);
+		}
+	}
+
+	return true;
+}
+
+const char* HookMetrics::GetPathName(HookMetricPath Path)
+{
+	switch (Path)
+	{
+	case HOOKMETRIC_STRINGED_TRANSLATED: return "StringEd translated";
+	case HOOKMETRIC_STRINGED_ENGINE: return "StringEd SE_GetString";
+	case HOOKMETRIC_STRINGED_ASSET: return "StringEd DB_FindXAssetHeader";
+	case HOOKMETRIC_STRINGED_UNRESOLVED: return "StringEd unresolved";
+	case HOOKMETRIC_SCALEFORM_TRANSLATED: return "Scaleform translated";
+	case HOOKMETRIC_SCALEFORM_ENGINE: return "Scaleform engine";
+	default: return "unknown";
+	}
+}
\ No newline at end of file
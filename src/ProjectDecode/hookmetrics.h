@@ -0,0 +1,132 @@
+#pragma once
+
+// Standard includes
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <string>
+
+// Our includes
+#include "sharedmemory.h"
+
+//
+// Per thread hook counters and cycle histograms, living in a named shared memory block so a reader can watch a running game.
+//   HookMetricsHeader
+//   HookMetricsThread blocks, one per thread that called a hook, each on its own cache lines
+// A thread only ever writes its own block with plain relaxed stores, the reader sums the blocks when it wants a snapshot.
+// Counters are 32 bit so a 32 bit process never needs a locked 64 bit store, readers take deltas between samples.
+//
+
+// 'D3HM'
+#define HOOKMETRICS_MAGIC 0x4D483344
+#define HOOKMETRICS_VERSION 1
+
+// Histogram bucket N counts calls that took [2^(N-1), 2^N) cycles, the last bucket everything longer
+#define HOOKMETRICS_BUCKETS 32
+
+// Default name of the shared block
+#define HOOKMETRICS_DEFAULT_NAME "D3codeMetrics"
+
+// The paths a hook call can take
+enum HookMetricPath : uint32_t
+{
+	HOOKMETRIC_STRINGED_TRANSLATED,		// StringEd key found in the database
+	HOOKMETRIC_STRINGED_ENGINE,			// Fell through to SE_GetString
+	HOOKMETRIC_STRINGED_ASSET,			// Fell through to DB_FindXAssetHeader
+	HOOKMETRIC_STRINGED_UNRESOLVED,		// Nothing had it, the key itself was returned
+	HOOKMETRIC_SCALEFORM_TRANSLATED,	// Scaleform key found in the database
+	HOOKMETRIC_SCALEFORM_ENGINE,		// Fell through to the engine's translate
+	HOOKMETRIC_PATH_COUNT
+};
+
+// Alignment of thread blocks, so two threads never share a cache line
+#ifdef _MSC_VER
+#define HOOKMETRICS_ALIGN(Size) __declspec(align(Size))
+#else
+#define HOOKMETRICS_ALIGN(Size) __attribute__((aligned(Size)))
+#endif
+
+struct HOOKMETRICS_ALIGN(64) HookMetricsHeader
+{
+	uint32_t Magic;
+	uint32_t Version;
+	uint32_t HeaderSize;
+	uint32_t ThreadBlockSize;
+	uint32_t ThreadCapacity;
+	uint32_t PathCount;
+	uint32_t BucketCount;
+	uint32_t ProcessId;
+	uint64_t CyclesPerSecond;			// Measured when the block was created
+	std::atomic<uint32_t> ThreadCount;	// Blocks handed out so far, may exceed the capacity, the last block is then shared
+	std::atomic<uint32_t> Enabled;
+};
+
+struct HookMetricsPathCounters
+{
+	std::atomic<uint32_t> Calls;
+	std::atomic<uint32_t> Buckets[HOOKMETRICS_BUCKETS];
+};
+
+struct HOOKMETRICS_ALIGN(64) HookMetricsThread
+{
+	std::atomic<uint32_t> ThreadId;
+	HookMetricsPathCounters Paths[HOOKMETRIC_PATH_COUNT];
+};
+
+// Totals of every thread block at one point in time
+struct HookMetricsSnapshot
+{
+	uint64_t CyclesPerSecond;
+	uint32_t ProcessId;
+	uint32_t ThreadCount;
+	bool Enabled;
+	uint32_t Calls[HOOKMETRIC_PATH_COUNT];
+	uint32_t Buckets[HOOKMETRIC_PATH_COUNT][HOOKMETRICS_BUCKETS];
+};
+
+class HookMetrics
+{
+private:
+	SharedMemory Block;
+	HookMetricsHeader* Header;
+	HookMetricsThread* Threads;
+	std::atomic<bool> Enabled;
+
+	// Gets the calling thread's block, registering it on first use
+	HookMetricsThread* GetThreadBlock();
+
+	// Reads the cycle counter
+	static uint64_t ReadCycles();
+
+public:
+	HookMetrics();
+	~HookMetrics();
+
+	HookMetrics(const HookMetrics&) = delete;
+	HookMetrics& operator=(const HookMetrics&) = delete;
+
+	// Creates the named block with room for the given amount of threads and starts counting
+	bool Start(const std::string& Name, uint32_t ThreadCapacity);
+	// Stops counting, the block stays readable until the metrics are destroyed
+	void Stop();
+
+	// Whether or not calls are being counted
+	bool IsEnabled() const
+	{
+		return this->Enabled.load(std::memory_order_relaxed);
+	}
+
+	// Starts timing a hook call, 0 when not counting
+	uint64_t Begin() const
+	{
+		return this->IsEnabled() ? ReadCycles() : 0;
+	}
+
+	// Counts a hook call that took the given path, started by Begin
+	void End(HookMetricPath Path, uint64_t Started);
+
+	// Sums the thread blocks of a mapped metrics block, false if it isn't one
+	static bool Aggregate(const uint8_t* Data, size_t Size, HookMetricsSnapshot& Result);
+	// Gets the name of a path
+	static const char* GetPathName(HookMetricPath Path);
+};
\ No newline at end of file
@@ -0,0 +1,614 @@
+// Platform includes
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+
+// Standard includes
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <thread>
+#include <unordered_map>
+
+// The class we are implementing
+#include "keytrace.h"
+
+// Our includes
+#include "hashing.h"
+
+// Bytes of records a block holds before it's written out
+static const size_t BlockPayloadSize = 64 * 1024;
+// Keys a block defines at most, the intern table has twice as many slots
+static const uint32_t BlockKeys = 2048;
+static const uint32_t BlockTableSize = BlockKeys * 2;
+// Longest key recorded, longer ones are cut
+static const uint32_t MaximumKeyBytes = 1024;
+// Largest encoding of one record, ticks, flags, address, length and key
+static const size_t MaximumRecordSize = 10 + 1 + 10 + 5 + MaximumKeyBytes;
+// Yields stopping waits for a busy thread under the loader lock, a thread cut off by the process exiting never finishes
+static const uint32_t MaximumStopSpins = 10000;
+
+// Appends an unsigned LEB128 varint
+static void WriteVarint(std::vector<uint8_t>& Output, uint64_t Value)
+{
+	while (Value >= 0x80)
+	{
+		Output.push_back((uint8_t)(Value | 0x80));
+		Value >>= 7;
+	}
+
+	Output.push_back((uint8_t)Value);
+}
+
+// Reads an unsigned LEB128 varint, false if it runs past the end or over 64 bits
+static bool ReadVarint(const uint8_t*& Cursor, const uint8_t* End, uint64_t& Value)
+{
+	Value = 0;
+
+	for (uint32_t Shift = 0; Shift < 64; Shift += 7)
+	{
+		if (Cursor >= End)
+			return false;
+
+		auto Byte = *Cursor++;
+		Value |= (uint64_t)(Byte & 0x7F) << Shift;
+
+		if ((Byte & 0x80) == 0)
+			return true;
+	}
+
+	return false;
+}
+
+KeyTraceBlock::KeyTraceBlock()
+{
+	this->Reset(0);
+}
+
+void KeyTraceBlock::Reset(uint32_t ThreadId)
+{
+	KeyTraceBlockHeader Header;
+	std::memset(&Header, 0, sizeof(Header));
+	Header.ThreadId = ThreadId;
+
+	this->Data.clear();
+	this->Data.reserve(sizeof(Header) + BlockPayloadSize);
+	this->Data.insert(this->Data.end(), (const uint8_t*)&Header, (const uint8_t*)&Header + sizeof(Header));
+
+	this->RecordCount = 0;
+	this->LastTicks = 0;
+
+	// Room for every key a block defines, cleared vectors keep it, so adding records never allocates
+	this->Table.assign(BlockTableSize, 0);
+	this->KeyHashes.clear();
+	this->KeyHashes.reserve(BlockKeys);
+	this->KeyHooks.clear();
+	this->KeyHooks.reserve(BlockKeys);
+	this->KeyAddresses.clear();
+	this->KeyAddresses.reserve(BlockKeys);
+	this->KeyOffsets.clear();
+	this->KeyOffsets.reserve(BlockKeys);
+	this->KeyLengths.clear();
+	this->KeyLengths.reserve(BlockKeys);
+}
+
+bool KeyTraceBlock::Add(uint64_t Ticks, uint8_t Hook, uint64_t Address, const void* Key, uint32_t KeyBytes, bool Hit)
+{
+	if (this->Data.size() - sizeof(KeyTraceBlockHeader) + MaximumRecordSize > BlockPayloadSize)
+		return false;
+
+	// Cut long keys, utf16 keys on a code unit
+	KeyBytes = std::min(KeyBytes, MaximumKeyBytes);
+	if (Hook == KEYTRACE_HOOK_SCALEFORM)
+		KeyBytes &= ~1u;
+
+	auto Hash = Hashing::Mix64(Hashing::WordMix::Hash(Key, KeyBytes) ^ (Address * 0x9E3779B97F4A7C15ull) ^ Hook);
+	auto Slot = (uint32_t)Hash & (BlockTableSize - 1);
+	uint32_t Index = UINT32_MAX;
+
+	while (this->Table[Slot] != 0)
+	{
+		auto Candidate = this->Table[Slot] - 1;
+
+		if (this->KeyHashes[Candidate] == Hash && this->KeyHooks[Candidate] == Hook && this->KeyAddresses[Candidate] == Address && this->KeyLengths[Candidate] == KeyBytes &&
+			std::memcmp(this->Data.data() + this->KeyOffsets[Candidate], Key, KeyBytes) == 0)
+		{
+			Index = Candidate;
+			break;
+		}
+
+		Slot = (Slot + 1) & (BlockTableSize - 1);
+	}
+
+	if (Index == UINT32_MAX && this->KeyHashes.size() >= BlockKeys)
+		return false;
+
+	auto Header = (KeyTraceBlockHeader*)this->Data.data();
+	if (this->RecordCount == 0)
+	{
+		Header->FirstTicks = Ticks;
+		this->LastTicks = Ticks;
+	}
+
+	// Clocks of different cores may disagree by a little, records never go back in time
+	WriteVarint(this->Data, (Ticks > this->LastTicks) ? Ticks - this->LastTicks : 0);
+	this->LastTicks = std::max(Ticks, this->LastTicks);
+
+	auto Flags = (uint8_t)((Hook & KEYTRACE_FLAG_HOOK_MASK) | (Hit ? KEYTRACE_FLAG_HIT : 0));
+
+	if (Index != UINT32_MAX)
+	{
+		this->Data.push_back(Flags);
+		WriteVarint(this->Data, Index);
+	}
+	else
+	{
+		this->Data.push_back(Flags | KEYTRACE_FLAG_DEFINE);
+		WriteVarint(this->Data, Address);
+		WriteVarint(this->Data, KeyBytes);
+
+		this->Table[Slot] = (uint32_t)this->KeyHashes.size() + 1;
+		this->KeyHashes.push_back(Hash);
+		this->KeyHooks.push_back(Hook);
+		this->KeyAddresses.push_back(Address);
+		this->KeyOffsets.push_back((uint32_t)this->Data.size());
+		this->KeyLengths.push_back(KeyBytes);
+
+		this->Data.insert(this->Data.end(), (const uint8_t*)Key, (const uint8_t*)Key + KeyBytes);
+	}
+
+	// The header may have moved with the data
+	Header = (KeyTraceBlockHeader*)this->Data.data();
+	Header->RecordCount = ++this->RecordCount;
+	Header->PayloadSize = (uint32_t)(this->Data.size() - sizeof(KeyTraceBlockHeader));
+
+	return true;
+}
+
+bool KeyTraceBlock::IsEmpty() const
+{
+	return (this->RecordCount == 0);
+}
+
+void KeyTraceBlock::Take(std::vector<uint8_t>& Result)
+{
+	Result.swap(this->Data);
+	this->Data.clear();
+}
+
+// A thread's blocks, busy while the thread writes to them so stopping can wait for it. A filled block is swapped with
+// the spare, which the writer writes and hands back
+struct KeyTraceRecorder::ThreadBuffer
+{
+	std::atomic<bool> Busy;
+	std::atomic<bool> SpareFilled;
+	// Only written by the thread, 32bit so reading them takes no lock on 32bit targets
+	std::atomic<uint32_t> Records;
+	std::atomic<uint32_t> Dropped;
+	uint32_t ThreadId;
+	uint32_t Session;
+	KeyTraceBlock* Active;
+	KeyTraceBlock* Spare;
+	KeyTraceBlock Blocks[2];
+};
+
+KeyTraceRecorder::KeyTraceRecorder()
+{
+	this->Recording.store(false);
+	this->Session.store(0);
+	this->File = nullptr;
+}
+
+KeyTraceRecorder::~KeyTraceRecorder()
+{
+	this->Stop(true);
+}
+
+bool KeyTraceRecorder::Start(const std::string& Path)
+{
+	if (this->Recording.load() || this->Writer.IsRunning())
+		return false;
+
+	this->File = fopen(Path.c_str(), "wb");
+	if (this->File == nullptr)
+		return false;
+
+	std::vector<uint8_t> Header;
+	WriteHeader(Header, GetFrequency(), GetTicks());
+	fwrite(Header.data(), 1, Header.size(), this->File);
+
+	// Buffers of a previous recording are never reused, threads register again
+	this->Session.fetch_add(1);
+	this->Recording.store(true);
+
+	// Woken when a block fills, the interval only catches a missed wake up
+	this->Writer.Start([this]() { this->WriteFilled(); }, 100);
+
+	return true;
+}
+
+void KeyTraceRecorder::Stop(bool Wait)
+{
+	if (!this->Recording.exchange(false))
+		return;
+
+	// Skipped when the writer was cut off by the process exiting, the file is left to the system then
+	this->Writer.Stop(Wait, [this, Wait]()
+	{
+		this->WriteRemaining(Wait);
+
+		fclose(this->File);
+		this->File = nullptr;
+	});
+}
+
+void KeyTraceRecorder::WriteFilled()
+{
+	for (auto Buffer : this->GetSessionBuffers())
+	{
+		if (!Buffer->SpareFilled.load(std::memory_order_acquire))
+			continue;
+
+		this->WriteBlock(*Buffer->Spare, Buffer->ThreadId);
+		Buffer->SpareFilled.store(false, std::memory_order_release);
+	}
+}
+
+void KeyTraceRecorder::WriteRemaining(bool Wait)
+{
+	// A thread cut off while registering never releases the lock
+	std::unique_lock<std::mutex> Guard(this->Lock, std::defer_lock);
+	if (Wait)
+		Guard.lock();
+	else if (!Guard.try_lock())
+		return;
+
+	auto Current = this->Session.load();
+	std::vector<ThreadBuffer*> Remaining;
+
+	for (auto& Buffer : this->Buffers)
+	{
+		if (Buffer->Session == Current)
+			Remaining.push_back(Buffer.get());
+	}
+
+	Guard.unlock();
+
+	for (auto Buffer : Remaining)
+	{
+		// Every thread that saw the recorder running is done once its buffer isn't busy, one cut off in the middle of
+		// a record stays busy for good
+		uint32_t Spins = 0;
+		while (Buffer->Busy.load(std::memory_order_acquire) && (Wait || Spins++ < MaximumStopSpins))
+			std::this_thread::yield();
+
+		if (Spins > MaximumStopSpins)
+			continue;
+
+		if (Buffer->SpareFilled.load(std::memory_order_acquire))
+		{
+			this->WriteBlock(*Buffer->Spare, Buffer->ThreadId);
+			Buffer->SpareFilled.store(false, std::memory_order_release);
+		}
+
+		if (!Buffer->Active->IsEmpty())
+			this->WriteBlock(*Buffer->Active, Buffer->ThreadId);
+	}
+}
+
+void KeyTraceRecorder::WriteBlock(KeyTraceBlock& Block, uint32_t ThreadId)
+{
+	// The scratch bytes go back into the block, so a block only allocates the first time it fills
+	Block.Take(this->Scratch);
+	fwrite(this->Scratch.data(), 1, this->Scratch.size(), this->File);
+	Block.Reset(ThreadId);
+}
+
+std::vector<KeyTraceRecorder::ThreadBuffer*> KeyTraceRecorder::GetSessionBuffers() const
+{
+	std::lock_guard<std::mutex> Guard(this->Lock);
+
+	auto Current = this->Session.load();
+	std::vector<ThreadBuffer*> Result;
+
+	for (auto& Buffer : this->Buffers)
+	{
+		if (Buffer->Session == Current)
+			Result.push_back(Buffer.get());
+	}
+
+	return Result;
+}
+
+KeyTraceRecorder::ThreadBuffer* KeyTraceRecorder::GetThreadBuffer()
+{
+	// Cached per thread, a new session or recorder registers again
+	static thread_local const KeyTraceRecorder* CachedOwner = nullptr;
+	static thread_local uint32_t CachedSession = 0;
+	static thread_local ThreadBuffer* CachedBuffer = nullptr;
+
+	auto Current = this->Session.load(std::memory_order_acquire);
+	if (CachedOwner == this && CachedSession == Current)
+		return CachedBuffer;
+
+	std::lock_guard<std::mutex> Guard(this->Lock);
+	if (!this->Recording.load())
+		return nullptr;
+
+	// Both blocks are allocated here, once per thread
+	std::unique_ptr<ThreadBuffer> Buffer(new ThreadBuffer());
+	Buffer->Busy.store(false);
+	Buffer->SpareFilled.store(false);
+	Buffer->Records.store(0);
+	Buffer->Dropped.store(0);
+	Buffer->ThreadId = GetThreadId();
+	Buffer->Session = Current;
+	Buffer->Active = &Buffer->Blocks[0];
+	Buffer->Spare = &Buffer->Blocks[1];
+	Buffer->Blocks[0].Reset(Buffer->ThreadId);
+	Buffer->Blocks[1].Reset(Buffer->ThreadId);
+
+	CachedOwner = this;
+	CachedSession = Current;
+	CachedBuffer = Buffer.get();
+
+	this->Buffers.push_back(std::move(Buffer));
+	return CachedBuffer;
+}
+
+void KeyTraceRecorder::Record(uint8_t Hook, uint64_t Address, const void* Key, uint32_t KeyBytes, bool Hit)
+{
+	auto Buffer = this->GetThreadBuffer();
+	if (Buffer == nullptr)
+		return;
+
+	// Marked busy before checking, so a stop either sees the mark or this thread sees the stop
+	Buffer->Busy.store(true);
+	if (!this->Recording.load())
+	{
+		Buffer->Busy.store(false, std::memory_order_release);
+		return;
+	}
+
+	auto Ticks = GetTicks();
+	if (!Buffer->Active->Add(Ticks, Hook, Address, Key, KeyBytes, Hit))
+	{
+		// The writer hands the spare back once it's written, until then records are dropped rather than waited on
+		if (Buffer->SpareFilled.load(std::memory_order_acquire))
+		{
+			Buffer->Dropped.store(Buffer->Dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			Buffer->Busy.store(false, std::memory_order_release);
+			return;
+		}
+
+		std::swap(Buffer->Active, Buffer->Spare);
+		Buffer->Active->Add(Ticks, Hook, Address, Key, KeyBytes, Hit);
+		Buffer->SpareFilled.store(true, std::memory_order_release);
+
+		this->Writer.Wake();
+	}
+
+	Buffer->Records.store(Buffer->Records.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	Buffer->Busy.store(false, std::memory_order_release);
+}
+
+void KeyTraceRecorder::RecordStringReference(const char* Reference, bool Hit)
+{
+	if (Reference != nullptr)
+		this->Record(KEYTRACE_HOOK_STRINGED, (uint64_t)(uintptr_t)Reference, Reference, (uint32_t)std::strlen(Reference), Hit);
+}
+
+void KeyTraceRecorder::RecordScaleformKey(const uint16_t* Key, bool Hit)
+{
+	if (Key == nullptr)
+		return;
+
+	uint32_t Length = 0;
+	while (Key[Length] != 0 && Length < MaximumKeyBytes / 2)
+		Length++;
+
+	this->Record(KEYTRACE_HOOK_SCALEFORM, (uint64_t)(uintptr_t)Key, Key, Length * 2, Hit);
+}
+
+uint64_t KeyTraceRecorder::GetRecordCount() const
+{
+	uint64_t Result = 0;
+	for (auto Buffer : this->GetSessionBuffers())
+		Result += Buffer->Records.load(std::memory_order_relaxed);
+
+	return Result;
+}
+
+uint64_t KeyTraceRecorder::GetDroppedCount() const
+{
+	uint64_t Result = 0;
+	for (auto Buffer : this->GetSessionBuffers())
+		Result += Buffer->Dropped.load(std::memory_order_relaxed);
+
+	return Result;
+}
+
+uint64_t KeyTraceRecorder::GetTicks()
+{
+#ifdef _WIN32
+	LARGE_INTEGER Counter;
+	QueryPerformanceCounter(&Counter);
+	return (uint64_t)Counter.QuadPart;
+#else
+	return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+uint64_t KeyTraceRecorder::GetFrequency()
+{
+#ifdef _WIN32
+	LARGE_INTEGER Frequency;
+	QueryPerformanceFrequency(&Frequency);
+	return (uint64_t)Frequency.QuadPart;
+#else
+	return 1000000000ull;
+#endif
+}
+
+uint32_t KeyTraceRecorder::GetThreadId()
+{
+#ifdef _WIN32
+	return (uint32_t)GetCurrentThreadId();
+#else
+	return (uint32_t)std::hash<std::thread::id>()(std::this_thread::get_id());
+#endif
+}
+
+void KeyTraceRecorder::WriteHeader(std::vector<uint8_t>& Result, uint64_t Frequency, uint64_t StartTicks)
+{
+	KeyTraceHeader Header;
+	std::memset(&Header, 0, sizeof(Header));
+
+	Header.Magic = KEYTRACE_MAGIC;
+	Header.Version = KEYTRACE_VERSION;
+	Header.HeaderSize = (uint16_t)sizeof(Header);
+	Header.Frequency = Frequency;
+	Header.StartTicks = StartTicks;
+
+	Result.assign((const uint8_t*)&Header, (const uint8_t*)&Header + sizeof(Header));
+}
+
+KeyTraceReader::KeyTraceReader()
+{
+	this->Frequency = 0;
+}
+
+bool KeyTraceReader::Load(const std::string& Path)
+{
+	auto Handle = fopen(Path.c_str(), "rb");
+	if (Handle == nullptr)
+		return false;
+
+	std::vector<uint8_t> Buffer;
+	uint8_t Chunk[64 * 1024];
+	size_t Read = 0;
+
+	while ((Read = fread(Chunk, 1, sizeof(Chunk), Handle)) > 0)
+		Buffer.insert(Buffer.end(), Chunk, Chunk + Read);
+
+	fclose(Handle);
+	return this->Parse(Buffer.data(), Buffer.size());
+}
+
+bool KeyTraceReader::Parse(const uint8_t* Data, size_t Size)
+{
+	this->Frequency = 0;
+	this->Keys.clear();
+	this->Records.clear();
+
+	if (Size < sizeof(KeyTraceHeader))
+		return false;
+
+	KeyTraceHeader Header;
+	std::memcpy(&Header, Data, sizeof(Header));
+
+	if (Header.Magic != KEYTRACE_MAGIC || Header.Version != KEYTRACE_VERSION || Header.HeaderSize < sizeof(Header) || Header.HeaderSize > Size || Header.Frequency == 0)
+		return false;
+
+	this->Frequency = Header.Frequency;
+
+	// Keys are shared between blocks by hook, address and text
+	std::unordered_map<std::string, uint32_t> KeyIndex;
+	std::vector<uint32_t> BlockKeyIndex;
+
+	auto Cursor = Data + Header.HeaderSize;
+	auto End = Data + Size;
+
+	while (Cursor < End)
+	{
+		KeyTraceBlockHeader Block;
+		if ((size_t)(End - Cursor) < sizeof(Block))
+			return false;
+
+		std::memcpy(&Block, Cursor, sizeof(Block));
+		Cursor += sizeof(Block);
+
+		if (Block.PayloadSize > (size_t)(End - Cursor))
+			return false;
+
+		auto BlockEnd = Cursor + Block.PayloadSize;
+		auto Ticks = Block.FirstTicks;
+		BlockKeyIndex.clear();
+
+		for (uint32_t i = 0; i < Block.RecordCount; i++)
+		{
+			uint64_t Delta = 0, Value = 0;
+			if (!ReadVarint(Cursor, BlockEnd, Delta) || Cursor >= BlockEnd)
+				return false;
+
+			Ticks += Delta;
+			auto Flags = *Cursor++;
+
+			KeyTraceRecord Record;
+			Record.Ticks = (Ticks > Header.StartTicks) ? Ticks - Header.StartTicks : 0;
+			Record.ThreadId = Block.ThreadId;
+			Record.Hook = (uint8_t)(Flags & KEYTRACE_FLAG_HOOK_MASK);
+			Record.Hit = (Flags & KEYTRACE_FLAG_HIT) != 0;
+
+			if ((Flags & KEYTRACE_FLAG_DEFINE) != 0)
+			{
+				uint64_t Address = 0, Length = 0;
+				if (!ReadVarint(Cursor, BlockEnd, Address) || !ReadVarint(Cursor, BlockEnd, Length) || Length > (uint64_t)(BlockEnd - Cursor))
+					return false;
+
+				std::string Identity((const char*)&Record.Hook, 1);
+				Identity.append((const char*)&Address, sizeof(Address));
+				Identity.append((const char*)Cursor, (size_t)Length);
+
+				auto Inserted = KeyIndex.emplace(Identity, (uint32_t)this->Keys.size());
+				if (Inserted.second)
+				{
+					KeyTraceKey Key;
+					Key.Hook = Record.Hook;
+					Key.Address = Address;
+					Key.Text.assign((const char*)Cursor, (size_t)Length);
+					this->Keys.push_back(std::move(Key));
+				}
+
+				Cursor += Length;
+				BlockKeyIndex.push_back(Inserted.first->second);
+				Record.Key = Inserted.first->second;
+			}
+			else
+			{
+				if (!ReadVarint(Cursor, BlockEnd, Value) || Value >= BlockKeyIndex.size())
+					return false;
+
+				Record.Key = BlockKeyIndex[(size_t)Value];
+			}
+
+			this->Records.push_back(Record);
+		}
+
+		Cursor = BlockEnd;
+	}
+
+	// Blocks of different threads are written as they fill, a thread's own blocks are in order
+	std::stable_sort(this->Records.begin(), this->Records.end(), [](const KeyTraceRecord& Lhs, const KeyTraceRecord& Rhs)
+	{
+		return Lhs.Ticks < Rhs.Ticks;
+	});
+
+	return true;
+}
+
+uint64_t KeyTraceReader::GetFrequency() const
+{
+	return this->Frequency;
+}
+
+const std::vector<KeyTraceKey>& KeyTraceReader::GetKeys() const
+{
+	return this->Keys;
+}
+
+const std::vector<KeyTraceRecord>& KeyTraceReader::GetRecords() const
+{
+	return this->Records;
+}
\ No newline at end of file
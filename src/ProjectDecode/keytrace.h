@@ -0,0 +1,199 @@
+#pragma once
+
+// Standard includes
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Our includes
+#include "backgroundwriter.h"
+
+//
+// Key traces, a compact binary record of every key the hooks are asked for.
+//   KeyTraceHeader
+//   Blocks, one per filled thread buffer, in the order they were written:
+//     KeyTraceBlockHeader
+//     Records, each <ticks since the previous record of the block, varint> <flags> followed by either
+//       <key index, varint>										a key defined earlier in the block
+//       <address, varint> <key length in bytes, varint> <key bytes>	with KEYTRACE_FLAG_DEFINE, defines the next key index
+// Keys are stored as the engine passed them, utf8 for StringEd and utf16 for Scaleform, with the address they were passed at,
+// so a replay reproduces literals and reused buffers. Keys repeat every frame, so most records are three or four bytes.
+//
+
+// 'D3TR'
+#define KEYTRACE_MAGIC 0x52543344
+#define KEYTRACE_VERSION 1
+
+// The hook a record came from
+#define KEYTRACE_HOOK_STRINGED 0
+#define KEYTRACE_HOOK_SCALEFORM 1
+
+// Record flags, the low bits are the hook
+#define KEYTRACE_FLAG_HOOK_MASK 0x03
+#define KEYTRACE_FLAG_HIT 0x04
+#define KEYTRACE_FLAG_DEFINE 0x08
+
+struct KeyTraceHeader
+{
+	uint32_t Magic;
+	uint16_t Version;
+	uint16_t HeaderSize;	// Size of this header, blocks follow it
+	uint64_t Frequency;		// Ticks per second
+	uint64_t StartTicks;	// Ticks when recording started
+};
+
+struct KeyTraceBlockHeader
+{
+	uint32_t ThreadId;
+	uint32_t RecordCount;
+	uint32_t PayloadSize;	// Bytes of records following the header
+	uint32_t Reserved;
+	uint64_t FirstTicks;	// Ticks of the first record, the others are deltas
+};
+
+// A distinct key of a trace, with the address it was passed at
+struct KeyTraceKey
+{
+	uint8_t Hook;
+	uint64_t Address;
+	std::string Text;		// The raw key bytes, utf16 code units for Scaleform keys
+};
+
+// A record read back from a trace
+struct KeyTraceRecord
+{
+	uint64_t Ticks;			// Since recording started
+	uint32_t ThreadId;
+	uint32_t Key;			// Index into the trace's keys
+	uint8_t Hook;
+	bool Hit;
+};
+
+// Encodes the records of one thread into a block, interning repeated keys
+class KeyTraceBlock
+{
+private:
+	std::vector<uint8_t> Data;
+	uint32_t RecordCount;
+	uint64_t LastTicks;
+
+	// Open addressed key index + 1 by hash, with the key hash, hook, address and where its bytes are in the block
+	std::vector<uint32_t> Table;
+	std::vector<uint64_t> KeyHashes;
+	std::vector<uint8_t> KeyHooks;
+	std::vector<uint64_t> KeyAddresses;
+	std::vector<uint32_t> KeyOffsets;
+	std::vector<uint32_t> KeyLengths;
+
+public:
+	KeyTraceBlock();
+
+	// Starts an empty block for a thread
+	void Reset(uint32_t ThreadId);
+	// Adds a record, false when the block is full and must be taken first
+	bool Add(uint64_t Ticks, uint8_t Hook, uint64_t Address, const void* Key, uint32_t KeyBytes, bool Hit);
+	// Whether or not any records were added since the reset
+	bool IsEmpty() const;
+	// Finishes the block, swapping its bytes (header included) into the result, the block must be reset before reuse
+	void Take(std::vector<uint8_t>& Result);
+};
+
+// Records keys from any thread into per thread buffers, a background thread writes filled buffers to disk.
+// Each thread has a spare block it swaps in when its block fills, the hooks never allocate or lock after registering
+class KeyTraceRecorder
+{
+private:
+	struct ThreadBuffer;
+
+	std::atomic<bool> Recording;
+	std::atomic<uint32_t> Session;
+
+	// Guards the list of thread buffers, taken by a thread only when it registers
+	mutable std::mutex Lock;
+	std::vector<std::unique_ptr<ThreadBuffer>> Buffers;
+
+	// Only used by the writer, or by stopping once the writer is done
+	FILE* File;
+	std::vector<uint8_t> Scratch;
+	BackgroundWriter Writer;
+
+	// Writes every filled spare block and hands it back to its thread
+	void WriteFilled();
+	// Writes what's left in every buffer of the session, buffers still busy are given up on when not waiting
+	void WriteRemaining(bool Wait);
+	// Writes a block and resets it for its thread
+	void WriteBlock(KeyTraceBlock& Block, uint32_t ThreadId);
+	// Gets the buffers of the current session
+	std::vector<ThreadBuffer*> GetSessionBuffers() const;
+	// Gets the calling thread's buffer, registering it on first use, nullptr when not recording
+	ThreadBuffer* GetThreadBuffer();
+	// Records a key on the calling thread
+	void Record(uint8_t Hook, uint64_t Address, const void* Key, uint32_t KeyBytes, bool Hit);
+
+public:
+	KeyTraceRecorder();
+	~KeyTraceRecorder();
+
+	KeyTraceRecorder(const KeyTraceRecorder&) = delete;
+	KeyTraceRecorder& operator=(const KeyTraceRecorder&) = delete;
+
+	// Starts recording into a new trace file
+	bool Start(const std::string& Path);
+	// Stops recording, writing every buffered record. When not waiting nothing is waited on (required under the loader lock),
+	// records of threads that were cut off are dropped
+	void Stop(bool Wait);
+
+	// Whether or not keys are being recorded, cheap enough to check on every hook call
+	bool IsRecording() const
+	{
+		return this->Recording.load(std::memory_order_relaxed);
+	}
+
+	// Records a null-term StringEd reference, as passed to the hook
+	void RecordStringReference(const char* Reference, bool Hit);
+	// Records a null-term utf16 Scaleform key, as passed to the hook
+	void RecordScaleformKey(const uint16_t* Key, bool Hit);
+
+	// Gets the amount of records so far
+	uint64_t GetRecordCount() const;
+	// Gets the amount of records dropped because a thread filled both of its blocks before the writer caught up
+	uint64_t GetDroppedCount() const;
+
+	// Gets the current time in trace ticks
+	static uint64_t GetTicks();
+	// Gets the amount of trace ticks per second
+	static uint64_t GetFrequency();
+	// Gets an id for the calling thread
+	static uint32_t GetThreadId();
+	// Writes a trace header to the start of a buffer
+	static void WriteHeader(std::vector<uint8_t>& Result, uint64_t Frequency, uint64_t StartTicks);
+};
+
+// Reads a whole trace, records of every thread merged in time order
+class KeyTraceReader
+{
+private:
+	uint64_t Frequency;
+	std::vector<KeyTraceKey> Keys;
+	std::vector<KeyTraceRecord> Records;
+
+public:
+	KeyTraceReader();
+
+	// Reads a trace file, false if it's missing or corrupt
+	bool Load(const std::string& Path);
+	// Reads a trace from memory
+	bool Parse(const uint8_t* Data, size_t Size);
+
+	// Gets the amount of ticks per second
+	uint64_t GetFrequency() const;
+	// Gets every distinct key (hook, address and text)
+	const std::vector<KeyTraceKey>& GetKeys() const;
+	// Gets every record in time order, records at the same tick keep their recorded order
+	const std::vector<KeyTraceRecord>& GetRecords() const;
+};
\ No newline at end of file
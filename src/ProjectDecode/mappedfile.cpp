@@ -0,0 +1,136 @@
+// Platform includes
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+// The class we are implementing
+#include "mappedfile.h"
+
+MappedFile::MappedFile()
+{
+#ifdef _WIN32
+	this->FileHandle = INVALID_HANDLE_VALUE;
+	this->MappingHandle = NULL;
+#else
+	this->FileDescriptor = -1;
+#endif
+	this->Data = nullptr;
+	this->Size = 0;
+}
+
+MappedFile::~MappedFile()
+{
+	this->Close();
+}
+
+bool MappedFile::Open(const std::string& Path)
+{
+	// Release the previous mapping
+	this->Close();
+
+#ifdef _WIN32
+	this->FileHandle = CreateFileA(Path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (this->FileHandle == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER FileSize;
+	if (!GetFileSizeEx(this->FileHandle, &FileSize) || FileSize.HighPart != 0)
+	{
+		this->Close();
+		return false;
+	}
+
+	this->Size = (size_t)FileSize.LowPart;
+
+	// Empty files can't be mapped, but are still valid
+	if (this->Size == 0)
+		return true;
+
+	this->MappingHandle = CreateFileMappingA(this->FileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (this->MappingHandle == NULL)
+	{
+		this->Close();
+		return false;
+	}
+
+	this->Data = (const uint8_t*)MapViewOfFile(this->MappingHandle, FILE_MAP_READ, 0, 0, 0);
+#else
+	this->FileDescriptor = open(Path.c_str(), O_RDONLY);
+	if (this->FileDescriptor < 0)
+		return false;
+
+	struct stat FileInfo;
+	if (fstat(this->FileDescriptor, &FileInfo) != 0)
+	{
+		this->Close();
+		return false;
+	}
+
+	this->Size = (size_t)FileInfo.st_size;
+
+	// Empty files can't be mapped, but are still valid
+	if (this->Size == 0)
+		return true;
+
+	auto View = mmap(nullptr, this->Size, PROT_READ, MAP_PRIVATE, this->FileDescriptor, 0);
+	this->Data = (View == MAP_FAILED) ? nullptr : (const uint8_t*)View;
+#endif
+
+	// Check the view
+	if (this->Data == nullptr)
+	{
+		this->Close();
+		return false;
+	}
+
+	return true;
+}
+
+void MappedFile::Close()
+{
+#ifdef _WIN32
+	if (this->Data != nullptr)
+		UnmapViewOfFile(this->Data);
+	if (this->MappingHandle != NULL)
+		CloseHandle(this->MappingHandle);
+	if (this->FileHandle != INVALID_HANDLE_VALUE)
+		CloseHandle(this->FileHandle);
+
+	this->FileHandle = INVALID_HANDLE_VALUE;
+	this->MappingHandle = NULL;
+#else
+	if (this->Data != nullptr)
+		munmap((void*)this->Data, this->Size);
+	if (this->FileDescriptor >= 0)
+		close(this->FileDescriptor);
+
+	this->FileDescriptor = -1;
+#endif
+
+	this->Data = nullptr;
+	this->Size = 0;
+}
+
+bool MappedFile::IsOpen() const
+{
+#ifdef _WIN32
+	return (this->FileHandle != INVALID_HANDLE_VALUE);
+#else
+	return (this->FileDescriptor >= 0);
+#endif
+}
+
+const uint8_t* MappedFile::GetData() const
+{
+	return this->Data;
+}
+
+size_t MappedFile::GetSize() const
+{
+	return this->Size;
+}
\ No newline at end of file
@@ -0,0 +1,39 @@
+#pragma once
+
+// Standard includes
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+// A read-only view of an entire file, mapped into memory
+class MappedFile
+{
+private:
+#ifdef _WIN32
+	void* FileHandle;
+	void* MappingHandle;
+#else
+	int FileDescriptor;
+#endif
+	const uint8_t* Data;
+	size_t Size;
+
+public:
+	MappedFile();
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// Maps the given file, closing any previously mapped one
+	bool Open(const std::string& Path);
+	// Unmaps the file, if any
+	void Close();
+
+	// Whether or not a file is mapped
+	bool IsOpen() const;
+	// Gets the mapped file data
+	const uint8_t* GetData() const;
+	// Gets the mapped file size
+	size_t GetSize() const;
+};
\ No newline at end of file
@@ -0,0 +1,286 @@
+// The class we are implementing
+#include "missingkeys.h"
+
+// Standard includes
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+// Our includes
+#include "gbk.h"
+#include "hashing.h"
+#include "translate.h"
+#include "unicode.h"
+
+// Buckets probed past the home bucket before a key is given up on
+static const uint32_t MaximumProbes = 4;
+// Longest key and value kept, longer ones are cut
+static const size_t MaximumKeyLength = 1024;
+static const size_t MaximumValueLength = 4096;
+
+MissingKeyCollector::MissingKeyCollector()
+{
+	this->Enabled.store(false);
+	this->BucketMask = 0;
+	this->Recorded.store(0);
+	this->Overflowed.store(0);
+	this->Pending.store(nullptr);
+	this->File = nullptr;
+	this->Written = 0;
+}
+
+MissingKeyCollector::~MissingKeyCollector()
+{
+	this->Stop(true);
+
+	// Anything queued after stopping
+	auto Current = this->Pending.exchange(nullptr);
+	while (Current != nullptr)
+	{
+		auto Next = Current->Next;
+		delete Current;
+		Current = Next;
+	}
+}
+
+bool MissingKeyCollector::Start(const std::string& Path, uint32_t Capacity, uint32_t FlushMilliseconds)
+{
+	if (this->Enabled.load() || this->Writer.IsRunning())
+		return false;
+
+	// The set lives as long as the collector, a hook may still be probing it after a stop
+	if (this->Buckets == nullptr)
+	{
+		uint32_t BucketCount = 1;
+		while (BucketCount * MISSINGKEYS_BUCKET_SIZE < Capacity * 2 && BucketCount < (1u << 20))
+			BucketCount <<= 1;
+
+		this->Buckets.reset(new MissingKeyBucket[BucketCount]);
+		for (uint32_t b = 0; b < BucketCount; b++)
+		{
+			for (auto& Tag : this->Buckets[b].Tags)
+				Tag.store(0, std::memory_order_relaxed);
+		}
+
+		this->BucketMask = BucketCount - 1;
+	}
+
+	// Keys collected by an earlier session are already in the file
+	auto Existing = fopen(Path.c_str(), "rb");
+	bool Empty = true;
+
+	if (Existing != nullptr)
+	{
+		char Line[MaximumKeyLength + MaximumValueLength];
+		while (fgets(Line, sizeof(Line), Existing) != nullptr)
+		{
+			Empty = false;
+
+			auto Split = std::strchr(Line, '|');
+			if (Split != nullptr && Split != Line && std::strncmp(Line, "//", 2) != 0)
+				this->Insert(HashKey(Line, (size_t)(Split - Line)));
+		}
+
+		fclose(Existing);
+	}
+
+	this->File = fopen(Path.c_str(), "ab");
+	if (this->File == nullptr)
+		return false;
+
+	if (Empty)
+		fputs("// Keys the database didn't have, with the text the game showed instead, collected by D3code\n", this->File);
+
+	this->Written = 0;
+	this->Recorded.store(0);
+
+	this->Enabled.store(true);
+	this->Writer.Start([this]() { this->Flush(); }, FlushMilliseconds);
+
+	return true;
+}
+
+void MissingKeyCollector::Stop(bool Wait)
+{
+	if (!this->Enabled.exchange(false))
+		return;
+
+	// The rest is written here, the writer may not get to run again when the process is exiting
+	this->Writer.Stop(Wait, [this]()
+	{
+		this->Flush();
+
+		fclose(this->File);
+		this->File = nullptr;
+	});
+}
+
+void MissingKeyCollector::Flush()
+{
+	auto Current = this->Pending.exchange(nullptr, std::memory_order_acquire);
+	if (Current == nullptr)
+		return;
+
+	// Newest first on the list, written in the order they were seen
+	std::vector<Entry*> Entries;
+	for (; Current != nullptr; Current = Current->Next)
+		Entries.push_back(Current);
+
+	std::string Batch;
+	for (auto Iterator = Entries.rbegin(); Iterator != Entries.rend(); Iterator++)
+	{
+		auto Item = *Iterator;
+		auto Value = Item->Utf8 ? std::move(Item->Value) : EngineToUtf8(Item->Value);
+		auto Key = std::move(Item->Key);
+		delete Item;
+
+		// Values are one line with no trailing whitespace
+		for (auto& Character : Value)
+		{
+			if (Character == '\r' || Character == '\n')
+				Character = ' ';
+		}
+
+		while (!Value.empty() && (Value.back() == ' ' || Value.back() == '\t'))
+			Value.pop_back();
+
+		Batch.append(Key);
+		Batch.push_back('|');
+		Batch.append(Value);
+		Batch.push_back('\n');
+
+		this->Written++;
+	}
+
+	fwrite(Batch.data(), 1, Batch.size(), this->File);
+	fflush(this->File);
+}
+
+bool MissingKeyCollector::Insert(uint64_t Hash)
+{
+	auto Home = (uint32_t)(Hash >> 32);
+	auto Tag = (uint32_t)Hash;
+	if (Tag == 0)
+		Tag = 1;
+
+	for (uint32_t Probe = 0; Probe <= MaximumProbes; Probe++)
+	{
+		auto& Target = this->Buckets[(Home + Probe) & this->BucketMask];
+
+		for (auto& Slot : Target.Tags)
+		{
+			auto Current = Slot.load(std::memory_order_relaxed);
+			if (Current == Tag)
+				return false;
+
+			// Claim the empty slot, unless another thread took it first, maybe for the same key
+			if (Current == 0)
+			{
+				if (Slot.compare_exchange_strong(Current, Tag, std::memory_order_relaxed))
+					return true;
+				if (Current == Tag)
+					return false;
+			}
+		}
+	}
+
+	// Counted, but treated as seen so the hook doesn't retry it every call
+	this->Overflowed.fetch_add(1, std::memory_order_relaxed);
+	return false;
+}
+
+void MissingKeyCollector::Queue(std::string Key, std::string Value, bool Utf8)
+{
+	auto Item = new Entry();
+	Item->Key = std::move(Key);
+	Item->Value = std::move(Value);
+	Item->Utf8 = Utf8;
+
+	auto Head = this->Pending.load(std::memory_order_relaxed);
+	do
+	{
+		Item->Next = Head;
+	} while (!this->Pending.compare_exchange_weak(Head, Item, std::memory_order_release, std::memory_order_relaxed));
+
+	this->Recorded.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool MissingKeyCollector::IsWritableKey(const char* Key, size_t Length)
+{
+	// The source format trims keys, splits on the first | and skips // comments, anything else is written as is
+	if (Length == 0 || Key[0] == ' ' || Key[Length - 1] == ' ' || (Length >= 2 && Key[0] == '/' && Key[1] == '/'))
+		return false;
+
+	for (size_t i = 0; i < Length; i++)
+	{
+		if ((uint8_t)Key[i] < 0x20 || Key[i] == '|')
+			return false;
+	}
+
+	return true;
+}
+
+uint64_t MissingKeyCollector::HashKey(const void* Key, size_t Length)
+{
+	return Hashing::WordMix::Hash(Key, Length);
+}
+
+void MissingKeyCollector::RecordStringReference(const char* Key, const char* Fallback)
+{
+	if (!this->IsEnabled() || Key == nullptr)
+		return;
+
+	// StringEd keys are ascii names, anything else would be hashed differently once it was written as utf8
+	size_t KeyLength = 0;
+	for (; KeyLength < MaximumKeyLength && Key[KeyLength] != 0; KeyLength++)
+	{
+		if ((uint8_t)Key[KeyLength] >= 0x80)
+			return;
+	}
+
+	if (!IsWritableKey(Key, KeyLength) || !this->Insert(HashKey(Key, KeyLength)))
+		return;
+
+	// First sighting, the only time anything is copied
+	std::string Value = (Fallback != nullptr) ? std::string(Fallback, strnlen(Fallback, MaximumValueLength)) : std::string();
+	this->Queue(std::string(Key, KeyLength), std::move(Value), false);
+}
+
+void MissingKeyCollector::RecordScaleformKey(const uint16_t* Key)
+{
+	if (!this->IsEnabled() || Key == nullptr)
+		return;
+
+	// Stripped of the @ modifier as the lookup does, so the key written is the one the database is asked for
+	auto KeyLength = std::min(PrepareScaleformKey(Key), MaximumKeyLength);
+
+	// Hashed as utf8, so a key seen by both hooks is recorded once
+	char Utf8Key[MaximumKeyLength * 3];
+	auto Utf8Length = Unicode::Utf16ToUtf8(Key, KeyLength, Utf8Key, sizeof(Utf8Key));
+
+	if (!IsWritableKey(Utf8Key, Utf8Length) || !this->Insert(HashKey(Utf8Key, Utf8Length)))
+		return;
+
+	std::string Text(Utf8Key, Utf8Length);
+	this->Queue(Text, Text, true);
+}
+
+uint32_t MissingKeyCollector::GetRecordedCount() const
+{
+	return this->Recorded.load(std::memory_order_relaxed);
+}
+
+uint32_t MissingKeyCollector::GetWrittenCount() const
+{
+	return this->Written;
+}
+
+uint32_t MissingKeyCollector::GetOverflowCount() const
+{
+	return this->Overflowed.load(std::memory_order_relaxed);
+}
+
+std::string MissingKeyCollector::EngineToUtf8(const std::string& Text)
+{
+	return Gbk::ToUtf8(Text);
+}
\ No newline at end of file
@@ -0,0 +1,109 @@
+#pragma once
+
+// Standard includes
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <atomic>
+#include <memory>
+#include <string>
+
+// Our includes
+#include "backgroundwriter.h"
+
+//
+// Collects every distinct key the database didn't have, once, with the text the engine fell back to.
+// Keys are identified by a 64 bit hash in an insert-only set of cache line buckets, half of it picks the
+// bucket and the other half is the 32 bit tag kept in it. A key that was already seen costs one hash and
+// one bucket scan, no locks and no writes, on 32bit targets too where a 64 bit atomic load is a locked
+// compare exchange. First sightings copy the key and value onto a lock-free list, a background thread
+// converts them to utf8 and appends them to a KEY|value file, the same format as en_source.txt.
+//
+
+// Tags per bucket, a bucket is one cache line
+#define MISSINGKEYS_BUCKET_SIZE 16
+
+// Alignment of buckets, so a lookup touches one cache line
+#ifdef _MSC_VER
+#define MISSINGKEYS_ALIGN(Size) __declspec(align(Size))
+#else
+#define MISSINGKEYS_ALIGN(Size) __attribute__((aligned(Size)))
+#endif
+
+struct MISSINGKEYS_ALIGN(64) MissingKeyBucket
+{
+	// The low half of each key's hash, never 0 which marks an empty slot
+	std::atomic<uint32_t> Tags[MISSINGKEYS_BUCKET_SIZE];
+};
+
+class MissingKeyCollector
+{
+private:
+	// A first sighting waiting to be written
+	struct Entry
+	{
+		Entry* Next;
+		std::string Key;
+		std::string Value;
+		bool Utf8;			// Otherwise the value is in the engine's codepage
+	};
+
+	std::atomic<bool> Enabled;
+	std::unique_ptr<MissingKeyBucket[]> Buckets;
+	uint32_t BucketMask;
+	std::atomic<uint32_t> Recorded;
+	std::atomic<uint32_t> Overflowed;
+
+	// First sightings, newest first
+	std::atomic<Entry*> Pending;
+
+	// Only used by the writer, or by stopping once the writer is done
+	FILE* File;
+	uint32_t Written;
+	BackgroundWriter Writer;
+
+	// Appends every pending entry to the file
+	void Flush();
+	// Inserts a hash, true when it wasn't in the set yet
+	bool Insert(uint64_t Hash);
+	// Queues a first sighting for the writer
+	void Queue(std::string Key, std::string Value, bool Utf8);
+	// Hashes a key
+	static uint64_t HashKey(const void* Key, size_t Length);
+
+public:
+	MissingKeyCollector();
+	~MissingKeyCollector();
+
+	MissingKeyCollector(const MissingKeyCollector&) = delete;
+	MissingKeyCollector& operator=(const MissingKeyCollector&) = delete;
+
+	// Starts collecting into a file, keys already in it are not written again. The capacity is in keys, rounded up to whole buckets
+	bool Start(const std::string& Path, uint32_t Capacity, uint32_t FlushMilliseconds);
+	// Stops collecting, writing every collected key. When not waiting nothing is waited on (required under the loader lock),
+	// keys still queued are dropped if the writer was cut off in the middle of writing
+	void Stop(bool Wait);
+
+	// Whether or not keys are being collected, cheap enough to check on every hook call
+	bool IsEnabled() const
+	{
+		return this->Enabled.load(std::memory_order_relaxed);
+	}
+
+	// Records a StringEd key (@ already stripped) and the text the engine returned instead, in its codepage. Keys that aren't ascii are ignored
+	void RecordStringReference(const char* Key, const char* Fallback);
+	// Records a null-term utf16 Scaleform key, the engine's own translation isn't known so the key is its value
+	void RecordScaleformKey(const uint16_t* Key);
+
+	// Gets the amount of distinct keys recorded this session
+	uint32_t GetRecordedCount() const;
+	// Gets the amount of keys written to the file this session
+	uint32_t GetWrittenCount() const;
+	// Gets the amount of keys that didn't fit the set
+	uint32_t GetOverflowCount() const;
+
+	// Converts text in the engine's codepage (GBK) to utf8, invalid sequences become ?
+	static std::string EngineToUtf8(const std::string& Text);
+	// Whether or not a key can be written as a KEY|value line and read back the same
+	static bool IsWritableKey(const char* Key, size_t Length);
+};
\ No newline at end of file
@@ -0,0 +1,41 @@
+#pragma once
+
+// Standard includes
+#include <cstdint>
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+namespace Parallel
+{
+	// Gets the amount of worker threads worth using, capped so loading never floods the machine
+	inline uint32_t GetWorkerCount(uint32_t Limit = 8)
+	{
+		auto Hardware = std::thread::hardware_concurrency();
+		return std::max<uint32_t>(1, std::min<uint32_t>((Hardware > 0) ? Hardware : 1, Limit));
+	}
+
+	// Gets the amount of chunks to split a range into, so each chunk has at least the minimum size
+	inline uint32_t GetChunkCount(size_t Size, size_t MinimumChunkSize, uint32_t Workers)
+	{
+		auto Chunks = (MinimumChunkSize > 0) ? (Size / MinimumChunkSize) : Size;
+		return (uint32_t)std::max<size_t>(1, std::min<size_t>(Chunks, Workers));
+	}
+
+	// Runs Func(Index) for every index in [0, Count), one thread per index, the caller runs index 0
+	template<typename Func>
+	void For(uint32_t Count, Func Function)
+	{
+		std::vector<std::thread> Workers;
+		Workers.reserve((Count > 1) ? Count - 1 : 0);
+
+		for (uint32_t i = 1; i < Count; i++)
+			Workers.push_back(std::thread(Function, i));
+
+		if (Count > 0)
+			Function(0);
+
+		for (auto& Worker : Workers)
+			Worker.join();
+	}
+}
\ No newline at end of file
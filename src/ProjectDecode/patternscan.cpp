@@ -0,0 +1,962 @@
+// Platform includes
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#include <immintrin.h>
+#define PATTERNSCAN_SIMD 1
+#else
+#define PATTERNSCAN_SIMD 0
+#endif
+
+// The class we are implementing
+#include "patternscan.h"
+
+// Standard includes
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+
+// Our includes
+#include "cpufeatures.h"
+#include "parallel.h"
+#include "hashing.h"
+
+// Lets a function use instructions past the build's baseline, it's only called once they're detected
+#if defined(_MSC_VER) || !PATTERNSCAN_SIMD
+#define PATTERNSCAN_TARGET(Target)
+#else
+#define PATTERNSCAN_TARGET(Target) __attribute__((target(Target)))
+#endif
+
+// A signature as the scan loops read it
+struct ScanState
+{
+	const uint8_t* Data;
+	const uint8_t* Mask;
+	size_t Length;
+	size_t PaddedLength;
+	uint32_t FirstAnchor;
+	uint32_t SecondAnchor;
+};
+
+// Gets the index of the lowest set bit of a non zero mask
+static uint32_t LowestBit(uint32_t Mask)
+{
+#ifdef _MSC_VER
+	unsigned long Index = 0;
+	_BitScanForward(&Index, Mask);
+	return (uint32_t)Index;
+#else
+	return (uint32_t)__builtin_ctz(Mask);
+#endif
+}
+
+// Compares every fixed byte one at a time
+static bool VerifyScalar(const ScanState& State, const uint8_t* Data)
+{
+	for (size_t i = 0; i < State.Length; i++)
+	{
+		if (((Data[i] ^ State.Data[i]) & State.Mask[i]) != 0)
+			return false;
+	}
+
+	return true;
+}
+
+#if PATTERNSCAN_SIMD
+
+// Compares 16 bytes at a time, the padding is read but masked out so it must be inside the range
+static bool VerifyBlocks(const ScanState& State, const uint8_t* Data)
+{
+	auto Zero = _mm_setzero_si128();
+
+	for (size_t i = 0; i < State.PaddedLength; i += 16)
+	{
+		auto Block = _mm_loadu_si128((const __m128i*)(Data + i));
+		auto Expected = _mm_loadu_si128((const __m128i*)(State.Data + i));
+		auto Mask = _mm_loadu_si128((const __m128i*)(State.Mask + i));
+
+		auto Difference = _mm_and_si128(_mm_xor_si128(Block, Expected), Mask);
+		if (_mm_movemask_epi8(_mm_cmpeq_epi8(Difference, Zero)) != 0xFFFF)
+			return false;
+	}
+
+	return true;
+}
+
+// Verifies a candidate, in blocks unless the padding would run past the range
+static bool VerifyCandidate(const ScanState& State, const uint8_t* Data, size_t Size, size_t Position)
+{
+	if (Size - Position >= State.PaddedLength)
+		return VerifyBlocks(State, Data + Position);
+
+	return VerifyScalar(State, Data + Position);
+}
+
+// Every start from Position whose anchors both match, 32 starts at a time. Stops before the last partial block
+static intptr_t ScanSse2(const ScanState& State, const uint8_t* Data, size_t Size, size_t& Position)
+{
+	auto Last = Size - State.Length;
+	auto First = _mm_set1_epi8((char)State.Data[State.FirstAnchor]);
+	auto Second = _mm_set1_epi8((char)State.Data[State.SecondAnchor]);
+
+	// The anchors are inside the signature, so the loads never pass the range
+	while (Position <= Last && Last - Position >= 31)
+	{
+		auto FirstData = Data + Position + State.FirstAnchor;
+		auto Low = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)FirstData), First);
+		auto High = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(FirstData + 16)), First);
+
+		// The rarest byte alone rules out most blocks, the second anchor is only checked when it's there
+		if (_mm_movemask_epi8(_mm_or_si128(Low, High)) != 0)
+		{
+			auto SecondData = Data + Position + State.SecondAnchor;
+			Low = _mm_and_si128(Low, _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)SecondData), Second));
+			High = _mm_and_si128(High, _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(SecondData + 16)), Second));
+
+			auto Candidates = (uint32_t)_mm_movemask_epi8(Low) | ((uint32_t)_mm_movemask_epi8(High) << 16);
+
+			while (Candidates != 0)
+			{
+				auto Candidate = Position + LowestBit(Candidates);
+				if (VerifyCandidate(State, Data, Size, Candidate))
+					return (intptr_t)Candidate;
+
+				Candidates &= Candidates - 1;
+			}
+		}
+
+		Position += 32;
+	}
+
+	return -1;
+}
+
+// The same with 64 starts at a time
+PATTERNSCAN_TARGET("avx2")
+static intptr_t ScanAvx2(const ScanState& State, const uint8_t* Data, size_t Size, size_t& Position)
+{
+	auto Last = Size - State.Length;
+	auto First = _mm256_set1_epi8((char)State.Data[State.FirstAnchor]);
+	auto Second = _mm256_set1_epi8((char)State.Data[State.SecondAnchor]);
+
+	while (Position <= Last && Last - Position >= 63)
+	{
+		auto FirstData = Data + Position + State.FirstAnchor;
+		auto Low = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)FirstData), First);
+		auto High = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(FirstData + 32)), First);
+
+		auto Any = _mm256_or_si256(Low, High);
+		if (!_mm256_testz_si256(Any, Any))
+		{
+			auto SecondData = Data + Position + State.SecondAnchor;
+			Low = _mm256_and_si256(Low, _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)SecondData), Second));
+			High = _mm256_and_si256(High, _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(SecondData + 32)), Second));
+
+			uint32_t Halves[2] = { (uint32_t)_mm256_movemask_epi8(Low), (uint32_t)_mm256_movemask_epi8(High) };
+
+			for (uint32_t h = 0; h < 2; h++)
+			{
+				while (Halves[h] != 0)
+				{
+					auto Candidate = Position + h * 32 + LowestBit(Halves[h]);
+					if (VerifyCandidate(State, Data, Size, Candidate))
+						return (intptr_t)Candidate;
+
+					Halves[h] &= Halves[h] - 1;
+				}
+			}
+		}
+
+		Position += 64;
+	}
+
+	return -1;
+}
+
+#endif
+
+// The rarest anchor found with memchr, then the other one and the rest checked a byte at a time
+static intptr_t ScanScalar(const ScanState& State, const uint8_t* Data, size_t Size, size_t Position)
+{
+	auto Last = Size - State.Length;
+	auto First = State.Data[State.FirstAnchor];
+	auto Second = State.Data[State.SecondAnchor];
+
+	while (Position <= Last)
+	{
+		auto Found = (const uint8_t*)std::memchr(Data + Position + State.FirstAnchor, First, Last - Position + 1);
+		if (Found == nullptr)
+			return -1;
+
+		Position = (size_t)(Found - Data) - State.FirstAnchor;
+		if (Data[Position + State.SecondAnchor] == Second && VerifyScalar(State, Data + Position))
+			return (intptr_t)Position;
+
+		Position++;
+	}
+
+	return -1;
+}
+
+// Starts a worker takes at once, enough that starting the workers is a small part of the scan
+static const size_t ParallelChunkSize = 1024 * 1024;
+
+// Gets the amount of chunks a range of starts splits into
+static uint32_t GetChunkCount(size_t Size)
+{
+	return (uint32_t)((Size + ParallelChunkSize - 1) / ParallelChunkSize);
+}
+
+// Gets the amount of starts in a chunk
+static size_t GetChunkStarts(size_t Size, uint32_t Chunk)
+{
+	return std::min(ParallelChunkSize, Size - (size_t)Chunk * ParallelChunkSize);
+}
+
+// Gets the bytes a chunk reads, its starts and what a match at the last of them covers
+static size_t GetChunkReadSize(size_t Size, uint32_t Chunk, size_t Length)
+{
+	auto Begin = (size_t)Chunk * ParallelChunkSize;
+	return std::min(Size - Begin, GetChunkStarts(Size, Chunk) + Length - 1);
+}
+
+// Lowers the last chunk still worth scanning, unless it's already lower
+static void LowerChunkLimit(std::atomic<uint32_t>& Limit, uint32_t Chunk)
+{
+	auto Current = Limit.load();
+	while (Chunk < Current && !Limit.compare_exchange_weak(Current, Chunk))
+	{
+	}
+}
+
+// Runs Function(Chunk) for every chunk on up to Threads workers, which take the lowest chunk left. Chunks past
+// Limit are skipped, so a scan lowers it once the chunks after one can't change the result
+template<typename Func>
+static void ForEachChunk(uint32_t ChunkCount, uint32_t Threads, std::atomic<uint32_t>& Limit, Func Function)
+{
+	std::atomic<uint32_t> Next(0);
+
+	Parallel::For(std::max<uint32_t>(1, std::min(Threads, ChunkCount)), [&](uint32_t)
+	{
+		while (true)
+		{
+			auto Chunk = Next.fetch_add(1);
+			if (Chunk >= ChunkCount || Chunk > Limit.load())
+				break;
+
+			Function(Chunk);
+		}
+	});
+}
+
+// Adds every match in a range to the offsets, Base added to each
+static void CollectMatches(const PatternScan& Scanner, uintptr_t Source, size_t Size, size_t Base, std::vector<uintptr_t>& Offsets)
+{
+	size_t Position = 0;
+
+	while (Position <= Size)
+	{
+		auto Result = Scanner.Scan(Source + Position, Size - Position);
+		if (Result < 0)
+			break;
+
+		Offsets.push_back(Base + Position + (size_t)Result);
+		Position += (size_t)Result + 1;
+	}
+}
+
+PatternScan::PatternScan(const char* Pattern)
+{
+	// A lone ? is one wildcard and so is ??, spaces only separate. Anything else is ignored
+	int32_t HighDigit = -1;
+	bool LastWasUnknown = false;
+
+	for (; *Pattern != 0; Pattern++)
+	{
+		auto Character = *Pattern;
+
+		if (Character == ' ')
+		{
+			LastWasUnknown = false;
+		}
+		else if (Character == '?')
+		{
+			if (!LastWasUnknown)
+			{
+				this->PatternData.push_back(0);
+				this->PatternMask.push_back(0);
+			}
+
+			LastWasUnknown = !LastWasUnknown;
+		}
+		else if (PatternCompiler::HexDigit(Character) >= 0)
+		{
+			if (HighDigit < 0)
+			{
+				HighDigit = PatternCompiler::HexDigit(Character);
+			}
+			else
+			{
+				this->PatternData.push_back((uint8_t)((HighDigit << 4) | PatternCompiler::HexDigit(Character)));
+				this->PatternMask.push_back(0xFF);
+				HighDigit = -1;
+			}
+
+			LastWasUnknown = false;
+		}
+	}
+
+	this->PatternLength = this->PatternData.size();
+
+	// The two rarest fixed bytes, earlier ones win ties
+	PatternCompiler::FindAnchors(this->PatternData.data(), this->PatternMask.data(), this->PatternLength, this->Anchors, this->HasAnchors);
+
+	this->PatternData.resize((this->PatternLength + 15) & ~(size_t)15, 0);
+	this->PatternMask.resize(this->PatternData.size(), 0);
+}
+
+PatternScan::PatternScan(const PatternView& Signature)
+{
+	this->PatternData.assign(Signature.Data, Signature.Data + Signature.PaddedLength);
+	this->PatternMask.assign(Signature.Mask, Signature.Mask + Signature.PaddedLength);
+	this->PatternLength = Signature.Length;
+	this->Anchors[0] = Signature.Anchors[0];
+	this->Anchors[1] = Signature.Anchors[1];
+	this->HasAnchors = Signature.HasAnchors;
+}
+
+PatternScan::~PatternScan()
+{
+}
+
+intptr_t PatternScan::Scan(uintptr_t Source, uintptr_t SourceSize) const
+{
+	return PatternScan::ScanSignature(this->GetView(), Source, SourceSize);
+}
+
+intptr_t PatternScan::ScanSignature(const PatternView& Signature, uintptr_t Source, uintptr_t SourceSize)
+{
+	if (SourceSize < Signature.Length)
+		return -1;
+	if (!Signature.HasAnchors)
+		return 0;
+
+	ScanState State;
+	State.Data = Signature.Data;
+	State.Mask = Signature.Mask;
+	State.Length = Signature.Length;
+	State.PaddedLength = Signature.PaddedLength;
+	State.FirstAnchor = Signature.Anchors[0];
+	State.SecondAnchor = Signature.Anchors[1];
+
+	auto Data = (const uint8_t*)Source;
+	size_t Position = 0;
+
+#if PATTERNSCAN_SIMD
+	// The vector loops leave a tail shorter than a block
+	intptr_t Result = -1;
+	auto Level = CpuFeatures::GetLevel();
+
+	if (Level >= CPU_LEVEL_AVX2)
+		Result = ScanAvx2(State, Data, SourceSize, Position);
+	if (Result < 0 && Level >= CPU_LEVEL_SSE2)
+		Result = ScanSse2(State, Data, SourceSize, Position);
+	if (Result >= 0)
+		return Result;
+#endif
+
+	return ScanScalar(State, Data, SourceSize, Position);
+}
+
+intptr_t PatternScan::ScanParallel(uintptr_t Source, uintptr_t SourceSize, uint32_t Threads) const
+{
+	auto ChunkCount = GetChunkCount(SourceSize);
+	if (Threads <= 1 || ChunkCount <= 1 || !this->HasAnchors)
+		return this->Scan(Source, SourceSize);
+
+	std::vector<intptr_t> Results(ChunkCount, -1);
+	std::atomic<uint32_t> Limit(UINT32_MAX);
+
+	ForEachChunk(ChunkCount, Threads, Limit, [&](uint32_t Chunk)
+	{
+		auto Begin = (size_t)Chunk * ParallelChunkSize;
+		auto Result = this->Scan(Source + Begin, GetChunkReadSize(SourceSize, Chunk, this->PatternLength));
+
+		if (Result >= 0)
+		{
+			Results[Chunk] = (intptr_t)Begin + Result;
+			LowerChunkLimit(Limit, Chunk);
+		}
+	});
+
+	// The lowest chunk with a match, whichever worker finished first
+	for (auto Result : Results)
+	{
+		if (Result >= 0)
+			return Result;
+	}
+
+	return -1;
+}
+
+void PatternScan::ScanAll(uintptr_t Source, uintptr_t SourceSize, std::vector<uintptr_t>& Offsets, uint32_t Threads) const
+{
+	Offsets.clear();
+
+	auto ChunkCount = GetChunkCount(SourceSize);
+	if (Threads <= 1 || ChunkCount <= 1 || !this->HasAnchors)
+	{
+		CollectMatches(*this, Source, SourceSize, 0, Offsets);
+		return;
+	}
+
+	std::vector<std::vector<uintptr_t>> Found(ChunkCount);
+	std::atomic<uint32_t> Limit(UINT32_MAX);
+
+	ForEachChunk(ChunkCount, Threads, Limit, [&](uint32_t Chunk)
+	{
+		auto Begin = (size_t)Chunk * ParallelChunkSize;
+		CollectMatches(*this, Source + Begin, GetChunkReadSize(SourceSize, Chunk, this->PatternLength), Begin, Found[Chunk]);
+	});
+
+	// A chunk can't fit a match past its starts, so every match is in one chunk and they're already in order
+	for (auto& Matches : Found)
+		Offsets.insert(Offsets.end(), Matches.begin(), Matches.end());
+}
+
+bool PatternScan::Matches(const uint8_t* Data) const
+{
+	ScanState State;
+	State.Data = this->PatternData.data();
+	State.Mask = this->PatternMask.data();
+	State.Length = this->PatternLength;
+
+	return VerifyScalar(State, Data);
+}
+
+bool PatternScan::MatchesAt(const uint8_t* Data, size_t Size, size_t Position) const
+{
+	return PatternScan::MatchesSignatureAt(this->GetView(), Data, Size, Position);
+}
+
+bool PatternScan::MatchesSignatureAt(const PatternView& Signature, const uint8_t* Data, size_t Size, size_t Position)
+{
+	if (Position > Size || Size - Position < Signature.Length)
+		return false;
+
+	ScanState State;
+	State.Data = Signature.Data;
+	State.Mask = Signature.Mask;
+	State.Length = Signature.Length;
+	State.PaddedLength = Signature.PaddedLength;
+
+#if PATTERNSCAN_SIMD
+	return VerifyCandidate(State, Data, Size, Position);
+#else
+	return VerifyScalar(State, Data + Position);
+#endif
+}
+
+PatternView PatternScan::GetView() const
+{
+	return { this->PatternData.data(), this->PatternMask.data(), this->PatternLength, this->PatternData.size(), { this->Anchors[0], this->Anchors[1] }, this->HasAnchors };
+}
+
+size_t PatternScan::GetLength() const
+{
+	return this->PatternLength;
+}
+
+uint32_t PatternScan::GetAnchor(uint32_t Index) const
+{
+	return this->Anchors[(Index != 0) ? 1 : 0];
+}
+
+uint8_t PatternScan::GetByte(size_t Index) const
+{
+	return this->PatternData[Index];
+}
+
+bool PatternScan::IsFixed(size_t Index) const
+{
+	return this->PatternMask[Index] != 0;
+}
+
+uint8_t PatternScan::GetByteRank(uint8_t Value)
+{
+	return PatternCompiler::CodeByteRanks[Value];
+}
+
+size_t PatternScan::GetChunkSize()
+{
+	return ParallelChunkSize;
+}
+
+// Signatures a set holds, a bit each in 64 groups
+static const uint32_t MaximumPatterns = 512;
+
+// A single pass over a range for a set of signatures
+struct MultiScanState
+{
+	const PatternScan* Patterns;
+	const uint32_t* Anchors;
+	const PatternAnchorGroup* Groups;
+	uint32_t GroupCount;
+	const uint8_t* Data;
+	size_t Size;
+	bool FirstOnly;
+	// The signatures of every group not found yet, all of them unless FirstOnly is set
+	uint8_t Remaining[MaximumPatterns / 8];
+	uint32_t RemainingCount;
+	std::vector<PatternMatch>* Matches;
+};
+
+// Gets the signatures of a group whose anchor pair starts at an offset, the end of the range matches any second byte
+static uint32_t GetAnchorBits(const MultiScanState& State, uint32_t Group, size_t Offset)
+{
+	auto& Tables = State.Groups[Group];
+	uint32_t Bits = Tables.Bytes[0][State.Data[Offset]] & State.Remaining[Group];
+
+	if (Offset + 1 < State.Size)
+		Bits &= Tables.Bytes[1][State.Data[Offset + 1]];
+
+	return Bits;
+}
+
+// Verifies the signatures anchored at an offset, true once every signature was found
+static bool TestAnchor(MultiScanState& State, size_t Offset)
+{
+	for (uint32_t g = 0; g < State.GroupCount; g++)
+	{
+		auto Bits = GetAnchorBits(State, g, Offset);
+
+		while (Bits != 0)
+		{
+			auto Bit = LowestBit(Bits);
+			Bits &= Bits - 1;
+
+			auto Id = g * 8 + Bit;
+			auto Anchor = State.Anchors[Id];
+
+			if (Offset < Anchor || !State.Patterns[Id].MatchesAt(State.Data, State.Size, Offset - Anchor))
+				continue;
+
+			State.Matches->push_back({ Id, (uintptr_t)(Offset - Anchor) });
+
+			if (State.FirstOnly)
+			{
+				State.Remaining[g] &= (uint8_t)~(1u << Bit);
+				if (--State.RemainingCount == 0)
+					return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+// Every anchor a byte at a time, from Position to the end
+static void MultiScanScalar(MultiScanState& State, size_t Position)
+{
+	for (; Position < State.Size; Position++)
+	{
+		uint32_t Any = 0;
+		for (uint32_t g = 0; g < State.GroupCount; g++)
+			Any |= GetAnchorBits(State, g, Position);
+
+		if (Any != 0 && TestAnchor(State, Position))
+			return;
+	}
+}
+
+#if PATTERNSCAN_SIMD
+
+// Verifies every byte of a block with an anchor bit set, true once every signature was found
+static bool TestAnchorBlock(MultiScanState& State, size_t Position, uint32_t Hits)
+{
+	while (Hits != 0)
+	{
+		if (TestAnchor(State, Position + LowestBit(Hits)))
+			return true;
+
+		Hits &= Hits - 1;
+	}
+
+	return false;
+}
+
+// Looks a block up in a group's nibble tables, the bits of the signatures whose byte it could be
+PATTERNSCAN_TARGET("ssse3")
+static __m128i LookupNibbles(const uint8_t* LowNibbles, const uint8_t* HighNibbles, __m128i Low, __m128i High)
+{
+	return _mm_and_si128(_mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)LowNibbles), Low), _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)HighNibbles), High));
+}
+
+// 16 starts at a time, both bytes of every start looked up in the tables of every group
+PATTERNSCAN_TARGET("ssse3")
+static size_t MultiScanSsse3(MultiScanState& State, size_t Position)
+{
+	auto LowBits = _mm_set1_epi8(0x0F);
+	auto Zero = _mm_setzero_si128();
+
+	// The second bytes are read one past the block
+	while (State.Size - Position >= 17)
+	{
+		auto First = _mm_loadu_si128((const __m128i*)(State.Data + Position));
+		auto Second = _mm_loadu_si128((const __m128i*)(State.Data + Position + 1));
+		auto FirstLow = _mm_and_si128(First, LowBits);
+		auto FirstHigh = _mm_and_si128(_mm_srli_epi16(First, 4), LowBits);
+		auto SecondLow = _mm_and_si128(Second, LowBits);
+		auto SecondHigh = _mm_and_si128(_mm_srli_epi16(Second, 4), LowBits);
+		auto Any = Zero;
+
+		for (uint32_t g = 0; g < State.GroupCount; g++)
+		{
+			auto& Tables = State.Groups[g];
+
+			auto Bits = _mm_and_si128(LookupNibbles(Tables.LowNibbles[0], Tables.HighNibbles[0], FirstLow, FirstHigh), LookupNibbles(Tables.LowNibbles[1], Tables.HighNibbles[1], SecondLow, SecondHigh));
+			Any = _mm_or_si128(Any, _mm_and_si128(Bits, _mm_set1_epi8((char)State.Remaining[g])));
+		}
+
+		auto Hits = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(Any, Zero)) ^ 0xFFFF;
+		if (Hits != 0 && TestAnchorBlock(State, Position, Hits))
+			return State.Size;
+
+		Position += 16;
+	}
+
+	return Position;
+}
+
+// Looks a block up in a group's nibble tables, repeated in both lanes
+PATTERNSCAN_TARGET("avx2")
+static __m256i LookupNibbles(const uint8_t* LowNibbles, const uint8_t* HighNibbles, __m256i Low, __m256i High)
+{
+	auto LowTable = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)LowNibbles));
+	auto HighTable = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)HighNibbles));
+
+	return _mm256_and_si256(_mm256_shuffle_epi8(LowTable, Low), _mm256_shuffle_epi8(HighTable, High));
+}
+
+// The same 32 starts at a time
+PATTERNSCAN_TARGET("avx2")
+static size_t MultiScanAvx2(MultiScanState& State, size_t Position)
+{
+	auto LowBits = _mm256_set1_epi8(0x0F);
+	auto Zero = _mm256_setzero_si256();
+
+	while (State.Size - Position >= 33)
+	{
+		auto First = _mm256_loadu_si256((const __m256i*)(State.Data + Position));
+		auto Second = _mm256_loadu_si256((const __m256i*)(State.Data + Position + 1));
+		auto FirstLow = _mm256_and_si256(First, LowBits);
+		auto FirstHigh = _mm256_and_si256(_mm256_srli_epi16(First, 4), LowBits);
+		auto SecondLow = _mm256_and_si256(Second, LowBits);
+		auto SecondHigh = _mm256_and_si256(_mm256_srli_epi16(Second, 4), LowBits);
+		auto Any = Zero;
+
+		for (uint32_t g = 0; g < State.GroupCount; g++)
+		{
+			auto& Tables = State.Groups[g];
+
+			auto Bits = _mm256_and_si256(LookupNibbles(Tables.LowNibbles[0], Tables.HighNibbles[0], FirstLow, FirstHigh), LookupNibbles(Tables.LowNibbles[1], Tables.HighNibbles[1], SecondLow, SecondHigh));
+			Any = _mm256_or_si256(Any, _mm256_and_si256(Bits, _mm256_set1_epi8((char)State.Remaining[g])));
+		}
+
+		if (!_mm256_testz_si256(Any, Any))
+		{
+			auto Hits = ~(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(Any, Zero));
+			if (TestAnchorBlock(State, Position, Hits))
+				return State.Size;
+		}
+
+		Position += 32;
+	}
+
+	return Position;
+}
+
+#endif
+
+MultiPatternScan::MultiPatternScan()
+{
+}
+
+MultiPatternScan::~MultiPatternScan()
+{
+}
+
+uint32_t MultiPatternScan::Add(const char* Pattern)
+{
+	if (this->Patterns.size() >= MaximumPatterns)
+		return UINT32_MAX;
+
+	this->Patterns.emplace_back(Pattern);
+	return this->AddAnchors();
+}
+
+uint32_t MultiPatternScan::Add(const PatternView& Signature)
+{
+	if (this->Patterns.size() >= MaximumPatterns)
+		return UINT32_MAX;
+
+	this->Patterns.emplace_back(Signature);
+	return this->AddAnchors();
+}
+
+uint32_t MultiPatternScan::AddAnchors()
+{
+	auto Id = (uint32_t)this->Patterns.size() - 1;
+
+	if ((Id % 8) == 0)
+	{
+		this->Groups.push_back(PatternAnchorGroup());
+		std::memset(&this->Groups.back(), 0, sizeof(PatternAnchorGroup));
+	}
+
+	auto& Group = this->Groups.back();
+	auto& Added = this->Patterns.back();
+	auto Bit = (uint8_t)(1u << (Id % 8));
+
+	// The adjacent fixed pair with the rarest bytes, or the rarest byte alone when no two fixed bytes touch
+	auto Anchor = Added.GetAnchor(0);
+	bool Paired = false;
+	uint32_t BestRank = 0;
+
+	for (uint32_t i = 0; i + 1 < (uint32_t)Added.GetLength(); i++)
+	{
+		if (!Added.IsFixed(i) || !Added.IsFixed(i + 1))
+			continue;
+
+		auto Rank = (uint32_t)PatternScan::GetByteRank(Added.GetByte(i)) + PatternScan::GetByteRank(Added.GetByte(i + 1));
+		if (!Paired || Rank < BestRank)
+		{
+			Anchor = i;
+			BestRank = Rank;
+			Paired = true;
+		}
+	}
+
+	this->Anchors.push_back(Anchor);
+
+	// A signature of wildcards has no anchor, it's matched outside the tables
+	if (Added.GetLength() == 0 || !Added.IsFixed(Anchor))
+		return Id;
+
+	for (uint32_t Index = 0; Index < 2; Index++)
+	{
+		if (Index == 1 && !Paired)
+		{
+			for (uint32_t Nibble = 0; Nibble < 16; Nibble++)
+			{
+				Group.LowNibbles[1][Nibble] |= Bit;
+				Group.HighNibbles[1][Nibble] |= Bit;
+			}
+			for (uint32_t Value = 0; Value < 256; Value++)
+				Group.Bytes[1][Value] |= Bit;
+
+			break;
+		}
+
+		auto Byte = Added.GetByte(Anchor + Index);
+
+		Group.LowNibbles[Index][Byte & 15] |= Bit;
+		Group.HighNibbles[Index][Byte >> 4] |= Bit;
+		Group.Bytes[Index][Byte] |= Bit;
+	}
+
+	return Id;
+}
+
+uint32_t MultiPatternScan::GetCount() const
+{
+	return (uint32_t)this->Patterns.size();
+}
+
+bool MultiPatternScan::MatchesAt(uint32_t Id, const uint8_t* Data, size_t Size, size_t Position) const
+{
+	if (Id >= (uint32_t)this->Patterns.size())
+		return false;
+
+	return this->Patterns[Id].MatchesAt(Data, Size, Position);
+}
+
+uint64_t MultiPatternScan::GetHash() const
+{
+	auto Hash = Hashing::Fnv1aOffsetBasis;
+
+	for (auto& Pattern : this->Patterns)
+	{
+		auto View = Pattern.GetView();
+		uint64_t Length = View.Length;
+
+		for (size_t i = 0; i < sizeof(Length); i++)
+			Hash = Hashing::Fnv1a64Update(Hash, (uint8_t)(Length >> (i * 8)));
+
+		for (size_t i = 0; i < View.Length; i++)
+		{
+			Hash = Hashing::Fnv1a64Update(Hash, View.Data[i]);
+			Hash = Hashing::Fnv1a64Update(Hash, View.Mask[i]);
+		}
+	}
+
+	return Hash;
+}
+
+void MultiPatternScan::ScanRange(const uint8_t* Data, size_t Size, bool FirstOnly, std::vector<PatternMatch>& Matches) const
+{
+	MultiScanState State;
+	State.Patterns = this->Patterns.data();
+	State.Anchors = this->Anchors.data();
+	State.Groups = this->Groups.data();
+	State.GroupCount = (uint32_t)this->Groups.size();
+	State.Data = Data;
+	State.Size = Size;
+	State.FirstOnly = FirstOnly;
+	State.RemainingCount = 0;
+	State.Matches = &Matches;
+
+	for (uint32_t g = 0; g < State.GroupCount; g++)
+	{
+		State.Remaining[g] = 0;
+
+		for (uint32_t Id = g * 8; Id < (uint32_t)this->Patterns.size() && Id < g * 8 + 8; Id++)
+		{
+			auto& Pattern = this->Patterns[Id];
+
+			// Wildcards alone match wherever they fit
+			if (Pattern.GetLength() == 0 || !Pattern.IsFixed(this->Anchors[Id]))
+			{
+				for (size_t Offset = 0; Offset + Pattern.GetLength() <= Size; Offset++)
+				{
+					Matches.push_back({ Id, (uintptr_t)Offset });
+					if (FirstOnly)
+						break;
+				}
+
+				continue;
+			}
+
+			State.Remaining[g] |= (uint8_t)(1u << (Id % 8));
+			State.RemainingCount++;
+		}
+	}
+
+	if (State.RemainingCount == 0)
+		return;
+
+	size_t Position = 0;
+
+#if PATTERNSCAN_SIMD
+	auto Level = CpuFeatures::GetLevel();
+
+	if (Level >= CPU_LEVEL_AVX2)
+		Position = MultiScanAvx2(State, Position);
+	if (Level >= CPU_LEVEL_SSSE3)
+		Position = MultiScanSsse3(State, Position);
+#endif
+
+	MultiScanScalar(State, Position);
+}
+
+void MultiPatternScan::ScanChunks(const uint8_t* Data, size_t Size, bool FirstOnly, uint32_t Threads, std::vector<PatternMatch>& Matches) const
+{
+	size_t Longest = 0;
+	for (auto& Pattern : this->Patterns)
+		Longest = std::max(Longest, Pattern.GetLength());
+
+	auto ChunkCount = GetChunkCount(Size);
+	if (Threads <= 1 || ChunkCount <= 1 || Longest == 0)
+	{
+		this->ScanRange(Data, Size, FirstOnly, Matches);
+		return;
+	}
+
+	std::vector<std::vector<PatternMatch>> Found(ChunkCount);
+	std::atomic<uint32_t> Limit(UINT32_MAX);
+
+	ForEachChunk(ChunkCount, Threads, Limit, [&](uint32_t Chunk)
+	{
+		auto Begin = (size_t)Chunk * ParallelChunkSize;
+		auto Starts = GetChunkStarts(Size, Chunk);
+		auto& Chunked = Found[Chunk];
+
+		this->ScanRange(Data + Begin, GetChunkReadSize(Size, Chunk, Longest), FirstOnly, Chunked);
+
+		// Signatures shorter than the longest can match past the starts, those belong to the next chunk
+		if (Begin + Starts < Size)
+			Chunked.erase(std::remove_if(Chunked.begin(), Chunked.end(), [&](const PatternMatch& Match) { return Match.Offset >= Starts; }), Chunked.end());
+
+		for (auto& Match : Chunked)
+			Match.Offset += Begin;
+
+		// A chunk with every signature has their lowest matches, unless an earlier chunk has them too
+		if (FirstOnly && Chunked.size() == this->Patterns.size())
+			LowerChunkLimit(Limit, Chunk);
+	});
+
+	for (auto& Chunked : Found)
+		Matches.insert(Matches.end(), Chunked.begin(), Chunked.end());
+}
+
+bool MultiPatternScan::UsesOnePass()
+{
+#if PATTERNSCAN_SIMD
+	return (CpuFeatures::GetLevel() >= CPU_LEVEL_SSSE3);
+#else
+	return false;
+#endif
+}
+
+void MultiPatternScan::ScanAll(uintptr_t Source, uintptr_t SourceSize, std::vector<PatternMatch>& Matches, uint32_t Threads) const
+{
+	Matches.clear();
+
+	if (UsesOnePass())
+	{
+		this->ScanChunks((const uint8_t*)Source, SourceSize, false, Threads, Matches);
+	}
+	else
+	{
+		std::vector<uintptr_t> Offsets;
+		for (uint32_t Id = 0; Id < (uint32_t)this->Patterns.size(); Id++)
+		{
+			this->Patterns[Id].ScanAll(Source, SourceSize, Offsets, Threads);
+
+			for (auto Offset : Offsets)
+				Matches.push_back({ Id, Offset });
+		}
+	}
+
+	// Found in anchor order, or signature by signature, either differs from offset order
+	std::sort(Matches.begin(), Matches.end(), [](const PatternMatch& Left, const PatternMatch& Right)
+	{
+		return (Left.Offset != Right.Offset) ? (Left.Offset < Right.Offset) : (Left.Id < Right.Id);
+	});
+}
+
+void MultiPatternScan::ScanFirst(uintptr_t Source, uintptr_t SourceSize, std::vector<intptr_t>& Offsets, uint32_t Threads) const
+{
+	if (!UsesOnePass())
+	{
+		Offsets.resize(this->Patterns.size());
+		for (size_t Id = 0; Id < this->Patterns.size(); Id++)
+			Offsets[Id] = this->Patterns[Id].ScanParallel(Source, SourceSize, Threads);
+
+		return;
+	}
+
+	std::vector<PatternMatch> Matches;
+	this->ScanChunks((const uint8_t*)Source, SourceSize, true, Threads, Matches);
+
+	// A signature's anchor is at a fixed offset in it, so its first anchor hit is its lowest match in a chunk, and
+	// the chunks are in order
+	Offsets.assign(this->Patterns.size(), -1);
+	for (auto& Match : Matches)
+	{
+		if (Offsets[Match.Id] < 0)
+			Offsets[Match.Id] = (intptr_t)Match.Offset;
+	}
+}
\ No newline at end of file
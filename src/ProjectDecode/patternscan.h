@@ -0,0 +1,131 @@
+#pragma once
+
+// Standard includes
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// Our includes
+#include "patternsignature.h"
+
+//
+// Masked byte signatures found in code, written as hex bytes with ? for any byte ("55 8B EC ? 56"). Candidates
+// come from the two fixed bytes least common in x86 code, compared a vector at a time, then the whole signature
+// is verified with masked compares. The instruction set is detected once by CpuFeatures. Large ranges can be split
+// into chunks of starts for a few workers, each chunk reading on past its last start by the signature's length, so a
+// match over a boundary is found once, by the chunk it starts in. Signatures written in the code are parsed by the
+// compiler instead (patternsignature.h) and scanned with ScanSignature.
+//
+
+class PatternScan
+{
+private:
+	// The bytes and the mask (0xFF fixed, 0 any), padded with wildcards to whole 16 byte blocks
+	std::vector<uint8_t> PatternData;
+	std::vector<uint8_t> PatternMask;
+	// The amount of bytes the signature covers
+	size_t PatternLength;
+	// Offsets of the two rarest fixed bytes, the same offset twice when there is only one
+	uint32_t Anchors[2];
+	// Whether or not any byte is fixed, a signature of wildcards matches anywhere
+	bool HasAnchors;
+
+public:
+	PatternScan(const char* Pattern);
+	PatternScan(const PatternView& Signature);
+	~PatternScan();
+
+	// Scan the given memory range for the pattern, returns the offset of the first match from Source, or -1
+	intptr_t Scan(uintptr_t Source, uintptr_t SourceSize) const;
+	// Scan the given memory range for a parsed signature, as Scan does without parsing or allocating anything
+	static intptr_t ScanSignature(const PatternView& Signature, uintptr_t Source, uintptr_t SourceSize);
+	// Scan the range in chunks on up to Threads workers, returns the same offset Scan does
+	intptr_t ScanParallel(uintptr_t Source, uintptr_t SourceSize, uint32_t Threads) const;
+	// Finds every match in the range, ordered by offset, on up to Threads workers
+	void ScanAll(uintptr_t Source, uintptr_t SourceSize, std::vector<uintptr_t>& Offsets, uint32_t Threads = 1) const;
+
+	// Whether or not the signature matches at an address, which must hold the whole signature
+	bool Matches(const uint8_t* Data) const;
+	// Whether or not the signature matches at an offset of a range, false if it doesn't fit
+	bool MatchesAt(const uint8_t* Data, size_t Size, size_t Position) const;
+	// Whether or not a parsed signature matches at an offset of a range, false if it doesn't fit
+	static bool MatchesSignatureAt(const PatternView& Signature, const uint8_t* Data, size_t Size, size_t Position);
+	// Gets the signature as the scan loops read it, valid while the scanner is
+	PatternView GetView() const;
+	// Gets the amount of bytes the signature covers
+	size_t GetLength() const;
+	// Gets the offset of an anchor (0 the rarest byte, 1 the next rarest)
+	uint32_t GetAnchor(uint32_t Index) const;
+	// Gets a byte of the signature, zero for wildcards
+	uint8_t GetByte(size_t Index) const;
+	// Whether or not a byte of the signature is fixed
+	bool IsFixed(size_t Index) const;
+
+	// Gets how common a byte is in x86 code, from 0 for the rarest to 255 for the most common
+	static uint8_t GetByteRank(uint8_t Value);
+	// Gets the amount of starts a worker takes at once in the chunked scans
+	static size_t GetChunkSize();
+};
+
+// A match of one of a set's signatures
+struct PatternMatch
+{
+	uint32_t Id;
+	uintptr_t Offset;
+};
+
+//
+// A set of signatures found in one pass. Each signature's rarest pair of adjacent fixed bytes is a bit in nibble
+// tables, so two loads and four byte shuffles test a block for up to 8 signatures at once (SSSE3 and AVX2). Without
+// the shuffles a byte at a time pass is slower than scanning for each signature alone, so below SSSE3 the set is
+// scanned once per signature with PatternScan. Candidates are verified as PatternScan does. Sets hold up to 512
+// signatures.
+//
+
+// Up to 8 signatures tested together, a bit each, for both bytes of their anchor pairs. A byte is in a signature's
+// pair when the bit is in both of its nibble entries. A signature without two adjacent fixed bytes has every bit set
+// for its second byte
+struct PatternAnchorGroup
+{
+	uint8_t LowNibbles[2][16];
+	uint8_t HighNibbles[2][16];
+	// The same for whole bytes, for the byte at a time levels
+	uint8_t Bytes[2][256];
+};
+
+class MultiPatternScan
+{
+private:
+	std::vector<PatternScan> Patterns;
+	std::vector<uint32_t> Anchors;
+	std::vector<PatternAnchorGroup> Groups;
+
+	// Adds the anchor pair of the signature added last to its group, returns its id
+	uint32_t AddAnchors();
+	// Scans a range once, only for the signatures still unfound when FirstOnly is set
+	void ScanRange(const uint8_t* Data, size_t Size, bool FirstOnly, std::vector<PatternMatch>& Matches) const;
+	// Scans a range in chunks on up to Threads workers, the matches of every chunk in chunk order
+	void ScanChunks(const uint8_t* Data, size_t Size, bool FirstOnly, uint32_t Threads, std::vector<PatternMatch>& Matches) const;
+	// Whether or not one pass beats a scan per signature at the current instruction set level
+	static bool UsesOnePass();
+
+public:
+	MultiPatternScan();
+	~MultiPatternScan();
+
+	// Adds a signature to the set, returns its id, the order it was added in, or UINT32_MAX when the set is full
+	uint32_t Add(const char* Pattern);
+	// Adds a parsed signature to the set, as Add does
+	uint32_t Add(const PatternView& Signature);
+	// Gets the amount of signatures in the set
+	uint32_t GetCount() const;
+	// Whether or not a signature of the set matches at an offset of a range, false if it doesn't fit
+	bool MatchesAt(uint32_t Id, const uint8_t* Data, size_t Size, size_t Position) const;
+	// Hashes the bytes and masks of every signature in order, the same for the same set
+	uint64_t GetHash() const;
+
+	// Finds every match of every signature, ordered by offset and then id, on up to Threads workers
+	void ScanAll(uintptr_t Source, uintptr_t SourceSize, std::vector<PatternMatch>& Matches, uint32_t Threads = 1) const;
+	// Finds the first match of every signature, an offset or -1 for every id. Stops once they are all found
+	void ScanFirst(uintptr_t Source, uintptr_t SourceSize, std::vector<intptr_t>& Offsets, uint32_t Threads = 1) const;
+};
\ No newline at end of file
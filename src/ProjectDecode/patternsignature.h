@@ -0,0 +1,205 @@
+#pragma once
+
+// Standard includes
+#include <cstdint>
+#include <cstddef>
+
+//
+// Signatures parsed by the compiler. CompilePattern("55 8B EC ? 56") gives a static CompiledPattern with the bytes,
+// mask and anchors the scan loops read, and a signature that isn't well formed stops the build. Bytes are two hex
+// digits and wildcards ? or ??, separated by single or repeated spaces.
+//
+
+// A parsed signature as the scan loops read it, owned by whoever parsed it
+struct PatternView
+{
+	// The bytes and the mask (0xFF fixed, 0 any), padded with wildcards to whole 16 byte blocks
+	const uint8_t* Data;
+	const uint8_t* Mask;
+	// The amount of bytes the signature covers and with the padding
+	size_t Length;
+	size_t PaddedLength;
+	// Offsets of the two rarest fixed bytes, the same offset twice when there is only one
+	uint32_t Anchors[2];
+	// Whether or not any byte is fixed, a signature of wildcards matches anywhere
+	bool HasAnchors;
+};
+
+namespace PatternCompiler
+{
+	// How common every byte is in the code sections of MSVC x86 builds (1.3 MB measured), 0 the rarest
+	inline constexpr uint8_t CodeByteRanks[256] =
+	{
+		255, 241, 226, 224, 238, 193, 200, 197, 243, 173, 172, 166, 239, 164, 150, 247,
+		231, 127, 123, 136, 204, 203, 163,  94, 192,  88,  87, 137, 167, 108,  82, 116,
+		190,  47, 102, 121, 206, 141,  54,  35, 144,  63,  76, 195, 130,  56,  34,  22,
+		179,  81, 106, 235, 140, 161,  92,  32, 165, 188,  72, 227, 160, 143,  79,  67,
+		236, 223, 207, 176, 184, 245, 219, 135, 174, 101,  43,  57, 139, 213, 128,  53,
+		240, 185,  86, 215, 118, 218, 225, 209, 145, 234,  39, 157, 104, 220, 196, 170,
+		114,  48,   8,  16, 117,  95, 202,  19, 208,  24, 232,  42,  99,  20,  18,  31,
+		159,  85, 153, 126, 248, 250, 154, 113, 124,  51,  14,  29, 120, 199, 138, 142,
+		205, 168,  74, 251, 211, 249,  71,  37, 177, 246, 169, 253, 111, 242,  55,  58,
+		105,  23,  15,  13,  90, 119,   4,   6,  61,  52,   2,   7,  59,  97,   5, 109,
+		 96, 147,   3, 103,  80,  49,   9,   0, 125,  21,   1,  25,  84,  10,  11,  12,
+		148,  33,  28,  17,  70, 146, 194, 152, 149,  73,  40,  41,  65, 155, 112,  66,
+		244, 214, 178, 237, 212,  77, 191, 221, 187, 186,  98,  75, 183,  60, 100, 110,
+		175, 129, 156, 115,  91,  26, 133,  69, 171,  78,  64, 151, 131,  50,  38,  36,
+		198,  93,  62,  27, 180, 158,  83,  45, 252, 201,  44, 233, 222,  30,  46,  89,
+		216, 132, 107, 122, 182,  68, 210, 181, 230, 162, 134, 189, 229, 217, 228, 254,
+	};
+
+	// Gets the value of a hex digit, -1 if it isn't one
+	constexpr int32_t HexDigit(char Character)
+	{
+		if (Character >= '0' && Character <= '9')
+			return Character - '0';
+		if (Character >= 'A' && Character <= 'F')
+			return Character - 'A' + 10;
+		if (Character >= 'a' && Character <= 'f')
+			return Character - 'a' + 10;
+
+		return -1;
+	}
+
+	// Counts the space separated tokens of a signature, its length when it's well formed
+	constexpr size_t CountBytes(const char* Pattern)
+	{
+		size_t Count = 0;
+		bool InToken = false;
+
+		for (; *Pattern != 0; Pattern++)
+		{
+			if (*Pattern == ' ')
+			{
+				InToken = false;
+			}
+			else if (!InToken)
+			{
+				InToken = true;
+				Count++;
+			}
+		}
+
+		return Count;
+	}
+
+	// Picks the two rarest fixed bytes as anchors, earlier ones win ties
+	constexpr void FindAnchors(const uint8_t* Data, const uint8_t* Mask, size_t Length, uint32_t* Anchors, bool& HasAnchors)
+	{
+		HasAnchors = false;
+		Anchors[0] = 0;
+		Anchors[1] = 0;
+
+		for (uint32_t i = 0; i < (uint32_t)Length; i++)
+		{
+			if (Mask[i] == 0)
+				continue;
+
+			auto Rank = CodeByteRanks[Data[i]];
+
+			if (!HasAnchors)
+			{
+				Anchors[0] = i;
+				Anchors[1] = i;
+				HasAnchors = true;
+			}
+			else if (Rank < CodeByteRanks[Data[Anchors[0]]])
+			{
+				Anchors[1] = Anchors[0];
+				Anchors[0] = i;
+			}
+			else if (Anchors[1] == Anchors[0] || Rank < CodeByteRanks[Data[Anchors[1]]])
+			{
+				Anchors[1] = i;
+			}
+		}
+	}
+}
+
+// A signature parsed into storage for up to Capacity bytes, CompilePattern sizes it exactly
+template<size_t Capacity>
+class CompiledPattern
+{
+public:
+	// Whole blocks, and one for an empty signature so the arrays aren't empty
+	static constexpr size_t PaddedCapacity = (Capacity > 0) ? ((Capacity + 15) & ~(size_t)15) : 16;
+
+	uint8_t Data[PaddedCapacity];
+	uint8_t Mask[PaddedCapacity];
+	size_t Length;
+	uint32_t Anchors[2];
+	bool HasAnchors;
+	// What's wrong with the signature, or null when it's well formed
+	const char* Error;
+
+	constexpr CompiledPattern(const char* Pattern)
+		: Data(), Mask(), Length(0), Anchors(), HasAnchors(false), Error(nullptr)
+	{
+		while (*Pattern != 0 && this->Error == nullptr)
+		{
+			if (*Pattern == ' ')
+			{
+				Pattern++;
+				continue;
+			}
+
+			// A token runs to the next space
+			size_t TokenLength = 0;
+			while (Pattern[TokenLength] != 0 && Pattern[TokenLength] != ' ')
+				TokenLength++;
+
+			if (this->Length >= Capacity)
+			{
+				this->Error = "more bytes than the pattern has room for";
+			}
+			else if (Pattern[0] == '?')
+			{
+				if (TokenLength > 2 || (TokenLength == 2 && Pattern[1] != '?'))
+					this->Error = "a wildcard is ? or ??";
+
+				this->Length++;
+			}
+			else if (PatternCompiler::HexDigit(Pattern[0]) < 0 || (TokenLength > 1 && PatternCompiler::HexDigit(Pattern[1]) < 0))
+			{
+				this->Error = "a byte is two hex digits";
+			}
+			else if (TokenLength != 2)
+			{
+				this->Error = "a byte is two hex digits, with spaces between bytes";
+			}
+			else
+			{
+				this->Data[this->Length] = (uint8_t)((PatternCompiler::HexDigit(Pattern[0]) << 4) | PatternCompiler::HexDigit(Pattern[1]));
+				this->Mask[this->Length] = 0xFF;
+				this->Length++;
+			}
+
+			Pattern += TokenLength;
+		}
+
+		if (this->Error != nullptr)
+			return;
+
+		PatternCompiler::FindAnchors(this->Data, this->Mask, this->Length, this->Anchors, this->HasAnchors);
+
+		if (this->Length == 0)
+			this->Error = "the signature is empty";
+		else if (!this->HasAnchors)
+			this->Error = "the signature has no fixed byte";
+	}
+
+	// Whether or not the signature is well formed
+	constexpr bool IsValid() const
+	{
+		return this->Error == nullptr;
+	}
+
+	// Gets the signature as the scan loops read it
+	constexpr PatternView GetView() const
+	{
+		return { this->Data, this->Mask, this->Length, (this->Length + 15) & ~(size_t)15, { this->Anchors[0], this->Anchors[1] }, this->HasAnchors };
+	}
+};
+
+// Parses a signature literal at compile time into a static CompiledPattern, a malformed one fails the build
+#define CompilePattern(Pattern) ([]() -> const CompiledPattern<PatternCompiler::CountBytes(Pattern)>& { static constexpr CompiledPattern<PatternCompiler::CountBytes(Pattern)> Compiled(Pattern); static_assert(Compiled.IsValid(), "Malformed signature: " Pattern); return Compiled; }())
\ No newline at end of file
@@ -15,199 +15,22 @@
 #include <cstdint>
 #include <string>
 
+// Our includes
+#include "patternscan.h"
+
 //
 // Begin macro definitions
 //
 
 // Attempt to patch bytes in the given memory range
 #define PatchMemory(Source, Data, Size) MemPatch().Patch((uintptr_t)Source, (const uint8_t*)Data, (uintptr_t)Size);
-// Attempt to find the pattern at the given memory range
-#define FindPattern(Pattern, Start, Size) PatternScan(Pattern).Scan((uintptr_t)Start, (uintptr_t)Size);
+// Attempt to find the pattern at the given memory range, the pattern is parsed by the compiler
+#define FindPattern(Pattern, Start, Size) PatternScan::ScanSignature(CompilePattern(Pattern).GetView(), (uintptr_t)Start, (uintptr_t)Size);
 
 //
 // Begin hooking utilities
 //
 
-class PatternScan
-{
-private:
-	std::string PatternData;
-	std::string PatternMask;
-
-public:
-	PatternScan(LPCSTR Pattern)
-	{
-		// Buffers for temporary processing flags
-		uint8_t TempDigit = 0;
-		bool TempFlag = false;
-		bool LastWasUnknown = false;
-
-		// Iterate over all bytes
-		for (size_t i = 0; i < strlen(Pattern); i++)
-		{
-			auto& ch = Pattern[i];
-
-			// If it's a space, just skip it
-			if (ch == ' ')
-			{
-				// Reset
-				LastWasUnknown = false;
-				// Skip
-				continue;
-			}
-			else if (ch == '?')
-			{
-				// This is an unknown instance
-				if (LastWasUnknown)
-				{
-					// This is second one, just disable
-					LastWasUnknown = false;
-				}
-				else
-				{
-					// Append mask
-					PatternData += '\x00';
-					PatternMask += '?';
-					// Set it
-					LastWasUnknown = true;
-				}
-			}
-			else if ((ch >= '0' && ch <= '9') || (ch >= 'A' && ch <= 'F') || (ch >= 'a' && ch <= 'f'))
-			{
-				// This is a hex value
-				char StrBuffer[] = { ch, 0 };
-				// Convert to digit
-				int thisDigit = strtol(StrBuffer, nullptr, 16);
-
-				// Check if we need the second digit
-				if (!TempFlag)
-				{
-					// We do
-					TempDigit = (thisDigit << 4);
-					TempFlag = true;
-				}
-				else
-				{
-					// This is the second digit, process
-					TempDigit |= thisDigit;
-					TempFlag = false;
-
-					// Append data to mask and data string
-					PatternData += TempDigit;
-					PatternMask += 'x';
-				}
-
-				// Reset
-				LastWasUnknown = false;
-			}
-		}
-	}
-
-	~PatternScan() { }
-
-	// Scan the given memory range for a pattern
-	intptr_t Scan(uintptr_t Source, uintptr_t SourceSize)
-	{
-		// Scan a block of memory for the given pattern, check for SSE4.2
-		bool UseSSE = false;
-		
-		// Only use SSE on patterns 16 bytes or less
-		if (this->PatternMask.size() <= 16)
-		{
-			// The CPU info buffer
-			int cpuid[4]; __cpuid(cpuid, 0);
-
-			// Check for support
-			if (cpuid[0] >= 1)
-			{
-				__cpuidex(cpuid, 1, 0);
-				// Whether or not we have support for it
-				UseSSE = ((cpuid[2] & (1 << 20)) > 0);
-			}
-		}
-
-		// If we can't use SSE just check each byte
-		if (!UseSSE)
-		{
-			// Convert
-			const char* PatternData = this->PatternData.c_str();
-			const char* MaskData = this->PatternMask.c_str();
-
-			// Data to search
-			char* DataPtr = (char*)Source;
-
-			// Check each
-			for (uint64_t i = 0; i < SourceSize; i++)
-			{
-				// If we found it
-				bool IsMatch = true;
-				// Check for a match, if success, return it
-				for (size_t c = 0; c < this->PatternData.size(); c++)
-				{
-					// Check
-					if (this->PatternMask[c] == '?')
-					{
-						// Skip
-						continue;
-					}
-
-					// Check the data
-					if (PatternData[c] != DataPtr[i + c])
-					{
-						// Not match
-						IsMatch = false;
-						// Stop
-						break;
-					}
-				}
-				// Check
-				if (IsMatch)
-				{
-					// Return result
-					return (intptr_t)(i);
-				}
-			}
-		}
-		else
-		{
-			// We can use SSE to speed this up
-			__declspec(align(16)) char DesiredMask[16] = { 0 };
-
-			// Build the mask
-			for (size_t i = 0; i < this->PatternMask.size(); i++)
-			{
-				DesiredMask[i / 8] |= ((this->PatternMask[i] == '?') ? 0 : 1) << (i % 8);
-			}
-
-			// Load the mask and the data
-			__m128i Mask = _mm_load_si128((const __m128i*)DesiredMask);
-			__m128i Comparand = _mm_loadu_si128((const __m128i*)this->PatternData.c_str());
-
-			// Loop and compare data in up to 16 byte chunks (SSE4.2)
-			for (uint64_t i = Source; i <= (Source + SourceSize); i++)
-			{
-				// Compare
-				__m128i Value = _mm_loadu_si128((const __m128i*)i);
-				__m128i Result = _mm_cmpestrm(Value, 16, Comparand, (int)this->PatternData.size(), _SIDD_CMP_EQUAL_EACH);
-
-				// See if we can match with the mask
-				__m128i Matches = _mm_and_si128(Mask, Result);
-				__m128i Equivalence = _mm_xor_si128(Mask, Matches);
-
-				// Test the result
-				if (_mm_test_all_zeros(Equivalence, Equivalence))
-				{
-					// We got a result here return it
-					return (intptr_t)(i - Source);
-				}
-			}
-		}
-
-		// Failed to locate pattern
-		return -1;
-	}
-};
-
 // A class that provides information about the main module
 class MainModule
 {
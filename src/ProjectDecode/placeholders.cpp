@@ -0,0 +1,79 @@
+// The class we are implementing
+#include "placeholders.h"
+
+// Longest literal a single segment holds
+static const size_t MaximumLiteral = 0xFFFF;
+
+// Appends a literal, split into as many segments as it takes
+static void AddLiteral(std::vector<PlaceholderSegment>& Segments, size_t Offset, size_t Length)
+{
+	while (Length > 0)
+	{
+		auto Part = (Length < MaximumLiteral) ? Length : MaximumLiteral;
+
+		PlaceholderSegment Segment;
+		Segment.Offset = (uint32_t)Offset;
+		Segment.Length = (uint16_t)Part;
+		Segment.Slot = 0;
+		Segments.push_back(Segment);
+
+		Offset += Part;
+		Length -= Part;
+	}
+}
+
+bool Placeholders::Parse(const char* Value, size_t Length, std::vector<PlaceholderSegment>& Segments, uint32_t& SlotMask)
+{
+	Segments.clear();
+	SlotMask = 0;
+
+	size_t LiteralStart = 0;
+
+	for (size_t i = 0; i < Length;)
+	{
+		auto Slot = GetSlot(Value + i, Length - i);
+		if (Slot == 0)
+		{
+			i++;
+			continue;
+		}
+
+		AddLiteral(Segments, LiteralStart, i - LiteralStart);
+
+		PlaceholderSegment Segment;
+		Segment.Offset = (uint32_t)i;
+		Segment.Length = PLACEHOLDERS_LENGTH;
+		Segment.Slot = (uint16_t)Slot;
+		Segments.push_back(Segment);
+
+		SlotMask |= 1u << Slot;
+		i += PLACEHOLDERS_LENGTH;
+		LiteralStart = i;
+	}
+
+	if (SlotMask == 0)
+	{
+		Segments.clear();
+		return false;
+	}
+
+	AddLiteral(Segments, LiteralStart, Length - LiteralStart);
+	return true;
+}
+
+uint32_t Placeholders::GetSlotMask(const char* Value, size_t Length)
+{
+	uint32_t Result = 0;
+
+	for (size_t i = 0; i < Length; i++)
+	{
+		auto Slot = GetSlot(Value + i, Length - i);
+		if (Slot != 0)
+		{
+			Result |= 1u << Slot;
+			i += PLACEHOLDERS_LENGTH - 1;
+		}
+	}
+
+	return Result;
+}
\ No newline at end of file
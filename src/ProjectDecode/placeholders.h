@@ -0,0 +1,83 @@
+#pragma once
+
+// Standard includes
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+//
+// Engine placeholders (&&1 through &&9) in translated values, split into literal and slot segments when the
+// database is built so formatting is a single copy pass without scanning for them. An && not followed by a
+// slot digit is plain text, so "&&&1" is a literal '&' followed by slot 1.
+//
+
+// Highest slot number, slots are a single digit
+#define PLACEHOLDERS_MAX_SLOT 9
+// Length of a placeholder, && and the digit
+#define PLACEHOLDERS_LENGTH 3
+
+// A template, followed by its segments
+struct PlaceholderTemplate
+{
+	uint16_t SegmentCount;
+	uint16_t SlotMask;		// Bit N set when slot N is used
+	uint32_t ValueLength;	// Length of the value the segments index into
+};
+
+struct PlaceholderSegment
+{
+	uint32_t Offset;		// Into the value, for slots the placeholder itself
+	uint16_t Length;
+	uint16_t Slot;			// Zero for literal text
+};
+
+namespace Placeholders
+{
+	// Gets the slot of a placeholder at the start of the input, zero if there isn't one
+	inline uint32_t GetSlot(const char* Input, size_t Length)
+	{
+		if (Length < PLACEHOLDERS_LENGTH || Input[0] != '&' || Input[1] != '&' || Input[2] < '1' || Input[2] > '0' + PLACEHOLDERS_MAX_SLOT)
+			return 0;
+
+		return (uint32_t)(Input[2] - '0');
+	}
+
+	// Splits a value into segments, false if it has no placeholders
+	bool Parse(const char* Value, size_t Length, std::vector<PlaceholderSegment>& Segments, uint32_t& SlotMask);
+	// Gets the slots a value uses, bit N set for slot N
+	uint32_t GetSlotMask(const char* Value, size_t Length);
+
+	// Formats a template into a buffer in one pass, slots past the argument count keep their placeholder.
+	// Returns the full formatted length, the output is truncated to fit and always null-term when the buffer isn't empty
+	inline size_t Format(const char* Value, const PlaceholderTemplate* Template, const std::string_view* Arguments, uint32_t ArgumentCount, char* Buffer, size_t BufferSize)
+	{
+		auto Segments = (const PlaceholderSegment*)(Template + 1);
+		auto Limit = (BufferSize > 0) ? BufferSize - 1 : 0;
+		size_t Written = 0;
+
+		for (uint32_t i = 0; i < Template->SegmentCount; i++)
+		{
+			auto& Segment = Segments[i];
+			const char* Source = Value + Segment.Offset;
+			size_t Length = Segment.Length;
+
+			if (Segment.Slot != 0 && Segment.Slot <= ArgumentCount)
+			{
+				Source = Arguments[Segment.Slot - 1].data();
+				Length = Arguments[Segment.Slot - 1].size();
+			}
+
+			if (Written < Limit)
+				std::memcpy(Buffer + Written, Source, (Length < Limit - Written) ? Length : Limit - Written);
+
+			Written += Length;
+		}
+
+		if (BufferSize > 0)
+			Buffer[(Written < Limit) ? Written : Limit] = 0;
+
+		return Written;
+	}
+}
\ No newline at end of file
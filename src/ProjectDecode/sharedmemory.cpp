@@ -0,0 +1,176 @@
+// Platform includes
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+// The class we are implementing
+#include "sharedmemory.h"
+
+// Standard includes
+#include <cstring>
+
+#ifndef _WIN32
+// Posix names are one path component with a leading slash
+static std::string GetPosixName(const std::string& Name)
+{
+	std::string Result = "/";
+	for (auto Character : Name)
+		Result.push_back((Character == '/' || Character == '\\') ? '_' : Character);
+
+	return Result;
+}
+#endif
+
+SharedMemory::SharedMemory()
+{
+#ifdef _WIN32
+	this->MappingHandle = NULL;
+#else
+	this->FileDescriptor = -1;
+#endif
+	this->Data = nullptr;
+	this->Size = 0;
+}
+
+SharedMemory::~SharedMemory()
+{
+	this->Close();
+}
+
+bool SharedMemory::Create(const std::string& Name, size_t Size)
+{
+	// Release the previous block
+	this->Close();
+
+	if (Size == 0)
+		return false;
+
+#ifdef _WIN32
+	this->MappingHandle = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, (DWORD)Size, Name.c_str());
+	if (this->MappingHandle == NULL)
+		return false;
+
+	this->Data = (uint8_t*)MapViewOfFile(this->MappingHandle, FILE_MAP_WRITE, 0, 0, Size);
+#else
+	auto PosixName = GetPosixName(Name);
+
+	// A block left behind by a crashed process is replaced
+	shm_unlink(PosixName.c_str());
+
+	this->FileDescriptor = shm_open(PosixName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+	if (this->FileDescriptor < 0)
+		return false;
+
+	this->UnlinkName = PosixName;
+
+	if (ftruncate(this->FileDescriptor, (off_t)Size) != 0)
+	{
+		this->Close();
+		return false;
+	}
+
+	auto View = mmap(nullptr, Size, PROT_READ | PROT_WRITE, MAP_SHARED, this->FileDescriptor, 0);
+	this->Data = (View == MAP_FAILED) ? nullptr : (uint8_t*)View;
+#endif
+
+	// Check the view
+	if (this->Data == nullptr)
+	{
+		this->Close();
+		return false;
+	}
+
+	this->Size = Size;
+	std::memset(this->Data, 0, Size);
+
+	return true;
+}
+
+bool SharedMemory::Open(const std::string& Name)
+{
+	// Release the previous block
+	this->Close();
+
+#ifdef _WIN32
+	this->MappingHandle = OpenFileMappingA(FILE_MAP_READ, FALSE, Name.c_str());
+	if (this->MappingHandle == NULL)
+		return false;
+
+	this->Data = (uint8_t*)MapViewOfFile(this->MappingHandle, FILE_MAP_READ, 0, 0, 0);
+
+	// The view is rounded up to whole pages, the creator's header tells the real size
+	MEMORY_BASIC_INFORMATION Information;
+	if (this->Data != nullptr && VirtualQuery(this->Data, &Information, sizeof(Information)) != 0)
+		this->Size = (size_t)Information.RegionSize;
+#else
+	this->FileDescriptor = shm_open(GetPosixName(Name).c_str(), O_RDONLY, 0);
+	if (this->FileDescriptor < 0)
+		return false;
+
+	struct stat Information;
+	if (fstat(this->FileDescriptor, &Information) != 0 || Information.st_size == 0)
+	{
+		this->Close();
+		return false;
+	}
+
+	this->Size = (size_t)Information.st_size;
+
+	auto View = mmap(nullptr, this->Size, PROT_READ, MAP_SHARED, this->FileDescriptor, 0);
+	this->Data = (View == MAP_FAILED) ? nullptr : (uint8_t*)View;
+#endif
+
+	// Check the view
+	if (this->Data == nullptr)
+	{
+		this->Close();
+		return false;
+	}
+
+	return true;
+}
+
+void SharedMemory::Close()
+{
+#ifdef _WIN32
+	if (this->Data != nullptr)
+		UnmapViewOfFile(this->Data);
+	if (this->MappingHandle != NULL)
+		CloseHandle(this->MappingHandle);
+
+	this->MappingHandle = NULL;
+#else
+	if (this->Data != nullptr)
+		munmap(this->Data, this->Size);
+	if (this->FileDescriptor >= 0)
+		close(this->FileDescriptor);
+	if (!this->UnlinkName.empty())
+		shm_unlink(this->UnlinkName.c_str());
+
+	this->FileDescriptor = -1;
+	this->UnlinkName.clear();
+#endif
+
+	this->Data = nullptr;
+	this->Size = 0;
+}
+
+bool SharedMemory::IsOpen() const
+{
+	return (this->Data != nullptr);
+}
+
+uint8_t* SharedMemory::GetData() const
+{
+	return this->Data;
+}
+
+size_t SharedMemory::GetSize() const
+{
+	return this->Size;
+}
\ No newline at end of file
@@ -0,0 +1,41 @@
+#pragma once
+
+// Standard includes
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+// A named block of memory shared with other processes, a file mapping backed by the page file on Windows, posix shared memory elsewhere
+class SharedMemory
+{
+private:
+#ifdef _WIN32
+	void* MappingHandle;
+#else
+	int FileDescriptor;
+	std::string UnlinkName;
+#endif
+	uint8_t* Data;
+	size_t Size;
+
+public:
+	SharedMemory();
+	~SharedMemory();
+
+	SharedMemory(const SharedMemory&) = delete;
+	SharedMemory& operator=(const SharedMemory&) = delete;
+
+	// Creates a zeroed block, writable, closing any previously opened one. The name is removed again when this block is closed
+	bool Create(const std::string& Name, size_t Size);
+	// Opens a block another process created, read-only
+	bool Open(const std::string& Name);
+	// Unmaps the block, if any
+	void Close();
+
+	// Whether or not a block is mapped
+	bool IsOpen() const;
+	// Gets the mapped block
+	uint8_t* GetData() const;
+	// Gets the mapped block size
+	size_t GetSize() const;
+};
\ No newline at end of file
@@ -0,0 +1,204 @@
+// Standard includes
+#include <cstdio>
+#include <cstring>
+
+// The class we are implementing
+#include "sitecache.h"
+
+// Our includes
+#include "hashing.h"
+
+// Where the PE headers keep what we read, from the NT headers and from the optional header in them
+static const size_t PeFileHeaderOffset = 4;
+static const size_t PeTimeDateStampOffset = PeFileHeaderOffset + 4;
+static const size_t PeOptionalHeaderOffset = PeFileHeaderOffset + 20;
+static const size_t PeImageSizeOffset = 56;
+static const size_t PeHeadersSizeOffset = 60;
+
+// Reads a little endian value from a byte offset
+template<typename T>
+static T ReadValue(const uint8_t* Data, size_t Offset)
+{
+	T Value;
+	std::memcpy(&Value, Data + Offset, sizeof(T));
+	return Value;
+}
+
+// Reads an entire, small, file into memory
+static bool ReadCacheFile(const std::string& Path, std::vector<uint8_t>& Result)
+{
+	auto Handle = fopen(Path.c_str(), "rb");
+	if (Handle == nullptr)
+		return false;
+
+	fseek(Handle, 0, SEEK_END);
+	auto Size = ftell(Handle);
+	fseek(Handle, 0, SEEK_SET);
+
+	// Far more than any set of sites needs, anything larger isn't ours
+	if (Size < 0 || Size > 65536)
+	{
+		fclose(Handle);
+		return false;
+	}
+
+	Result.resize((size_t)Size);
+	auto Read = Result.empty() ? 0 : fread(Result.data(), 1, Result.size(), Handle);
+	fclose(Handle);
+
+	return (Read == Result.size());
+}
+
+SiteCache::SiteCache(const std::string& Path, const uint8_t* Image, size_t Size, const MultiPatternScan& Signatures)
+{
+	this->Path = Path;
+	this->SignatureHash = Signatures.GetHash();
+	this->Identified = SiteCache::GetModuleIdentity(Image, Size, this->Identity);
+}
+
+SiteCache::~SiteCache()
+{
+}
+
+bool SiteCache::Load(const MultiPatternScan& Signatures, const uint8_t* Image, size_t Size, std::vector<uint32_t>& Sites, std::vector<uint32_t>& Extras) const
+{
+	Sites.clear();
+	Extras.clear();
+
+	std::vector<uint8_t> Data;
+	if (!this->Identified || !ReadCacheFile(this->Path, Data))
+		return false;
+	if (!SiteCache::Parse(Data, this->Identity, this->SignatureHash, Sites, Extras) || Sites.size() != Signatures.GetCount())
+		return false;
+
+	// Same executable and signatures, but a site is only trusted if its bytes still say so
+	for (uint32_t Id = 0; Id < (uint32_t)Sites.size(); Id++)
+	{
+		if (!Signatures.MatchesAt(Id, Image, Size, Sites[Id]))
+			return false;
+	}
+
+	return true;
+}
+
+bool SiteCache::Save(const std::vector<uint32_t>& Sites, const std::vector<uint32_t>& Extras) const
+{
+	if (!this->Identified)
+		return false;
+
+	std::vector<uint8_t> Data;
+	SiteCache::Serialize(this->Identity, this->SignatureHash, Sites, Extras, Data);
+
+	// A write cut short leaves a file whose checksum fails, which is scanned over and replaced next launch
+	auto Handle = fopen(this->Path.c_str(), "wb");
+	if (Handle == nullptr)
+		return false;
+
+	auto Written = fwrite(Data.data(), 1, Data.size(), Handle);
+	auto Closed = (fclose(Handle) == 0);
+
+	return (Written == Data.size() && Closed);
+}
+
+bool SiteCache::GetIdentity(ModuleIdentity& Result) const
+{
+	Result = this->Identity;
+	return this->Identified;
+}
+
+bool SiteCache::GetModuleIdentity(const uint8_t* Image, size_t Size, ModuleIdentity& Identity)
+{
+	std::memset(&Identity, 0, sizeof(Identity));
+
+	if (Image == nullptr || Size < 0x40 || Image[0] != 'M' || Image[1] != 'Z')
+		return false;
+
+	auto NtOffset = (size_t)ReadValue<uint32_t>(Image, 0x3C);
+	if (NtOffset > Size || Size - NtOffset < PeOptionalHeaderOffset + PeHeadersSizeOffset + 4)
+		return false;
+
+	auto NtHeaders = Image + NtOffset;
+	if (std::memcmp(NtHeaders, "PE\0\0", 4) != 0)
+		return false;
+
+	// The image base is 4 bytes at +28 in 32bit images and 8 bytes at +24 in 64bit ones
+	auto Magic = ReadValue<uint16_t>(NtHeaders, PeOptionalHeaderOffset);
+	if (Magic != 0x10B && Magic != 0x20B)
+		return false;
+
+	auto ImageBaseOffset = NtOffset + PeOptionalHeaderOffset + ((Magic == 0x10B) ? 28 : 24);
+	auto ImageBaseSize = (size_t)((Magic == 0x10B) ? 4 : 8);
+
+	auto HeadersSize = (size_t)ReadValue<uint32_t>(NtHeaders, PeOptionalHeaderOffset + PeHeadersSizeOffset);
+	if (HeadersSize > Size || HeadersSize < ImageBaseOffset + ImageBaseSize)
+		return false;
+
+	Identity.TimeDateStamp = ReadValue<uint32_t>(NtHeaders, PeTimeDateStampOffset);
+	Identity.ImageSize = ReadValue<uint32_t>(NtHeaders, PeOptionalHeaderOffset + PeImageSizeOffset);
+
+	uint64_t Hash = Hashing::Fnv1aOffsetBasis;
+	for (size_t i = 0; i < HeadersSize; i++)
+	{
+		if (i < ImageBaseOffset || i >= ImageBaseOffset + ImageBaseSize)
+			Hash = Hashing::Fnv1a64Update(Hash, Image[i]);
+	}
+
+	Identity.HeaderHash = Hash;
+	return true;
+}
+
+void SiteCache::Serialize(const ModuleIdentity& Identity, uint64_t SignatureHash, const std::vector<uint32_t>& Sites, const std::vector<uint32_t>& Extras, std::vector<uint8_t>& Result)
+{
+	std::vector<uint32_t> Values(Sites);
+	Values.insert(Values.end(), Extras.begin(), Extras.end());
+
+	SiteCacheHeader Header;
+	std::memset(&Header, 0, sizeof(Header));
+
+	Header.Magic = SITECACHE_MAGIC;
+	Header.Version = SITECACHE_VERSION;
+	Header.SiteCount = (uint16_t)Sites.size();
+	Header.ExtraCount = (uint16_t)Extras.size();
+	Header.TimeDateStamp = Identity.TimeDateStamp;
+	Header.ImageSize = Identity.ImageSize;
+	Header.HeaderHash = Identity.HeaderHash;
+	Header.SignatureHash = SignatureHash;
+	Header.Checksum = Hashing::Fnv1a64(Values.data(), Values.size() * sizeof(uint32_t));
+
+	Result.resize(sizeof(Header) + Values.size() * sizeof(uint32_t));
+	std::memcpy(Result.data(), &Header, sizeof(Header));
+	if (!Values.empty())
+		std::memcpy(Result.data() + sizeof(Header), Values.data(), Values.size() * sizeof(uint32_t));
+}
+
+bool SiteCache::Parse(const std::vector<uint8_t>& Data, const ModuleIdentity& Identity, uint64_t SignatureHash, std::vector<uint32_t>& Sites, std::vector<uint32_t>& Extras)
+{
+	Sites.clear();
+	Extras.clear();
+
+	if (Data.size() < sizeof(SiteCacheHeader))
+		return false;
+
+	SiteCacheHeader Header;
+	std::memcpy(&Header, Data.data(), sizeof(Header));
+
+	if (Header.Magic != SITECACHE_MAGIC || Header.Version != SITECACHE_VERSION)
+		return false;
+	if (Data.size() != sizeof(Header) + ((size_t)Header.SiteCount + Header.ExtraCount) * sizeof(uint32_t))
+		return false;
+
+	// Another build of the game, or the signatures changed with an update of ours
+	if (Header.TimeDateStamp != Identity.TimeDateStamp || Header.ImageSize != Identity.ImageSize || Header.HeaderHash != Identity.HeaderHash || Header.SignatureHash != SignatureHash)
+		return false;
+
+	std::vector<uint32_t> Values((size_t)Header.SiteCount + Header.ExtraCount);
+	if (!Values.empty())
+		std::memcpy(Values.data(), Data.data() + sizeof(Header), Values.size() * sizeof(uint32_t));
+
+	if (Hashing::Fnv1a64(Values.data(), Values.size() * sizeof(uint32_t)) != Header.Checksum)
+		return false;
+
+	Sites.assign(Values.begin(), Values.begin() + Header.SiteCount);
+	Extras.assign(Values.begin() + Header.SiteCount, Values.end());
+	return true;
+}
\ No newline at end of file
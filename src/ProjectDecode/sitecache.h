@@ -0,0 +1,72 @@
+#pragma once
+
+// Standard includes
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Our includes
+#include "patternscan.h"
+
+//
+// The sites a set of signatures was found at in an executable, kept between launches so the code is only scanned
+// again when the game is patched. The file is keyed by the PE timestamp, image size and a hash of the headers, and by
+// a hash of the signatures. Cached sites are still checked against their signatures before they're used.
+//
+
+#define SITECACHE_MAGIC 0x43533344
+#define SITECACHE_VERSION 1
+
+struct SiteCacheHeader
+{
+	uint32_t Magic;
+	uint16_t Version;
+	uint16_t SiteCount;		// Offsets from the module base, one for each signature
+	uint16_t ExtraCount;	// Values the caller derived from the sites, following them
+	uint16_t Reserved;
+	uint32_t TimeDateStamp;
+	uint32_t ImageSize;
+	uint32_t Padding;
+	uint64_t HeaderHash;
+	uint64_t SignatureHash;	// MultiPatternScan::GetHash of the signatures
+	uint64_t Checksum;		// Hashing::Fnv1a64 of the values following the header
+};
+
+// What identifies an executable, taken from its PE headers
+struct ModuleIdentity
+{
+	uint32_t TimeDateStamp;
+	uint32_t ImageSize;
+	uint64_t HeaderHash;
+};
+
+class SiteCache
+{
+private:
+	std::string Path;
+	ModuleIdentity Identity;
+	uint64_t SignatureHash;
+	// Whether or not the image had valid PE headers, nothing is loaded or saved without them
+	bool Identified;
+
+public:
+	SiteCache(const std::string& Path, const uint8_t* Image, size_t Size, const MultiPatternScan& Signatures);
+	~SiteCache();
+
+	// Loads the sites cached for this executable and signatures, true only if every one still matches its signature
+	bool Load(const MultiPatternScan& Signatures, const uint8_t* Image, size_t Size, std::vector<uint32_t>& Sites, std::vector<uint32_t>& Extras) const;
+	// Replaces the file with the sites of a full scan and the values derived from them
+	bool Save(const std::vector<uint32_t>& Sites, const std::vector<uint32_t>& Extras) const;
+
+	// Gets the identity of the executable the cache is for, false if its PE headers weren't valid
+	bool GetIdentity(ModuleIdentity& Result) const;
+
+	// Reads the identity from the PE headers at the start of an image, false if they aren't valid. The image base
+	// is left out of the hash, the loader rewrites it when the image is relocated
+	static bool GetModuleIdentity(const uint8_t* Image, size_t Size, ModuleIdentity& Identity);
+	// Writes a cache file to memory
+	static void Serialize(const ModuleIdentity& Identity, uint64_t SignatureHash, const std::vector<uint32_t>& Sites, const std::vector<uint32_t>& Extras, std::vector<uint8_t>& Result);
+	// Reads a cache file from memory, false if it's damaged or for another executable or signatures
+	static bool Parse(const std::vector<uint8_t>& Data, const ModuleIdentity& Identity, uint64_t SignatureHash, std::vector<uint32_t>& Sites, std::vector<uint32_t>& Extras);
+};
\ No newline at end of file
@@ -0,0 +1,65 @@
+// The class we are implementing
+#include "stringcache.h"
+
+StringReferenceCache::StringReferenceCache()
+{
+	for (auto& Slot : this->Slots)
+		Slot.Sequence.store(0, std::memory_order_relaxed);
+
+	this->Clear();
+	this->ResetCounters();
+}
+
+void StringReferenceCache::Insert(const char* Reference, uint32_t Generation, const char* Key, const char* Value)
+{
+	auto& Slot = this->Slots[GetSlotIndex(Reference)];
+	auto Sequence = Slot.Sequence.load(std::memory_order_relaxed);
+
+	// Claim the slot, caching is best effort so a busy slot is simply left alone
+	if ((Sequence & 1) != 0 || !Slot.Sequence.compare_exchange_strong(Sequence, Sequence + 1, std::memory_order_acquire))
+		return;
+
+	std::atomic_thread_fence(std::memory_order_release);
+
+	Slot.Generation.store(Generation, std::memory_order_relaxed);
+	Slot.Reference.store(Reference, std::memory_order_relaxed);
+	Slot.Key.store(Key, std::memory_order_relaxed);
+	Slot.Value.store(Value, std::memory_order_relaxed);
+
+	Slot.Sequence.store(Sequence + 2, std::memory_order_release);
+}
+
+void StringReferenceCache::Clear()
+{
+	for (auto& Slot : this->Slots)
+	{
+		auto Sequence = Slot.Sequence.load(std::memory_order_relaxed);
+		if ((Sequence & 1) != 0 || !Slot.Sequence.compare_exchange_strong(Sequence, Sequence + 1, std::memory_order_acquire))
+			continue;
+
+		std::atomic_thread_fence(std::memory_order_release);
+
+		Slot.Generation.store(0, std::memory_order_relaxed);
+		Slot.Reference.store(nullptr, std::memory_order_relaxed);
+		Slot.Key.store(nullptr, std::memory_order_relaxed);
+		Slot.Value.store(nullptr, std::memory_order_relaxed);
+
+		Slot.Sequence.store(Sequence + 2, std::memory_order_release);
+	}
+}
+
+uint32_t StringReferenceCache::GetHits() const
+{
+	return this->Counters.Hits.load(std::memory_order_relaxed);
+}
+
+uint32_t StringReferenceCache::GetMisses() const
+{
+	return this->Counters.Misses.load(std::memory_order_relaxed);
+}
+
+void StringReferenceCache::ResetCounters()
+{
+	this->Counters.Hits.store(0, std::memory_order_relaxed);
+	this->Counters.Misses.store(0, std::memory_order_relaxed);
+}
\ No newline at end of file
@@ -0,0 +1,101 @@
+#pragma once
+
+// Standard includes
+#include <cstdint>
+#include <cstring>
+#include <atomic>
+
+//
+// Direct-mapped cache in front of the StringEd lookup, keyed by the address the engine passes in.
+// Most references are literals in the engine image, so the same pointer comes back every frame.
+// The pointer only selects the slot, a hit is verified against the key text so reused buffers can't alias.
+// Every slot is a small seqlock, readers never write to a slot and writers skip slots that are busy.
+//
+
+// Alignment of slots and counters, so a slot never straddles a cache line
+#ifdef _MSC_VER
+#define STRINGCACHE_ALIGN(Size) __declspec(align(Size))
+#else
+#define STRINGCACHE_ALIGN(Size) __attribute__((aligned(Size)))
+#endif
+
+// The cache holds 1 << STRINGCACHE_SLOT_BITS slots
+#define STRINGCACHE_SLOT_BITS 10
+#define STRINGCACHE_SLOTS (1 << STRINGCACHE_SLOT_BITS)
+
+struct STRINGCACHE_ALIGN(32) StringCacheSlot
+{
+	std::atomic<uint32_t> Sequence;		// Odd while the slot is being written
+	std::atomic<uint32_t> Generation;	// Store generation the strings belong to
+	std::atomic<const char*> Reference;	// The pointer the engine passed
+	std::atomic<const char*> Key;		// The database key, used to verify the reference text
+	std::atomic<const char*> Value;
+};
+
+struct STRINGCACHE_ALIGN(64) StringCacheCounters
+{
+	std::atomic<uint32_t> Hits;
+	std::atomic<uint32_t> Misses;
+};
+
+class StringReferenceCache
+{
+private:
+	StringCacheSlot Slots[STRINGCACHE_SLOTS];
+	StringCacheCounters Counters;
+
+	// Maps a reference pointer to its slot
+	static uint32_t GetSlotIndex(const char* Reference)
+	{
+		auto Bits = (uint64_t)(uintptr_t)Reference;
+		return ((uint32_t)(Bits ^ (Bits >> 32)) * 0x9E3779B1u) >> (32 - STRINGCACHE_SLOT_BITS);
+	}
+
+	// Bumps a counter without a locked instruction, concurrent callers may lose increments
+	static void Bump(std::atomic<uint32_t>& Counter)
+	{
+		Counter.store(Counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	}
+
+public:
+	StringReferenceCache();
+
+	StringReferenceCache(const StringReferenceCache&) = delete;
+	StringReferenceCache& operator=(const StringReferenceCache&) = delete;
+
+	// Finds the cached value for a reference pointer whose (@ stripped) text is Text, nullptr on a miss
+	const char* Lookup(const char* Reference, const char* Text, uint32_t Generation)
+	{
+		auto& Slot = this->Slots[GetSlotIndex(Reference)];
+		auto Sequence = Slot.Sequence.load(std::memory_order_acquire);
+
+		if ((Sequence & 1) == 0 && Slot.Reference.load(std::memory_order_relaxed) == Reference && Slot.Generation.load(std::memory_order_relaxed) == Generation)
+		{
+			auto Key = Slot.Key.load(std::memory_order_relaxed);
+			auto Value = Slot.Value.load(std::memory_order_relaxed);
+
+			// The slot must not have changed while it was read, only then is the key safe to compare
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (Slot.Sequence.load(std::memory_order_relaxed) == Sequence && std::strcmp(Key, Text) == 0)
+			{
+				Bump(this->Counters.Hits);
+				return Value;
+			}
+		}
+
+		Bump(this->Counters.Misses);
+		return nullptr;
+	}
+
+	// Caches the value for a reference pointer, skipped if another thread is writing the slot
+	void Insert(const char* Reference, uint32_t Generation, const char* Key, const char* Value);
+	// Empties every slot
+	void Clear();
+
+	// Gets the approximate amount of hits
+	uint32_t GetHits() const;
+	// Gets the approximate amount of misses
+	uint32_t GetMisses() const;
+	// Resets the hit and miss counters
+	void ResetCounters();
+};
\ No newline at end of file
@@ -0,0 +1,207 @@
+// Standard includes
+#include <algorithm>
+#include <unordered_map>
+
+// The class we are implementing
+#include "symboltable.h"
+
+// Codes available to symbols, 0 is never emitted and 255 escapes
+static const uint32_t FirstCode = 1;
+static const uint32_t LastCode = 254;
+// Training passes, each one re-encodes the sample with the previous table
+static const uint32_t TrainingRounds = 5;
+// Bytes of the sample used for training, spread evenly over the input
+static const size_t TrainingSampleSize = 256 * 1024;
+// Training identifiers, codes and then literal bytes
+static const uint32_t TrainingIds = 512;
+
+SymbolTable::SymbolTable()
+{
+	std::memset(&this->Data, 0, sizeof(this->Data));
+}
+
+void SymbolTable::BuildIndex()
+{
+	for (auto& List : this->Candidates)
+		List.clear();
+
+	for (uint32_t Code = FirstCode; Code <= LastCode; Code++)
+	{
+		if (this->Data.Lengths[Code] > 0)
+			this->Candidates[(uint8_t)this->Data.Symbols[Code]].push_back((uint8_t)Code);
+	}
+
+	auto& Lengths = this->Data.Lengths;
+	for (auto& List : this->Candidates)
+	{
+		std::stable_sort(List.begin(), List.end(), [&Lengths](uint8_t Lhs, uint8_t Rhs)
+		{
+			return Lengths[Lhs] > Lengths[Rhs];
+		});
+	}
+}
+
+uint8_t SymbolTable::Match(const uint8_t* Input, size_t Length) const
+{
+	for (auto Code : this->Candidates[Input[0]])
+	{
+		auto SymbolLength = this->Data.Lengths[Code];
+		if (SymbolLength <= Length && std::memcmp(Input, &this->Data.Symbols[Code], SymbolLength) == 0)
+			return Code;
+	}
+
+	return 0;
+}
+
+void SymbolTable::Train(const std::vector<std::string_view>& Sample)
+{
+	std::memset(&this->Data, 0, sizeof(this->Data));
+	this->BuildIndex();
+
+	// Take every Nth string so the sample stays within budget
+	size_t TotalSize = 0;
+	for (auto& String : Sample)
+		TotalSize += String.size();
+
+	auto Stride = std::max<size_t>(1, (TotalSize + TrainingSampleSize - 1) / TrainingSampleSize);
+
+	std::vector<uint32_t> Counts(TrainingIds);
+	std::vector<uint32_t> PairCounts(TrainingIds * TrainingIds);
+
+	// The bytes and length of a training identifier
+	auto IdBytes = [this](uint32_t Id) -> uint64_t { return (Id >= 256) ? (uint64_t)(Id - 256) : this->Data.Symbols[Id]; };
+	auto IdLength = [this](uint32_t Id) -> uint32_t { return (Id >= 256) ? 1 : this->Data.Lengths[Id]; };
+
+	for (uint32_t Round = 0; Round < TrainingRounds; Round++)
+	{
+		std::fill(Counts.begin(), Counts.end(), 0);
+		std::fill(PairCounts.begin(), PairCounts.end(), 0);
+
+		// Encode the sample with the current table, counting every symbol and every pair of neighbours
+		for (size_t s = 0; s < Sample.size(); s += Stride)
+		{
+			auto Input = (const uint8_t*)Sample[s].data();
+			auto Length = Sample[s].size();
+			uint32_t Previous = UINT32_MAX;
+
+			for (size_t i = 0; i < Length;)
+			{
+				auto Code = this->Match(Input + i, Length - i);
+				auto Id = (Code != 0) ? (uint32_t)Code : 256 + Input[i];
+
+				Counts[Id]++;
+				if (Previous != UINT32_MAX)
+					PairCounts[Previous * TrainingIds + Id]++;
+
+				Previous = Id;
+				i += IdLength(Id);
+			}
+		}
+
+		// Every symbol and every concatenation that fits is a candidate, worth the bytes it would cover.
+		// Input strings have no nulls, so the zero padded bytes alone identify a symbol
+		std::unordered_map<uint64_t, uint64_t> Gains;
+
+		for (uint32_t Id = 0; Id < TrainingIds; Id++)
+		{
+			if (Counts[Id] == 0)
+				continue;
+
+			Gains[IdBytes(Id)] += (uint64_t)Counts[Id] * IdLength(Id);
+
+			for (uint32_t Next = 0; Next < TrainingIds; Next++)
+			{
+				auto Count = PairCounts[Id * TrainingIds + Next];
+				if (Count == 0 || IdLength(Id) + IdLength(Next) > SYMBOLTABLE_MAX_LENGTH)
+					continue;
+
+				auto Joined = IdBytes(Id) | (IdBytes(Next) << (IdLength(Id) * 8));
+				Gains[Joined] += (uint64_t)Count * (IdLength(Id) + IdLength(Next));
+			}
+		}
+
+		// Keep the best ones, ties broken by the bytes so training is deterministic
+		std::vector<std::pair<uint64_t, uint64_t>> Ranked(Gains.begin(), Gains.end());
+		std::sort(Ranked.begin(), Ranked.end(), [](const std::pair<uint64_t, uint64_t>& Lhs, const std::pair<uint64_t, uint64_t>& Rhs)
+		{
+			return (Lhs.second != Rhs.second) ? (Lhs.second > Rhs.second) : (Lhs.first < Rhs.first);
+		});
+
+		std::memset(&this->Data, 0, sizeof(this->Data));
+
+		auto Code = FirstCode;
+		for (size_t i = 0; i < Ranked.size() && Code <= LastCode; i++, Code++)
+		{
+			auto Bytes = Ranked[i].first;
+			uint8_t Length = 0;
+
+			while (Length < SYMBOLTABLE_MAX_LENGTH && ((Bytes >> (Length * 8)) & 0xFF) != 0)
+				Length++;
+
+			this->Data.Symbols[Code] = Bytes;
+			this->Data.Lengths[Code] = Length;
+		}
+
+		this->BuildIndex();
+	}
+}
+
+bool SymbolTable::Validate(const SymbolTableData& Source)
+{
+	// Reserved codes must be empty, symbols must be null free and zero padded
+	if (Source.Lengths[0] != 0 || Source.Lengths[SYMBOLTABLE_ESCAPE] != 0)
+		return false;
+
+	for (uint32_t Code = FirstCode; Code <= LastCode; Code++)
+	{
+		auto Length = Source.Lengths[Code];
+		if (Length > SYMBOLTABLE_MAX_LENGTH)
+			return false;
+
+		for (uint32_t i = 0; i < SYMBOLTABLE_MAX_LENGTH; i++)
+		{
+			auto Byte = (Source.Symbols[Code] >> (i * 8)) & 0xFF;
+			if ((i < Length) != (Byte != 0))
+				return false;
+		}
+	}
+
+	return true;
+}
+
+bool SymbolTable::Load(const SymbolTableData& Source)
+{
+	if (!Validate(Source))
+		return false;
+
+	std::memcpy(&this->Data, &Source, sizeof(this->Data));
+	this->BuildIndex();
+
+	return true;
+}
+
+const SymbolTableData& SymbolTable::GetData() const
+{
+	return this->Data;
+}
+
+void SymbolTable::Encode(const char* Input, size_t Length, std::vector<uint8_t>& Result) const
+{
+	auto Bytes = (const uint8_t*)Input;
+
+	for (size_t i = 0; i < Length;)
+	{
+		auto Code = this->Match(Bytes + i, Length - i);
+
+		if (Code != 0)
+		{
+			Result.push_back(Code);
+			i += this->Data.Lengths[Code];
+		}
+		else
+		{
+			Result.push_back(SYMBOLTABLE_ESCAPE);
+			Result.push_back(Bytes[i++]);
+		}
+	}
+}
\ No newline at end of file
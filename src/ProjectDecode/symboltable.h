@@ -0,0 +1,99 @@
+#pragma once
+
+// Standard includes
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+//
+// Static symbol table compression for short strings (FSST style). Up to 254 symbols of 1-8 bytes are
+// trained once, then every string is encoded on its own and decodes without any other context.
+// Code 0 is never emitted and escaped literals are input bytes, so encoded strings never contain a null.
+// Symbols are stored little-endian, like everything else in the database.
+//
+
+// Code followed by a literal byte
+#define SYMBOLTABLE_ESCAPE 0xFF
+// Longest symbol, also the output slack Decode needs
+#define SYMBOLTABLE_MAX_LENGTH 8
+
+// The serialized table, stored in the database as is
+struct SymbolTableData
+{
+	uint8_t Lengths[256];		// Zero for unused codes
+	uint64_t Symbols[256];		// Symbol bytes, zero padded
+};
+
+class SymbolTable
+{
+private:
+	SymbolTableData Data;
+	// Codes of the symbols starting with each byte, longest first
+	std::vector<uint8_t> Candidates[256];
+
+	// Rebuilds the encoding index from the table
+	void BuildIndex();
+	// Finds the longest symbol at the start of the input, zero if none matches
+	uint8_t Match(const uint8_t* Input, size_t Length) const;
+
+public:
+	SymbolTable();
+
+	// Trains the table on a sample of strings
+	void Train(const std::vector<std::string_view>& Sample);
+	// Loads a serialized table, false if it's malformed
+	bool Load(const SymbolTableData& Source);
+	// Whether or not a serialized table is well formed, reserved codes unused and symbols null free
+	static bool Validate(const SymbolTableData& Source);
+	// Gets the serialized table
+	const SymbolTableData& GetData() const;
+
+	// Encodes a string, appending it to the result
+	void Encode(const char* Input, size_t Length, std::vector<uint8_t>& Result) const;
+
+	// Gets the decoded length of an encoded string
+	static size_t GetDecodedLength(const SymbolTableData& Table, const uint8_t* Input, size_t Length)
+	{
+		size_t Result = 0;
+
+		for (size_t i = 0; i < Length; i++)
+		{
+			if (Input[i] == SYMBOLTABLE_ESCAPE)
+			{
+				Result += (i + 1 < Length) ? 1 : 0;
+				i++;
+				continue;
+			}
+
+			Result += Table.Lengths[Input[i]];
+		}
+
+		return Result;
+	}
+
+	// Decodes a string, the output needs SYMBOLTABLE_MAX_LENGTH bytes of slack past the decoded length
+	static size_t Decode(const SymbolTableData& Table, const uint8_t* Input, size_t Length, char* Output)
+	{
+		size_t Written = 0;
+
+		for (size_t i = 0; i < Length;)
+		{
+			auto Code = Input[i++];
+
+			if (Code == SYMBOLTABLE_ESCAPE)
+			{
+				if (i < Length)
+					Output[Written++] = (char)Input[i++];
+				continue;
+			}
+
+			// Always copy a whole word, only the symbol's length is kept
+			std::memcpy(Output + Written, &Table.Symbols[Code], sizeof(uint64_t));
+			Written += Table.Lengths[Code];
+		}
+
+		return Written;
+	}
+};
\ No newline at end of file
@@ -0,0 +1,97 @@
+// Standard includes
+#include <cstring>
+
+// The class we are implementing
+#include "translate.h"
+
+const char* TranslateStringReference(const TranslationDB& Database, const char* StringReferenceText)
+{
+	// The @ modifier is stripped as the key is hashed
+	return Database.FindReference(StringReferenceText);
+}
+
+const char* TranslateStringReference(StringReferenceCache& Cache, const TranslationStore& Store, const char* StringReferenceText)
+{
+	// Strip the @ modifier, the cache is still keyed by the pointer the engine passed
+	auto Text = StringReferenceText;
+	if (*Text == '@')
+		Text++;
+
+	// Read the generation first, a slot filled from an older database then never matches
+	auto Generation = Store.GetGeneration();
+
+	auto Cached = Cache.Lookup(StringReferenceText, Text, Generation);
+	if (Cached != nullptr)
+		return Cached;
+
+	// The layer that owns the key hands out the strings
+	const TranslationDBEntry* Entry = nullptr;
+	auto Layer = Store.Acquire()->FindReferenceEntry(StringReferenceText, Entry);
+	if (Layer == nullptr)
+		return nullptr;
+
+	auto Value = Layer->GetValue(Entry);
+	Cache.Insert(StringReferenceText, Generation, Layer->GetKey(Entry), Value);
+
+	return Value;
+}
+
+size_t PrepareScaleformKey(const uint16_t*& Key)
+{
+	size_t KeyLength = 0;
+	while (Key[KeyLength] != 0)
+		KeyLength++;
+
+	if (KeyLength > 2 && Key[0] == '@')
+	{
+		Key++;
+		KeyLength--;
+	}
+
+	return KeyLength;
+}
+
+const uint16_t* TranslateScaleformKey(const TranslationDB& Database, const uint16_t* Key, uint32_t& ResultLength)
+{
+	auto KeyLength = PrepareScaleformKey(Key);
+
+	auto Entry = Database.FindEntry(Key, KeyLength);
+	if (Entry == nullptr)
+		return nullptr;
+
+	// Values that aren't valid utf8 are left to the engine
+	return Database.GetWideValue(Entry, ResultLength);
+}
+
+const uint16_t* TranslateScaleformKey(const TranslationStack& Stack, const uint16_t* Key, uint32_t& ResultLength)
+{
+	auto KeyLength = PrepareScaleformKey(Key);
+
+	const TranslationDBEntry* Entry = nullptr;
+	auto Layer = Stack.FindEntry(Key, KeyLength, Entry);
+	if (Layer == nullptr)
+		return nullptr;
+
+	return Layer->GetWideValue(Entry, ResultLength);
+}
+
+size_t FormatTranslation(const TranslationDB& Layer, const TranslationDBEntry* Entry, const std::string_view* Arguments, uint32_t ArgumentCount, char* Buffer, size_t BufferSize)
+{
+	auto Value = Layer.GetValue(Entry);
+
+	auto Template = Layer.GetTemplate(Entry);
+	if (Template != nullptr)
+		return Placeholders::Format(Value, Template, Arguments, ArgumentCount, Buffer, BufferSize);
+
+	// Nothing to substitute, the value is copied as is
+	auto Length = Layer.IsCompressed() ? std::strlen(Value) : (size_t)Entry->ValueLength;
+
+	if (BufferSize > 0)
+	{
+		auto Copied = (Length < BufferSize - 1) ? Length : BufferSize - 1;
+		std::memcpy(Buffer, Value, Copied);
+		Buffer[Copied] = 0;
+	}
+
+	return Length;
+}
\ No newline at end of file
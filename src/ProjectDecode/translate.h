@@ -0,0 +1,29 @@
+#pragma once
+
+// Standard includes
+#include <cstdint>
+#include <string_view>
+
+// Our includes
+#include "translationdb.h"
+#include "translationstack.h"
+#include "translationstore.h"
+#include "stringcache.h"
+
+//
+// Portable lookup logic shared by the engine hooks, kept free of engine types
+//
+
+// Resolves a StringEd reference (optionally prefixed with @), nullptr if not translated
+const char* TranslateStringReference(const TranslationDB& Database, const char* StringReferenceText);
+// Resolves a StringEd reference through the pointer cache, filling it on a miss, nullptr if not translated
+const char* TranslateStringReference(StringReferenceCache& Cache, const TranslationStore& Store, const char* StringReferenceText);
+// Measures a null-term utf16 Scaleform key, stripping the @ modifier the way every Scaleform lookup does
+size_t PrepareScaleformKey(const uint16_t*& Key);
+// Resolves a null-term utf16 Scaleform key (optionally prefixed with @), nullptr if not translated
+const uint16_t* TranslateScaleformKey(const TranslationDB& Database, const uint16_t* Key, uint32_t& ResultLength);
+// Resolves a null-term utf16 Scaleform key (optionally prefixed with @) through every layer, nullptr if not translated
+const uint16_t* TranslateScaleformKey(const TranslationStack& Stack, const uint16_t* Key, uint32_t& ResultLength);
+// Formats the value of an entry into a buffer, substituting &&N placeholders with the arguments in one pass.
+// Returns the full formatted length, the output is truncated to fit and always null-term when the buffer isn't empty
+size_t FormatTranslation(const TranslationDB& Layer, const TranslationDBEntry* Entry, const std::string_view* Arguments, uint32_t ArgumentCount, char* Buffer, size_t BufferSize);
\ No newline at end of file
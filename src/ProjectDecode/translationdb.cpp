@@ -0,0 +1,1095 @@
+// Standard includes
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+// The class we are implementing
+#include "translationdb.h"
+
+// Our includes
+#include "unicode.h"
+#include "bytescan.h"
+#include "parallel.h"
+#include "translationlookup.h"
+#include "bloomfilter.h"
+#include "symboltable.h"
+#include "translationdelta.h"
+
+// Average keys per bucket of the perfect hash, trades seed table size for build time
+static const uint32_t KeysPerBucket = 4;
+// Section payload alignment
+static const uint32_t SectionAlignment = 16;
+// Filter payload alignment, a cache line
+static const uint32_t FilterAlignment = 64;
+// Smallest slice of a legacy file worth giving its own thread
+static const size_t LegacyChunkSize = 128 * 1024;
+// Smallest amount of pairs worth giving their own thread when building
+static const uint32_t BuildChunkPairs = 2048;
+
+static uint64_t AlignSection(uint64_t Offset, uint32_t Alignment = SectionAlignment)
+{
+	return (Offset + (Alignment - 1)) & ~(uint64_t)(Alignment - 1);
+}
+
+// A section of an image being built
+struct SectionLayout
+{
+	uint32_t Id;
+	uint64_t Size;
+	uint32_t Alignment;
+	uint64_t Offset;
+};
+
+TranslationDB::TranslationDB()
+{
+	this->Header = nullptr;
+	this->View = TranslationDBView();
+	this->Patched = false;
+}
+
+TranslationDB::~TranslationDB()
+{
+	this->Unload();
+}
+
+// Reads an entire file into memory with a single read
+static bool ReadEntireFile(const std::string& Path, std::vector<uint8_t>& Result)
+{
+	auto Handle = fopen(Path.c_str(), "rb");
+	if (Handle == nullptr)
+		return false;
+
+	fseek(Handle, 0, SEEK_END);
+	auto Size = ftell(Handle);
+	fseek(Handle, 0, SEEK_SET);
+
+	Result.resize((Size > 0) ? (size_t)Size : 0);
+	auto Read = Result.empty() ? 0 : fread(Result.data(), 1, Result.size(), Handle);
+	fclose(Handle);
+
+	return (Size >= 0 && Read == Result.size());
+}
+
+bool TranslationDB::Load(const std::string& Path, bool MapInPlace)
+{
+	// Release the previous database
+	this->Unload();
+
+	// Copies never map, a mapped file could be truncated by the writer while we parse it
+	std::vector<uint8_t> Buffer;
+	const uint8_t* Data = nullptr;
+	size_t Size = 0;
+
+	if (MapInPlace)
+	{
+		if (!this->File.Open(Path))
+			return false;
+
+		Data = this->File.GetData();
+		Size = this->File.GetSize();
+	}
+	else
+	{
+		if (!ReadEntireFile(Path, Buffer))
+			return false;
+
+		Data = Buffer.data();
+		Size = Buffer.size();
+	}
+
+	// Both formats start with a 32bit field
+	if (Size < sizeof(uint32_t))
+	{
+		this->Unload();
+		return false;
+	}
+
+	// v2 files are queried in place, anything else is treated as the legacy format
+	bool Result = false;
+	if (*(const uint32_t*)Data == TRANSLATIONDB_MAGIC)
+	{
+		if (!MapInPlace)
+		{
+			this->Image.swap(Buffer);
+			Data = this->Image.data();
+		}
+
+		Result = this->Attach(Data, Size);
+	}
+	else
+	{
+		Result = this->LoadLegacy(Data, Size);
+		// The image owns a copy of the strings now
+		this->File.Close();
+	}
+
+	if (!Result)
+		this->Unload();
+
+	return Result;
+}
+
+bool TranslationDB::LoadPatched(const std::string& Path, const std::string& DeltaPath)
+{
+	// Release the previous database
+	this->Unload();
+
+	std::vector<uint8_t> Base, Delta, Patched;
+	if (!ReadEntireFile(Path, Base) || !ReadEntireFile(DeltaPath, Delta))
+		return false;
+
+	// The delta checks it was made for this file and reproduces the build it was made from
+	if (!TranslationDelta::Apply(Base, Delta, Patched))
+		return false;
+
+	// The patched file is in the base's format
+	bool Result = false;
+	if (Patched.size() >= sizeof(uint32_t) && *(const uint32_t*)Patched.data() == TRANSLATIONDB_MAGIC)
+		Result = this->LoadImage(Patched);
+	else
+		Result = this->LoadLegacy(Patched.data(), Patched.size());
+
+	if (!Result)
+		this->Unload();
+
+	this->Patched = Result;
+	return Result;
+}
+
+bool TranslationDB::LoadImage(std::vector<uint8_t>& Buffer)
+{
+	// Release the previous database
+	this->Unload();
+
+	this->Image.swap(Buffer);
+
+	if (!this->Attach(this->Image.data(), this->Image.size()))
+	{
+		this->Unload();
+		return false;
+	}
+
+	return true;
+}
+
+void TranslationDB::Unload()
+{
+	this->Header = nullptr;
+	this->View = TranslationDBView();
+
+	this->File.Close();
+	std::vector<uint8_t>().swap(this->Image);
+	std::vector<TranslationDBWideEntry>().swap(this->WideEntryData);
+	std::vector<uint16_t>().swap(this->WideStringData);
+	std::vector<uint32_t>().swap(this->FilterData);
+	this->DecodedValues.reset();
+	this->Patched = false;
+}
+
+bool TranslationDB::Attach(const uint8_t* Data, size_t Size)
+{
+	// Validate the header
+	if (Size < sizeof(TranslationDBHeader))
+		return false;
+
+	auto DbHeader = (const TranslationDBHeader*)Data;
+	if (DbHeader->Magic != TRANSLATIONDB_MAGIC || DbHeader->Version != TRANSLATIONDB_VERSION)
+		return false;
+	if (DbHeader->FileSize > Size || DbHeader->BucketCount == 0)
+		return false;
+	if (DbHeader->HashId != Hashing::HashFnv1a && DbHeader->HashId != Hashing::HashWordMix)
+		return false;
+
+	// Validate the section table
+	auto SectionTableEnd = sizeof(TranslationDBHeader) + ((size_t)DbHeader->SectionCount * sizeof(TranslationDBSection));
+	if (SectionTableEnd > DbHeader->FileSize)
+		return false;
+
+	auto Sections = (const TranslationDBSection*)(Data + sizeof(TranslationDBHeader));
+
+	const TranslationDBSection* SeedSection = nullptr;
+	const TranslationDBSection* EntrySection = nullptr;
+	const TranslationDBSection* StringSection = nullptr;
+	const TranslationDBSection* WideEntrySection = nullptr;
+	const TranslationDBSection* WideStringSection = nullptr;
+	const TranslationDBSection* FilterSection = nullptr;
+	const TranslationDBSection* SymbolSection = nullptr;
+	const TranslationDBSection* TemplateIndexSection = nullptr;
+	const TranslationDBSection* TemplateSection = nullptr;
+
+	for (uint32_t i = 0; i < DbHeader->SectionCount; i++)
+	{
+		auto& Section = Sections[i];
+
+		// Every section must be aligned and in bounds
+		if ((Section.Offset % sizeof(uint32_t)) != 0 || (uint64_t)Section.Offset + Section.Size > DbHeader->FileSize)
+			return false;
+
+		// Unknown sections are skipped so newer files stay readable
+		switch (Section.Id)
+		{
+		case TRANSLATIONDB_SECTION_SEEDS: SeedSection = &Section; break;
+		case TRANSLATIONDB_SECTION_ENTRIES: EntrySection = &Section; break;
+		case TRANSLATIONDB_SECTION_STRINGS: StringSection = &Section; break;
+		case TRANSLATIONDB_SECTION_WIDEENTRIES: WideEntrySection = &Section; break;
+		case TRANSLATIONDB_SECTION_WIDESTRINGS: WideStringSection = &Section; break;
+		case TRANSLATIONDB_SECTION_FILTER: FilterSection = &Section; break;
+		case TRANSLATIONDB_SECTION_SYMBOLS: SymbolSection = &Section; break;
+		case TRANSLATIONDB_SECTION_TEMPLATEINDEX: TemplateIndexSection = &Section; break;
+		case TRANSLATIONDB_SECTION_TEMPLATES: TemplateSection = &Section; break;
+		}
+	}
+
+	if (SeedSection == nullptr || EntrySection == nullptr || StringSection == nullptr)
+		return false;
+	if (SeedSection->Size != (uint64_t)DbHeader->BucketCount * sizeof(uint32_t))
+		return false;
+	if (EntrySection->Size != (uint64_t)DbHeader->EntryCount * sizeof(TranslationDBEntry))
+		return false;
+
+	// Every decoded value depends on the symbol table, so it's checked up front
+	const SymbolTableData* Symbols = nullptr;
+	if (SymbolSection != nullptr)
+	{
+		if (SymbolSection->Size != sizeof(SymbolTableData) || (SymbolSection->Offset % sizeof(uint64_t)) != 0)
+			return false;
+
+		Symbols = (const SymbolTableData*)(Data + SymbolSection->Offset);
+		if (!SymbolTable::Validate(*Symbols))
+			return false;
+	}
+
+	// Entries are bounds checked as they are queried, so attaching doesn't touch them
+	this->Header = DbHeader;
+	this->View.EntryCount = DbHeader->EntryCount;
+	this->View.BucketCount = DbHeader->BucketCount;
+	this->View.HashId = DbHeader->HashId;
+	this->View.Seeds = (const uint32_t*)(Data + SeedSection->Offset);
+	this->View.Entries = (const TranslationDBEntry*)(Data + EntrySection->Offset);
+	this->View.Strings = (const char*)(Data + StringSection->Offset);
+	this->View.StringsSize = StringSection->Size;
+
+	// Templates are optional, without them values are handed out as is
+	if (TemplateIndexSection != nullptr && TemplateSection != nullptr && TemplateIndexSection->Size == (uint64_t)DbHeader->EntryCount * sizeof(uint32_t))
+	{
+		this->View.TemplateIndex = (const uint32_t*)(Data + TemplateIndexSection->Offset);
+		this->View.Templates = Data + TemplateSection->Offset;
+		this->View.TemplatesSize = TemplateSection->Size;
+	}
+
+	// Compressed values are decoded on demand, wide values included
+	if (Symbols != nullptr)
+	{
+		this->DecodedValues.reset(new DecodedValueCache(Symbols, DbHeader->EntryCount));
+		this->View.Symbols = Symbols;
+		this->View.Decoded = this->DecodedValues.get();
+	}
+	// Wide values are optional, images built before they existed get them converted once here
+	else if (WideEntrySection != nullptr && WideStringSection != nullptr && WideEntrySection->Size == (uint64_t)DbHeader->EntryCount * sizeof(TranslationDBWideEntry))
+	{
+		this->View.WideEntries = (const TranslationDBWideEntry*)(Data + WideEntrySection->Offset);
+		this->View.WideStrings = (const uint16_t*)(Data + WideStringSection->Offset);
+		this->View.WideStringsSize = WideStringSection->Size / sizeof(uint16_t);
+	}
+	else
+	{
+		this->BuildWideValues();
+	}
+
+	// The filter is optional too, images built before it existed get one built here
+	if (FilterSection != nullptr && FilterSection->Size >= BloomFilter::BlockSize && (FilterSection->Size % BloomFilter::BlockSize) == 0)
+	{
+		this->View.FilterBlocks = (const uint32_t*)(Data + FilterSection->Offset);
+		this->View.FilterBlockCount = FilterSection->Size / BloomFilter::BlockSize;
+	}
+	else
+	{
+		this->BuildFilter();
+	}
+
+	return true;
+}
+
+void TranslationDB::BuildFilter()
+{
+	auto EntryCount = this->View.EntryCount;
+	auto BlockCount = BloomFilter::GetBlockCount(EntryCount, TRANSLATIONDB_FILTER_BITS_PER_KEY);
+
+	this->FilterData.assign((size_t)BlockCount * BloomFilter::BlockWords, 0);
+
+	// Entries only keep half the hash, so every key is hashed again with the policy that placed it
+	for (uint32_t i = 0; i < EntryCount; i++)
+	{
+		auto& Entry = this->View.Entries[i];
+		if ((uint64_t)Entry.KeyOffset + Entry.KeyLength >= this->View.StringsSize)
+			continue;
+
+		auto Key = this->View.Strings + Entry.KeyOffset;
+		auto Hash = (this->View.HashId == Hashing::HashWordMix) ? Hashing::WordMix::Hash(Key, Entry.KeyLength) : Hashing::Fnv1a::Hash(Key, Entry.KeyLength);
+
+		BloomFilter::Insert(this->FilterData.data(), BlockCount, Hash);
+	}
+
+	this->View.FilterBlocks = this->FilterData.data();
+	this->View.FilterBlockCount = BlockCount;
+}
+
+void TranslationDB::BuildWideValues()
+{
+	auto EntryCount = this->Header->EntryCount;
+
+	this->WideEntryData.resize(EntryCount);
+	this->WideStringData.clear();
+
+	for (uint32_t i = 0; i < EntryCount; i++)
+	{
+		auto& Entry = this->View.Entries[i];
+		auto& WideEntry = this->WideEntryData[i];
+
+		WideEntry.ValueOffset = (uint32_t)this->WideStringData.size();
+		WideEntry.ValueLength = TRANSLATIONDB_WIDE_INVALID;
+
+		if ((uint64_t)Entry.ValueOffset + Entry.ValueLength >= this->View.StringsSize)
+			continue;
+
+		size_t WideLength = 0;
+		if (!Unicode::MeasureUtf8AsUtf16(this->View.Strings + Entry.ValueOffset, Entry.ValueLength, WideLength))
+			continue;
+
+		this->WideStringData.resize(WideEntry.ValueOffset + WideLength + 1);
+		Unicode::Utf8ToUtf16(this->View.Strings + Entry.ValueOffset, Entry.ValueLength, this->WideStringData.data() + WideEntry.ValueOffset, WideLength);
+
+		WideEntry.ValueLength = (uint32_t)WideLength;
+	}
+
+	this->View.WideEntries = this->WideEntryData.data();
+	this->View.WideStrings = this->WideStringData.data();
+	this->View.WideStringsSize = (uint32_t)this->WideStringData.size();
+}
+
+bool TranslationDB::LoadLegacy(const uint8_t* Data, size_t Size)
+{
+	TranslationDBBuilder Builder;
+
+	auto Threads = Parallel::GetWorkerCount();
+
+	if (!ParseLegacyDatabase(Data, Size, Builder, Threads))
+		return false;
+	if (!Builder.Build(this->Image, nullptr, Threads))
+		return false;
+
+	return this->Attach(this->Image.data(), this->Image.size());
+}
+
+// Runs a lookup with the hash policy the database was built with
+template<typename Func>
+static auto WithLookup(const TranslationDBView& View, Func Function) -> decltype(Function(TranslationLookup<Hashing::Fnv1a>(View)))
+{
+	if (View.HashId == Hashing::HashWordMix)
+		return Function(TranslationLookup<Hashing::WordMix>(View));
+
+	return Function(TranslationLookup<Hashing::Fnv1a>(View));
+}
+
+const TranslationDBEntry* TranslationDB::FindEntry(const char* Key, size_t KeyLength) const
+{
+	return WithLookup(this->View, [&](const auto& Lookup) { return Lookup.FindEntry(std::string_view(Key, KeyLength)); });
+}
+
+const TranslationDBEntry* TranslationDB::FindEntry(const uint16_t* Key, size_t KeyLength) const
+{
+	return WithLookup(this->View, [&](const auto& Lookup) { return Lookup.FindEntry(Key, KeyLength); });
+}
+
+const TranslationDBEntry* TranslationDB::FindReferenceEntry(const char* Reference) const
+{
+	return WithLookup(this->View, [&](const auto& Lookup) { return Lookup.FindReference(Reference); });
+}
+
+const char* TranslationDB::Find(const char* Key, size_t KeyLength) const
+{
+	return WithLookup(this->View, [&](const auto& Lookup) { return Lookup.Find(std::string_view(Key, KeyLength)); });
+}
+
+const char* TranslationDB::Find(const char* Key) const
+{
+	return this->Find(Key, std::strlen(Key));
+}
+
+const char* TranslationDB::FindReference(const char* Reference) const
+{
+	auto Entry = this->FindReferenceEntry(Reference);
+
+	return (Entry != nullptr) ? this->GetValue(Entry) : nullptr;
+}
+
+const char* TranslationDB::GetKey(const TranslationDBEntry* Entry) const
+{
+	return this->View.Strings + Entry->KeyOffset;
+}
+
+const char* TranslationDB::GetValue(const TranslationDBEntry* Entry) const
+{
+	return TranslationLookup<>(this->View).GetValue(Entry);
+}
+
+const uint16_t* TranslationDB::GetWideValue(const TranslationDBEntry* Entry, uint32_t& Length) const
+{
+	return TranslationLookup<>(this->View).GetWideValue(Entry, Length);
+}
+
+const PlaceholderTemplate* TranslationDB::GetTemplate(const TranslationDBEntry* Entry) const
+{
+	return TranslationLookup<>(this->View).GetTemplate(Entry);
+}
+
+const TranslationDBView& TranslationDB::GetView() const
+{
+	return this->View;
+}
+
+uint32_t TranslationDB::GetEntryCount() const
+{
+	return (this->Header != nullptr) ? this->Header->EntryCount : 0;
+}
+
+uint32_t TranslationDB::GetImageSize() const
+{
+	return (this->Header != nullptr) ? this->Header->FileSize : 0;
+}
+
+bool TranslationDB::IsCompressed() const
+{
+	return (this->View.Symbols != nullptr);
+}
+
+bool TranslationDB::IsPatched() const
+{
+	return this->Patched;
+}
+
+bool TranslationDB::IsMapped() const
+{
+	return (this->Header != nullptr && this->Image.empty());
+}
+
+TranslationDBBuilder::TranslationDBBuilder()
+{
+	this->CompressValues = false;
+	this->LayoutHint = nullptr;
+}
+
+TranslationDBBuilder::~TranslationDBBuilder()
+{
+}
+
+void TranslationDBBuilder::Add(const char* Key, uint32_t KeyLength, const char* Value, uint32_t ValueLength)
+{
+	TranslationPair Pair;
+	Pair.Key = Key;
+	Pair.KeyLength = KeyLength;
+	Pair.Value = Value;
+	Pair.ValueLength = ValueLength;
+
+	this->Pairs.push_back(Pair);
+}
+
+void TranslationDBBuilder::Reserve(uint32_t Count)
+{
+	this->Pairs.reserve(Count);
+}
+
+void TranslationDBBuilder::Clear()
+{
+	this->Pairs.clear();
+}
+
+void TranslationDBBuilder::SetValueCompression(bool Enabled)
+{
+	this->CompressValues = Enabled;
+}
+
+void TranslationDBBuilder::SetLayoutHint(const TranslationDBView* Previous)
+{
+	this->LayoutHint = Previous;
+}
+
+static bool SetBuildError(std::string* Error, const std::string& Message)
+{
+	if (Error != nullptr)
+		*Error = Message;
+
+	return false;
+}
+
+bool TranslationDBBuilder::Build(std::vector<uint8_t>& Result, std::string* Error, uint32_t Threads) const
+{
+	return this->BuildWith<Hashing::Fnv1a>(Result, Error, Threads);
+}
+
+template<typename Hasher>
+bool TranslationDBBuilder::BuildWith(std::vector<uint8_t>& Result, std::string* Error, uint32_t Threads) const
+{
+	// Order by key, keeping insertion order for duplicates so the last one wins
+	std::vector<uint32_t> Order(this->Pairs.size());
+	for (uint32_t i = 0; i < (uint32_t)Order.size(); i++)
+		Order[i] = i;
+
+	auto& Pairs = this->Pairs;
+	std::stable_sort(Order.begin(), Order.end(), [&Pairs](uint32_t Lhs, uint32_t Rhs)
+	{
+		auto& A = Pairs[Lhs];
+		auto& B = Pairs[Rhs];
+		auto Compare = std::memcmp(A.Key, B.Key, std::min(A.KeyLength, B.KeyLength));
+		return (Compare != 0) ? (Compare < 0) : (A.KeyLength < B.KeyLength);
+	});
+
+	std::vector<uint32_t> Unique;
+	Unique.reserve(Order.size());
+
+	for (size_t i = 0; i < Order.size(); i++)
+	{
+		auto& Pair = Pairs[Order[i]];
+
+		if (i + 1 < Order.size())
+		{
+			auto& Next = Pairs[Order[i + 1]];
+			if (Next.KeyLength == Pair.KeyLength && std::memcmp(Next.Key, Pair.Key, Pair.KeyLength) == 0)
+				continue;
+		}
+
+		Unique.push_back(Order[i]);
+	}
+
+	auto EntryCount = (uint32_t)Unique.size();
+	auto BucketCount = std::max<uint32_t>(1, (EntryCount + KeysPerBucket - 1) / KeysPerBucket);
+
+	// Compressed values are encoded with a table trained on all of them, and get no wide copies
+	auto Compress = this->CompressValues;
+	SymbolTable Symbols;
+	std::vector<std::vector<uint8_t>> EncodedValues;
+
+	if (Compress)
+	{
+		std::vector<std::string_view> Sample;
+		Sample.reserve(EntryCount);
+
+		for (auto Index : Unique)
+			Sample.emplace_back(Pairs[Index].Value, Pairs[Index].ValueLength);
+
+		Symbols.Train(Sample);
+		EncodedValues.resize(EntryCount);
+	}
+
+	// Hash every key once and measure every value as utf16 (or encode it), so the image can be sized once and values written straight into it.
+	// Values with placeholders are split into templates along the way
+	std::vector<uint64_t> Hashes(EntryCount);
+	std::vector<TranslationDBWideEntry> WideEntries(EntryCount);
+	std::vector<std::vector<PlaceholderSegment>> Segments(EntryCount);
+	std::vector<uint16_t> SlotMasks(EntryCount);
+
+	auto Chunks = Parallel::GetChunkCount(EntryCount, BuildChunkPairs, Threads);
+
+	Parallel::For(Chunks, [&](uint32_t Chunk)
+	{
+		auto Start = (uint32_t)(((uint64_t)EntryCount * Chunk) / Chunks);
+		auto End = (uint32_t)(((uint64_t)EntryCount * (Chunk + 1)) / Chunks);
+
+		for (uint32_t i = Start; i < End; i++)
+		{
+			auto& Pair = Pairs[Unique[i]];
+			Hashes[i] = Hasher::Hash(Pair.Key, Pair.KeyLength);
+
+			uint32_t SlotMask = 0;
+			Placeholders::Parse(Pair.Value, Pair.ValueLength, Segments[i], SlotMask);
+			SlotMasks[i] = (uint16_t)SlotMask;
+
+			// Values that would overflow a template are handed out as is
+			if (Segments[i].size() > UINT16_MAX)
+				Segments[i].clear();
+
+			if (Compress)
+			{
+				Symbols.Encode(Pair.Value, Pair.ValueLength, EncodedValues[i]);
+				continue;
+			}
+
+			size_t WideLength = 0;
+			if (Unicode::MeasureUtf8AsUtf16(Pair.Value, Pair.ValueLength, WideLength))
+				WideEntries[i].ValueLength = (uint32_t)WideLength;
+			else
+				WideEntries[i].ValueLength = TRANSLATIONDB_WIDE_INVALID;
+		}
+	});
+
+	// The bytes stored for a value
+	auto GetStoredValue = [&](uint32_t i, uint32_t& Length) -> const char*
+	{
+		if (Compress)
+		{
+			Length = (uint32_t)EncodedValues[i].size();
+			return (const char*)EncodedValues[i].data();
+		}
+
+		Length = Pairs[Unique[i]].ValueLength;
+		return Pairs[Unique[i]].Value;
+	};
+
+	// Wide values are laid out in key order, each null-term
+	uint64_t WideStringsLength = 0;
+	for (auto& WideEntry : WideEntries)
+	{
+		if (Compress)
+			break;
+
+		WideEntry.ValueOffset = (uint32_t)WideStringsLength;
+
+		if (WideEntry.ValueLength != TRANSLATIONDB_WIDE_INVALID)
+			WideStringsLength += (uint64_t)WideEntry.ValueLength + 1;
+	}
+
+	{
+		std::vector<uint64_t> Sorted(Hashes);
+		std::sort(Sorted.begin(), Sorted.end());
+		if (std::adjacent_find(Sorted.begin(), Sorted.end()) != Sorted.end())
+			return SetBuildError(Error, "Two distinct keys share a 64bit hash");
+	}
+
+	// Distribute keys over buckets with a counting sort into one flat array, then place the largest buckets first
+	std::vector<uint32_t> BucketStart(BucketCount + 1, 0);
+	std::vector<uint32_t> KeyBuckets(EntryCount);
+	for (uint32_t i = 0; i < EntryCount; i++)
+	{
+		KeyBuckets[i] = TranslationDBBucket(Hashes[i], BucketCount);
+		BucketStart[KeyBuckets[i] + 1]++;
+	}
+
+	for (uint32_t i = 0; i < BucketCount; i++)
+		BucketStart[i + 1] += BucketStart[i];
+
+	std::vector<uint32_t> BucketKeys(EntryCount);
+	{
+		std::vector<uint32_t> Fill(BucketStart.begin(), BucketStart.end() - 1);
+		for (uint32_t i = 0; i < EntryCount; i++)
+			BucketKeys[Fill[KeyBuckets[i]]++] = i;
+	}
+
+	std::vector<uint32_t> BucketOrder(BucketCount);
+	for (uint32_t i = 0; i < BucketCount; i++)
+		BucketOrder[i] = i;
+
+	std::stable_sort(BucketOrder.begin(), BucketOrder.end(), [&BucketStart](uint32_t Lhs, uint32_t Rhs)
+	{
+		return (BucketStart[Lhs + 1] - BucketStart[Lhs]) > (BucketStart[Rhs + 1] - BucketStart[Rhs]);
+	});
+
+	std::vector<uint32_t> Seeds(BucketCount, 0);
+	std::vector<uint32_t> SlotOwner(EntryCount, UINT32_MAX);
+	std::vector<uint32_t> Candidate;
+
+	// A previous build of exactly these keys already holds the seeds the search would find, every key must land on the slot of its previous entry
+	auto Hint = this->LayoutHint;
+	bool Reused = false;
+
+	if (Hint != nullptr && Hint->HashId == Hasher::Id && Hint->EntryCount == EntryCount && Hint->BucketCount == BucketCount)
+	{
+		Reused = true;
+
+		for (uint32_t i = 0; i < EntryCount && Reused; i++)
+		{
+			auto& Pair = Pairs[Unique[i]];
+			auto Slot = TranslationDBSlot(Hashes[i], Hint->Seeds[TranslationDBBucket(Hashes[i], BucketCount)], EntryCount);
+			auto& Previous = Hint->Entries[Slot];
+
+			Reused = (SlotOwner[Slot] == UINT32_MAX && Previous.Hash == (uint32_t)Hashes[i] && Previous.KeyLength == Pair.KeyLength && std::memcmp(Hint->Strings + Previous.KeyOffset, Pair.Key, Pair.KeyLength) == 0);
+			SlotOwner[Slot] = i;
+		}
+
+		if (Reused)
+			Seeds.assign(Hint->Seeds, Hint->Seeds + BucketCount);
+		else
+			SlotOwner.assign(EntryCount, UINT32_MAX);
+	}
+
+	if (!Reused)
+	{
+		for (auto BucketIndex : BucketOrder)
+		{
+			auto BucketBegin = BucketKeys.data() + BucketStart[BucketIndex];
+			auto BucketEnd = BucketKeys.data() + BucketStart[BucketIndex + 1];
+			if (BucketBegin == BucketEnd)
+				break;
+
+			bool Placed = false;
+			for (uint32_t Seed = 0; Seed < UINT32_MAX && !Placed; Seed++)
+			{
+				Candidate.clear();
+				Placed = true;
+
+				for (auto Key = BucketBegin; Key != BucketEnd; Key++)
+				{
+					auto Slot = TranslationDBSlot(Hashes[*Key], Seed, EntryCount);
+
+					if (SlotOwner[Slot] != UINT32_MAX || std::find(Candidate.begin(), Candidate.end(), Slot) != Candidate.end())
+					{
+						Placed = false;
+						break;
+					}
+
+					Candidate.push_back(Slot);
+				}
+
+				if (Placed)
+				{
+					Seeds[BucketIndex] = Seed;
+					for (size_t i = 0; i < Candidate.size(); i++)
+						SlotOwner[Candidate[i]] = BucketBegin[i];
+				}
+			}
+
+			if (!Placed)
+				return SetBuildError(Error, "Failed to place a perfect hash bucket");
+		}
+	}
+
+	// Lay out the strings in key order
+	uint64_t StringsSize = 0;
+	for (uint32_t i = 0; i < EntryCount; i++)
+	{
+		uint32_t ValueLength = 0;
+		GetStoredValue(i, ValueLength);
+		StringsSize += (uint64_t)Pairs[Unique[i]].KeyLength + ValueLength + 2;
+	}
+
+	// Templates in key order, after the empty one every entry without placeholders points at
+	std::vector<uint32_t> TemplateOffsets(EntryCount, 0);
+	uint64_t TemplatesSize = sizeof(PlaceholderTemplate);
+
+	for (uint32_t i = 0; i < EntryCount; i++)
+	{
+		if (Segments[i].empty())
+			continue;
+
+		TemplateOffsets[i] = (uint32_t)TemplatesSize;
+		TemplatesSize += sizeof(PlaceholderTemplate) + (Segments[i].size() * sizeof(PlaceholderSegment));
+	}
+
+	auto HasTemplates = (TemplatesSize > sizeof(PlaceholderTemplate));
+
+	// The negative filter, aligned so a block never straddles a cache line
+	auto FilterBlockCount = BloomFilter::GetBlockCount(EntryCount, TRANSLATIONDB_FILTER_BITS_PER_KEY);
+
+	// Sections in file order, each payload follows the previous one
+	std::vector<SectionLayout> Layout;
+	Layout.push_back({ TRANSLATIONDB_SECTION_SEEDS, (uint64_t)BucketCount * sizeof(uint32_t), SectionAlignment, 0 });
+	Layout.push_back({ TRANSLATIONDB_SECTION_ENTRIES, (uint64_t)EntryCount * sizeof(TranslationDBEntry), SectionAlignment, 0 });
+	Layout.push_back({ TRANSLATIONDB_SECTION_STRINGS, StringsSize, SectionAlignment, 0 });
+
+	if (!Compress)
+	{
+		Layout.push_back({ TRANSLATIONDB_SECTION_WIDEENTRIES, (uint64_t)EntryCount * sizeof(TranslationDBWideEntry), SectionAlignment, 0 });
+		Layout.push_back({ TRANSLATIONDB_SECTION_WIDESTRINGS, WideStringsLength * sizeof(uint16_t), SectionAlignment, 0 });
+	}
+
+	Layout.push_back({ TRANSLATIONDB_SECTION_FILTER, (uint64_t)FilterBlockCount * BloomFilter::BlockSize, FilterAlignment, 0 });
+
+	if (Compress)
+		Layout.push_back({ TRANSLATIONDB_SECTION_SYMBOLS, sizeof(SymbolTableData), SectionAlignment, 0 });
+
+	if (HasTemplates)
+	{
+		Layout.push_back({ TRANSLATIONDB_SECTION_TEMPLATEINDEX, (uint64_t)EntryCount * sizeof(uint32_t), SectionAlignment, 0 });
+		Layout.push_back({ TRANSLATIONDB_SECTION_TEMPLATES, TemplatesSize, SectionAlignment, 0 });
+	}
+
+	uint64_t FileSize = sizeof(TranslationDBHeader) + (Layout.size() * sizeof(TranslationDBSection));
+	for (auto& Section : Layout)
+	{
+		Section.Offset = AlignSection(FileSize, Section.Alignment);
+		FileSize = Section.Offset + Section.Size;
+	}
+
+	if (FileSize > UINT32_MAX)
+		return SetBuildError(Error, "Database exceeds 4GB");
+
+	auto GetSectionOffset = [&Layout](uint32_t Id) -> uint32_t
+	{
+		for (auto& Section : Layout)
+		{
+			if (Section.Id == Id)
+				return (uint32_t)Section.Offset;
+		}
+
+		return 0;
+	};
+
+	Result.assign((size_t)FileSize, 0);
+
+	auto DbHeader = (TranslationDBHeader*)Result.data();
+	DbHeader->Magic = TRANSLATIONDB_MAGIC;
+	DbHeader->Version = TRANSLATIONDB_VERSION;
+	DbHeader->SectionCount = (uint16_t)Layout.size();
+	DbHeader->EntryCount = EntryCount;
+	DbHeader->BucketCount = BucketCount;
+	DbHeader->FileSize = (uint32_t)FileSize;
+	DbHeader->HashId = Hasher::Id;
+
+	auto Sections = (TranslationDBSection*)(Result.data() + sizeof(TranslationDBHeader));
+	for (size_t i = 0; i < Layout.size(); i++)
+	{
+		Sections[i].Id = Layout[i].Id;
+		Sections[i].Offset = (uint32_t)Layout[i].Offset;
+		Sections[i].Size = (uint32_t)Layout[i].Size;
+	}
+
+	auto SeedsOffset = GetSectionOffset(TRANSLATIONDB_SECTION_SEEDS);
+	auto EntriesOffset = GetSectionOffset(TRANSLATIONDB_SECTION_ENTRIES);
+	auto StringsOffset = GetSectionOffset(TRANSLATIONDB_SECTION_STRINGS);
+	auto FilterOffset = GetSectionOffset(TRANSLATIONDB_SECTION_FILTER);
+
+	if (Compress)
+		std::memcpy(Result.data() + GetSectionOffset(TRANSLATIONDB_SECTION_SYMBOLS), &Symbols.GetData(), sizeof(SymbolTableData));
+
+	// Templates index into the plain value, which is what compressed values decode to
+	if (HasTemplates)
+	{
+		auto TemplateData = Result.data() + GetSectionOffset(TRANSLATIONDB_SECTION_TEMPLATES);
+
+		for (uint32_t i = 0; i < EntryCount; i++)
+		{
+			if (Segments[i].empty())
+				continue;
+
+			PlaceholderTemplate Template;
+			Template.SegmentCount = (uint16_t)Segments[i].size();
+			Template.SlotMask = SlotMasks[i];
+			Template.ValueLength = Pairs[Unique[i]].ValueLength;
+
+			std::memcpy(TemplateData + TemplateOffsets[i], &Template, sizeof(Template));
+			std::memcpy(TemplateData + TemplateOffsets[i] + sizeof(Template), Segments[i].data(), Segments[i].size() * sizeof(PlaceholderSegment));
+		}
+	}
+
+	std::memcpy(Result.data() + SeedsOffset, Seeds.data(), BucketCount * sizeof(uint32_t));
+
+	// Key index for every unique pair, so entries can reference the string offsets
+	std::vector<uint32_t> KeyOffsets(EntryCount), ValueOffsets(EntryCount);
+	auto StringData = (char*)(Result.data() + StringsOffset);
+	uint32_t Cursor = 0;
+
+	for (uint32_t i = 0; i < EntryCount; i++)
+	{
+		auto& Pair = Pairs[Unique[i]];
+
+		KeyOffsets[i] = Cursor;
+		std::memcpy(StringData + Cursor, Pair.Key, Pair.KeyLength);
+		Cursor += Pair.KeyLength + 1;
+
+		uint32_t ValueLength = 0;
+		auto Value = GetStoredValue(i, ValueLength);
+
+		ValueOffsets[i] = Cursor;
+		std::memcpy(StringData + Cursor, Value, ValueLength);
+		Cursor += ValueLength + 1;
+	}
+
+	auto EntryData = (TranslationDBEntry*)(Result.data() + EntriesOffset);
+	auto WideEntryData = (TranslationDBWideEntry*)(Result.data() + GetSectionOffset(TRANSLATIONDB_SECTION_WIDEENTRIES));
+	for (uint32_t Slot = 0; Slot < EntryCount; Slot++)
+	{
+		auto Key = SlotOwner[Slot];
+		auto& Pair = Pairs[Unique[Key]];
+		auto& Entry = EntryData[Slot];
+
+		Entry.Hash = (uint32_t)Hashes[Key];
+		Entry.KeyOffset = KeyOffsets[Key];
+		Entry.KeyLength = Pair.KeyLength;
+		Entry.ValueOffset = ValueOffsets[Key];
+		GetStoredValue(Key, Entry.ValueLength);
+
+		if (!Compress)
+			WideEntryData[Slot] = WideEntries[Key];
+	}
+
+	// Template offsets follow the entries into slot order
+	if (HasTemplates)
+	{
+		auto TemplateIndex = (uint32_t*)(Result.data() + GetSectionOffset(TRANSLATIONDB_SECTION_TEMPLATEINDEX));
+		for (uint32_t Slot = 0; Slot < EntryCount; Slot++)
+			TemplateIndex[Slot] = TemplateOffsets[SlotOwner[Slot]];
+	}
+
+	// Convert the values into the image, the terminators are already zero
+	auto WideStringData = (uint16_t*)(Result.data() + GetSectionOffset(TRANSLATIONDB_SECTION_WIDESTRINGS));
+
+	Parallel::For(Compress ? 0 : Chunks, [&](uint32_t Chunk)
+	{
+		auto Start = (uint32_t)(((uint64_t)EntryCount * Chunk) / Chunks);
+		auto End = (uint32_t)(((uint64_t)EntryCount * (Chunk + 1)) / Chunks);
+
+		for (uint32_t i = Start; i < End; i++)
+		{
+			if (WideEntries[i].ValueLength == TRANSLATIONDB_WIDE_INVALID)
+				continue;
+
+			auto& Pair = Pairs[Unique[i]];
+			size_t WideLength = 0;
+			Unicode::Utf8ToUtf16(Pair.Value, Pair.ValueLength, WideStringData + WideEntries[i].ValueOffset, WideLength);
+		}
+	});
+
+	auto FilterData = (uint32_t*)(Result.data() + FilterOffset);
+	for (uint32_t i = 0; i < EntryCount; i++)
+		BloomFilter::Insert(FilterData, FilterBlockCount, Hashes[i]);
+
+	return true;
+}
+
+// The hash policies databases can be built with
+template bool TranslationDBBuilder::BuildWith<Hashing::Fnv1a>(std::vector<uint8_t>& Result, std::string* Error, uint32_t Threads) const;
+template bool TranslationDBBuilder::BuildWith<Hashing::WordMix>(std::vector<uint8_t>& Result, std::string* Error, uint32_t Threads) const;
+
+bool ParseLegacyDatabase(const uint8_t* Data, size_t Size, std::vector<TranslationPair>& Pairs, uint32_t Threads)
+{
+	//
+	// Simple format <uint32_t> entry count X null-term utf8-string KVP
+	//
+	// The body is split into chunks, a first pass counts the nulls of every chunk so each chunk knows
+	// the index of the strings inside it, a second pass emits the pairs whose key starts in the chunk.
+	//
+
+	if (Size < sizeof(uint32_t))
+		return false;
+
+	auto Entries = *(const uint32_t*)Data;
+	auto Body = Data + sizeof(uint32_t);
+	auto End = Data + Size;
+
+	auto Chunks = Parallel::GetChunkCount((size_t)(End - Body), LegacyChunkSize, Threads);
+	std::vector<const uint8_t*> Bounds(Chunks + 1);
+	for (uint32_t Chunk = 0; Chunk <= Chunks; Chunk++)
+		Bounds[Chunk] = Body + (((uint64_t)(End - Body) * Chunk) / Chunks);
+
+	// Pass one, nulls per chunk
+	std::vector<uint64_t> NullsBefore(Chunks + 1, 0);
+	if (Chunks > 1)
+	{
+		std::vector<uint64_t> NullCounts(Chunks, 0);
+		Parallel::For(Chunks, [&](uint32_t Chunk)
+		{
+			NullCounts[Chunk] = ByteScan::Count(Bounds[Chunk], Bounds[Chunk + 1], 0);
+		});
+
+		for (uint32_t Chunk = 0; Chunk < Chunks; Chunk++)
+			NullsBefore[Chunk + 1] = NullsBefore[Chunk] + NullCounts[Chunk];
+	}
+
+	// Pass two, every chunk builds a partial table of the pairs that start inside it
+	std::vector<std::vector<TranslationPair>> Partials(Chunks);
+	auto StringLimit = (uint64_t)Entries * 2;
+
+	Parallel::For(Chunks, [&](uint32_t Chunk)
+	{
+		auto Cursor = Bounds[Chunk];
+		auto ChunkEnd = Bounds[Chunk + 1];
+		auto StringIndex = NullsBefore[Chunk];
+
+		// Move to the first string that starts inside this chunk
+		if (Cursor != Body && Cursor[-1] != 0)
+		{
+			auto Terminator = ByteScan::Find(Cursor, ChunkEnd, 0);
+			if (Terminator == nullptr)
+				return;
+
+			Cursor = Terminator + 1;
+			StringIndex++;
+		}
+
+		// Keys are the even strings, skip a value straddling the chunk start
+		if ((StringIndex & 1) != 0 && Cursor < ChunkEnd)
+		{
+			auto Terminator = ByteScan::Find(Cursor, End, 0);
+			if (Terminator == nullptr)
+				return;
+
+			Cursor = Terminator + 1;
+			StringIndex++;
+		}
+
+		auto& Partial = Partials[Chunk];
+
+		while (Cursor < ChunkEnd && StringIndex < StringLimit)
+		{
+			// Either string may run past the chunk, the pair belongs to the chunk its key starts in
+			auto KeyEnd = ByteScan::Find(Cursor, End, 0);
+			if (KeyEnd == nullptr)
+				break;
+
+			auto Value = KeyEnd + 1;
+			auto ValueEnd = ByteScan::Find(Value, End, 0);
+			if (ValueEnd == nullptr)
+				break;
+
+			TranslationPair Pair;
+			Pair.Key = (const char*)Cursor;
+			Pair.KeyLength = (uint32_t)(KeyEnd - Cursor);
+			Pair.Value = (const char*)Value;
+			Pair.ValueLength = (uint32_t)(ValueEnd - Value);
+			Partial.push_back(Pair);
+
+			Cursor = ValueEnd + 1;
+			StringIndex += 2;
+		}
+	});
+
+	// Merge in file order, so duplicate keys still resolve to the last one
+	size_t PairCount = 0;
+	for (auto& Partial : Partials)
+		PairCount += Partial.size();
+
+	Pairs.clear();
+	Pairs.reserve(PairCount);
+
+	for (auto& Partial : Partials)
+		Pairs.insert(Pairs.end(), Partial.begin(), Partial.end());
+
+	return true;
+}
+
+bool ParseLegacyDatabase(const uint8_t* Data, size_t Size, TranslationDBBuilder& Builder, uint32_t Threads)
+{
+	std::vector<TranslationPair> Pairs;
+	if (!ParseLegacyDatabase(Data, Size, Pairs, Threads))
+		return false;
+
+	Builder.Reserve((uint32_t)Pairs.size());
+
+	for (auto& Pair : Pairs)
+		Builder.Add(Pair.Key, Pair.KeyLength, Pair.Value, Pair.ValueLength);
+
+	return true;
+}
+
+void BuildLegacyDatabase(const std::vector<TranslationPair>& Pairs, std::vector<uint8_t>& Result)
+{
+	size_t Size = sizeof(uint32_t);
+	for (auto& Pair : Pairs)
+		Size += (size_t)Pair.KeyLength + Pair.ValueLength + 2;
+
+	Result.resize(Size);
+
+	auto Output = Result.data();
+	*(uint32_t*)Output = (uint32_t)Pairs.size();
+	Output += sizeof(uint32_t);
+
+	for (auto& Pair : Pairs)
+	{
+		std::memcpy(Output, Pair.Key, Pair.KeyLength);
+		Output[Pair.KeyLength] = 0;
+		Output += Pair.KeyLength + 1;
+
+		std::memcpy(Output, Pair.Value, Pair.ValueLength);
+		Output[Pair.ValueLength] = 0;
+		Output += Pair.ValueLength + 1;
+	}
+}
\ No newline at end of file
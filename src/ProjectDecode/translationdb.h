@@ -0,0 +1,247 @@
+#pragma once
+
+// Standard includes
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Our includes
+#include "mappedfile.h"
+#include "hashing.h"
+#include "valuecache.h"
+#include "placeholders.h"
+
+//
+// TranslationsDB v2 layout, little-endian, designed to be mapped and queried in place:
+//   TranslationDBHeader
+//   TranslationDBSection[SectionCount]
+//   Section payloads, each 16 byte aligned
+//
+// Lookup hashes the key once (FNV-1a 64), the upper bits select a bucket whose seed
+// displaces the key to its slot in a minimal perfect hash, the slot entry is then verified.
+// Images with a symbol table store every value encoded with it (see symboltable.h) and no wide values,
+// values are then decoded the first time they are asked for.
+// Values with engine placeholders (&&1) also get a template splitting them into literal and slot segments.
+//
+
+// 'D3DB'
+#define TRANSLATIONDB_MAGIC 0x42443344
+#define TRANSLATIONDB_VERSION 2
+
+// Section identifiers
+#define TRANSLATIONDB_SECTION_SEEDS 0x44454553		// 'SEED' uint32_t[BucketCount]
+#define TRANSLATIONDB_SECTION_ENTRIES 0x52544E45	// 'ENTR' TranslationDBEntry[EntryCount]
+#define TRANSLATIONDB_SECTION_STRINGS 0x53525453	// 'STRS' null-term utf8 keys and values
+#define TRANSLATIONDB_SECTION_WIDEENTRIES 0x58444957	// 'WIDX' TranslationDBWideEntry[EntryCount], parallel to the entries
+#define TRANSLATIONDB_SECTION_WIDESTRINGS 0x52545357	// 'WSTR' null-term utf16 values
+#define TRANSLATIONDB_SECTION_FILTER 0x4D4F4C42		// 'BLOM' split block bloom filter of every key hash, see bloomfilter.h
+#define TRANSLATIONDB_SECTION_SYMBOLS 0x534D5953	// 'SYMS' SymbolTableData the values in the strings section are encoded with
+#define TRANSLATIONDB_SECTION_TEMPLATEINDEX 0x58444954	// 'TIDX' uint32_t[EntryCount] offsets into the templates, parallel to the entries
+#define TRANSLATIONDB_SECTION_TEMPLATES 0x4C504D54	// 'TMPL' PlaceholderTemplate records, each followed by its segments, the first one is empty
+
+// Filter size, 12 bits per key lets ~0.7% of absent keys through
+#define TRANSLATIONDB_FILTER_BITS_PER_KEY 12
+
+// Wide length of a value that isn't valid utf8
+#define TRANSLATIONDB_WIDE_INVALID 0xFFFFFFFF
+
+struct TranslationDBHeader
+{
+	uint32_t Magic;
+	uint16_t Version;
+	uint16_t SectionCount;
+	uint32_t EntryCount;
+	uint32_t BucketCount;
+	uint32_t FileSize;
+	uint32_t HashId;		// Hashing::HashId of the policy that placed the keys, zero in files from before it existed
+	uint32_t Reserved[2];
+};
+
+struct TranslationDBSection
+{
+	uint32_t Id;
+	uint32_t Offset;
+	uint32_t Size;
+	uint32_t Reserved;
+};
+
+struct TranslationDBEntry
+{
+	uint32_t Hash;			// Lower 32 bits of the key hash, used to reject misses early
+	uint32_t KeyOffset;		// Offsets are relative to the strings section
+	uint32_t KeyLength;
+	uint32_t ValueOffset;
+	uint32_t ValueLength;
+};
+
+struct TranslationDBWideEntry
+{
+	uint32_t ValueOffset;	// In utf16 units, relative to the wide strings section
+	uint32_t ValueLength;	// In utf16 units, without the terminator
+};
+
+// Computes the bucket for a key hash
+inline uint32_t TranslationDBBucket(uint64_t Hash, uint32_t BucketCount)
+{
+	return (uint32_t)((Hash >> 32) % BucketCount);
+}
+
+// Computes the slot for a key hash, displaced by the bucket seed
+inline uint32_t TranslationDBSlot(uint64_t Hash, uint32_t Seed, uint32_t EntryCount)
+{
+	return (uint32_t)(Hashing::Mix64(Hash ^ ((uint64_t)Seed * 0x9E3779B97F4A7C15ull)) % EntryCount);
+}
+
+// The tables of a loaded database, everything a lookup reads
+struct TranslationDBView
+{
+	uint32_t EntryCount;
+	uint32_t BucketCount;
+	uint32_t HashId;
+	const uint32_t* Seeds;
+	const TranslationDBEntry* Entries;
+	const char* Strings;
+	uint32_t StringsSize;
+	const TranslationDBWideEntry* WideEntries;
+	const uint16_t* WideStrings;
+	uint32_t WideStringsSize;
+	const uint32_t* FilterBlocks;
+	uint32_t FilterBlockCount;
+	const uint32_t* TemplateIndex;		// Set when any value has placeholders
+	const uint8_t* Templates;
+	uint32_t TemplatesSize;
+	const SymbolTableData* Symbols;		// Set when values are compressed
+	DecodedValueCache* Decoded;		// Decoded values of a compressed database
+};
+
+// A loaded translation database, v2 files are mapped read-only, v1 files are converted on load
+class TranslationDB
+{
+private:
+	MappedFile File;
+	std::vector<uint8_t> Image;
+
+	const TranslationDBHeader* Header;
+	TranslationDBView View;
+
+	// Wide values built on load, for images without them
+	std::vector<TranslationDBWideEntry> WideEntryData;
+	std::vector<uint16_t> WideStringData;
+	// Filter built on load, for images without one
+	std::vector<uint32_t> FilterData;
+	// Values decoded on demand, for compressed images
+	std::unique_ptr<DecodedValueCache> DecodedValues;
+	// Loaded through LoadPatched
+	bool Patched;
+
+	// Attaches to a v2 image, validating every section
+	bool Attach(const uint8_t* Data, size_t Size);
+	// Converts a legacy v1 database into an in-memory v2 image
+	bool LoadLegacy(const uint8_t* Data, size_t Size);
+	// Converts every value to utf16, for images built without wide values
+	void BuildWideValues();
+	// Builds the negative filter, for images built without one
+	void BuildFilter();
+
+public:
+	TranslationDB();
+	~TranslationDB();
+
+	TranslationDB(const TranslationDB&) = delete;
+	TranslationDB& operator=(const TranslationDB&) = delete;
+
+	// Loads the database at the given path, read into memory instead of mapped when the file must stay writable
+	bool Load(const std::string& Path, bool MapInPlace = true);
+	// Loads a v2 image built in memory, taking ownership of the buffer
+	bool LoadImage(std::vector<uint8_t>& Buffer);
+	// Loads the database at the given path with a delta applied to it (see TranslationDelta), false if the delta wasn't made for that file
+	bool LoadPatched(const std::string& Path, const std::string& DeltaPath);
+	// Unloads the database
+	void Unload();
+
+	// Finds the value for a key, nullptr if not translated
+	const char* Find(const char* Key, size_t KeyLength) const;
+	// Finds the value for a null-term key, nullptr if not translated
+	const char* Find(const char* Key) const;
+
+	// Finds the value for a null-term engine reference (optionally prefixed with @), nullptr if not translated
+	const char* FindReference(const char* Reference) const;
+
+	// Finds the entry for a utf8 key, nullptr if not translated
+	const TranslationDBEntry* FindEntry(const char* Key, size_t KeyLength) const;
+	// Finds the entry for a null-term engine reference (optionally prefixed with @), nullptr if not translated
+	const TranslationDBEntry* FindReferenceEntry(const char* Reference) const;
+	// Finds the entry for a utf16 key, hashed and compared as utf8 without converting it
+	const TranslationDBEntry* FindEntry(const uint16_t* Key, size_t KeyLength) const;
+
+	// Gets the null-term utf8 key of an entry
+	const char* GetKey(const TranslationDBEntry* Entry) const;
+	// Gets the null-term utf8 value of an entry
+	const char* GetValue(const TranslationDBEntry* Entry) const;
+	// Gets the null-term utf16 value of an entry, nullptr if the value isn't valid utf8
+	const uint16_t* GetWideValue(const TranslationDBEntry* Entry, uint32_t& Length) const;
+	// Gets the placeholder template of an entry, nullptr if its value has no placeholders
+	const PlaceholderTemplate* GetTemplate(const TranslationDBEntry* Entry) const;
+
+	// Gets the tables for lookups, see TranslationLookup
+	const TranslationDBView& GetView() const;
+	// Gets the amount of loaded entries
+	uint32_t GetEntryCount() const;
+	// Whether or not values are stored compressed
+	bool IsCompressed() const;
+	// Gets the size of the loaded image in bytes
+	uint32_t GetImageSize() const;
+	// Whether or not the database is queried directly from the file mapping
+	bool IsMapped() const;
+	// Whether or not the database was loaded with a delta applied
+	bool IsPatched() const;
+};
+
+// A translation key value pair, referencing memory owned by the caller
+struct TranslationPair
+{
+	const char* Key;
+	uint32_t KeyLength;
+	const char* Value;
+	uint32_t ValueLength;
+};
+
+// Builds v2 database images
+class TranslationDBBuilder
+{
+private:
+	std::vector<TranslationPair> Pairs;
+	bool CompressValues;
+	const TranslationDBView* LayoutHint;
+
+public:
+	TranslationDBBuilder();
+	~TranslationDBBuilder();
+
+	// Adds a pair, the memory must stay valid until built, later keys replace earlier ones
+	void Add(const char* Key, uint32_t KeyLength, const char* Value, uint32_t ValueLength);
+	// Reserves room for an amount of pairs
+	void Reserve(uint32_t Count);
+	// Removes all pairs
+	void Clear();
+	// Stores values encoded with a symbol table trained on them, instead of plain utf8 and utf16 copies
+	void SetValueCompression(bool Enabled);
+	// Reuses the perfect hash seeds of a previous image when it holds exactly the same keys, skipping the seed search.
+	// The image is identical either way, the view must stay valid until built
+	void SetLayoutHint(const TranslationDBView* Previous);
+
+	// Builds the image, entries are ordered by key so output is deterministic, hashing and conversion are split across threads
+	bool Build(std::vector<uint8_t>& Result, std::string* Error = nullptr, uint32_t Threads = 1) const;
+	// Builds the image with a specific hash policy (Hashing::Fnv1a or Hashing::WordMix)
+	template<typename Hasher>
+	bool BuildWith(std::vector<uint8_t>& Result, std::string* Error = nullptr, uint32_t Threads = 1) const;
+};
+
+// Parses a legacy v1 database (<uint32_t> entry count, null-term utf8 key value pairs), split into chunks across threads
+bool ParseLegacyDatabase(const uint8_t* Data, size_t Size, TranslationDBBuilder& Builder, uint32_t Threads = 1);
+// Parses a legacy v1 database into its pairs in file order, duplicates included, referencing the input
+bool ParseLegacyDatabase(const uint8_t* Data, size_t Size, std::vector<TranslationPair>& Pairs, uint32_t Threads = 1);
+// Writes pairs as a legacy v1 database into a buffer sized once, the format translategen writes
+void BuildLegacyDatabase(const std::vector<TranslationPair>& Pairs, std::vector<uint8_t>& Result);
\ No newline at end of file
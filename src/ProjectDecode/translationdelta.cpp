@@ -0,0 +1,559 @@
+// Standard includes
+#include <algorithm>
+#include <cstring>
+#include <memory>
+
+// The class we are implementing
+#include "translationdelta.h"
+
+// Our includes
+#include "hashing.h"
+
+// Edits the diff looks for in the changed middle before it's replaced outright, bounds the diff to a few MB
+static const int32_t MaximumEdits = 1024;
+
+// A run of the edit script, inserted pairs are referenced wherever they live
+struct DeltaStep
+{
+	uint8_t Operation;
+	uint32_t Count;
+	const TranslationPair* Inserted;
+};
+
+// A database file opened for patching, with its pairs in the order deltas address them
+struct DeltaSource
+{
+	bool Legacy;
+	std::vector<TranslationPair> Pairs;
+	// Values of compressed images are decoded through the database
+	std::unique_ptr<TranslationDB> Database;
+
+	bool Open(const std::vector<uint8_t>& Data, uint32_t Threads)
+	{
+		this->Legacy = (Data.size() < sizeof(uint32_t) || *(const uint32_t*)Data.data() != TRANSLATIONDB_MAGIC);
+		this->Pairs.clear();
+
+		if (this->Legacy)
+			return ParseLegacyDatabase(Data.data(), Data.size(), this->Pairs, Threads);
+
+		std::vector<uint8_t> Image(Data);
+		this->Database.reset(new TranslationDB());
+
+		if (!this->Database->LoadImage(Image))
+			return false;
+
+		// Strings are laid out in key order, which is the order a build emits them in
+		auto& View = this->Database->GetView();
+		std::vector<const TranslationDBEntry*> Entries(View.EntryCount);
+
+		for (uint32_t i = 0; i < View.EntryCount; i++)
+			Entries[i] = &View.Entries[i];
+
+		std::sort(Entries.begin(), Entries.end(), [](const TranslationDBEntry* Lhs, const TranslationDBEntry* Rhs)
+		{
+			return Lhs->KeyOffset < Rhs->KeyOffset;
+		});
+
+		this->Pairs.reserve(View.EntryCount);
+		for (auto Entry : Entries)
+		{
+			TranslationPair Pair;
+			Pair.Key = this->Database->GetKey(Entry);
+			Pair.KeyLength = Entry->KeyLength;
+			Pair.Value = this->Database->GetValue(Entry);
+			Pair.ValueLength = this->Database->IsCompressed() ? (uint32_t)std::strlen(Pair.Value) : Entry->ValueLength;
+			this->Pairs.push_back(Pair);
+		}
+
+		return true;
+	}
+};
+
+static bool SetDeltaError(std::string* Error, const std::string& Message)
+{
+	if (Error != nullptr)
+		*Error = Message;
+
+	return false;
+}
+
+static bool PairsEqual(const TranslationPair& Lhs, const TranslationPair& Rhs)
+{
+	return (Lhs.KeyLength == Rhs.KeyLength && Lhs.ValueLength == Rhs.ValueLength && std::memcmp(Lhs.Key, Rhs.Key, Lhs.KeyLength) == 0 && std::memcmp(Lhs.Value, Rhs.Value, Lhs.ValueLength) == 0);
+}
+
+// Orders pairs by key keeping the last of every duplicate, the order a v2 build emits them in
+static std::vector<TranslationPair> SortUnique(const std::vector<TranslationPair>& Pairs)
+{
+	std::vector<TranslationPair> Sorted(Pairs);
+
+	std::stable_sort(Sorted.begin(), Sorted.end(), [](const TranslationPair& A, const TranslationPair& B)
+	{
+		auto Compare = std::memcmp(A.Key, B.Key, std::min(A.KeyLength, B.KeyLength));
+		return (Compare != 0) ? (Compare < 0) : (A.KeyLength < B.KeyLength);
+	});
+
+	std::vector<TranslationPair> Result;
+	Result.reserve(Sorted.size());
+
+	for (size_t i = 0; i < Sorted.size(); i++)
+	{
+		if (i + 1 < Sorted.size() && Sorted[i + 1].KeyLength == Sorted[i].KeyLength && std::memcmp(Sorted[i + 1].Key, Sorted[i].Key, Sorted[i].KeyLength) == 0)
+			continue;
+
+		Result.push_back(Sorted[i]);
+	}
+
+	return Result;
+}
+
+// Appends a step, merging it into the previous one when they're the same operation
+static void AddStep(std::vector<DeltaStep>& Steps, uint8_t Operation, uint32_t Count, const TranslationPair* Inserted)
+{
+	if (Count == 0)
+		return;
+
+	if (!Steps.empty() && Steps.back().Operation == Operation && (Operation != TRANSLATIONDELTA_INSERT || Steps.back().Inserted + Steps.back().Count == Inserted))
+	{
+		Steps.back().Count += Count;
+		return;
+	}
+
+	DeltaStep Step;
+	Step.Operation = Operation;
+	Step.Count = Count;
+	Step.Inserted = Inserted;
+	Steps.push_back(Step);
+}
+
+// Finds the shortest edit script from one pair sequence to another (Myers), past the common prefix and suffix
+static std::vector<DeltaStep> Diff(const std::vector<TranslationPair>& From, const std::vector<TranslationPair>& To)
+{
+	std::vector<DeltaStep> Steps;
+
+	size_t Prefix = 0;
+	while (Prefix < From.size() && Prefix < To.size() && PairsEqual(From[Prefix], To[Prefix]))
+		Prefix++;
+
+	size_t Suffix = 0;
+	while (Suffix < From.size() - Prefix && Suffix < To.size() - Prefix && PairsEqual(From[From.size() - 1 - Suffix], To[To.size() - 1 - Suffix]))
+		Suffix++;
+
+	auto A = From.data() + Prefix;
+	auto B = To.data() + Prefix;
+	auto N = (int32_t)(From.size() - Prefix - Suffix);
+	auto M = (int32_t)(To.size() - Prefix - Suffix);
+
+	AddStep(Steps, TRANSLATIONDELTA_COPY, (uint32_t)Prefix, nullptr);
+
+	// Furthest reaching x on every diagonal after every edit count, kept to walk the path back
+	auto Limit = std::min(N + M, MaximumEdits);
+	std::vector<int32_t> Furthest(2 * (size_t)Limit + 3, 0);
+	std::vector<std::vector<int32_t>> Trace;
+	int32_t Edits = -1;
+
+	for (int32_t D = 0; D <= Limit && Edits < 0; D++)
+	{
+		for (int32_t K = -D; K <= D; K += 2)
+		{
+			auto& Below = Furthest[Limit + 1 + K - 1];
+			auto& Above = Furthest[Limit + 1 + K + 1];
+
+			auto X = (K == -D || (K != D && Below < Above)) ? Above : Below + 1;
+			auto Y = X - K;
+
+			while (X < N && Y < M && PairsEqual(A[X], B[Y]))
+				X++, Y++;
+
+			Furthest[Limit + 1 + K] = X;
+
+			if (X >= N && Y >= M)
+			{
+				Edits = D;
+				break;
+			}
+		}
+
+		Trace.push_back(std::vector<int32_t>(Furthest.begin() + (Limit + 1 - D), Furthest.begin() + (Limit + 2 + D)));
+	}
+
+	if (Edits < 0)
+	{
+		// Too much changed, replace the middle
+		AddStep(Steps, TRANSLATIONDELTA_SKIP, (uint32_t)N, nullptr);
+		AddStep(Steps, TRANSLATIONDELTA_INSERT, (uint32_t)M, B);
+	}
+	else
+	{
+		// Walk back from the end, collecting the moves in reverse
+		std::vector<uint8_t> Moves;
+		auto X = N, Y = M;
+
+		for (int32_t D = Edits; D > 0; D--)
+		{
+			auto& Previous = Trace[D - 1];
+			auto K = X - Y;
+			auto Down = (K == -D || (K != D && Previous[(D - 1) + K - 1] < Previous[(D - 1) + K + 1]));
+			auto PreviousK = Down ? K + 1 : K - 1;
+			auto PreviousX = Previous[(D - 1) + PreviousK];
+			auto PreviousY = PreviousX - PreviousK;
+
+			while (X > PreviousX + (Down ? 0 : 1) && Y > PreviousY + (Down ? 1 : 0))
+			{
+				Moves.push_back(TRANSLATIONDELTA_COPY);
+				X--, Y--;
+			}
+
+			Moves.push_back(Down ? TRANSLATIONDELTA_INSERT : TRANSLATIONDELTA_SKIP);
+			X = PreviousX;
+			Y = PreviousY;
+		}
+
+		while (X > 0 && Y > 0)
+		{
+			Moves.push_back(TRANSLATIONDELTA_COPY);
+			X--, Y--;
+		}
+
+		int32_t Inserted = 0;
+		for (auto Move = Moves.rbegin(); Move != Moves.rend(); Move++)
+		{
+			AddStep(Steps, *Move, 1, (*Move == TRANSLATIONDELTA_INSERT) ? B + Inserted : nullptr);
+
+			if (*Move != TRANSLATIONDELTA_SKIP)
+				Inserted++;
+		}
+	}
+
+	AddStep(Steps, TRANSLATIONDELTA_COPY, (uint32_t)Suffix, nullptr);
+	return Steps;
+}
+
+// Builds pairs in the format of a source file, v2 images reuse the seeds of the source when the keys are the same
+static bool BuildLikeSource(const DeltaSource& Source, const std::vector<TranslationPair>& Pairs, std::vector<uint8_t>& Result, std::string* Error, uint32_t Threads)
+{
+	if (Source.Legacy)
+	{
+		BuildLegacyDatabase(Pairs, Result);
+		return true;
+	}
+
+	TranslationDBBuilder Builder;
+	Builder.Reserve((uint32_t)Pairs.size());
+	Builder.SetValueCompression(Source.Database->IsCompressed());
+	Builder.SetLayoutHint(&Source.Database->GetView());
+
+	for (auto& Pair : Pairs)
+		Builder.Add(Pair.Key, Pair.KeyLength, Pair.Value, Pair.ValueLength);
+
+	if (Source.Database->GetView().HashId == Hashing::HashWordMix)
+		return Builder.BuildWith<Hashing::WordMix>(Result, Error, Threads);
+
+	return Builder.BuildWith<Hashing::Fnv1a>(Result, Error, Threads);
+}
+
+// Runs an edit script over a source file, legacy files copy the kept runs of pairs as they are
+static bool BuildResult(const DeltaSource& Source, const std::vector<DeltaStep>& Steps, std::vector<uint8_t>& Result, std::string* Error, uint32_t Threads)
+{
+	auto& Pairs = Source.Pairs;
+	size_t Cursor = 0, PairCount = 0;
+
+	for (auto& Step : Steps)
+	{
+		if (Step.Operation != TRANSLATIONDELTA_INSERT && Step.Count > Pairs.size() - Cursor)
+			return SetDeltaError(Error, "The delta runs past the end of the base");
+
+		if (Step.Operation != TRANSLATIONDELTA_INSERT)
+			Cursor += Step.Count;
+		if (Step.Operation != TRANSLATIONDELTA_SKIP)
+			PairCount += Step.Count;
+	}
+
+	if (Cursor != Pairs.size())
+		return SetDeltaError(Error, "The delta doesn't cover the whole base");
+
+	if (!Source.Legacy)
+	{
+		std::vector<TranslationPair> Edited;
+		Edited.reserve(PairCount);
+		Cursor = 0;
+
+		for (auto& Step : Steps)
+		{
+			if (Step.Operation == TRANSLATIONDELTA_COPY)
+				Edited.insert(Edited.end(), Pairs.begin() + Cursor, Pairs.begin() + Cursor + Step.Count);
+			else if (Step.Operation == TRANSLATIONDELTA_INSERT)
+				Edited.insert(Edited.end(), Step.Inserted, Step.Inserted + Step.Count);
+
+			if (Step.Operation != TRANSLATIONDELTA_INSERT)
+				Cursor += Step.Count;
+		}
+
+		return BuildLikeSource(Source, Edited, Result, Error, Threads);
+	}
+
+	// Kept pairs are contiguous in the base, key through value terminator
+	auto GetRunSize = [&Pairs](size_t Start, size_t Count) -> size_t
+	{
+		auto& Last = Pairs[Start + Count - 1];
+		return (size_t)((Last.Value + Last.ValueLength + 1) - Pairs[Start].Key);
+	};
+
+	size_t Size = sizeof(uint32_t);
+	Cursor = 0;
+
+	for (auto& Step : Steps)
+	{
+		if (Step.Operation == TRANSLATIONDELTA_COPY)
+			Size += GetRunSize(Cursor, Step.Count);
+
+		for (uint32_t i = 0; Step.Operation == TRANSLATIONDELTA_INSERT && i < Step.Count; i++)
+			Size += (size_t)Step.Inserted[i].KeyLength + Step.Inserted[i].ValueLength + 2;
+
+		if (Step.Operation != TRANSLATIONDELTA_INSERT)
+			Cursor += Step.Count;
+	}
+
+	Result.assign(Size, 0);
+	*(uint32_t*)Result.data() = (uint32_t)PairCount;
+
+	auto Output = Result.data() + sizeof(uint32_t);
+	Cursor = 0;
+
+	for (auto& Step : Steps)
+	{
+		if (Step.Operation == TRANSLATIONDELTA_COPY)
+		{
+			auto RunSize = GetRunSize(Cursor, Step.Count);
+			std::memcpy(Output, Pairs[Cursor].Key, RunSize);
+			Output += RunSize;
+		}
+
+		// The buffer is zeroed, so the terminators are already there
+		for (uint32_t i = 0; Step.Operation == TRANSLATIONDELTA_INSERT && i < Step.Count; i++)
+		{
+			auto& Pair = Step.Inserted[i];
+
+			std::memcpy(Output, Pair.Key, Pair.KeyLength);
+			Output += Pair.KeyLength + 1;
+			std::memcpy(Output, Pair.Value, Pair.ValueLength);
+			Output += Pair.ValueLength + 1;
+		}
+
+		if (Step.Operation != TRANSLATIONDELTA_INSERT)
+			Cursor += Step.Count;
+	}
+
+	return true;
+}
+
+// Writes an unsigned LEB128 varint
+static void WriteVarint(std::vector<uint8_t>& Output, uint32_t Value)
+{
+	while (Value >= 0x80)
+	{
+		Output.push_back((uint8_t)(Value | 0x80));
+		Value >>= 7;
+	}
+
+	Output.push_back((uint8_t)Value);
+}
+
+// Reads an unsigned LEB128 varint, false if it runs past the end or over 32 bits
+static bool ReadVarint(const uint8_t*& Cursor, const uint8_t* End, uint32_t& Value)
+{
+	Value = 0;
+
+	for (uint32_t Shift = 0; Shift < 35; Shift += 7)
+	{
+		if (Cursor >= End)
+			return false;
+
+		auto Byte = *Cursor++;
+		Value |= (uint32_t)(Byte & 0x7F) << Shift;
+
+		if ((Byte & 0x80) == 0)
+			return true;
+	}
+
+	return false;
+}
+
+// Encodes an edit script after its header
+static void WriteDelta(const std::vector<uint8_t>& Base, const std::vector<uint8_t>& Result, const std::vector<DeltaStep>& Steps, std::vector<uint8_t>& Delta)
+{
+	std::vector<uint8_t> Operations;
+
+	for (auto& Step : Steps)
+	{
+		Operations.push_back(Step.Operation);
+		WriteVarint(Operations, Step.Count);
+
+		for (uint32_t i = 0; Step.Operation == TRANSLATIONDELTA_INSERT && i < Step.Count; i++)
+		{
+			auto& Pair = Step.Inserted[i];
+
+			WriteVarint(Operations, Pair.KeyLength);
+			WriteVarint(Operations, Pair.ValueLength);
+			Operations.insert(Operations.end(), (const uint8_t*)Pair.Key, (const uint8_t*)Pair.Key + Pair.KeyLength);
+			Operations.insert(Operations.end(), (const uint8_t*)Pair.Value, (const uint8_t*)Pair.Value + Pair.ValueLength);
+		}
+	}
+
+	TranslationDeltaHeader Header;
+	std::memset(&Header, 0, sizeof(Header));
+
+	Header.Magic = TRANSLATIONDELTA_MAGIC;
+	Header.Version = TRANSLATIONDELTA_VERSION;
+	Header.BaseSize = (uint32_t)Base.size();
+	Header.ResultSize = (uint32_t)Result.size();
+	Header.BaseHash = TranslationDelta::Checksum(Base.data(), Base.size());
+	Header.ResultHash = TranslationDelta::Checksum(Result.data(), Result.size());
+	Header.OperationsSize = (uint32_t)Operations.size();
+
+	Delta.resize(sizeof(Header) + Operations.size());
+	std::memcpy(Delta.data(), &Header, sizeof(Header));
+
+	if (!Operations.empty())
+		std::memcpy(Delta.data() + sizeof(Header), Operations.data(), Operations.size());
+}
+
+uint64_t TranslationDelta::Checksum(const uint8_t* Data, size_t Size)
+{
+	return Hashing::WordMix::Hash(Data, Size);
+}
+
+bool TranslationDelta::Create(const std::vector<uint8_t>& Base, const std::vector<uint8_t>& Result, std::vector<uint8_t>& Delta, std::string* Error)
+{
+	DeltaSource From, To;
+	if (!From.Open(Base, 1) || !To.Open(Result, 1))
+		return SetDeltaError(Error, "Not a database");
+	if (From.Legacy != To.Legacy)
+		return SetDeltaError(Error, "The base and result are in different formats");
+
+	WriteDelta(Base, Result, Diff(From.Pairs, To.Pairs), Delta);
+
+	// A result that isn't a full build of its pairs can't be reproduced
+	std::vector<uint8_t> Check;
+	if (!Apply(Base, Delta, Check, Error))
+		return false;
+	if (Check != Result)
+		return SetDeltaError(Error, "The result isn't a full build of its pairs");
+
+	return true;
+}
+
+bool TranslationDelta::Apply(const std::vector<uint8_t>& Base, const std::vector<uint8_t>& Delta, std::vector<uint8_t>& Result, std::string* Error, uint32_t Threads)
+{
+	if (Delta.size() < sizeof(TranslationDeltaHeader))
+		return SetDeltaError(Error, "Not a delta");
+
+	auto Header = (const TranslationDeltaHeader*)Delta.data();
+
+	if (Header->Magic != TRANSLATIONDELTA_MAGIC || Header->Version != TRANSLATIONDELTA_VERSION || Header->OperationsSize > Delta.size() - sizeof(TranslationDeltaHeader))
+		return SetDeltaError(Error, "Not a delta");
+	if (Header->BaseSize != Base.size() || Header->BaseHash != Checksum(Base.data(), Base.size()))
+		return SetDeltaError(Error, "The delta was made for a different base");
+
+	DeltaSource Source;
+	if (!Source.Open(Base, Threads))
+		return SetDeltaError(Error, "The base isn't a database");
+
+	// Decode the script, inserted pairs reference the delta
+	auto Cursor = Delta.data() + sizeof(TranslationDeltaHeader);
+	auto End = Cursor + Header->OperationsSize;
+
+	struct EncodedStep
+	{
+		uint8_t Operation;
+		uint32_t Count;
+		size_t FirstInserted;
+	};
+
+	std::vector<EncodedStep> Encoded;
+	std::vector<TranslationPair> Inserted;
+
+	while (Cursor < End)
+	{
+		EncodedStep Step;
+		Step.Operation = *Cursor++;
+		Step.FirstInserted = Inserted.size();
+
+		if (Step.Operation > TRANSLATIONDELTA_INSERT || !ReadVarint(Cursor, End, Step.Count))
+			return SetDeltaError(Error, "The delta is corrupt");
+
+		for (uint32_t i = 0; Step.Operation == TRANSLATIONDELTA_INSERT && i < Step.Count; i++)
+		{
+			TranslationPair Pair;
+			if (!ReadVarint(Cursor, End, Pair.KeyLength) || !ReadVarint(Cursor, End, Pair.ValueLength) || (uint64_t)Pair.KeyLength + Pair.ValueLength > (uint64_t)(End - Cursor))
+				return SetDeltaError(Error, "The delta is corrupt");
+
+			Pair.Key = (const char*)Cursor;
+			Pair.Value = (const char*)Cursor + Pair.KeyLength;
+			Cursor += Pair.KeyLength + Pair.ValueLength;
+			Inserted.push_back(Pair);
+		}
+
+		Encoded.push_back(Step);
+	}
+
+	std::vector<DeltaStep> Steps;
+	for (auto& Step : Encoded)
+		AddStep(Steps, Step.Operation, Step.Count, Inserted.data() + Step.FirstInserted);
+
+	if (!BuildResult(Source, Steps, Result, Error, Threads))
+		return false;
+
+	if (Result.size() != Header->ResultSize || Checksum(Result.data(), Result.size()) != Header->ResultHash)
+		return SetDeltaError(Error, "The patched database doesn't match the build the delta was made from");
+
+	return true;
+}
+
+bool TranslationDelta::Rebuild(const std::vector<uint8_t>& Previous, const std::vector<TranslationPair>& Pairs, std::vector<uint8_t>& Result, std::vector<uint8_t>* Delta, std::string* Error, uint32_t Threads)
+{
+	DeltaSource Source;
+	if (!Source.Open(Previous, Threads))
+		return SetDeltaError(Error, "The previous build isn't a database");
+
+	// v2 images hold every key once in key order, legacy files keep the pairs as they were written
+	std::vector<TranslationPair> Target;
+	if (!Source.Legacy)
+		Target = SortUnique(Pairs);
+
+	auto Steps = Diff(Source.Pairs, Source.Legacy ? Pairs : Target);
+
+	if (!BuildResult(Source, Steps, Result, Error, Threads))
+		return false;
+
+	if (Delta != nullptr)
+		WriteDelta(Previous, Result, Steps, *Delta);
+
+	return true;
+}
+
+bool TranslationDelta::BuildLike(const std::vector<uint8_t>& Reference, const std::vector<TranslationPair>& Pairs, std::vector<uint8_t>& Result, std::string* Error, uint32_t Threads)
+{
+	DeltaSource Source;
+	if (!Source.Open(Reference, Threads))
+		return SetDeltaError(Error, "Not a database");
+
+	// A full build, nothing is reused
+	if (Source.Legacy)
+	{
+		BuildLegacyDatabase(Pairs, Result);
+		return true;
+	}
+
+	TranslationDBBuilder Builder;
+	Builder.Reserve((uint32_t)Pairs.size());
+	Builder.SetValueCompression(Source.Database->IsCompressed());
+
+	for (auto& Pair : Pairs)
+		Builder.Add(Pair.Key, Pair.KeyLength, Pair.Value, Pair.ValueLength);
+
+	if (Source.Database->GetView().HashId == Hashing::HashWordMix)
+		return Builder.BuildWith<Hashing::WordMix>(Result, Error, Threads);
+
+	return Builder.BuildWith<Hashing::Fnv1a>(Result, Error, Threads);
+}
\ No newline at end of file
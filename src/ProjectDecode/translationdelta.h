@@ -0,0 +1,61 @@
+#pragma once
+
+// Standard includes
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Our includes
+#include "translationdb.h"
+
+//
+// Translation deltas, a compact edit script turning one database file into the next full build of it.
+//   TranslationDeltaHeader
+//   Operations, each an opcode byte followed by LEB128 varints:
+//     Copy <count>		the next pairs of the base are kept
+//     Skip <count>		the next pairs of the base are dropped
+//     Insert <count>	followed by <key length> <value length> <key> <value> for every inserted pair
+// Pairs are addressed in file order for legacy files (duplicates included) and in key order for v2 images.
+// The result is rebuilt in the base file's format, re-emitting only what changed, and must hash to the result hash,
+// so base + delta is byte for byte the full build it was made from.
+//
+
+// 'D3DL'
+#define TRANSLATIONDELTA_MAGIC 0x4C443344
+#define TRANSLATIONDELTA_VERSION 1
+
+// Delta opcodes
+#define TRANSLATIONDELTA_COPY 0
+#define TRANSLATIONDELTA_SKIP 1
+#define TRANSLATIONDELTA_INSERT 2
+
+struct TranslationDeltaHeader
+{
+	uint32_t Magic;
+	uint16_t Version;
+	uint16_t Reserved;
+	uint32_t BaseSize;
+	uint32_t ResultSize;
+	uint64_t BaseHash;		// TranslationDelta::Checksum of the whole file
+	uint64_t ResultHash;
+	uint32_t OperationsSize;	// Bytes of operations following the header
+	uint32_t Padding;
+};
+
+namespace TranslationDelta
+{
+	// Hashes a whole database file, identifies the base a delta applies to and the result it must produce
+	uint64_t Checksum(const uint8_t* Data, size_t Size);
+
+	// Creates the delta from a base file to a full build of the same format
+	bool Create(const std::vector<uint8_t>& Base, const std::vector<uint8_t>& Result, std::vector<uint8_t>& Delta, std::string* Error = nullptr);
+	// Applies a delta to the file it was created against, producing the full build it was created from
+	bool Apply(const std::vector<uint8_t>& Base, const std::vector<uint8_t>& Delta, std::vector<uint8_t>& Result, std::string* Error = nullptr, uint32_t Threads = 1);
+	// Rebuilds a file for a new set of pairs (in source order), re-emitting only what changed since the previous build.
+	// Produces the same file a full build in the previous file's format would, and optionally the delta between them
+	bool Rebuild(const std::vector<uint8_t>& Previous, const std::vector<TranslationPair>& Pairs, std::vector<uint8_t>& Result, std::vector<uint8_t>* Delta = nullptr, std::string* Error = nullptr, uint32_t Threads = 1);
+
+	// Builds a file from pairs (in source order) in the format of another one, legacy or v2 with the same hash and compression
+	bool BuildLike(const std::vector<uint8_t>& Reference, const std::vector<TranslationPair>& Pairs, std::vector<uint8_t>& Result, std::string* Error = nullptr, uint32_t Threads = 1);
+}
\ No newline at end of file
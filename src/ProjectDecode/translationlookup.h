@@ -0,0 +1,221 @@
+#pragma once
+
+// Standard includes
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+// Our includes
+#include "translationdb.h"
+#include "unicode.h"
+#include "bloomfilter.h"
+
+//
+// Read-only lookups over a loaded database, parameterized on the hash policy that built it.
+// Every lookup hashes the key once, probes one slot and compares once, nothing allocates or mutates.
+//
+
+template<typename Hasher = Hashing::Fnv1a>
+class TranslationLookup
+{
+private:
+	const TranslationDBView* View;
+
+	// Resolves the slot for a key hash, verifying everything but the key bytes
+	const TranslationDBEntry* ResolveEntry(uint64_t Hash, size_t KeyLength) const
+	{
+		if (this->View->EntryCount == 0)
+			return nullptr;
+
+		// Most keys the engine asks for aren't translated, reject them with a single cache line read
+		if (this->View->FilterBlocks != nullptr && !BloomFilter::MayContain(this->View->FilterBlocks, this->View->FilterBlockCount, Hash))
+			return nullptr;
+
+		auto Bucket = TranslationDBBucket(Hash, this->View->BucketCount);
+		auto Slot = TranslationDBSlot(Hash, this->View->Seeds[Bucket], this->View->EntryCount);
+
+		auto& Entry = this->View->Entries[Slot];
+
+		// Every key maps to some slot, verify it's actually ours
+		if (Entry.Hash != (uint32_t)Hash || Entry.KeyLength != KeyLength)
+			return nullptr;
+		if ((uint64_t)Entry.KeyOffset + Entry.KeyLength >= this->View->StringsSize || (uint64_t)Entry.ValueOffset + Entry.ValueLength >= this->View->StringsSize)
+			return nullptr;
+
+		// Values must be null-term for the engine
+		if (this->View->Strings[Entry.ValueOffset + Entry.ValueLength] != 0)
+			return nullptr;
+
+		return &Entry;
+	}
+
+public:
+	explicit TranslationLookup(const TranslationDBView& DatabaseView)
+		: View(&DatabaseView)
+	{
+	}
+
+	// Whether or not the database was built with this hash policy
+	bool IsCompatible() const
+	{
+		return this->View->HashId == Hasher::Id;
+	}
+
+	// Finds the entry for a utf8 key, nullptr if not translated
+	const TranslationDBEntry* FindEntry(std::string_view Key) const
+	{
+		auto Entry = this->ResolveEntry(Hasher::Hash(Key.data(), Key.size()), Key.size());
+
+		if (Entry == nullptr || std::memcmp(this->View->Strings + Entry->KeyOffset, Key.data(), Key.size()) != 0)
+			return nullptr;
+
+		return Entry;
+	}
+
+	// Finds the entry for a null-term engine reference, the @ modifier is stripped inline
+	const TranslationDBEntry* FindReference(const char* Reference) const
+	{
+		if (*Reference == '@')
+			Reference++;
+
+		// Block hashes are faster after a vectorized strlen
+		if constexpr (!Hasher::StreamsBytes)
+			return this->FindEntry(std::string_view(Reference));
+
+		// Measure the key as it's hashed
+		auto State = Hasher::Begin();
+		size_t KeyLength = 0;
+
+		while (Reference[KeyLength] != 0)
+			Hasher::Update(State, (uint8_t)Reference[KeyLength++]);
+
+		auto Entry = this->ResolveEntry(Hasher::Finish(State, KeyLength), KeyLength);
+
+		if (Entry == nullptr || std::memcmp(this->View->Strings + Entry->KeyOffset, Reference, KeyLength) != 0)
+			return nullptr;
+
+		return Entry;
+	}
+
+	// Finds the entry for a utf16 key, hashed and compared as utf8 without converting it
+	const TranslationDBEntry* FindEntry(const uint16_t* Key, size_t KeyLength) const
+	{
+		// Hash the utf8 form of the key as it's decoded
+		auto State = Hasher::Begin();
+		size_t Utf8Length = 0;
+
+		for (size_t i = 0; i < KeyLength;)
+		{
+			// Ascii units are their own utf8 form
+			if (Key[i] < 0x80)
+			{
+				Hasher::Update(State, (uint8_t)Key[i++]);
+				Utf8Length++;
+				continue;
+			}
+
+			uint8_t Encoded[4];
+			auto EncodedLength = Unicode::EncodeUtf8(Unicode::DecodeUtf16(Key, KeyLength, i), Encoded);
+
+			for (uint32_t c = 0; c < EncodedLength; c++)
+				Hasher::Update(State, Encoded[c]);
+
+			Utf8Length += EncodedLength;
+		}
+
+		auto Entry = this->ResolveEntry(Hasher::Finish(State, Utf8Length), Utf8Length);
+		if (Entry == nullptr)
+			return nullptr;
+
+		// Compare against the stored key the same way
+		auto Stored = (const uint8_t*)this->View->Strings + Entry->KeyOffset;
+
+		for (size_t i = 0; i < KeyLength;)
+		{
+			if (Key[i] < 0x80)
+			{
+				if (*Stored++ != Key[i++])
+					return nullptr;
+				continue;
+			}
+
+			uint8_t Encoded[4];
+			auto EncodedLength = Unicode::EncodeUtf8(Unicode::DecodeUtf16(Key, KeyLength, i), Encoded);
+
+			if (std::memcmp(Stored, Encoded, EncodedLength) != 0)
+				return nullptr;
+
+			Stored += EncodedLength;
+		}
+
+		return Entry;
+	}
+
+	// Finds the value for a utf8 key, nullptr if not translated
+	const char* Find(std::string_view Key) const
+	{
+		auto Entry = this->FindEntry(Key);
+		return (Entry != nullptr) ? this->GetValue(Entry) : nullptr;
+	}
+
+	// Gets the null-term utf8 key of an entry
+	const char* GetKey(const TranslationDBEntry* Entry) const
+	{
+		return this->View->Strings + Entry->KeyOffset;
+	}
+
+	// Gets the null-term utf8 value of an entry
+	const char* GetValue(const TranslationDBEntry* Entry) const
+	{
+		// Compressed values are decoded once, later calls return the same pointer
+		if (this->View->Decoded != nullptr)
+			return this->View->Decoded->GetValue((uint32_t)(Entry - this->View->Entries), (const uint8_t*)this->View->Strings + Entry->ValueOffset, Entry->ValueLength);
+
+		return this->View->Strings + Entry->ValueOffset;
+	}
+
+	// Gets the placeholder template of an entry, nullptr if its value has no placeholders
+	const PlaceholderTemplate* GetTemplate(const TranslationDBEntry* Entry) const
+	{
+		if (this->View->TemplateIndex == nullptr)
+			return nullptr;
+
+		auto Offset = this->View->TemplateIndex[Entry - this->View->Entries];
+		if ((Offset % sizeof(uint32_t)) != 0 || (uint64_t)Offset + sizeof(PlaceholderTemplate) > this->View->TemplatesSize)
+			return nullptr;
+
+		auto Template = (const PlaceholderTemplate*)(this->View->Templates + Offset);
+		if (Template->SegmentCount == 0 || (uint64_t)Offset + sizeof(PlaceholderTemplate) + ((uint64_t)Template->SegmentCount * sizeof(PlaceholderSegment)) > this->View->TemplatesSize)
+			return nullptr;
+
+		// Plain values have their length in the entry, decoded ones are measured
+		auto ValueLength = (this->View->Decoded != nullptr) ? std::strlen(this->GetValue(Entry)) : (size_t)Entry->ValueLength;
+		if (Template->ValueLength != ValueLength)
+			return nullptr;
+
+		auto Segments = (const PlaceholderSegment*)(Template + 1);
+		for (uint32_t i = 0; i < Template->SegmentCount; i++)
+		{
+			if ((uint64_t)Segments[i].Offset + Segments[i].Length > ValueLength || Segments[i].Slot > PLACEHOLDERS_MAX_SLOT)
+				return nullptr;
+		}
+
+		return Template;
+	}
+
+	// Gets the null-term utf16 value of an entry, nullptr if the value isn't valid utf8
+	const uint16_t* GetWideValue(const TranslationDBEntry* Entry, uint32_t& Length) const
+	{
+		if (this->View->Decoded != nullptr)
+			return this->View->Decoded->GetWideValue((uint32_t)(Entry - this->View->Entries), (const uint8_t*)this->View->Strings + Entry->ValueOffset, Entry->ValueLength, Length);
+
+		auto& WideEntry = this->View->WideEntries[Entry - this->View->Entries];
+
+		// Bounds check including the terminator
+		if (WideEntry.ValueLength == TRANSLATIONDB_WIDE_INVALID || (uint64_t)WideEntry.ValueOffset + WideEntry.ValueLength >= this->View->WideStringsSize)
+			return nullptr;
+
+		Length = WideEntry.ValueLength;
+		return this->View->WideStrings + WideEntry.ValueOffset;
+	}
+};
\ No newline at end of file
@@ -0,0 +1,333 @@
+// Platform includes
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <dirent.h>
+#endif
+
+// Standard includes
+#include <algorithm>
+#include <cstring>
+
+// The class we are implementing
+#include "translationstack.h"
+
+// Our includes
+#include "translationstore.h"
+
+// Layers are numbered in the owner index with 16 bits
+static const size_t MaximumLayers = 0xFFFF;
+// The value stored for every owner index key, only the key is used
+static const char OwnerValue[] = "";
+
+TranslationStack::TranslationStack()
+{
+	this->AddedKeys = 0;
+}
+
+TranslationStack::~TranslationStack()
+{
+}
+
+bool TranslationStack::Load(const std::string& BasePath, bool MapInPlace)
+{
+	auto Paths = FindLayerPaths(BasePath);
+	if (Paths.empty())
+		return false;
+
+	// A delta that doesn't apply is stale, the base it was made for was replaced, so the base is used as is
+	uint64_t DeltaStamp = 0;
+	auto DeltaPath = GetDeltaPath(BasePath);
+	auto HasDelta = GetFileStamp(DeltaPath, DeltaStamp);
+
+	for (auto& Path : Paths)
+	{
+		std::unique_ptr<TranslationDB> Layer(new TranslationDB());
+
+		auto Patched = (HasDelta && &Path == &Paths[0] && Layer->LoadPatched(Path, DeltaPath));
+
+		// A broken overlay fails the whole stack, half applied terminology is worse than the previous stack
+		if (!Patched && !Layer->Load(Path, MapInPlace))
+			return false;
+
+		this->AddLayer(std::move(Layer), Path);
+	}
+
+	return this->BuildIndex();
+}
+
+void TranslationStack::AddLayer(std::unique_ptr<TranslationDB> Layer, const std::string& Path)
+{
+	this->Layers.push_back(std::move(Layer));
+	this->LayerPaths.push_back(Path);
+}
+
+bool TranslationStack::BuildIndex()
+{
+	this->OwnerIndex.Unload();
+	this->OwnerLayers.clear();
+	this->AddedKeys = 0;
+
+	if (this->Layers.size() > MaximumLayers)
+		return false;
+	if (this->Layers.size() <= 1)
+		return true;
+
+	// Every overlay key, the keys are copied into the index image
+	TranslationDBBuilder Builder;
+
+	uint32_t OverlayEntries = 0;
+	for (size_t i = 1; i < this->Layers.size(); i++)
+		OverlayEntries += this->Layers[i]->GetEntryCount();
+
+	Builder.Reserve(OverlayEntries);
+
+	for (size_t i = 1; i < this->Layers.size(); i++)
+	{
+		auto& View = this->Layers[i]->GetView();
+
+		for (uint32_t e = 0; e < View.EntryCount; e++)
+			Builder.Add(this->Layers[i]->GetKey(&View.Entries[e]), View.Entries[e].KeyLength, OwnerValue, 0);
+	}
+
+	std::vector<uint8_t> Image;
+	if (!Builder.Build(Image) || !this->OwnerIndex.LoadImage(Image))
+		return false;
+
+	// The topmost layer holding a key owns it
+	auto& Index = this->OwnerIndex.GetView();
+	this->OwnerLayers.resize(Index.EntryCount);
+
+	for (uint32_t e = 0; e < Index.EntryCount; e++)
+	{
+		auto Key = this->OwnerIndex.GetKey(&Index.Entries[e]);
+		auto KeyLength = Index.Entries[e].KeyLength;
+
+		for (size_t i = this->Layers.size() - 1; i > 0; i--)
+		{
+			if (this->Layers[i]->FindEntry(Key, KeyLength) != nullptr)
+			{
+				this->OwnerLayers[e] = (uint16_t)i;
+				break;
+			}
+		}
+
+		if (this->Layers[0]->FindEntry(Key, KeyLength) == nullptr)
+			this->AddedKeys++;
+	}
+
+	return true;
+}
+
+const TranslationDB* TranslationStack::FindEntry(const char* Key, size_t KeyLength, const TranslationDBEntry*& Entry) const
+{
+	Entry = nullptr;
+	if (this->Layers.empty())
+		return nullptr;
+
+	// A single layer needs no index
+	auto Layer = (this->Layers.size() > 1) ? this->GetOwner(this->OwnerIndex.FindEntry(Key, KeyLength)) : this->Layers[0].get();
+
+	Entry = Layer->FindEntry(Key, KeyLength);
+	return (Entry != nullptr) ? Layer : nullptr;
+}
+
+const TranslationDB* TranslationStack::FindReferenceEntry(const char* Reference, const TranslationDBEntry*& Entry) const
+{
+	Entry = nullptr;
+	if (this->Layers.empty())
+		return nullptr;
+
+	auto Layer = (this->Layers.size() > 1) ? this->GetOwner(this->OwnerIndex.FindReferenceEntry(Reference)) : this->Layers[0].get();
+
+	Entry = Layer->FindReferenceEntry(Reference);
+	return (Entry != nullptr) ? Layer : nullptr;
+}
+
+const TranslationDB* TranslationStack::FindEntry(const uint16_t* Key, size_t KeyLength, const TranslationDBEntry*& Entry) const
+{
+	Entry = nullptr;
+	if (this->Layers.empty())
+		return nullptr;
+
+	auto Layer = (this->Layers.size() > 1) ? this->GetOwner(this->OwnerIndex.FindEntry(Key, KeyLength)) : this->Layers[0].get();
+
+	Entry = Layer->FindEntry(Key, KeyLength);
+	return (Entry != nullptr) ? Layer : nullptr;
+}
+
+const char* TranslationStack::Find(const char* Key, size_t KeyLength) const
+{
+	const TranslationDBEntry* Entry = nullptr;
+	auto Layer = this->FindEntry(Key, KeyLength, Entry);
+
+	return (Layer != nullptr) ? Layer->GetValue(Entry) : nullptr;
+}
+
+const char* TranslationStack::Find(const char* Key) const
+{
+	return this->Find(Key, std::strlen(Key));
+}
+
+const char* TranslationStack::FindReference(const char* Reference) const
+{
+	const TranslationDBEntry* Entry = nullptr;
+	auto Layer = this->FindReferenceEntry(Reference, Entry);
+
+	return (Layer != nullptr) ? Layer->GetValue(Entry) : nullptr;
+}
+
+uint32_t TranslationStack::GetLayerCount() const
+{
+	return (uint32_t)this->Layers.size();
+}
+
+const TranslationDB& TranslationStack::GetLayer(uint32_t Index) const
+{
+	return *this->Layers[Index];
+}
+
+const std::string& TranslationStack::GetLayerPath(uint32_t Index) const
+{
+	return this->LayerPaths[Index];
+}
+
+uint32_t TranslationStack::GetEntryCount() const
+{
+	return this->Layers.empty() ? 0 : this->Layers[0]->GetEntryCount() + this->AddedKeys;
+}
+
+uint32_t TranslationStack::GetOverlayKeyCount() const
+{
+	return this->OwnerIndex.GetEntryCount();
+}
+
+size_t TranslationStack::GetIndexSize() const
+{
+	return this->OwnerIndex.GetImageSize() + (this->OwnerLayers.size() * sizeof(uint16_t));
+}
+
+// Splits a path into its directory (with the trailing separator) and file name
+static void SplitPath(const std::string& Path, std::string& Directory, std::string& FileName)
+{
+	auto Separator = Path.find_last_of("/\\");
+
+	Directory = (Separator != std::string::npos) ? Path.substr(0, Separator + 1) : std::string();
+	FileName = (Separator != std::string::npos) ? Path.substr(Separator + 1) : Path;
+}
+
+// Lists the file names in a directory
+static std::vector<std::string> ListDirectory(const std::string& Directory)
+{
+	std::vector<std::string> Result;
+
+#ifdef _WIN32
+	WIN32_FIND_DATAA FindData;
+	auto Handle = FindFirstFileA((Directory.empty() ? std::string(".\\*") : Directory + "*").c_str(), &FindData);
+	if (Handle == INVALID_HANDLE_VALUE)
+		return Result;
+
+	do
+	{
+		if ((FindData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == 0)
+			Result.push_back(FindData.cFileName);
+	} while (FindNextFileA(Handle, &FindData));
+
+	FindClose(Handle);
+#else
+	auto Handle = opendir(Directory.empty() ? "." : Directory.c_str());
+	if (Handle == nullptr)
+		return Result;
+
+	while (auto Entry = readdir(Handle))
+		Result.push_back(Entry->d_name);
+
+	closedir(Handle);
+#endif
+
+	return Result;
+}
+
+// Whether or not a file name has the text at an offset, without regard to case on Windows, as the file system compares them
+static bool HasNameAt(const std::string& Name, size_t Offset, const std::string& Text)
+{
+	if (Offset > Name.size() || Name.size() - Offset < Text.size())
+		return false;
+
+#ifdef _WIN32
+	return (_strnicmp(Name.c_str() + Offset, Text.c_str(), Text.size()) == 0);
+#else
+	return (Name.compare(Offset, Text.size(), Text) == 0);
+#endif
+}
+
+std::vector<std::string> TranslationStack::FindLayerPaths(const std::string& BasePath)
+{
+	std::vector<std::string> Result;
+
+	uint64_t Stamp = 0;
+	if (!GetFileStamp(BasePath, Stamp))
+		return Result;
+
+	Result.push_back(BasePath);
+
+	// Overlays are <name>.<anything>.db, next to <name>.db
+	std::string Directory, FileName;
+	SplitPath(BasePath, Directory, FileName);
+
+	static const std::string Extension = ".db";
+	if (FileName.size() <= Extension.size() || !HasNameAt(FileName, FileName.size() - Extension.size(), Extension))
+		return Result;
+
+	auto Prefix = FileName.substr(0, FileName.size() - Extension.size()) + ".";
+	std::vector<std::string> Overlays;
+
+	for (auto& Name : ListDirectory(Directory))
+	{
+		if (Name.size() > Prefix.size() + Extension.size() && HasNameAt(Name, 0, Prefix) && HasNameAt(Name, Name.size() - Extension.size(), Extension))
+			Overlays.push_back(Name);
+	}
+
+	// Ordinal order, so the stack is the same on every machine
+	std::sort(Overlays.begin(), Overlays.end());
+
+	for (auto& Name : Overlays)
+		Result.push_back(Directory + Name);
+
+	return Result;
+}
+
+std::string TranslationStack::GetDeltaPath(const std::string& BasePath)
+{
+	static const std::string Extension = ".db";
+
+	if (BasePath.size() > Extension.size() && BasePath.compare(BasePath.size() - Extension.size(), Extension.size(), Extension) == 0)
+		return BasePath.substr(0, BasePath.size() - Extension.size()) + ".delta";
+
+	return BasePath + ".delta";
+}
+
+bool TranslationStack::GetStamp(const std::string& BasePath, uint64_t& Stamp)
+{
+	auto Paths = FindLayerPaths(BasePath);
+	if (Paths.empty())
+		return false;
+
+	// Fold every file's stamp together with its name, so added and removed overlays count as changes
+	Stamp = Paths.size();
+
+	for (auto& Path : Paths)
+	{
+		uint64_t FileStamp = 0;
+		GetFileStamp(Path, FileStamp);
+
+		Stamp = Hashing::Mix64(Stamp ^ FileStamp ^ Hashing::Fnv1a::Hash(Path.data(), Path.size()));
+	}
+
+	// The delta changes the base, a missing one stamps as zero
+	uint64_t DeltaStamp = 0;
+	GetFileStamp(GetDeltaPath(BasePath), DeltaStamp);
+
+	Stamp = Hashing::Mix64(Stamp ^ DeltaStamp);
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,89 @@
+#pragma once
+
+// Standard includes
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Our includes
+#include "translationdb.h"
+
+//
+// An ordered stack of databases, a base pack with overlays on top (TranslationsDB.db, then TranslationsDB.*.db by name).
+// Layers are queried in place, nothing is merged. An owner index holding only the overlay keys maps every
+// overridden key to the topmost layer that has it, so a lookup is one index probe plus one layer probe no matter
+// how many layers there are, and the index grows with the overlays, never with the base.
+//
+
+class TranslationStack
+{
+private:
+	// Base first, later layers win
+	std::vector<std::unique_ptr<TranslationDB>> Layers;
+	std::vector<std::string> LayerPaths;
+
+	// Every overlay key, with the layer that owns it by owner index entry
+	TranslationDB OwnerIndex;
+	std::vector<uint16_t> OwnerLayers;
+	// Keys no layer below the overlays has
+	uint32_t AddedKeys;
+
+	// Gets the layer a key resolves to, from its owner index entry
+	const TranslationDB* GetOwner(const TranslationDBEntry* OwnerEntry) const
+	{
+		if (OwnerEntry == nullptr)
+			return this->Layers[0].get();
+
+		return this->Layers[this->OwnerLayers[OwnerEntry - this->OwnerIndex.GetView().Entries]].get();
+	}
+
+public:
+	TranslationStack();
+	~TranslationStack();
+
+	TranslationStack(const TranslationStack&) = delete;
+	TranslationStack& operator=(const TranslationStack&) = delete;
+
+	// Loads the base database and every overlay next to it, read into memory instead of mapped when the files must stay writable.
+	// A delta next to the base (<name>.delta) is applied to it, the plain base is loaded when the delta doesn't apply
+	bool Load(const std::string& BasePath, bool MapInPlace = true);
+	// Adds a loaded layer on top of the others, BuildIndex must be called once every layer is added
+	void AddLayer(std::unique_ptr<TranslationDB> Layer, const std::string& Path = std::string());
+	// Builds the owner index over the overlays
+	bool BuildIndex();
+
+	// Finds the entry for a utf8 key, returns the layer that owns it or nullptr if not translated
+	const TranslationDB* FindEntry(const char* Key, size_t KeyLength, const TranslationDBEntry*& Entry) const;
+	// Finds the entry for a null-term engine reference (optionally prefixed with @), returns the owning layer or nullptr if not translated
+	const TranslationDB* FindReferenceEntry(const char* Reference, const TranslationDBEntry*& Entry) const;
+	// Finds the entry for a utf16 key, returns the owning layer or nullptr if not translated
+	const TranslationDB* FindEntry(const uint16_t* Key, size_t KeyLength, const TranslationDBEntry*& Entry) const;
+
+	// Finds the value for a key, nullptr if not translated
+	const char* Find(const char* Key, size_t KeyLength) const;
+	// Finds the value for a null-term key, nullptr if not translated
+	const char* Find(const char* Key) const;
+	// Finds the value for a null-term engine reference (optionally prefixed with @), nullptr if not translated
+	const char* FindReference(const char* Reference) const;
+
+	// Gets the amount of layers, the base included
+	uint32_t GetLayerCount() const;
+	// Gets a layer, zero is the base
+	const TranslationDB& GetLayer(uint32_t Index) const;
+	// Gets the path a layer was loaded from
+	const std::string& GetLayerPath(uint32_t Index) const;
+	// Gets the amount of distinct keys across every layer
+	uint32_t GetEntryCount() const;
+	// Gets the amount of keys held by the owner index
+	uint32_t GetOverlayKeyCount() const;
+	// Gets the memory used by the owner index in bytes
+	size_t GetIndexSize() const;
+
+	// Gets the paths of a stack, the base first then its overlays ordered by name, empty if there is no base
+	static std::vector<std::string> FindLayerPaths(const std::string& BasePath);
+	// Gets the path of the delta applied to a base, <name>.delta next to <name>.db
+	static std::string GetDeltaPath(const std::string& BasePath);
+	// Gets a stamp covering every file of a stack and the base's delta, changes when any of them changes, appears or disappears
+	static bool GetStamp(const std::string& BasePath, uint64_t& Stamp);
+};
\ No newline at end of file
@@ -0,0 +1,136 @@
+// Platform includes
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <sys/stat.h>
+#endif
+
+// The class we are implementing
+#include "translationstore.h"
+
+// Published while nothing is loaded, so readers never check for nullptr
+static const TranslationStack EmptyStack;
+
+TranslationStore::TranslationStore()
+{
+	this->Current.store(&EmptyStack, std::memory_order_relaxed);
+	this->StopRequested.store(false, std::memory_order_relaxed);
+	this->Generation.store(0, std::memory_order_relaxed);
+}
+
+TranslationStore::~TranslationStore()
+{
+	this->StopWatching(false);
+}
+
+uint32_t TranslationStore::GetGeneration() const
+{
+	return this->Generation.load(std::memory_order_acquire);
+}
+
+void TranslationStore::Publish(std::unique_ptr<TranslationStack> Stack)
+{
+	std::lock_guard<std::mutex> Lock(this->WriterLock);
+
+	// Swap first, then retire, readers may still be inside the old one
+	this->Current.store(Stack.get(), std::memory_order_release);
+
+	if (this->CurrentOwner != nullptr)
+		this->Retired.push_back(std::make_pair(std::move(this->CurrentOwner), std::chrono::steady_clock::now()));
+
+	this->CurrentOwner = std::move(Stack);
+	this->Generation.fetch_add(1, std::memory_order_release);
+}
+
+void TranslationStore::Reclaim(uint32_t GraceMilliseconds)
+{
+	std::lock_guard<std::mutex> Lock(this->WriterLock);
+
+	auto Now = std::chrono::steady_clock::now();
+	auto Grace = std::chrono::milliseconds(GraceMilliseconds);
+
+	// Retired in order, so everything expired is at the front
+	size_t Expired = 0;
+	while (Expired < this->Retired.size() && (Now - this->Retired[Expired].second) >= Grace)
+		Expired++;
+
+	this->Retired.erase(this->Retired.begin(), this->Retired.begin() + Expired);
+}
+
+bool TranslationStore::StartWatching(const std::string& BasePath, uint32_t PollMilliseconds, uint32_t GraceMilliseconds)
+{
+	if (this->Watcher.joinable())
+		return false;
+
+	this->StopRequested.store(false, std::memory_order_relaxed);
+	this->Watcher = std::thread(&TranslationStore::WatchLoop, this, BasePath, PollMilliseconds, GraceMilliseconds);
+
+	return true;
+}
+
+void TranslationStore::StopWatching(bool Wait)
+{
+	if (!this->Watcher.joinable())
+		return;
+
+	this->StopRequested.store(true, std::memory_order_relaxed);
+
+	if (Wait)
+		this->Watcher.join();
+	else
+		this->Watcher.detach();
+}
+
+void TranslationStore::WatchLoop(std::string BasePath, uint32_t PollMilliseconds, uint32_t GraceMilliseconds)
+{
+	// Whatever is on disk right now is what was loaded initially
+	uint64_t LoadedStamp = 0, PendingStamp = 0;
+	TranslationStack::GetStamp(BasePath, LoadedStamp);
+	PendingStamp = LoadedStamp;
+
+	while (!this->StopRequested.load(std::memory_order_relaxed))
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(PollMilliseconds));
+
+		uint64_t Stamp = 0;
+		if (TranslationStack::GetStamp(BasePath, Stamp) && Stamp != LoadedStamp)
+		{
+			// Only reload once the files stopped changing for a full poll, so we don't read a partial write
+			if (Stamp == PendingStamp)
+			{
+				// Copied instead of mapped so the files stay writable for the next edit
+				std::unique_ptr<TranslationStack> Stack(new TranslationStack());
+				if (Stack->Load(BasePath, false))
+					this->Publish(std::move(Stack));
+
+				// A broken stack is retried on its next change, not every poll
+				LoadedStamp = Stamp;
+			}
+
+			PendingStamp = Stamp;
+		}
+
+		this->Reclaim(GraceMilliseconds);
+	}
+}
+
+bool GetFileStamp(const std::string& Path, uint64_t& Stamp)
+{
+#ifdef _WIN32
+	WIN32_FILE_ATTRIBUTE_DATA FileAttrs;
+	if (!GetFileAttributesExA(Path.c_str(), GetFileExInfoStandard, &FileAttrs))
+		return false;
+
+	auto Modified = ((uint64_t)FileAttrs.ftLastWriteTime.dwHighDateTime << 32) | FileAttrs.ftLastWriteTime.dwLowDateTime;
+	Stamp = Modified ^ (((uint64_t)FileAttrs.nFileSizeHigh << 32) | FileAttrs.nFileSizeLow) * 0x9E3779B97F4A7C15ull;
+#else
+	struct stat FileInfo;
+	if (stat(Path.c_str(), &FileInfo) != 0)
+		return false;
+
+	auto Modified = ((uint64_t)FileInfo.st_mtim.tv_sec * 1000000000ull) + (uint64_t)FileInfo.st_mtim.tv_nsec;
+	Stamp = Modified ^ ((uint64_t)FileInfo.st_size * 0x9E3779B97F4A7C15ull);
+#endif
+
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,68 @@
+#pragma once
+
+// Standard includes
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Our includes
+#include "translationstack.h"
+
+//
+// Publishes immutable database stacks to the hooks with an atomic pointer swap, readers never lock.
+// Values handed to the engine escape any read-side critical section, so replaced stacks are
+// retired and only freed once a fixed grace period has passed since they stopped being current.
+//
+
+class TranslationStore
+{
+private:
+	std::atomic<const TranslationStack*> Current;
+
+	// Writer side state, guarded by WriterLock
+	std::mutex WriterLock;
+	std::unique_ptr<TranslationStack> CurrentOwner;
+	std::vector<std::pair<std::unique_ptr<TranslationStack>, std::chrono::steady_clock::time_point>> Retired;
+
+	// Watcher state
+	std::thread Watcher;
+	std::atomic<bool> StopRequested;
+	std::atomic<uint32_t> Generation;
+
+	// The polling loop for the watched stack
+	void WatchLoop(std::string BasePath, uint32_t PollMilliseconds, uint32_t GraceMilliseconds);
+
+public:
+	TranslationStore();
+	~TranslationStore();
+
+	TranslationStore(const TranslationStore&) = delete;
+	TranslationStore& operator=(const TranslationStore&) = delete;
+
+	// Gets the current stack, never nullptr, valid for at least the grace period after a swap
+	const TranslationStack* Acquire() const
+	{
+		return this->Current.load(std::memory_order_acquire);
+	}
+
+	// Gets the amount of stacks published so far, a changed value means Acquire returns the newer stack
+	uint32_t GetGeneration() const;
+
+	// Makes the stack current, retiring the previous one
+	void Publish(std::unique_ptr<TranslationStack> Stack);
+	// Frees retired stacks older than the grace period
+	void Reclaim(uint32_t GraceMilliseconds);
+
+	// Starts polling the base file and its overlays for changes on a background thread, reloading the stack when any changes
+	bool StartWatching(const std::string& BasePath, uint32_t PollMilliseconds, uint32_t GraceMilliseconds);
+	// Stops the watcher, when not waiting the thread is detached (required under the loader lock)
+	void StopWatching(bool Wait);
+};
+
+// Gets a stamp (modified time and size) for a file, false if it doesn't exist
+bool GetFileStamp(const std::string& Path, uint64_t& Stamp);
\ No newline at end of file
@@ -0,0 +1,672 @@
+// Platform includes
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#include <immintrin.h>
+#define UNICODE_SIMD 1
+#else
+#define UNICODE_SIMD 0
+#endif
+
+// The class we are implementing
+#include "unicode.h"
+
+// Our includes
+#include "cpufeatures.h"
+
+// Lets a function use instructions past the build's baseline, it's only called once they're detected
+#if defined(_MSC_VER) || !UNICODE_SIMD
+#define UNICODE_TARGET(Target)
+#else
+#define UNICODE_TARGET(Target) __attribute__((target(Target)))
+#endif
+
+// Units converted per call when only measuring
+static const size_t MeasureChunkSize = 256;
+
+bool Unicode::DecodeUtf8(const uint8_t* Data, size_t Length, size_t& Position, uint32_t& CodePoint)
+{
+	uint32_t Lead = Data[Position];
+
+	// Single byte
+	if (Lead < 0x80)
+	{
+		CodePoint = Lead;
+		Position++;
+		return true;
+	}
+
+	// Determine the sequence length and the minimum value it may encode
+	uint32_t Extra = 0, Minimum = 0;
+	if ((Lead & 0xE0) == 0xC0) { Extra = 1; Minimum = 0x80; CodePoint = Lead & 0x1F; }
+	else if ((Lead & 0xF0) == 0xE0) { Extra = 2; Minimum = 0x800; CodePoint = Lead & 0x0F; }
+	else if ((Lead & 0xF8) == 0xF0) { Extra = 3; Minimum = 0x10000; CodePoint = Lead & 0x07; }
+	else return false;
+
+	// Must have every continuation byte
+	if (Length - Position <= Extra)
+		return false;
+
+	for (uint32_t i = 1; i <= Extra; i++)
+	{
+		uint32_t Continuation = Data[Position + i];
+		if ((Continuation & 0xC0) != 0x80)
+			return false;
+
+		CodePoint = (CodePoint << 6) | (Continuation & 0x3F);
+	}
+
+	// Reject overlong forms, surrogates and out of range values
+	if (CodePoint < Minimum || CodePoint > 0x10FFFF || (CodePoint >= 0xD800 && CodePoint <= 0xDFFF))
+		return false;
+
+	Position += Extra + 1;
+	return true;
+}
+
+#if UNICODE_SIMD
+
+//
+// Vector blocks, each converts a whole block or nothing. Pure ascii and pure 3 byte (cjk) runs take the
+// widest blocks, mixed text goes through shuffle tables built once. Anything else (4 byte sequences,
+// surrogate pairs, malformed input) is left to the scalar loop, which hands back after one code point.
+//
+
+// The shuffles for mixed blocks
+struct TranscodeTables
+{
+	// How a 12 byte utf8 window is cut, by the mask of bytes that end a code point
+	struct Utf8Window
+	{
+		uint8_t Consumed;		// Bytes taken, 0 when the window can't be taken
+		uint8_t Units;			// Code points, 6 of 1-2 bytes into 16 bit lanes or 4 of 1-3 bytes into 32 bit lanes
+		uint8_t Shuffle;
+	};
+
+	Utf8Window Utf8Windows[4096];
+	uint8_t Utf8Shuffles[64 + 81][16];
+
+	// How 4 utf16 units, expanded to 4 byte lanes, are packed, by their lengths (bit k over 1 byte, bit 4+k over 2)
+	uint8_t Utf16Shuffles[256][16];
+	uint8_t Utf16Lengths[256];
+
+	TranscodeTables()
+	{
+		for (uint32_t Ends = 0; Ends < 4096; Ends++)
+		{
+			uint32_t Lengths[12], Count = 0, Start = 0;
+			for (uint32_t i = 0; i < 12; i++)
+			{
+				if ((Ends & (1u << i)) != 0)
+				{
+					Lengths[Count++] = i - Start + 1;
+					Start = i + 1;
+				}
+			}
+
+			auto& Window = this->Utf8Windows[Ends];
+			Window.Consumed = 0;
+			Window.Units = 0;
+			Window.Shuffle = 0;
+
+			uint32_t Short = 0, Medium = 0;
+			while (Short < Count && Short < 6 && Lengths[Short] <= 2)
+				Short++;
+			while (Medium < Count && Medium < 4 && Lengths[Medium] <= 3)
+				Medium++;
+
+			if (Short == 6)
+			{
+				// Each lane holds the last byte then the lead, the lead is 0 for ascii
+				uint32_t Index = 0, Offset = 0;
+				for (uint32_t k = 0; k < 6; k++)
+				{
+					Index |= (Lengths[k] - 1) << k;
+					Offset += Lengths[k];
+				}
+
+				auto Shuffle = this->Utf8Shuffles[Index];
+				for (uint32_t i = 0; i < 16; i++)
+					Shuffle[i] = 0x80;
+
+				for (uint32_t k = 0, Position = 0; k < 6; Position += Lengths[k++])
+				{
+					Shuffle[k * 2] = (uint8_t)(Position + Lengths[k] - 1);
+					if (Lengths[k] == 2)
+						Shuffle[k * 2 + 1] = (uint8_t)Position;
+				}
+
+				Window.Consumed = (uint8_t)Offset;
+				Window.Units = 6;
+				Window.Shuffle = (uint8_t)Index;
+			}
+			else if (Medium == 4)
+			{
+				// Each lane holds the last byte first, the lead last
+				uint32_t Index = 0, Offset = 0;
+				for (uint32_t k = 4; k-- > 0;)
+				{
+					Index = Index * 3 + (Lengths[k] - 1);
+					Offset += Lengths[k];
+				}
+
+				auto Shuffle = this->Utf8Shuffles[64 + Index];
+				for (uint32_t i = 0; i < 16; i++)
+					Shuffle[i] = 0x80;
+
+				for (uint32_t k = 0, Position = 0; k < 4; Position += Lengths[k++])
+				{
+					for (uint32_t b = 0; b < Lengths[k]; b++)
+						Shuffle[k * 4 + b] = (uint8_t)(Position + Lengths[k] - 1 - b);
+				}
+
+				Window.Consumed = (uint8_t)Offset;
+				Window.Units = 4;
+				Window.Shuffle = (uint8_t)(64 + Index);
+			}
+		}
+
+		for (uint32_t Key = 0; Key < 256; Key++)
+		{
+			auto Shuffle = this->Utf16Shuffles[Key];
+			uint32_t Length = 0;
+
+			for (uint32_t i = 0; i < 16; i++)
+				Shuffle[i] = 0x80;
+
+			for (uint32_t k = 0; k < 4; k++)
+			{
+				auto Bytes = 1 + ((Key >> k) & 1) + ((Key >> (4 + k)) & 1);
+				for (uint32_t b = 0; b < Bytes; b++)
+					Shuffle[Length++] = (uint8_t)(k * 4 + b);
+			}
+
+			this->Utf16Lengths[Key] = (uint8_t)Length;
+		}
+	}
+};
+
+// Built on first use
+static const TranscodeTables& GetTables()
+{
+	static const TranscodeTables Tables;
+	return Tables;
+}
+
+// Takes bits 0, 2, 4 and 6 of a byte mask, one per 16 bit lane
+static uint32_t CompactLaneMask(uint32_t Mask)
+{
+	Mask &= 0x55;
+	Mask = (Mask | (Mask >> 1)) & 0x33;
+	return (Mask | (Mask >> 2)) & 0x0F;
+}
+
+// 16 ascii bytes to 16 units
+static bool Utf8AsciiBlock(const uint8_t* Data, size_t Length, size_t& Position, uint16_t* Result, size_t ResultSize, size_t& Written)
+{
+	if (Length - Position < 16 || ResultSize - Written < 16)
+		return false;
+
+	auto Block = _mm_loadu_si128((const __m128i*)(Data + Position));
+	if (_mm_movemask_epi8(Block) != 0)
+		return false;
+
+	auto Zero = _mm_setzero_si128();
+	_mm_storeu_si128((__m128i*)(Result + Written), _mm_unpacklo_epi8(Block, Zero));
+	_mm_storeu_si128((__m128i*)(Result + Written + 8), _mm_unpackhi_epi8(Block, Zero));
+
+	Position += 16;
+	Written += 16;
+	return true;
+}
+
+// A 12 byte window of 1-3 byte sequences to 6 or 4 units
+UNICODE_TARGET("ssse3")
+static bool Utf8MixedBlock(const TranscodeTables& Tables, const uint8_t* Data, size_t Length, size_t& Position, uint16_t* Result, size_t ResultSize, size_t& Written)
+{
+	// The 6 unit store runs 2 units past them
+	if (Length - Position < 16 || ResultSize - Written < 8)
+		return false;
+
+	auto Block = _mm_loadu_si128((const __m128i*)(Data + Position));
+
+	// A code point ends where the next byte isn't a continuation (10xxxxxx)
+	auto Continuations = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(Block, _mm_set1_epi8((char)0xC0)), _mm_set1_epi8((char)0x80)));
+	auto& Window = Tables.Utf8Windows[(~Continuations >> 1) & 0xFFF];
+
+	if (Window.Consumed == 0)
+		return false;
+
+	auto Lanes = _mm_shuffle_epi8(Block, _mm_loadu_si128((const __m128i*)Tables.Utf8Shuffles[Window.Shuffle]));
+
+	if (Window.Units == 6)
+	{
+		// Ascii, or a 110xxxxx lead that isn't overlong (C0, C1)
+		auto Ascii = _mm_cmpeq_epi16(_mm_and_si128(Lanes, _mm_set1_epi16((short)0xFF80)), _mm_setzero_si128());
+		auto Pair = _mm_andnot_si128(_mm_cmpeq_epi16(_mm_and_si128(Lanes, _mm_set1_epi16(0x1E00)), _mm_setzero_si128()),
+			_mm_cmpeq_epi16(_mm_and_si128(Lanes, _mm_set1_epi16((short)0xE000)), _mm_set1_epi16((short)0xC000)));
+
+		if ((_mm_movemask_epi8(_mm_or_si128(Ascii, Pair)) & 0xFFF) != 0xFFF)
+			return false;
+
+		auto Decoded = _mm_or_si128(_mm_srli_epi16(_mm_and_si128(Lanes, _mm_set1_epi16(0x1F00)), 2), _mm_and_si128(Lanes, _mm_set1_epi16(0x3F)));
+		_mm_storeu_si128((__m128i*)(Result + Written), _mm_or_si128(_mm_and_si128(Ascii, Lanes), _mm_andnot_si128(Ascii, Decoded)));
+	}
+	else
+	{
+		// Lanes are under 2^24, signed compares are fine
+		auto One = _mm_cmplt_epi32(Lanes, _mm_set1_epi32(0x80));
+		auto Two = _mm_cmpeq_epi32(_mm_and_si128(Lanes, _mm_set1_epi32(0xFFE000)), _mm_set1_epi32(0xC000));
+		auto Three = _mm_cmpeq_epi32(_mm_and_si128(Lanes, _mm_set1_epi32(0xF00000)), _mm_set1_epi32(0xE00000));
+
+		auto Low = _mm_and_si128(Lanes, _mm_set1_epi32(0x3F));
+		auto PairPoint = _mm_or_si128(Low, _mm_and_si128(_mm_srli_epi32(Lanes, 2), _mm_set1_epi32(0x7C0)));
+		auto TriplePoint = _mm_or_si128(_mm_or_si128(Low, _mm_and_si128(_mm_srli_epi32(Lanes, 2), _mm_set1_epi32(0xFC0))), _mm_and_si128(_mm_srli_epi32(Lanes, 4), _mm_set1_epi32(0xF000)));
+
+		// Overlong pairs, overlong triples and surrogates
+		auto PairValid = _mm_andnot_si128(_mm_cmplt_epi32(PairPoint, _mm_set1_epi32(0x80)), Two);
+		auto TripleValid = _mm_andnot_si128(_mm_or_si128(_mm_cmplt_epi32(TriplePoint, _mm_set1_epi32(0x800)),
+			_mm_cmpeq_epi32(_mm_and_si128(TriplePoint, _mm_set1_epi32(0xF800)), _mm_set1_epi32(0xD800))), Three);
+
+		if (_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(One, PairValid), TripleValid)) != 0xFFFF)
+			return false;
+
+		auto CodePoints = _mm_or_si128(_mm_or_si128(_mm_and_si128(One, Lanes), _mm_and_si128(Two, PairPoint)), _mm_and_si128(Three, TriplePoint));
+		_mm_storel_epi64((__m128i*)(Result + Written), _mm_shuffle_epi8(CodePoints, _mm_setr_epi8(0, 1, 4, 5, 8, 9, 12, 13, -1, -1, -1, -1, -1, -1, -1, -1)));
+	}
+
+	Position += Window.Consumed;
+	Written += Window.Units;
+	return true;
+}
+
+// 32 ascii bytes to 32 units
+UNICODE_TARGET("avx2")
+static bool Utf8AsciiBlockAvx2(const uint8_t* Data, size_t Length, size_t& Position, uint16_t* Result, size_t ResultSize, size_t& Written)
+{
+	if (Length - Position < 32 || ResultSize - Written < 32)
+		return false;
+
+	auto Block = _mm256_loadu_si256((const __m256i*)(Data + Position));
+	if (_mm256_movemask_epi8(Block) != 0)
+		return false;
+
+	_mm256_storeu_si256((__m256i*)(Result + Written), _mm256_cvtepu8_epi16(_mm256_castsi256_si128(Block)));
+	_mm256_storeu_si256((__m256i*)(Result + Written + 16), _mm256_cvtepu8_epi16(_mm256_extracti128_si256(Block, 1)));
+
+	Position += 32;
+	Written += 32;
+	return true;
+}
+
+// 24 bytes of 3 byte sequences to 8 units, two 12 byte groups side by side
+UNICODE_TARGET("avx2")
+static bool Utf8ThreeByteBlockAvx2(const uint8_t* Data, size_t Length, size_t& Position, uint16_t* Result, size_t ResultSize, size_t& Written)
+{
+	if (Length - Position < 32 || ResultSize - Written < 8)
+		return false;
+
+	auto Block = _mm256_loadu_si256((const __m256i*)(Data + Position));
+
+	// Leads (1110xxxx) every third byte, continuations (10xxxxxx) everywhere else, in the first 24 bytes
+	auto Leads = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_and_si256(Block, _mm256_set1_epi8((char)0xF0)), _mm256_set1_epi8((char)0xE0))) & 0xFFFFFF;
+	auto Continuations = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_and_si256(Block, _mm256_set1_epi8((char)0xC0)), _mm256_set1_epi8((char)0x80))) & 0xFFFFFF;
+
+	if (Leads != 0x249249 || Continuations != 0xDB6DB6)
+		return false;
+
+	// Bytes 12-23 move to the high 128 bit lane, then each sequence into a 32 bit lane, last byte lowest
+	auto Groups = _mm256_permutevar8x32_epi32(Block, _mm256_setr_epi32(0, 1, 2, 3, 3, 4, 5, 6));
+	auto Lanes = _mm256_shuffle_epi8(Groups, _mm256_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1, 2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1));
+
+	auto Low = _mm256_and_si256(Lanes, _mm256_set1_epi32(0x3F));
+	auto Middle = _mm256_and_si256(_mm256_srli_epi32(Lanes, 2), _mm256_set1_epi32(0xFC0));
+	auto High = _mm256_and_si256(_mm256_srli_epi32(Lanes, 4), _mm256_set1_epi32(0xF000));
+	auto CodePoints = _mm256_or_si256(_mm256_or_si256(Low, Middle), High);
+
+	// Reject overlong forms and surrogates
+	auto Overlong = _mm256_cmpgt_epi32(_mm256_set1_epi32(0x800), CodePoints);
+	auto Surrogate = _mm256_cmpeq_epi32(_mm256_and_si256(CodePoints, _mm256_set1_epi32(0xF800)), _mm256_set1_epi32(0xD800));
+
+	if (_mm256_movemask_epi8(_mm256_or_si256(Overlong, Surrogate)) != 0)
+		return false;
+
+	auto Units = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(CodePoints, _mm256_setr_epi8(0, 1, 4, 5, 8, 9, 12, 13, -1, -1, -1, -1, -1, -1, -1, -1, 0, 1, 4, 5, 8, 9, 12, 13, -1, -1, -1, -1, -1, -1, -1, -1)), 0x08);
+	_mm_storeu_si128((__m128i*)(Result + Written), _mm256_castsi256_si128(Units));
+
+	Position += 24;
+	Written += 8;
+	return true;
+}
+
+// Runs the blocks of a level until none of them apply
+static void Utf8ToUtf16Blocks(CpuLevel Level, const uint8_t* Data, size_t Length, size_t& Position, uint16_t* Result, size_t ResultSize, size_t& Written)
+{
+	if (Level >= CPU_LEVEL_AVX2)
+	{
+		auto& Tables = GetTables();
+
+		// The first byte picks the wide block worth trying, mixed text goes straight to the tables
+		while (Position < Length)
+		{
+			auto Wide = (Data[Position] < 0x80) ? (Utf8AsciiBlockAvx2(Data, Length, Position, Result, ResultSize, Written) || Utf8AsciiBlock(Data, Length, Position, Result, ResultSize, Written)) :
+				Utf8ThreeByteBlockAvx2(Data, Length, Position, Result, ResultSize, Written);
+
+			if (!Wide && !Utf8MixedBlock(Tables, Data, Length, Position, Result, ResultSize, Written))
+				break;
+		}
+	}
+	else if (Level >= CPU_LEVEL_SSSE3)
+	{
+		auto& Tables = GetTables();
+		while (Utf8AsciiBlock(Data, Length, Position, Result, ResultSize, Written) || Utf8MixedBlock(Tables, Data, Length, Position, Result, ResultSize, Written));
+	}
+	else if (Level >= CPU_LEVEL_SSE2)
+	{
+		while (Utf8AsciiBlock(Data, Length, Position, Result, ResultSize, Written));
+	}
+}
+
+// 16 ascii units to 16 bytes
+static bool Utf16AsciiBlock(const uint16_t* Data, size_t Length, size_t& Position, char* Result, size_t ResultSize, size_t& Written)
+{
+	if (Length - Position < 16 || ResultSize - Written < 16)
+		return false;
+
+	auto First = _mm_loadu_si128((const __m128i*)(Data + Position));
+	auto Second = _mm_loadu_si128((const __m128i*)(Data + Position + 8));
+
+	if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(_mm_or_si128(First, Second), _mm_set1_epi16((short)0xFF80)), _mm_setzero_si128())) != 0xFFFF)
+		return false;
+
+	_mm_storeu_si128((__m128i*)(Result + Written), _mm_packus_epi16(First, Second));
+
+	Position += 16;
+	Written += 16;
+	return true;
+}
+
+// 8 units that aren't surrogates to 8-24 bytes
+UNICODE_TARGET("ssse3")
+static bool Utf16MixedBlock(const TranscodeTables& Tables, const uint16_t* Data, size_t Length, size_t& Position, char* Result, size_t ResultSize, size_t& Written)
+{
+	// The second store runs 4 bytes past the sequences at most
+	if (Length - Position < 8 || ResultSize - Written < 28)
+		return false;
+
+	auto Block = _mm_loadu_si128((const __m128i*)(Data + Position));
+
+	if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(Block, _mm_set1_epi16((short)0xF800)), _mm_set1_epi16((short)0xD800))) != 0)
+		return false;
+
+	auto Ascii = _mm_cmpeq_epi16(_mm_and_si128(Block, _mm_set1_epi16((short)0xFF80)), _mm_setzero_si128());
+	auto Small = _mm_cmpeq_epi16(_mm_and_si128(Block, _mm_set1_epi16((short)0xF800)), _mm_setzero_si128());
+
+	// Every unit as up to 3 bytes, the lead and the byte after share a 16 bit lane
+	auto Last = _mm_or_si128(_mm_and_si128(Block, _mm_set1_epi16(0x3F)), _mm_set1_epi16(0x80));
+	auto Middle = _mm_or_si128(_mm_and_si128(_mm_srli_epi16(Block, 6), _mm_set1_epi16(0x3F)), _mm_set1_epi16(0x80));
+	auto PairLead = _mm_or_si128(_mm_srli_epi16(Block, 6), _mm_set1_epi16(0xC0));
+	auto TripleLead = _mm_or_si128(_mm_srli_epi16(Block, 12), _mm_set1_epi16(0xE0));
+
+	auto Lead = _mm_or_si128(_mm_and_si128(Ascii, Block), _mm_andnot_si128(Ascii, _mm_or_si128(_mm_and_si128(Small, PairLead), _mm_andnot_si128(Small, TripleLead))));
+	auto Second = _mm_or_si128(_mm_and_si128(Small, Last), _mm_andnot_si128(Small, Middle));
+	auto Leading = _mm_or_si128(Lead, _mm_slli_epi16(Second, 8));
+
+	auto Longer = ~(uint32_t)_mm_movemask_epi8(Ascii);
+	auto Longest = ~(uint32_t)_mm_movemask_epi8(Small);
+	auto LowerKey = CompactLaneMask(Longer & 0xFF) | (CompactLaneMask(Longest & 0xFF) << 4);
+	auto UpperKey = CompactLaneMask((Longer >> 8) & 0xFF) | (CompactLaneMask((Longest >> 8) & 0xFF) << 4);
+
+	auto Lower = _mm_shuffle_epi8(_mm_unpacklo_epi16(Leading, Last), _mm_loadu_si128((const __m128i*)Tables.Utf16Shuffles[LowerKey]));
+	auto Upper = _mm_shuffle_epi8(_mm_unpackhi_epi16(Leading, Last), _mm_loadu_si128((const __m128i*)Tables.Utf16Shuffles[UpperKey]));
+
+	_mm_storeu_si128((__m128i*)(Result + Written), Lower);
+	Written += Tables.Utf16Lengths[LowerKey];
+	_mm_storeu_si128((__m128i*)(Result + Written), Upper);
+	Written += Tables.Utf16Lengths[UpperKey];
+
+	Position += 8;
+	return true;
+}
+
+// 32 ascii units to 32 bytes
+UNICODE_TARGET("avx2")
+static bool Utf16AsciiBlockAvx2(const uint16_t* Data, size_t Length, size_t& Position, char* Result, size_t ResultSize, size_t& Written)
+{
+	if (Length - Position < 32 || ResultSize - Written < 32)
+		return false;
+
+	auto First = _mm256_loadu_si256((const __m256i*)(Data + Position));
+	auto Second = _mm256_loadu_si256((const __m256i*)(Data + Position + 16));
+
+	if (!_mm256_testz_si256(_mm256_or_si256(First, Second), _mm256_set1_epi16((short)0xFF80)))
+		return false;
+
+	// Packing works within 128 bit lanes, the quarters are put back in order after
+	_mm256_storeu_si256((__m256i*)(Result + Written), _mm256_permute4x64_epi64(_mm256_packus_epi16(First, Second), 0xD8));
+
+	Position += 32;
+	Written += 32;
+	return true;
+}
+
+// 16 units of 0x800 and up, but not surrogates, to 48 bytes
+UNICODE_TARGET("avx2")
+static bool Utf16ThreeByteBlockAvx2(const uint16_t* Data, size_t Length, size_t& Position, char* Result, size_t ResultSize, size_t& Written)
+{
+	// The last store runs 4 bytes past the sequences
+	if (Length - Position < 16 || ResultSize - Written < 52)
+		return false;
+
+	auto Block = _mm256_loadu_si256((const __m256i*)(Data + Position));
+
+	auto Small = _mm256_cmpeq_epi16(_mm256_subs_epu16(Block, _mm256_set1_epi16(0x7FF)), _mm256_setzero_si256());
+	auto Surrogate = _mm256_cmpeq_epi16(_mm256_and_si256(Block, _mm256_set1_epi16((short)0xF800)), _mm256_set1_epi16((short)0xD800));
+
+	if (_mm256_movemask_epi8(_mm256_or_si256(Small, Surrogate)) != 0)
+		return false;
+
+	auto Lead = _mm256_or_si256(_mm256_srli_epi16(Block, 12), _mm256_set1_epi16(0xE0));
+	auto Middle = _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi16(Block, 6), _mm256_set1_epi16(0x3F)), _mm256_set1_epi16(0x80));
+	auto Last = _mm256_or_si256(_mm256_and_si256(Block, _mm256_set1_epi16(0x3F)), _mm256_set1_epi16(0x80));
+	auto Leading = _mm256_or_si256(Lead, _mm256_slli_epi16(Middle, 8));
+
+	// Unpacking works within 128 bit lanes, the low one holds units 0-3 and 4-7, the high one 8-11 and 12-15
+	auto Pack = _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1, 0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+	auto Lower = _mm256_shuffle_epi8(_mm256_unpacklo_epi16(Leading, Last), Pack);
+	auto Upper = _mm256_shuffle_epi8(_mm256_unpackhi_epi16(Leading, Last), Pack);
+
+	_mm_storeu_si128((__m128i*)(Result + Written), _mm256_castsi256_si128(Lower));
+	_mm_storeu_si128((__m128i*)(Result + Written + 12), _mm256_castsi256_si128(Upper));
+	_mm_storeu_si128((__m128i*)(Result + Written + 24), _mm256_extracti128_si256(Lower, 1));
+	_mm_storeu_si128((__m128i*)(Result + Written + 36), _mm256_extracti128_si256(Upper, 1));
+
+	Position += 16;
+	Written += 48;
+	return true;
+}
+
+// Runs the blocks of a level until none of them apply
+static void Utf16ToUtf8Blocks(CpuLevel Level, const uint16_t* Data, size_t Length, size_t& Position, char* Result, size_t ResultSize, size_t& Written)
+{
+	if (Level >= CPU_LEVEL_AVX2)
+	{
+		auto& Tables = GetTables();
+
+		// The first unit picks the wide block worth trying, mixed text goes straight to the tables
+		while (Position < Length)
+		{
+			auto Wide = (Data[Position] < 0x80) ? (Utf16AsciiBlockAvx2(Data, Length, Position, Result, ResultSize, Written) || Utf16AsciiBlock(Data, Length, Position, Result, ResultSize, Written)) :
+				Utf16ThreeByteBlockAvx2(Data, Length, Position, Result, ResultSize, Written);
+
+			if (!Wide && !Utf16MixedBlock(Tables, Data, Length, Position, Result, ResultSize, Written))
+				break;
+		}
+	}
+	else if (Level >= CPU_LEVEL_SSSE3)
+	{
+		auto& Tables = GetTables();
+		while (Utf16AsciiBlock(Data, Length, Position, Result, ResultSize, Written) || Utf16MixedBlock(Tables, Data, Length, Position, Result, ResultSize, Written));
+	}
+	else if (Level >= CPU_LEVEL_SSE2)
+	{
+		while (Utf16AsciiBlock(Data, Length, Position, Result, ResultSize, Written));
+	}
+}
+
+#endif
+
+TranscodeResult Unicode::TranscodeUtf8ToUtf16(const char* Data, size_t Length, uint16_t* Result, size_t ResultSize)
+{
+	auto Bytes = (const uint8_t*)Data;
+	size_t Position = 0, Written = 0;
+
+#if UNICODE_SIMD
+	auto Level = CpuFeatures::GetLevel();
+#endif
+
+	while (Position < Length)
+	{
+#if UNICODE_SIMD
+		// Short tails never fill a block
+		if (Length - Position >= 16)
+		{
+			Utf8ToUtf16Blocks(Level, Bytes, Length, Position, Result, ResultSize, Written);
+			if (Position == Length)
+				break;
+		}
+#endif
+
+		// One code point, then back to the blocks
+		auto Start = Position;
+		uint32_t CodePoint = 0;
+
+		if (!DecodeUtf8(Bytes, Length, Position, CodePoint))
+			return { TRANSCODE_INVALID, Start, Written };
+
+		if (CodePoint >= 0x10000)
+		{
+			if (ResultSize - Written < 2)
+				return { TRANSCODE_SHORT_BUFFER, Start, Written };
+
+			CodePoint -= 0x10000;
+			Result[Written++] = (uint16_t)(0xD800 + (CodePoint >> 10));
+			Result[Written++] = (uint16_t)(0xDC00 + (CodePoint & 0x3FF));
+		}
+		else
+		{
+			if (ResultSize - Written < 1)
+				return { TRANSCODE_SHORT_BUFFER, Start, Written };
+
+			Result[Written++] = (uint16_t)CodePoint;
+		}
+	}
+
+	return { TRANSCODE_OK, Position, Written };
+}
+
+TranscodeResult Unicode::TranscodeUtf16ToUtf8(const uint16_t* Data, size_t Length, char* Result, size_t ResultSize)
+{
+	size_t Position = 0, Written = 0;
+
+#if UNICODE_SIMD
+	auto Level = CpuFeatures::GetLevel();
+#endif
+
+	while (Position < Length)
+	{
+#if UNICODE_SIMD
+		// Short tails never fill a block
+		if (Length - Position >= 8)
+		{
+			Utf16ToUtf8Blocks(Level, Data, Length, Position, Result, ResultSize, Written);
+			if (Position == Length)
+				break;
+		}
+#endif
+
+		// One code point, then back to the blocks
+		auto Start = Position;
+		uint32_t CodePoint = Data[Position++];
+
+		if (CodePoint >= 0xD800 && CodePoint <= 0xDFFF)
+		{
+			if (CodePoint > 0xDBFF || Position == Length || Data[Position] < 0xDC00 || Data[Position] > 0xDFFF)
+				return { TRANSCODE_INVALID, Start, Written };
+
+			CodePoint = 0x10000 + ((CodePoint - 0xD800) << 10) + (Data[Position++] - 0xDC00);
+		}
+
+		uint8_t Encoded[4];
+		auto EncodedLength = EncodeUtf8(CodePoint, Encoded);
+
+		if (ResultSize - Written < EncodedLength)
+			return { TRANSCODE_SHORT_BUFFER, Start, Written };
+
+		for (uint32_t i = 0; i < EncodedLength; i++)
+			Result[Written++] = (char)Encoded[i];
+	}
+
+	return { TRANSCODE_OK, Position, Written };
+}
+
+bool Unicode::MeasureUtf8AsUtf16(const char* Data, size_t Length, size_t& Result)
+{
+	uint16_t Scratch[MeasureChunkSize];
+	size_t Position = 0;
+	Result = 0;
+
+	// Converted into a scratch buffer a chunk at a time, the blocks validate as they go
+	while (true)
+	{
+		auto Converted = TranscodeUtf8ToUtf16(Data + Position, Length - Position, Scratch, MeasureChunkSize);
+
+		Position += Converted.Read;
+		Result += Converted.Written;
+
+		if (Converted.Status == TRANSCODE_OK)
+			return true;
+		if (Converted.Status == TRANSCODE_INVALID)
+			return false;
+	}
+}
+
+bool Unicode::Utf8ToUtf16(const char* Data, size_t Length, uint16_t* Result, size_t& ResultLength)
+{
+	// The caller measured the string, so the result always fits
+	auto Converted = TranscodeUtf8ToUtf16(Data, Length, Result, (size_t)-1 / sizeof(uint16_t));
+	ResultLength = Converted.Written;
+
+	return Converted.Status == TRANSCODE_OK;
+}
+
+size_t Unicode::Utf16ToUtf8(const uint16_t* Data, size_t Length, char* Result, size_t ResultSize)
+{
+	size_t Position = 0, ResultLength = 0;
+
+	while (Position < Length)
+	{
+		auto Converted = TranscodeUtf16ToUtf8(Data + Position, Length - Position, Result + ResultLength, ResultSize - ResultLength);
+
+		Position += Converted.Read;
+		ResultLength += Converted.Written;
+
+		if (Converted.Status != TRANSCODE_INVALID)
+			break;
+
+		// A lone surrogate, encoded as itself
+		uint8_t Encoded[4];
+		auto EncodedLength = EncodeUtf8(Data[Position], Encoded);
+
+		if (ResultSize - ResultLength < EncodedLength)
+			break;
+
+		for (uint32_t i = 0; i < EncodedLength; i++)
+			Result[ResultLength++] = (char)Encoded[i];
+
+		Position++;
+	}
+
+	return ResultLength;
+}
\ No newline at end of file
@@ -0,0 +1,86 @@
+#pragma once
+
+// Standard includes
+#include <cstdint>
+#include <cstddef>
+
+// Why a transcode stopped
+enum TranscodeStatus : uint32_t
+{
+	TRANSCODE_OK,				// Every input unit was converted
+	TRANSCODE_INVALID,			// Malformed input at Read, nothing past it was converted
+	TRANSCODE_SHORT_BUFFER,		// The next code point at Read didn't fit the result
+};
+
+// Where a transcode stopped, Read and Written are in input and output units
+struct TranscodeResult
+{
+	TranscodeStatus Status;
+	size_t Read;
+	size_t Written;
+};
+
+namespace Unicode
+{
+	// Encodes a code point as utf8, returns the amount of bytes written (1-4)
+	inline uint32_t EncodeUtf8(uint32_t CodePoint, uint8_t* Result)
+	{
+		if (CodePoint < 0x80)
+		{
+			Result[0] = (uint8_t)CodePoint;
+			return 1;
+		}
+		else if (CodePoint < 0x800)
+		{
+			Result[0] = (uint8_t)(0xC0 | (CodePoint >> 6));
+			Result[1] = (uint8_t)(0x80 | (CodePoint & 0x3F));
+			return 2;
+		}
+		else if (CodePoint < 0x10000)
+		{
+			Result[0] = (uint8_t)(0xE0 | (CodePoint >> 12));
+			Result[1] = (uint8_t)(0x80 | ((CodePoint >> 6) & 0x3F));
+			Result[2] = (uint8_t)(0x80 | (CodePoint & 0x3F));
+			return 3;
+		}
+
+		Result[0] = (uint8_t)(0xF0 | (CodePoint >> 18));
+		Result[1] = (uint8_t)(0x80 | ((CodePoint >> 12) & 0x3F));
+		Result[2] = (uint8_t)(0x80 | ((CodePoint >> 6) & 0x3F));
+		Result[3] = (uint8_t)(0x80 | (CodePoint & 0x3F));
+		return 4;
+	}
+
+	// Decodes the next code point of a utf16 string, lone surrogates decode as themselves
+	inline uint32_t DecodeUtf16(const uint16_t* Data, size_t Length, size_t& Position)
+	{
+		uint32_t Unit = Data[Position++];
+
+		if (Unit >= 0xD800 && Unit <= 0xDBFF && Position < Length)
+		{
+			uint32_t Low = Data[Position];
+			if (Low >= 0xDC00 && Low <= 0xDFFF)
+			{
+				Position++;
+				return 0x10000 + ((Unit - 0xD800) << 10) + (Low - 0xDC00);
+			}
+		}
+
+		return Unit;
+	}
+
+	// Decodes the next code point of a utf8 string, returns false on a malformed sequence
+	bool DecodeUtf8(const uint8_t* Data, size_t Length, size_t& Position, uint32_t& CodePoint);
+
+	// Converts utf8 to utf16 into a fixed buffer, validating every sequence. Vectorized for anything but 4 byte sequences, never throws
+	TranscodeResult TranscodeUtf8ToUtf16(const char* Data, size_t Length, uint16_t* Result, size_t ResultSize);
+	// Converts utf16 to utf8 into a fixed buffer, lone surrogates are invalid. Vectorized for anything but surrogate pairs, never throws
+	TranscodeResult TranscodeUtf16ToUtf8(const uint16_t* Data, size_t Length, char* Result, size_t ResultSize);
+
+	// Gets the amount of utf16 units required for a utf8 string, false if the string is malformed
+	bool MeasureUtf8AsUtf16(const char* Data, size_t Length, size_t& Result);
+	// Converts utf8 to utf16, the result must hold MeasureUtf8AsUtf16 units, false if the string is malformed
+	bool Utf8ToUtf16(const char* Data, size_t Length, uint16_t* Result, size_t& ResultLength);
+	// Converts utf16 to utf8 into a fixed buffer, stopping at the last code point that fits, lone surrogates are encoded as themselves. Returns the amount of bytes written
+	size_t Utf16ToUtf8(const uint16_t* Data, size_t Length, char* Result, size_t ResultSize);
+}
\ No newline at end of file
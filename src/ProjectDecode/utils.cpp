@@ -1,12 +1,13 @@
 // Standard includes
 #include <Windows.h>
 #include <memory>
-#include <codecvt>
-#include <locale>
 
 // The class we are implementing
 #include "utils.h"
 
+// Our includes
+#include "unicode.h"
+
 // Constant platform specific variables
 static const char DirectorySeparatorChar = '\\';
 static const char AltDirectorySeparatorChar = '/';
@@ -200,18 +201,52 @@ bool Utils::HasEnding(const std::string& fullString, const std::string& ending)
 
 std::wstring Utils::StringToWideString(const std::string& str)
 {
-	using convert_typeX = std::codecvt_utf8<wchar_t>;
-	std::wstring_convert<convert_typeX, wchar_t> converterX;
+	// Never more units than bytes, even with every invalid byte replaced
+	std::wstring Result(str.size(), L'\0');
+	size_t Read = 0, Written = 0;
+
+	while (true)
+	{
+		auto Converted = Unicode::TranscodeUtf8ToUtf16(str.data() + Read, str.size() - Read, (uint16_t*)&Result[0] + Written, Result.size() - Written);
+
+		Read += Converted.Read;
+		Written += Converted.Written;
 
-	// Convert from raw bytes
-	return converterX.from_bytes(str);
+		if (Converted.Status != TRANSCODE_INVALID)
+			break;
+
+		// Malformed bytes become U+FFFD one at a time
+		Result[Written++] = (wchar_t)0xFFFD;
+		Read++;
+	}
+
+	Result.resize(Written);
+	return Result;
 }
 
 std::string Utils::WideStringToString(const std::wstring& wstr)
 {
-	using convert_typeX = std::codecvt_utf8<wchar_t>;
-	std::wstring_convert<convert_typeX, wchar_t> converterX;
+	// Never more than three bytes a unit, a surrogate pair is four bytes for two
+	std::string Result(wstr.size() * 3, '\0');
+	size_t Read = 0, Written = 0;
 
-	// Convert from raw bytes
-	return converterX.to_bytes(wstr);
+	while (true)
+	{
+		auto Converted = Unicode::TranscodeUtf16ToUtf8((const uint16_t*)wstr.data() + Read, wstr.size() - Read, &Result[0] + Written, Result.size() - Written);
+
+		Read += Converted.Read;
+		Written += Converted.Written;
+
+		if (Converted.Status != TRANSCODE_INVALID)
+			break;
+
+		// Lone surrogates become U+FFFD
+		Result[Written++] = (char)0xEF;
+		Result[Written++] = (char)0xBF;
+		Result[Written++] = (char)0xBD;
+		Read++;
+	}
+
+	Result.resize(Written);
+	return Result;
 }
\ No newline at end of file
@@ -35,8 +35,8 @@ namespace Utils
 	// If a string ends with another string
 	bool HasEnding(const std::string& fullString, const std::string& ending);
 
-	// String to wide string
+	// String to wide string (utf8 to utf16), malformed bytes become U+FFFD
 	std::wstring StringToWideString(const std::string& str);
-	// Wide string to string
+	// Wide string to string (utf16 to utf8), lone surrogates become U+FFFD
 	std::string WideStringToString(const std::wstring& wstr);
 }
\ No newline at end of file
@@ -0,0 +1,123 @@
+// Standard includes
+#include <algorithm>
+#include <cstring>
+
+// The class we are implementing
+#include "valuecache.h"
+
+// Our includes
+#include "unicode.h"
+
+// Size of an arena block, larger values get a block of their own
+static const size_t ArenaBlockSize = 64 * 1024;
+
+DecodedValueCache::DecodedValueCache(const SymbolTableData* SymbolData, uint32_t Entries)
+	: Values(new std::atomic<const char*>[Entries]), WideValues(new std::atomic<const uint16_t*>[Entries])
+{
+	this->Table = SymbolData;
+	this->EntryCount = Entries;
+	this->ArenaUsed = 0;
+	this->ArenaCapacity = 0;
+	this->DecodedBytes.store(0, std::memory_order_relaxed);
+
+	for (uint32_t i = 0; i < Entries; i++)
+	{
+		this->Values[i].store(nullptr, std::memory_order_relaxed);
+		this->WideValues[i].store(nullptr, std::memory_order_relaxed);
+	}
+}
+
+DecodedValueCache::~DecodedValueCache()
+{
+}
+
+uint8_t* DecodedValueCache::Allocate(size_t Size, size_t Alignment)
+{
+	auto Offset = (this->ArenaUsed + (Alignment - 1)) & ~(Alignment - 1);
+
+	if (this->ArenaBlocks.empty() || Offset + Size > this->ArenaCapacity)
+	{
+		auto BlockSize = std::max(ArenaBlockSize, Size);
+		this->ArenaBlocks.emplace_back(new uint8_t[BlockSize]);
+		this->ArenaCapacity = BlockSize;
+		Offset = 0;
+	}
+
+	this->ArenaUsed = Offset + Size;
+	this->DecodedBytes.fetch_add(Size, std::memory_order_relaxed);
+
+	return this->ArenaBlocks.back().get() + Offset;
+}
+
+const char* DecodedValueCache::DecodeValue(const uint8_t* Encoded, uint32_t EncodedLength, size_t& Length)
+{
+	Length = SymbolTable::GetDecodedLength(*this->Table, Encoded, EncodedLength);
+
+	// Decoding writes whole symbols, so leave room past the terminator
+	auto Value = (char*)this->Allocate(Length + 1 + SYMBOLTABLE_MAX_LENGTH, 1);
+	SymbolTable::Decode(*this->Table, Encoded, EncodedLength, Value);
+	Value[Length] = 0;
+
+	return Value;
+}
+
+const char* DecodedValueCache::DecodeSlow(uint32_t Index, const uint8_t* Encoded, uint32_t EncodedLength)
+{
+	std::lock_guard<std::mutex> Guard(this->ArenaLock);
+
+	// Another thread may have decoded it while we waited
+	auto Value = this->Values[Index].load(std::memory_order_acquire);
+	if (Value != nullptr)
+		return Value;
+
+	size_t Length = 0;
+	Value = this->DecodeValue(Encoded, EncodedLength, Length);
+	this->Values[Index].store(Value, std::memory_order_release);
+
+	return Value;
+}
+
+const uint16_t* DecodedValueCache::DecodeWideSlow(uint32_t Index, const uint8_t* Encoded, uint32_t EncodedLength)
+{
+	std::lock_guard<std::mutex> Guard(this->ArenaLock);
+
+	auto WideValue = this->WideValues[Index].load(std::memory_order_acquire);
+	if (WideValue != nullptr)
+		return WideValue;
+
+	// The utf8 form is kept too, it's usually asked for as well
+	auto Value = this->Values[Index].load(std::memory_order_acquire);
+	size_t Length = 0;
+
+	if (Value == nullptr)
+	{
+		Value = this->DecodeValue(Encoded, EncodedLength, Length);
+		this->Values[Index].store(Value, std::memory_order_release);
+	}
+	else
+	{
+		Length = std::strlen(Value);
+	}
+
+	// Length prefixed, values that aren't valid utf8 get a lone invalid length
+	size_t WideLength = 0;
+	auto Valid = Unicode::MeasureUtf8AsUtf16(Value, Length, WideLength);
+	auto Block = this->Allocate(sizeof(uint32_t) + ((Valid ? WideLength + 1 : 1) * sizeof(uint16_t)), sizeof(uint32_t));
+	auto Result = (uint16_t*)(Block + sizeof(uint32_t));
+
+	uint32_t StoredLength = Valid ? (uint32_t)WideLength : UINT32_MAX;
+	std::memcpy(Block, &StoredLength, sizeof(StoredLength));
+
+	if (Valid)
+		Unicode::Utf8ToUtf16(Value, Length, Result, WideLength);
+
+	Result[Valid ? WideLength : 0] = 0;
+	this->WideValues[Index].store(Result, std::memory_order_release);
+
+	return Result;
+}
+
+size_t DecodedValueCache::GetDecodedBytes() const
+{
+	return this->DecodedBytes.load(std::memory_order_relaxed);
+}
\ No newline at end of file
@@ -0,0 +1,82 @@
+#pragma once
+
+// Standard includes
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Our includes
+#include "symboltable.h"
+
+//
+// Values of a compressed database, decoded the first time they are asked for.
+// The engine keeps the pointers we hand it, so a value is decoded once into an arena and never moves.
+// Readers take a single acquire load once a value is decoded, only the first decode of an entry locks.
+//
+
+class DecodedValueCache
+{
+private:
+	const SymbolTableData* Table;
+	uint32_t EntryCount;
+
+	// Decoded values by entry index, nullptr until decoded
+	std::unique_ptr<std::atomic<const char*>[]> Values;
+	// Decoded utf16 values by entry index, each prefixed by its uint32_t length
+	std::unique_ptr<std::atomic<const uint16_t*>[]> WideValues;
+
+	// Guards the arena
+	std::mutex ArenaLock;
+	std::vector<std::unique_ptr<uint8_t[]>> ArenaBlocks;
+	size_t ArenaUsed;
+	size_t ArenaCapacity;
+	std::atomic<size_t> DecodedBytes;
+
+	// Allocates arena memory, must hold the lock
+	uint8_t* Allocate(size_t Size, size_t Alignment);
+	// Decodes a value into the arena, must hold the lock
+	const char* DecodeValue(const uint8_t* Encoded, uint32_t EncodedLength, size_t& Length);
+
+public:
+	DecodedValueCache(const SymbolTableData* SymbolData, uint32_t Entries);
+	~DecodedValueCache();
+
+	DecodedValueCache(const DecodedValueCache&) = delete;
+	DecodedValueCache& operator=(const DecodedValueCache&) = delete;
+
+	// Gets the null-term utf8 value of an entry
+	const char* GetValue(uint32_t Index, const uint8_t* Encoded, uint32_t EncodedLength)
+	{
+		auto Value = this->Values[Index].load(std::memory_order_acquire);
+		return (Value != nullptr) ? Value : this->DecodeSlow(Index, Encoded, EncodedLength);
+	}
+
+	// Gets the null-term utf16 value of an entry, nullptr if the value isn't valid utf8
+	const uint16_t* GetWideValue(uint32_t Index, const uint8_t* Encoded, uint32_t EncodedLength, uint32_t& Length)
+	{
+		auto Value = this->WideValues[Index].load(std::memory_order_acquire);
+		if (Value == nullptr)
+			Value = this->DecodeWideSlow(Index, Encoded, EncodedLength);
+
+		// Invalid values decode to a lone length
+		uint32_t WideLength;
+		std::memcpy(&WideLength, Value - 2, sizeof(WideLength));
+		if (WideLength == UINT32_MAX)
+			return nullptr;
+
+		Length = WideLength;
+		return Value;
+	}
+
+	// Decodes and publishes a value the first time it's asked for
+	const char* DecodeSlow(uint32_t Index, const uint8_t* Encoded, uint32_t EncodedLength);
+	// Decodes and publishes a utf16 value the first time it's asked for
+	const uint16_t* DecodeWideSlow(uint32_t Index, const uint8_t* Encoded, uint32_t EncodedLength);
+
+	// Gets the amount of arena bytes handed out so far
+	size_t GetDecodedBytes() const;
+};
\ No newline at end of file